@@ -150,6 +150,12 @@ extern "C" {
 // Max header count
 #define MAX_REQUEST_HEADER_COUNT                200
 
+// Number of the headers stored in the request info itself. More headers are moved into an allocated array
+#define REQUEST_INFO_INLINE_HEADER_COUNT        16
+
+// Size of the request info buffer for the header names and values. Headers which don't fit are allocated individually
+#define REQUEST_INFO_INLINE_HEADER_DATA_SIZE    2048
+
 // Max delimiter characters when packing headers into a string for printout
 #define MAX_REQUEST_HEADER_OUTPUT_DELIMITER     5
 
@@ -160,6 +166,7 @@ extern "C" {
 #define HTTP_REQUEST_VERB_GET_STRING            (PCHAR) "GET"
 #define HTTP_REQUEST_VERB_PUT_STRING            (PCHAR) "PUT"
 #define HTTP_REQUEST_VERB_POST_STRING           (PCHAR) "POST"
+#define HTTP_REQUEST_VERB_HEAD_STRING           (PCHAR) "HEAD"
 
 // Schema delimiter string
 #define SCHEMA_DELIMITER_STRING                 (PCHAR) "://"
@@ -223,6 +230,11 @@ extern "C" {
  */
 #define CALL_INFO_ERROR_BUFFER_LEN                  256
 
+/**
+ * Initial capacity of the response buffer. The buffer capacity is doubled whenever the response outgrows it
+ */
+#define CALL_INFO_MIN_RESPONSE_BUFFER_SIZE          1024
+
 /**
  * Parameterized string for each tag pair
  */
@@ -267,7 +279,8 @@ extern "C" {
 typedef enum {
     HTTP_REQUEST_VERB_GET,
     HTTP_REQUEST_VERB_POST,
-    HTTP_REQUEST_VERB_PUT
+    HTTP_REQUEST_VERB_PUT,
+    HTTP_REQUEST_VERB_HEAD
 } HTTP_REQUEST_VERB;
 
 /**
@@ -393,8 +406,18 @@ struct __RequestInfo {
     // AWS Credentials
     PAwsCredentials pAwsCredentials;
 
-    // Request headers
-    PSingleList pRequestHeaders;
+    // Request headers in an alphabetical order of the names. Points to the inline headers
+    // until they overflow. NULL if no header has been set.
+    PRequestHeader pRequestHeaders;
+
+    // Number of the request headers and the capacity of the array
+    UINT32 requestHeaderCount;
+    UINT32 requestHeaderCapacity;
+
+    // Inline storage for the headers and their names and values
+    RequestHeader inlineRequestHeaders[REQUEST_INFO_INLINE_HEADER_COUNT];
+    CHAR requestHeaderData[REQUEST_INFO_INLINE_HEADER_DATA_SIZE];
+    UINT32 requestHeaderDataLen;
 };
 typedef struct __RequestInfo* PRequestInfo;
 
@@ -426,11 +449,19 @@ struct __CallInfo {
 
     // Response data size
     UINT32 responseDataLen;
+
+    // Allocated size of the response buffer including the NULL terminator
+    UINT32 responseDataCapacity;
 };
 typedef struct __CallInfo* PCallInfo;
 
 typedef struct __AwsCredentialProvider *PAwsCredentialProvider;
 
+/**
+ * Cache of the derived SigV4 signing keys
+ */
+typedef struct __SigningKeyCache *PSigningKeyCache;
+
 /**
  * Function returning AWS credentials
  */
@@ -586,6 +617,19 @@ PUBLIC_API STATUS createLwsIotCredentialProviderWithTime(PCHAR, PCHAR, PCHAR, PC
  */
 PUBLIC_API STATUS freeIotCredentialProvider(PAwsCredentialProvider*);
 
+/**
+ * Starts renewing the credentials of an IoT based credential provider on a background thread
+ * ahead of their expiration. The get credentials calls will then only return the cached credentials
+ * and will never block on the IoT credential endpoint call.
+ *
+ * NOTE: The background refresh is stopped when the provider is freed.
+ *
+ * @param - PAwsCredentialProvider - IN - IoT based credential provider object
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS startIotCredentialProviderBackgroundRefresh(PAwsCredentialProvider);
+
 /**
  * Creates a File based AWS credential provider object
  *
@@ -617,6 +661,18 @@ PUBLIC_API STATUS createFileCredentialProviderWithTime(PCHAR, GetCurrentTimeFunc
  */
 PUBLIC_API STATUS freeFileCredentialProvider(PAwsCredentialProvider*);
 
+/**
+ * Starts re-reading the credentials file of a File based credential provider on a background thread
+ * ahead of the credentials expiration. The get credentials calls will then only return the cached credentials.
+ *
+ * NOTE: The background refresh is stopped when the provider is freed.
+ *
+ * @param - PAwsCredentialProvider - IN - File based credential provider object
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS startFileCredentialProviderBackgroundRefresh(PAwsCredentialProvider);
+
 /**
  * Creates a Request Info object
  *
@@ -660,6 +716,38 @@ PUBLIC_API STATUS freeRequestInfo(PRequestInfo*);
  */
 PUBLIC_API STATUS signAwsRequestInfo(PRequestInfo);
 
+/**
+ * Signs a request by appending SigV4 headers re-using the signing key cached for
+ * the credentials, date and region of the request if any.
+ *
+ * @param - PRequestInfo - IN/OUT request info for signing
+ * @param - PSigningKeyCache - IN/OPT - Signing key cache. Specifying NULL derives the key on every call
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS signAwsRequestInfoWithSigningKeyCache(PRequestInfo, PSigningKeyCache);
+
+/**
+ * Creates a signing key cache object. The derived signing key only changes when the date,
+ * region or the credentials change so it can be shared by the requests signed with the same credentials.
+ *
+ * @param - PSigningKeyCache* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS createSigningKeyCache(PSigningKeyCache*);
+
+/**
+ * Frees the signing key cache object
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PSigningKeyCache* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS freeSigningKeyCache(PSigningKeyCache*);
+
 /**
  * Signs a request by appending SigV4 query param
  *
@@ -726,7 +814,9 @@ PUBLIC_API STATUS getUserAgentString(PCHAR, PCHAR, UINT32, PCHAR);
 PUBLIC_API STATUS requestRequiresSecureConnection(PCHAR, PBOOL);
 
 /**
- * Sets a header in the request info
+ * Sets a header in the request info. The headers are kept in an alphabetical order of the names.
+ *
+ * NOTE: The header is copied into the request info and only allocates once the inline storage is exhausted
  *
  * @param - PRequestInfo - IN - Request Info object
  * @param - PCHAR - IN - Header name
@@ -757,6 +847,20 @@ PUBLIC_API STATUS removeRequestHeader(PRequestInfo, PCHAR);
 */
 PUBLIC_API STATUS removeRequestHeaders(PRequestInfo);
 
+/**
+ * Builds a list of the request headers in the order they are kept in the request info.
+ *
+ * NOTE: Compatibility accessor for the code which walked the pRequestHeaders list before the headers
+ * were stored in an array. The list items are PRequestHeader pointers owned by the request info which
+ * are valid until the headers are modified. The list itself should be freed with singleListFree.
+ *
+ * @param - PRequestInfo - IN - Request Info object
+ * @param - PSingleList* - OUT - Resulting list of the headers
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS getRequestHeaderList(PRequestInfo, PSingleList*);
+
 /**
  * Creates a request header
  *
@@ -788,6 +892,18 @@ PUBLIC_API SERVICE_CALL_RESULT getServiceCallResultFromHttpStatus(UINT32);
  */
 PUBLIC_API STATUS releaseCallInfo(PCallInfo);
 
+/**
+ * Appends the data to the response buffer of the CallInfo and NULL terminates it.
+ * The buffer grows geometrically so the accumulation of the response is amortized linear.
+ *
+ * @param - PCallInfo - IN - Call info object
+ * @param - PBYTE - IN - Data to append
+ * @param - UINT32 - IN - Size of the data
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS appendCallInfoResponseData(PCallInfo, PBYTE, UINT32);
+
 
 
 #ifdef  __cplusplus
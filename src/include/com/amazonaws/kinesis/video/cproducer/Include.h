@@ -38,6 +38,7 @@ extern "C" {
 #define STATUS_FILE_LOGGER_INDEX_FILE_TOO_LARGE                                     STATUS_PRODUCER_BASE + 0x0000001d
 #define STATUS_STREAM_BEING_SHUTDOWN                                                STATUS_PRODUCER_BASE + 0x0000001e
 #define STATUS_CLIENT_BEING_SHUTDOWN                                                STATUS_PRODUCER_BASE + 0x0000001f
+#define STATUS_RESOLVE_HOST_FAILED                                                  STATUS_PRODUCER_BASE + 0x00000020
 
 /**
  * Maximum callbacks in the processing chain
@@ -49,6 +50,21 @@ extern "C" {
  */
 #define DEFAULT_CALLBACK_CHAIN_COUNT                                            5
 
+/**
+ * Maximum number of curl network loops driving the API calls
+ */
+#define MAX_CURL_NETWORK_LOOP_COUNT                                             16
+
+/**
+ * Default max number of idle curl easy handles kept by the handle pool
+ */
+#define DEFAULT_CURL_HANDLE_POOL_MAX_IDLE_COUNT                                 16
+
+/**
+ * Number of the buckets in the ACK round trip histogram of the stream metrics
+ */
+#define CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_COUNT                          8
+
 ////////////////////////////////////////////////////
 // Main defines
 ////////////////////////////////////////////////////
@@ -60,6 +76,8 @@ extern "C" {
 #define STREAM_CALLBACKS_CURRENT_VERSION                                        0
 #define AUTH_CALLBACKS_CURRENT_VERSION                                          0
 #define API_CALLBACKS_CURRENT_VERSION                                           0
+#define CURL_STREAM_METRICS_CURRENT_VERSION                                     0
+#define CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION                              0
 
 ////////////////////////////////////////////////////
 // Extra callbacks definitions
@@ -109,6 +127,17 @@ typedef STATUS (*FreeAuthCallbacksFunc)(PUINT64);
  */
 typedef STATUS (*FreeApiCallbacksFunc)(PUINT64);
 
+/**
+ * Recommends the encoder bitrate for the stream when the buffer latency builds up.
+ *
+ * @param 1 UINT64 - Custom handle passed by the caller.
+ * @param 2 STREAM_HANDLE - The stream to throttle.
+ * @param 3 UINT64 - Recommended encoder bitrate in bits per second.
+ *
+ * @return STATUS code of the operations
+ */
+typedef STATUS (*StreamBitrateRecommendationFunc)(UINT64, STREAM_HANDLE, UINT64);
+
 ////////////////////////////////////////////////////
 // Main structure declarations
 ////////////////////////////////////////////////////
@@ -279,6 +308,89 @@ typedef enum {
     API_CALL_CACHE_TYPE_ALL,
 } API_CALL_CACHE_TYPE;
 
+/**
+ * Snapshot of the per-stream metrics of the curl based transport.
+ *
+ * The counters are cumulative since the stream has been created. The durations are in 100ns.
+ */
+typedef struct __CurlStreamMetrics CurlStreamMetrics;
+struct __CurlStreamMetrics {
+    // Version of the structure
+    UINT32 version;
+
+    // Number of bytes handed to curl for upload
+    UINT64 bytesSent;
+
+    // Number of the chunks handed to curl for upload
+    UINT64 chunksSent;
+
+    // Average number of the chunks per second over the time the uploads have been active
+    DOUBLE chunksPerSecond;
+
+    // Number of times the upload has been paused awaiting data or ACKs
+    UINT64 pauseCount;
+
+    // Number of times the upload has been un-paused
+    UINT64 unpauseCount;
+
+    // Total time the upload has spent paused
+    UINT64 pausedDuration;
+
+    // Number of the putMedia sessions started
+    UINT64 uploadSessionCount;
+
+    // Number of the putMedia sessions started after the initial one
+    UINT64 reconnectCount;
+
+    // TCP connect, TLS handshake and time to the first response byte of the last completed session.
+    // Measured from the start of the session. 0 if not established.
+    UINT64 connectTime;
+    UINT64 tlsHandshakeTime;
+    UINT64 firstByteTime;
+
+    // Number of the persisted ACKs received
+    UINT64 persistedAckCount;
+
+    // Histogram of the time between the BUFFERING and the PERSISTED ACK of a fragment.
+    // Buckets: < 50ms, < 100ms, < 250ms, < 500ms, < 1s, < 2.5s, < 5s, >= 5s
+    UINT64 ackRoundTripHistogram[CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_COUNT];
+
+    // Moving average of the rate the upload data is accepted by curl in bits per second. 0 if not measured yet.
+    UINT64 uploadBitrate;
+
+    // Moving average of the rate the uploaded data is persisted by the service in bits per second.
+    // Derived from the persisted ACKs. 0 if not measured yet.
+    UINT64 persistedBitrate;
+};
+typedef struct __CurlStreamMetrics* PCurlStreamMetrics;
+
+/**
+ * Transport options of the putMedia sessions of a stream
+ */
+typedef struct __CurlStreamUploadOptions CurlStreamUploadOptions;
+struct __CurlStreamUploadOptions {
+    // Version of the structure
+    UINT32 version;
+
+    // Size of the curl upload buffer in bytes which caps the amount of data read from the stream at once.
+    // 0 to scale it from the average bandwidth of the stream.
+    UINT32 uploadBufferSize;
+
+    // Send buffer size of the putMedia socket in bytes. 0 to keep the system default which the kernel can autotune.
+    // The size is only applied if it's larger than the system default.
+    UINT32 socketSendBufferSize;
+
+    // Whether to disable the Nagle's algorithm on the putMedia socket
+    BOOL tcpNoDelay;
+
+    // Idle time of the connection before the TCP keep-alive probes are sent. 0 to disable the keep-alive.
+    UINT64 tcpKeepAliveIdleTime;
+
+    // Interval between the TCP keep-alive probes
+    UINT64 tcpKeepAliveInterval;
+};
+typedef struct __CurlStreamUploadOptions* PCurlStreamUploadOptions;
+
 ////////////////////////////////////////////////////
 // Public functions
 ////////////////////////////////////////////////////
@@ -502,6 +614,21 @@ PUBLIC_API STATUS createOfflineAudioVideoStreamInfoProvider(PCHAR, UINT64, UINT6
 */
 PUBLIC_API STATUS setStreamInfoBasedOnStorageSize(UINT32, UINT64, UINT32, PStreamInfo);
 
+/**
+ * Configure streaminfo based on given storage size and the upload bitrate measured for a stream,
+ * like the uploadBitrate of the CurlStreamMetrics returned by getCurlStreamMetrics. Falls back to
+ * the given average bitrate if the upload bitrate of the stream hasn't been measured yet.
+ * Will change buffer duration, stream latency duration.
+ *
+ * @param - UINT64 - Measured upload bitrate of the stream. 0 if not measured yet. Unit: bits per second
+ * @param - UINT32 - Storage size in bytes
+ * @param - UINT64 - Total average bitrate for all tracks to fall back to. Unit: bits per second
+ * @param - UINT32 - Total number of streams per kinesisVideoStreamClient
+ * @param - PStreamInfo
+ * @return - STATUS code of the execution
+*/
+PUBLIC_API STATUS setStreamInfoBasedOnMeasuredBitrate(UINT64, UINT32, UINT64, UINT32, PStreamInfo);
+
 /*
  * Frees the StreamInfo provider object.
  *
@@ -581,6 +708,19 @@ PUBLIC_API STATUS createIotAuthCallbacks(PClientCallbacks, PCHAR, PCHAR, PCHAR,
  */
 PUBLIC_API STATUS freeIotAuthCallbacks(PAuthCallbacks*);
 
+/*
+ * Starts renewing the IoT credentials on a background thread ahead of their expiration so the
+ * token callbacks never block on the IoT credential endpoint call.
+ *
+ * NOTE: The credentials are fetched on demand by default. The background refresh is stopped
+ * when the auth callbacks are freed.
+ *
+ * @param - PAuthCallbacks - IN - Iot Credential auth callbacks
+ *
+ * @return - STATUS - status of operation
+ */
+PUBLIC_API STATUS startIotAuthCallbacksBackgroundRefresh(PAuthCallbacks);
+
 /*
  * Creates the File Credentials auth callbacks
  *
@@ -673,6 +813,24 @@ PUBLIC_API STATUS createContinuousRetryStreamCallbacks(PClientCallbacks, PStream
  */
 PUBLIC_API STATUS freeContinuousRetryStreamCallbacks(PStreamCallbacks*);
 
+/**
+ * Sets the callback receiving the bitrate recommendations of the continuous retry stream callbacks.
+ *
+ * The recommendation is issued when the stream latency pressure persists after the connection has
+ * been reset. The bitrate is derived from the measured upload rate of the stream and is lowered further
+ * to drain the buffer exceeding the max latency. Lowering the encoder bitrate accordingly avoids
+ * escalating to the infinite connection reset. It's up to the application to ramp the bitrate back up.
+ *
+ * NOTE: The callback should be set before the streams are created.
+ *
+ * @param - PStreamCallbacks - IN - Object created with createContinuousRetryStreamCallbacks
+ * @param - StreamBitrateRecommendationFunc - IN/OPT - Callback to set. NULL to remove
+ * @param - UINT64 - IN - Custom data passed to the callback
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setContinuousRetryStreamBitrateRecommendationCallback(PStreamCallbacks, StreamBitrateRecommendationFunc, UINT64);
+
 /**
  * Create abstract callback provider that can hook with other callbacks
  *
@@ -704,6 +862,140 @@ PUBLIC_API STATUS createAbstractDefaultCallbacksProvider(UINT32, API_CALL_CACHE_
  */
 PUBLIC_API STATUS addFileLoggerPlatformCallbacksProvider(PClientCallbacks, UINT64, UINT64, PCHAR, BOOL);
 
+/**
+ * Same as addFileLoggerPlatformCallbacksProvider except the log files are written by a dedicated writer thread.
+ * The logging threads format the records and copy them into an in-memory ring buffer of the string buffer size
+ * without waiting on the file IO. Records which don't fit into the ring buffer are dropped and counted.
+ *
+ * NOTE: The file logger is shared by the process. Fails with STATUS_INVALID_OPERATION if it's already running in the sync mode.
+ *
+ * @param - PClientCallbacks - IN - The callback provider whose logPrintFn will be replaced with file logger log printing function
+ * @param - UINT64 - IN - Size of string buffer in file logger. When the string buffer is full the logger will flush everything into a new file
+ * @param - UINT64 - IN - Max number of log file. When exceeded, the oldest file will be deleted when new one is generated
+ * @param - PCHAR - IN - Directory in which the log file will be generated
+ * @param - BOOL - IN - print log to std out too
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS addAsyncFileLoggerPlatformCallbacksProvider(PClientCallbacks, UINT64, UINT64, PCHAR, BOOL);
+
+/**
+ * Returns the number of log records dropped by the async file logger due to its ring buffer being full.
+ * Always 0 for the file logger in sync mode.
+ *
+ * @param - PUINT64 - OUT - Dropped log record count
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS getFileLoggerDroppedLogCount(PUINT64);
+
+/**
+ * Runs the curl based API calls on the specified number of network loop threads which multiplex the
+ * sessions instead of spawning a thread per API call. The requests are distributed to the least loaded loop.
+ * Specifying 0 loops keeps the default thread per call model.
+ *
+ * NOTE: This should be called right after the callbacks provider is created and before any streams are created.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - UINT32 - IN - Number of network loops. Should be less or equal to MAX_CURL_NETWORK_LOOP_COUNT
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlApiCallbacksNetworkLoopCount(PClientCallbacks, UINT32);
+
+/**
+ * Opts the curl based API calls into pooling the curl easy handles per endpoint host. The pooled handles
+ * share the TLS session and DNS caches so the reconnects to the same endpoint resume the TLS session instead
+ * of a full handshake. A handle running on its own thread keeps its live connection for the next session
+ * it's used for, while with the network loops the connections are re-used within each loop.
+ * Specifying 0 keeps the default of a fresh curl handle per session.
+ *
+ * NOTE: This should be called right after the callbacks provider is created and before any streams are created.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - UINT32 - IN - Max number of idle handles to keep. DEFAULT_CURL_HANDLE_POOL_MAX_IDLE_COUNT is a sensible value
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlApiCallbacksHandlePoolSize(PClientCallbacks, UINT32);
+
+/**
+ * Opts the curl based API calls into resolving the endpoint hosts on a background thread. The resolved addresses
+ * are injected into the new sessions so they don't block on DNS, and the last known addresses keep being used
+ * for a while should a refresh fail. Up to 32 hosts are cached and the sessions
+ * to the other hosts resolve on their own.
+ *
+ * NOTE: This should be called right after the callbacks provider is created and before any streams are created.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - BOOL - IN - Whether to resolve the hosts in the background
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlApiCallbacksResolverCache(PClientCallbacks, BOOL);
+
+/**
+ * Opts the curl based API calls into HTTP/2. The sessions negotiate HTTP/2 over TLS and fall back to
+ * HTTP/1.1 if the endpoint doesn't support it. With the network loops, the requests to the same host are
+ * pinned to the same loop so the putMedia sessions and the control plane calls to the host are multiplexed
+ * as HTTP/2 streams over a shared connection with each session flow controlled independently.
+ * Without the network loops each session still uses its own connection.
+ *
+ * NOTE: This should be called right after the callbacks provider is created and before any streams are created.
+ * Can be set only once.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - BOOL - IN - Whether to use HTTP/2
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlApiCallbacksHttp2(PClientCallbacks, BOOL);
+
+/**
+ * Opts the curl based API calls into opening the connection to the data endpoint as soon as the endpoint is known,
+ * ahead of the first putMedia session. The connection is opened on the network loop the putMedia sessions to the
+ * host are pinned to, so the session is multiplexed over it instead of doing its own TCP and TLS handshakes.
+ * The connection is opened once per endpoint lookup with an unauthenticated request which the endpoint rejects.
+ *
+ * NOTE: Requires the network loops and HTTP/2 to be set first. Can be set only once.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - BOOL - IN - Whether to warm up the connections
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlApiCallbacksConnectionWarmUp(PClientCallbacks, BOOL);
+
+/**
+ * Returns a snapshot of the curl transport metrics for the stream. The call only takes the metrics lock
+ * of the stream so it's cheap enough to be polled periodically by a monitoring agent.
+ *
+ * NOTE: The metrics are available once the first putMedia session for the stream has been started
+ * and are released when the stream is freed.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - STREAM_HANDLE - IN - Stream handle to return the metrics for
+ * @param - PCurlStreamMetrics - IN/OUT - Metrics to fill in. The version should be set by the caller
+ *
+ * @return - STATUS code of the execution. STATUS_HASH_KEY_NOT_PRESENT if the stream has no metrics yet.
+ */
+PUBLIC_API STATUS getCurlStreamMetrics(PClientCallbacks, STREAM_HANDLE, PCurlStreamMetrics);
+
+/**
+ * Sets the transport options of the putMedia sessions of the stream. The options take effect from the next
+ * putMedia session of the stream. The socket options apply to the newly established connections only.
+ *
+ * By default, the upload and the socket send buffers are scaled from the average bandwidth of the stream,
+ * TCP_NODELAY is set and the TCP keep-alive is disabled.
+ *
+ * @param - PClientCallbacks - IN - Callbacks provider created with the curl based API callbacks
+ * @param - STREAM_HANDLE - IN - Stream handle to set the options for
+ * @param - PCurlStreamUploadOptions - IN/OPT - Options to use. NULL to revert to the defaults
+ *
+ * @return - STATUS code of the execution
+ */
+PUBLIC_API STATUS setCurlStreamUploadOptions(PClientCallbacks, STREAM_HANDLE, PCurlStreamUploadOptions);
+
 
 
 #ifdef  __cplusplus
@@ -11,15 +11,18 @@
  * with enough storage from the previous call with NULL param.
  *
  */
-STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, BOOL authHeaders, PCHAR* ppSigningInfo, PUINT32 pSigningInfoLen)
+STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PSigningKeyCache pSigningKeyCache, PCHAR dateTimeStr, BOOL authHeaders,
+                                 PCHAR* ppSigningInfo, PUINT32 pSigningInfoLen)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     UINT32 requestLen, scopeLen, signedStrLen, signedHeadersLen = 0,
-            scratchLen, curSize, hmacSize, hexHmacLen;
-    PCHAR pScratchBuf = NULL, pCredentialScope = NULL, pUrlEncodedCredentials = NULL,
-            pSignedStr = NULL, pSignedHeaders = NULL;
+            scratchLen, curSize, hmacSize, hexHmacLen, signingKeyLen;
+    PCHAR pScratchBuf = NULL, pSignedHeaders = NULL;
     CHAR requestHexSha256[2 * SHA256_DIGEST_LENGTH + 1];
+    CHAR credentialScope[MAX_CREDENTIAL_SCOPE_LEN + 1];
+    CHAR signedStr[MAX_SIGNED_STRING_LEN + 1];
+    BYTE signingKey[KVS_MAX_HMAC_SIZE];
     BYTE hmac[KVS_MAX_HMAC_SIZE];
     CHAR hexHmac[KVS_MAX_HMAC_SIZE * 2 + 1];
 
@@ -30,26 +33,28 @@ STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, B
     *pSigningInfoLen = 0;
     *ppSigningInfo = NULL;
 
-    // Get the required sizes and select the largest for the scratch buffer
+    // Get the required sizes
     CHK_STATUS(generateCanonicalRequestString(pRequestInfo, NULL, &requestLen));
-    CHK_STATUS(generateCredentialScope(pRequestInfo, dateTimeStr, NULL, &scopeLen));
     CHK_STATUS(generateSignedHeaders(pRequestInfo, NULL, &signedHeadersLen));
 
-    scratchLen = MAX(requestLen, scopeLen) + MAX_AUTH_LEN + SCRATCH_BUFFER_EXTRA;
+    scratchLen = requestLen + MAX_AUTH_LEN + SCRATCH_BUFFER_EXTRA;
 
-    // Get the request length and allocate enough space and package the request
-    CHK(NULL != (pScratchBuf = (PCHAR) MEMALLOC(scratchLen * SIZEOF(CHAR))), STATUS_NOT_ENOUGH_MEMORY);
+    // Allocate the scratch buffer once. The signed headers are packed past the end of the scratch space
+    // as they are still needed when the resulting signing info is generated into the scratch space.
+    CHK(NULL != (pScratchBuf = (PCHAR) MEMALLOC((scratchLen + signedHeadersLen) * SIZEOF(CHAR))), STATUS_NOT_ENOUGH_MEMORY);
+    pSignedHeaders = pScratchBuf + scratchLen;
+
+    // Package the request
     CHK_STATUS(generateCanonicalRequestString(pRequestInfo, pScratchBuf, &requestLen));
 
     // Calculate the hex encoded SHA256 of the canonical request
     CHK_STATUS(hexEncodedSha256((PBYTE) pScratchBuf, requestLen * SIZEOF(CHAR), requestHexSha256));
 
     // Get the credential scope
-    CHK(NULL != (pCredentialScope = (PCHAR) MEMALLOC(scopeLen * SIZEOF(CHAR))), STATUS_NOT_ENOUGH_MEMORY);
-    CHK_STATUS(generateCredentialScope(pRequestInfo, dateTimeStr, pCredentialScope, &scopeLen));
+    scopeLen = ARRAY_SIZE(credentialScope);
+    CHK_STATUS(generateCredentialScope(pRequestInfo, dateTimeStr, credentialScope, &scopeLen));
 
     // Get the signed headers
-    CHK(NULL != (pSignedHeaders = (PCHAR) MEMALLOC(signedHeadersLen * SIZEOF(CHAR))), STATUS_NOT_ENOUGH_MEMORY);
     CHK_STATUS(generateSignedHeaders(pRequestInfo, pSignedHeaders, &signedHeadersLen));
 
     // https://docs.aws.amazon.com/general/latest/gr/sigv4-create-string-to-sign.html
@@ -58,13 +63,9 @@ STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, B
     //    RequestDateTime + \n +
     //    CredentialScope + \n +
     //    HashedCanonicalRequest
-    signedStrLen = (UINT32) STRLEN(AWS_SIG_V4_ALGORITHM) + 1 +
-                   SIGNATURE_DATE_TIME_STRING_LEN + 1 +
-                   scopeLen + 1 +
-                   SIZEOF(requestHexSha256) + 1;
-    CHK(NULL != (pSignedStr = (PCHAR) MEMALLOC(signedStrLen * SIZEOF(CHAR))), STATUS_NOT_ENOUGH_MEMORY);
-    curSize = SNPRINTF(pSignedStr, signedStrLen, SIGNED_STRING_TEMPLATE, AWS_SIG_V4_ALGORITHM, dateTimeStr,
-                       pCredentialScope, requestHexSha256);
+    signedStrLen = ARRAY_SIZE(signedStr);
+    curSize = SNPRINTF(signedStr, signedStrLen, SIGNED_STRING_TEMPLATE, AWS_SIG_V4_ALGORITHM, dateTimeStr,
+                       credentialScope, requestHexSha256);
     CHK(curSize > 0 && curSize < signedStrLen, STATUS_BUFFER_TOO_SMALL);
 
     // Set the actual size
@@ -72,25 +73,10 @@ STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, B
 
     // Create V4 signature
     // http://docs.aws.amazon.com/general/latest/gr/sigv4-calculate-signature.html
-    curSize = (UINT32) STRLEN(AWS_SIG_V4_SIGNATURE_START);
-    MEMCPY(pScratchBuf, AWS_SIG_V4_SIGNATURE_START, curSize);
-    MEMCPY((PBYTE) pScratchBuf + curSize, pRequestInfo->pAwsCredentials->secretKey, pRequestInfo->pAwsCredentials->secretKeyLen);
-    curSize += pRequestInfo->pAwsCredentials->secretKeyLen;
+    CHK_STATUS(getSigningKey(pRequestInfo, pSigningKeyCache, dateTimeStr, signingKey, &signingKeyLen));
 
     hmacSize = SIZEOF(hmac);
-    CHK_STATUS(generateRequestHmac((PBYTE) pScratchBuf, curSize, (PBYTE) dateTimeStr,
-                                   SIGNATURE_DATE_STRING_LEN * SIZEOF(CHAR),
-                                   hmac, &hmacSize));
-    CHK_STATUS(generateRequestHmac(hmac, hmacSize, (PBYTE) pRequestInfo->region,
-                                   (UINT32) STRLEN(pRequestInfo->region),
-                                   hmac, &hmacSize));
-    CHK_STATUS(generateRequestHmac(hmac, hmacSize, (PBYTE) KINESIS_VIDEO_SERVICE_NAME,
-                                   (UINT32) STRLEN(KINESIS_VIDEO_SERVICE_NAME),
-                                   hmac, &hmacSize));
-    CHK_STATUS(generateRequestHmac(hmac, hmacSize, (PBYTE) AWS_SIG_V4_SIGNATURE_END,
-                                   (UINT32) STRLEN(AWS_SIG_V4_SIGNATURE_END),
-                                   hmac, &hmacSize));
-    CHK_STATUS(generateRequestHmac(hmac, hmacSize, (PBYTE) pSignedStr,
+    CHK_STATUS(generateRequestHmac(signingKey, signingKeyLen, (PBYTE) signedStr,
                                    signedStrLen * SIZEOF(CHAR),
                                    hmac, &hmacSize));
 
@@ -103,7 +89,7 @@ STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, B
         curSize = SNPRINTF(pScratchBuf, scratchLen, AUTH_HEADER_TEMPLATE,
                            AWS_SIG_V4_ALGORITHM, pRequestInfo->pAwsCredentials->accessKeyIdLen,
                            pRequestInfo->pAwsCredentials->accessKeyId,
-                           pCredentialScope, signedHeadersLen, pSignedHeaders, hexHmac);
+                           credentialScope, signedHeadersLen, pSignedHeaders, hexHmac);
     } else {
         // Create the signature query param
         curSize = SNPRINTF(pScratchBuf, scratchLen, SIGNATURE_PARAM_TEMPLATE, hexHmac);
@@ -116,16 +102,178 @@ STATUS generateAwsSigV4Signature(PRequestInfo pRequestInfo, PCHAR dateTimeStr, B
 
 CleanUp:
 
-    SAFE_MEMFREE(pCredentialScope);
-    SAFE_MEMFREE(pUrlEncodedCredentials);
-    SAFE_MEMFREE(pSignedStr);
-    SAFE_MEMFREE(pSignedHeaders);
+    if (STATUS_FAILED(retStatus)) {
+        SAFE_MEMFREE(pScratchBuf);
+    }
+
+    MEMSET(signingKey, 0x00, SIZEOF(signingKey));
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS getSigningKey(PRequestInfo pRequestInfo, PSigningKeyCache pSigningKeyCache, PCHAR dateTimeStr, PBYTE pSigningKey,
+                     PUINT32 pSigningKeyLen)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PAwsCredentials pAwsCredentials;
+    PSigningKeyCacheEntry pEntry;
+    BYTE secretKeyHash[SHA256_DIGEST_LENGTH];
+    BYTE keyBuf[MAX_SECRET_KEY_LEN + 4];
+    UINT32 i, curSize, hmacSize = 0;
+    BOOL locked = FALSE, found = FALSE;
+
+    CHK(pRequestInfo != NULL && pRequestInfo->pAwsCredentials != NULL && dateTimeStr != NULL &&
+        pSigningKey != NULL && pSigningKeyLen != NULL, STATUS_NULL_ARG);
+    pAwsCredentials = pRequestInfo->pAwsCredentials;
+    CHK(pAwsCredentials->accessKeyIdLen <= MAX_ACCESS_KEY_LEN && pAwsCredentials->secretKeyLen <= MAX_SECRET_KEY_LEN,
+        STATUS_INVALID_ARG);
+
+    if (pSigningKeyCache != NULL) {
+        // Identify the secret by its hash so the secret itself is not retained
+        KVS_SHA256((PBYTE) pAwsCredentials->secretKey, pAwsCredentials->secretKeyLen, secretKeyHash);
+
+        MUTEX_LOCK(pSigningKeyCache->lock);
+        locked = TRUE;
+
+        for (i = 0; !found && i < SIGNING_KEY_CACHE_ENTRY_COUNT; i++) {
+            pEntry = &pSigningKeyCache->entries[i];
+            if (pEntry->valid &&
+                0 == MEMCMP(pEntry->date, dateTimeStr, SIGNATURE_DATE_STRING_LEN * SIZEOF(CHAR)) &&
+                0 == STRCMP(pEntry->region, pRequestInfo->region) &&
+                0 == MEMCMP(pEntry->secretKeyHash, secretKeyHash, SIZEOF(secretKeyHash)) &&
+                0 == STRNCMP(pEntry->accessKeyId, pAwsCredentials->accessKeyId, pAwsCredentials->accessKeyIdLen) &&
+                pEntry->accessKeyId[pAwsCredentials->accessKeyIdLen] == '\0') {
+                MEMCPY(pSigningKey, pEntry->signingKey, pEntry->signingKeyLen);
+                hmacSize = pEntry->signingKeyLen;
+                found = TRUE;
+            }
+        }
+
+        MUTEX_UNLOCK(pSigningKeyCache->lock);
+        locked = FALSE;
+
+        CHK(!found, retStatus);
+    }
+
+    // Derive the key from the secret
+    curSize = (UINT32) STRLEN(AWS_SIG_V4_SIGNATURE_START);
+    MEMCPY(keyBuf, AWS_SIG_V4_SIGNATURE_START, curSize);
+    MEMCPY(keyBuf + curSize, pAwsCredentials->secretKey, pAwsCredentials->secretKeyLen);
+    curSize += pAwsCredentials->secretKeyLen;
+
+    hmacSize = KVS_MAX_HMAC_SIZE;
+    CHK_STATUS(generateRequestHmac(keyBuf, curSize, (PBYTE) dateTimeStr,
+                                   SIGNATURE_DATE_STRING_LEN * SIZEOF(CHAR),
+                                   pSigningKey, &hmacSize));
+    CHK_STATUS(generateRequestHmac(pSigningKey, hmacSize, (PBYTE) pRequestInfo->region,
+                                   (UINT32) STRLEN(pRequestInfo->region),
+                                   pSigningKey, &hmacSize));
+    CHK_STATUS(generateRequestHmac(pSigningKey, hmacSize, (PBYTE) KINESIS_VIDEO_SERVICE_NAME,
+                                   (UINT32) STRLEN(KINESIS_VIDEO_SERVICE_NAME),
+                                   pSigningKey, &hmacSize));
+    CHK_STATUS(generateRequestHmac(pSigningKey, hmacSize, (PBYTE) AWS_SIG_V4_SIGNATURE_END,
+                                   (UINT32) STRLEN(AWS_SIG_V4_SIGNATURE_END),
+                                   pSigningKey, &hmacSize));
+
+    if (pSigningKeyCache != NULL) {
+        MUTEX_LOCK(pSigningKeyCache->lock);
+        locked = TRUE;
+
+        // Replace the entries round-robin. The number of the distinct keys in use is expected to be small.
+        pEntry = &pSigningKeyCache->entries[pSigningKeyCache->nextEntryIndex];
+        pSigningKeyCache->nextEntryIndex = (pSigningKeyCache->nextEntryIndex + 1) % SIGNING_KEY_CACHE_ENTRY_COUNT;
+
+        MEMCPY(pEntry->accessKeyId, pAwsCredentials->accessKeyId, pAwsCredentials->accessKeyIdLen);
+        pEntry->accessKeyId[pAwsCredentials->accessKeyIdLen] = '\0';
+        MEMCPY(pEntry->secretKeyHash, secretKeyHash, SIZEOF(secretKeyHash));
+        MEMCPY(pEntry->date, dateTimeStr, SIGNATURE_DATE_STRING_LEN * SIZEOF(CHAR));
+        pEntry->date[SIGNATURE_DATE_STRING_LEN] = '\0';
+        STRNCPY(pEntry->region, pRequestInfo->region, MAX_REGION_NAME_LEN);
+        pEntry->region[MAX_REGION_NAME_LEN] = '\0';
+        MEMCPY(pEntry->signingKey, pSigningKey, hmacSize);
+        pEntry->signingKeyLen = hmacSize;
+        pEntry->valid = TRUE;
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pSigningKeyCache->lock);
+    }
+
+    MEMSET(keyBuf, 0x00, SIZEOF(keyBuf));
+
+    if (pSigningKeyLen != NULL) {
+        *pSigningKeyLen = hmacSize;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS createSigningKeyCache(PSigningKeyCache* ppSigningKeyCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PSigningKeyCache pSigningKeyCache = NULL;
+
+    CHK(ppSigningKeyCache != NULL, STATUS_NULL_ARG);
+
+    CHK(NULL != (pSigningKeyCache = (PSigningKeyCache) MEMCALLOC(1, SIZEOF(SigningKeyCache))), STATUS_NOT_ENOUGH_MEMORY);
+    pSigningKeyCache->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pSigningKeyCache->lock), STATUS_INVALID_OPERATION);
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        freeSigningKeyCache(&pSigningKeyCache);
+    }
+
+    if (ppSigningKeyCache != NULL) {
+        *ppSigningKeyCache = pSigningKeyCache;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS freeSigningKeyCache(PSigningKeyCache* ppSigningKeyCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PSigningKeyCache pSigningKeyCache = NULL;
+
+    CHK(ppSigningKeyCache != NULL, STATUS_NULL_ARG);
+
+    pSigningKeyCache = *ppSigningKeyCache;
+
+    // Call is idempotent
+    CHK(pSigningKeyCache != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pSigningKeyCache->lock)) {
+        MUTEX_FREE(pSigningKeyCache->lock);
+    }
+
+    // Wipe the derived keys
+    MEMSET(pSigningKeyCache, 0x00, SIZEOF(SigningKeyCache));
+    MEMFREE(pSigningKeyCache);
+
+    *ppSigningKeyCache = NULL;
+
+CleanUp:
 
     LEAVES();
     return retStatus;
 }
 
 STATUS signAwsRequestInfo(PRequestInfo pRequestInfo)
+{
+    return signAwsRequestInfoWithSigningKeyCache(pRequestInfo, NULL);
+}
+
+STATUS signAwsRequestInfoWithSigningKeyCache(PRequestInfo pRequestInfo, PSigningKeyCache pSigningKeyCache)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
@@ -154,7 +302,7 @@ STATUS signAwsRequestInfo(PRequestInfo pRequestInfo)
     }
 
     // Generate the signature
-    CHK_STATUS(generateAwsSigV4Signature(pRequestInfo, dateTimeStr, TRUE, &pSignatureInfo, &len));
+    CHK_STATUS(generateAwsSigV4Signature(pRequestInfo, pSigningKeyCache, dateTimeStr, TRUE, &pSignatureInfo, &len));
 
     // Set the header
     CHK_STATUS(setRequestHeader(pRequestInfo, AWS_SIG_V4_HEADER_AUTH, 0, pSignatureInfo, len));
@@ -254,7 +402,7 @@ STATUS signAwsRequestInfoQueryParam(PRequestInfo pRequestInfo)
     SAFE_MEMFREE(pQueryParams);
 
     // Generate the signature
-    CHK_STATUS(generateAwsSigV4Signature(pRequestInfo, dateTimeStr, FALSE, &pSignatureInfo, &len));
+    CHK_STATUS(generateAwsSigV4Signature(pRequestInfo, NULL, dateTimeStr, FALSE, &pSignatureInfo, &len));
 
     // Add the auth param
     STRNCAT(pRequestInfo->url, pSignatureInfo, remaining);
@@ -448,7 +596,7 @@ STATUS generateCanonicalRequestString(PRequestInfo pRequestInfo, PCHAR pRequestS
 
     CHK(pRequestInfo != NULL && pRequestLen != NULL, STATUS_NULL_ARG);
 
-    CHK_STATUS(singleListGetNodeCount(pRequestInfo->pRequestHeaders, &itemCount));
+    itemCount = pRequestInfo->requestHeaderCount;
 
     // Calculate the rough max size first including the new lines and hex of the 256 bit hash (2 * 32)
     //    CanonicalRequest =
@@ -555,10 +703,8 @@ STATUS generateCanonicalHeaders(PRequestInfo pRequestInfo, PCHAR pCanonicalHeade
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT32 overallLen = 0, valueLen, specifiedLen;
-    PSingleListNode pCurNode;
+    UINT32 overallLen = 0, valueLen, specifiedLen, i;
     PRequestHeader pRequestHeader;
-    UINT64 item;
     PCHAR pStart, pEnd;
     PCHAR pCurPtr = pCanonicalHeaders;
 
@@ -566,12 +712,9 @@ STATUS generateCanonicalHeaders(PRequestInfo pRequestInfo, PCHAR pCanonicalHeade
 
     specifiedLen = *pCanonicalHeadersLen;
 
-    CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-
     // Iterate through the headers
-    while (pCurNode != NULL) {
-        CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-        pRequestHeader = (PRequestHeader) item;
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        pRequestHeader = &pRequestInfo->pRequestHeaders[i];
 
         // Process only if we have a canonical header name
         if (IS_CANONICAL_HEADER_NAME(pRequestHeader->pName)) {
@@ -600,9 +743,6 @@ STATUS generateCanonicalHeaders(PRequestInfo pRequestInfo, PCHAR pCanonicalHeade
                 *pCurPtr++ = '\n';
             }
         }
-
-        // Iterate
-        CHK_STATUS(singleListGetNextNode(pCurNode, &pCurNode));
     }
 
 CleanUp:
@@ -619,10 +759,8 @@ STATUS generateSignedHeaders(PRequestInfo pRequestInfo, PCHAR pSignedHeaders, PU
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT32 overallLen = 0, specifiedLen;
-    PSingleListNode pCurNode;
+    UINT32 overallLen = 0, specifiedLen, i;
     PRequestHeader pRequestHeader;
-    UINT64 item;
     PCHAR pCurPtr = pSignedHeaders;
     BOOL appended = FALSE;
 
@@ -630,12 +768,9 @@ STATUS generateSignedHeaders(PRequestInfo pRequestInfo, PCHAR pSignedHeaders, PU
 
     specifiedLen = *pSignedHeadersLen;
 
-    CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-
     // Iterate through the headers
-    while (pCurNode != NULL) {
-        CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-        pRequestHeader = (PRequestHeader) item;
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        pRequestHeader = &pRequestInfo->pRequestHeaders[i];
 
         // Process only if we have a canonical header name
         if (IS_CANONICAL_HEADER_NAME(pRequestHeader->pName)) {
@@ -663,9 +798,6 @@ STATUS generateSignedHeaders(PRequestInfo pRequestInfo, PCHAR pSignedHeaders, PU
 
             appended = TRUE;
         }
-
-        // Iterate
-        CHK_STATUS(singleListGetNextNode(pCurNode, &pCurNode));
     }
 
 CleanUp:
@@ -1020,6 +1152,8 @@ PCHAR getRequestVerbString(HTTP_REQUEST_VERB verb)
             return HTTP_REQUEST_VERB_GET_STRING;
         case HTTP_REQUEST_VERB_POST:
             return HTTP_REQUEST_VERB_POST_STRING;
+        case HTTP_REQUEST_VERB_HEAD:
+            return HTTP_REQUEST_VERB_HEAD_STRING;
     }
 
     return NULL;
@@ -30,7 +30,16 @@ extern "C" {
 // Scratch buffer extra allocation
 #define SCRATCH_BUFFER_EXTRA                    10000
 
-#define MAX_CREDENTIAL_SCOPE_LEN                asd
+// Max credential scope length - date/region/service/aws4_request
+#define MAX_CREDENTIAL_SCOPE_LEN                (SIGNATURE_DATE_STRING_LEN + 1 + MAX_REGION_NAME_LEN + 1 + \
+                                                SIZEOF(KINESIS_VIDEO_SERVICE_NAME) + SIZEOF("aws4_request"))
+
+// Max string to sign length - algorithm, date/time, credential scope and hex encoded request hash
+#define MAX_SIGNED_STRING_LEN                   (SIZEOF("AWS4-HMAC-SHA256") + SIGNATURE_DATE_TIME_STRING_LEN + \
+                                                MAX_CREDENTIAL_SCOPE_LEN + 2 * SHA256_DIGEST_LENGTH + 3)
+
+// Number of the derived signing keys to keep in the cache
+#define SIGNING_KEY_CACHE_ENTRY_COUNT           8
 
 // Hex encoded signature len
 #define AWS_SIGV4_SIGNATURE_STRING_LEN          (EVP_MAX_MD_SIZE * 2)
@@ -82,6 +91,47 @@ extern "C" {
 
 #define KVS_MAX_HMAC_SIZE                     	64
 
+/**
+ * Derived signing key cache entry
+ */
+typedef struct __SigningKeyCacheEntry SigningKeyCacheEntry;
+struct __SigningKeyCacheEntry {
+    // Whether the entry has been populated
+    BOOL valid;
+
+    // Access key id of the credentials the key is derived from
+    CHAR accessKeyId[MAX_ACCESS_KEY_LEN + 1];
+
+    // SHA256 of the secret key the key is derived from. The secret itself is not retained.
+    BYTE secretKeyHash[SHA256_DIGEST_LENGTH];
+
+    // Date of the signature
+    CHAR date[SIGNATURE_DATE_STRING_LEN + 1];
+
+    // Region of the signature
+    CHAR region[MAX_REGION_NAME_LEN + 1];
+
+    // The derived signing key
+    BYTE signingKey[KVS_MAX_HMAC_SIZE];
+    UINT32 signingKeyLen;
+};
+typedef struct __SigningKeyCacheEntry* PSigningKeyCacheEntry;
+
+/**
+ * Cache of the derived signing keys. The service is not part of the key as it's always the same.
+ */
+typedef struct __SigningKeyCache SigningKeyCache;
+struct __SigningKeyCache {
+    // Lock guarding the entries
+    MUTEX lock;
+
+    // Cached keys
+    SigningKeyCacheEntry entries[SIGNING_KEY_CACHE_ENTRY_COUNT];
+
+    // Index of the entry to be replaced next
+    UINT32 nextEntryIndex;
+};
+
 ////////////////////////////////////////////////////
 // Function definitions
 ////////////////////////////////////////////////////
@@ -89,6 +139,7 @@ extern "C" {
  * Generates AWS SigV4 signature encoded string into the provided buffer.
  *
  * @param - PRequestInfo - IN request info for signing
+ * @param - PSigningKeyCache - IN/OPT - Signing key cache to use
  * @param - PCHAR - IN - Date/time string to use
  * @param - BOOL - IN - Whether to generate auth headers signing info or query auth info
  * @param - PCHAR* - OUT - Newly allocated buffer containing the info. NOTE: Caller should free.
@@ -96,7 +147,21 @@ extern "C" {
  *
  * @return - STATUS code of the execution
  */
-STATUS generateAwsSigV4Signature(PRequestInfo, PCHAR, BOOL, PCHAR*, PUINT32);
+STATUS generateAwsSigV4Signature(PRequestInfo, PSigningKeyCache, PCHAR, BOOL, PCHAR*, PUINT32);
+
+/**
+ * Gets the signing key for the request credentials, region and the date. The key is derived
+ * by the chain of HMACs unless it's been found in the cache.
+ *
+ * @param - PRequestInfo - IN - Request object
+ * @param - PSigningKeyCache - IN/OPT - Signing key cache to use
+ * @param - PCHAR - IN - Date/time string to use
+ * @param - PBYTE - OUT - Buffer of KVS_MAX_HMAC_SIZE bytes to store the key
+ * @param - PUINT32 - OUT - Key length
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS getSigningKey(PRequestInfo, PSigningKeyCache, PCHAR, PBYTE, PUINT32);
 
 /**
  * Generates a canonical request string
@@ -0,0 +1,224 @@
+/**
+ * Kinesis Video Producer background credential refresher
+ */
+#define LOG_CLASS "CredentialRefresher"
+#include "Include_i.h"
+
+STATUS createCredentialRefresher(RefreshCredentialsFunc refreshFn, UINT64 refreshCustomData, GetCurrentTimeFunc getCurrentTimeFn,
+                                 UINT64 customData, UINT64 refreshAheadPeriod, UINT64 expiration,
+                                 PCredentialRefresher* ppCredentialRefresher)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCredentialRefresher pCredentialRefresher = NULL;
+
+    CHK(refreshFn != NULL && getCurrentTimeFn != NULL && ppCredentialRefresher != NULL, STATUS_NULL_ARG);
+
+    pCredentialRefresher = (PCredentialRefresher) MEMCALLOC(1, SIZEOF(CredentialRefresher));
+    CHK(pCredentialRefresher != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pCredentialRefresher->refreshFn = refreshFn;
+    pCredentialRefresher->refreshCustomData = refreshCustomData;
+    pCredentialRefresher->getCurrentTimeFn = getCurrentTimeFn;
+    pCredentialRefresher->customData = customData;
+    pCredentialRefresher->refreshAheadPeriod = refreshAheadPeriod;
+    pCredentialRefresher->threadId = INVALID_TID_VALUE;
+    ATOMIC_STORE_BOOL(&pCredentialRefresher->shutdown, FALSE);
+
+    pCredentialRefresher->nextRefreshTime = credentialRefresherGetNextRefreshTime(pCredentialRefresher,
+                                                                                 getCurrentTimeFn(customData),
+                                                                                 expiration);
+
+    pCredentialRefresher->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pCredentialRefresher->lock), STATUS_INVALID_OPERATION);
+    pCredentialRefresher->cvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pCredentialRefresher->cvar), STATUS_INVALID_OPERATION);
+
+    CHK_STATUS(THREAD_CREATE(&pCredentialRefresher->threadId, credentialRefresherRoutine, (PVOID) pCredentialRefresher));
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCredentialRefresher(&pCredentialRefresher);
+    }
+
+    if (ppCredentialRefresher != NULL) {
+        *ppCredentialRefresher = pCredentialRefresher;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS freeCredentialRefresher(PCredentialRefresher* ppCredentialRefresher)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCredentialRefresher pCredentialRefresher = NULL;
+
+    CHK(ppCredentialRefresher != NULL, STATUS_NULL_ARG);
+
+    pCredentialRefresher = *ppCredentialRefresher;
+
+    // Call is idempotent
+    CHK(pCredentialRefresher != NULL, retStatus);
+
+    // Signal the thread to exit and wait for it
+    if (IS_VALID_TID_VALUE(pCredentialRefresher->threadId)) {
+        MUTEX_LOCK(pCredentialRefresher->lock);
+        ATOMIC_STORE_BOOL(&pCredentialRefresher->shutdown, TRUE);
+        CVAR_SIGNAL(pCredentialRefresher->cvar);
+        MUTEX_UNLOCK(pCredentialRefresher->lock);
+
+        THREAD_JOIN(pCredentialRefresher->threadId, NULL);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pCredentialRefresher->cvar)) {
+        CVAR_FREE(pCredentialRefresher->cvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pCredentialRefresher->lock)) {
+        MUTEX_FREE(pCredentialRefresher->lock);
+    }
+
+    MEMFREE(pCredentialRefresher);
+
+    *ppCredentialRefresher = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS credentialRefresherSwapCredentials(MUTEX lock, PAwsCredentials* ppAwsCredentials, PAwsCredentials pAwsCredentials)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppAwsCredentials != NULL && pAwsCredentials != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(lock);
+    freeAwsCredentials(ppAwsCredentials);
+    *ppAwsCredentials = pAwsCredentials;
+    MUTEX_UNLOCK(lock);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS credentialRefresherCopyCredentials(PAwsCredentials pAwsCredentials, PAwsCredentials* ppCopiedCredentials)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PAwsCredentials pCopiedCredentials = NULL;
+
+    CHK(pAwsCredentials != NULL && ppCopiedCredentials != NULL, STATUS_NULL_ARG);
+
+    // Nothing to do if the copy is up to date. The strings follow the structure
+    pCopiedCredentials = *ppCopiedCredentials;
+    CHK(pCopiedCredentials == NULL ||
+        pCopiedCredentials->size != pAwsCredentials->size ||
+        pCopiedCredentials->expiration != pAwsCredentials->expiration ||
+        0 != MEMCMP(pCopiedCredentials + 1, pAwsCredentials + 1, pAwsCredentials->size - SIZEOF(AwsCredentials)), retStatus);
+
+    pCopiedCredentials = (PAwsCredentials) MEMALLOC(pAwsCredentials->size);
+    CHK(pCopiedCredentials != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    MEMCPY(pCopiedCredentials, pAwsCredentials, pAwsCredentials->size);
+
+    // Point the strings into the copy
+    CHK_STATUS(deserializeAwsCredentials((PBYTE) pCopiedCredentials));
+
+    freeAwsCredentials(ppCopiedCredentials);
+    *ppCopiedCredentials = pCopiedCredentials;
+    pCopiedCredentials = NULL;
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        SAFE_MEMFREE(pCopiedCredentials);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS credentialRefresherFreeCredentials(PCredentialRefresher* ppCredentialRefresher, PAwsCredentials* ppAwsCredentials,
+                                          PAwsCredentials* ppCopiedCredentials)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppAwsCredentials != NULL && ppCopiedCredentials != NULL, STATUS_NULL_ARG);
+
+    // Stop the background refresh first so nothing swaps the credentials while they are freed
+    if (ppCredentialRefresher != NULL) {
+        freeCredentialRefresher(ppCredentialRefresher);
+    }
+
+    freeAwsCredentials(ppAwsCredentials);
+    freeAwsCredentials(ppCopiedCredentials);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+PVOID credentialRefresherRoutine(PVOID args)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCredentialRefresher pCredentialRefresher = (PCredentialRefresher) args;
+    UINT64 currentTime, expiration;
+
+    CHECK(pCredentialRefresher != NULL);
+
+    MUTEX_LOCK(pCredentialRefresher->lock);
+
+    while (!ATOMIC_LOAD_BOOL(&pCredentialRefresher->shutdown)) {
+        currentTime = pCredentialRefresher->getCurrentTimeFn(pCredentialRefresher->customData);
+
+        if (currentTime < pCredentialRefresher->nextRefreshTime) {
+            // Spurious wake-ups and timeouts are handled by re-checking the state
+            CVAR_WAIT(pCredentialRefresher->cvar, pCredentialRefresher->lock,
+                      pCredentialRefresher->nextRefreshTime - currentTime);
+            continue;
+        }
+
+        // Fetch without holding the lock so the shutdown is not blocked by the fetch longer than needed
+        MUTEX_UNLOCK(pCredentialRefresher->lock);
+        retStatus = pCredentialRefresher->refreshFn(pCredentialRefresher->refreshCustomData, &expiration);
+        MUTEX_LOCK(pCredentialRefresher->lock);
+
+        currentTime = pCredentialRefresher->getCurrentTimeFn(pCredentialRefresher->customData);
+        if (STATUS_FAILED(retStatus)) {
+            DLOGW("Background credential refresh failed with 0x%08x. Retrying in %" PRIu64 " seconds", retStatus,
+                  CREDENTIAL_REFRESH_RETRY_INTERVAL / HUNDREDS_OF_NANOS_IN_A_SECOND);
+            pCredentialRefresher->nextRefreshTime = currentTime + CREDENTIAL_REFRESH_RETRY_INTERVAL;
+        } else {
+            pCredentialRefresher->nextRefreshTime = credentialRefresherGetNextRefreshTime(pCredentialRefresher,
+                                                                                         currentTime,
+                                                                                         expiration);
+        }
+    }
+
+    MUTEX_UNLOCK(pCredentialRefresher->lock);
+
+    LEAVES();
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+UINT64 credentialRefresherGetNextRefreshTime(PCredentialRefresher pCredentialRefresher, UINT64 currentTime, UINT64 expiration)
+{
+    UINT64 refreshTime = 0;
+
+    if (expiration > pCredentialRefresher->refreshAheadPeriod) {
+        refreshTime = expiration - pCredentialRefresher->refreshAheadPeriod;
+    }
+
+    // Avoid spinning on the credentials which are already within the refresh period
+    return MAX(refreshTime, currentTime + CREDENTIAL_REFRESH_RETRY_INTERVAL);
+}
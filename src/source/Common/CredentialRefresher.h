@@ -0,0 +1,140 @@
+/*******************************************
+Credential refresher internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CREDENTIAL_REFRESHER_INCLUDE_I__
+#define __KINESIS_VIDEO_CREDENTIAL_REFRESHER_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+* Additional period ahead of the provider grace period the credentials are renewed in the background
+* so the token callbacks never have to block on a fetch
+*/
+#define CREDENTIAL_REFRESH_LEAD_PERIOD                  (30 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+/**
+* Interval to retry a failed background refresh
+*/
+#define CREDENTIAL_REFRESH_RETRY_INTERVAL               (5 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+/**
+* Function performing the refresh. Fetches and stores new credentials and returns their expiration.
+*/
+typedef STATUS (*RefreshCredentialsFunc)(UINT64, PUINT64);
+
+/**
+ * Renews the credentials on a background thread ahead of their expiration
+ */
+typedef struct __CredentialRefresher CredentialRefresher;
+struct __CredentialRefresher {
+    // Refresh functionality and its custom data
+    RefreshCredentialsFunc refreshFn;
+    UINT64 refreshCustomData;
+
+    // Current time functionality and its custom data
+    GetCurrentTimeFunc getCurrentTimeFn;
+    UINT64 customData;
+
+    // Period ahead of the expiration to renew the credentials
+    UINT64 refreshAheadPeriod;
+
+    // Time of the next refresh
+    UINT64 nextRefreshTime;
+
+    // Whether the refresher is being shut down
+    volatile ATOMIC_BOOL shutdown;
+
+    // Lock and condition variable to wait for the next refresh or shutdown
+    MUTEX lock;
+    CVAR cvar;
+
+    // Refresh thread
+    TID threadId;
+};
+typedef struct __CredentialRefresher* PCredentialRefresher;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a credential refresher object and starts the refresh thread
+ *
+ * @param - RefreshCredentialsFunc - IN - Refresh function
+ * @param - UINT64 - IN - Refresh function custom data
+ * @param - GetCurrentTimeFunc - IN - Current time function
+ * @param - UINT64 - IN - Time function custom data
+ * @param - UINT64 - IN - Period ahead of the expiration to renew the credentials
+ * @param - UINT64 - IN - Expiration of the current credentials
+ * @param - PCredentialRefresher* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCredentialRefresher(RefreshCredentialsFunc, UINT64, GetCurrentTimeFunc, UINT64, UINT64, UINT64, PCredentialRefresher*);
+
+/**
+ * Stops the refresh thread and frees the object
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PCredentialRefresher* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCredentialRefresher(PCredentialRefresher*);
+
+/**
+ * Swaps in the renewed credentials under the lock guarding them and frees the previous ones.
+ *
+ * NOTE: The getters hand out the copies made with credentialRefresherCopyCredentials only so the
+ * previous credentials can't be in use by any caller.
+ *
+ * @param - MUTEX - IN - Lock guarding the credentials
+ * @param - PAwsCredentials* - IN/OUT - The current credentials to replace
+ * @param - PAwsCredentials - IN - The renewed credentials to take the ownership of
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS credentialRefresherSwapCredentials(MUTEX, PAwsCredentials*, PAwsCredentials);
+
+/**
+ * Copies the current credentials for the getter to hand out. The copy is only replaced by the getter
+ * so it stays valid for the caller until its next get credentials call no matter how many times the
+ * credentials are renewed in the background meanwhile. The copy is kept if it's still up to date.
+ *
+ * NOTE: Should be called under the lock guarding the credentials.
+ *
+ * @param - PAwsCredentials - IN - The current credentials
+ * @param - PAwsCredentials* - IN/OUT - The copy handed out by the getter
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS credentialRefresherCopyCredentials(PAwsCredentials, PAwsCredentials*);
+
+/**
+ * Stops the background refresh and frees the credentials it has been renewing along with their copy
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PCredentialRefresher* - IN/OUT/OPT - The refresher to stop
+ * @param - PAwsCredentials* - IN/OUT - The current credentials
+ * @param - PAwsCredentials* - IN/OUT - The copy handed out by the getter
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS credentialRefresherFreeCredentials(PCredentialRefresher*, PAwsCredentials*, PAwsCredentials*);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID credentialRefresherRoutine(PVOID);
+UINT64 credentialRefresherGetNextRefreshTime(PCredentialRefresher, UINT64, UINT64);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CREDENTIAL_REFRESHER_INCLUDE_I__ */
@@ -110,19 +110,8 @@ SIZE_T writeCurlResponseCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PV
         return CURL_READFUNC_ABORT;
     }
 
-    // Alloc and copy if needed
-    PCHAR pNewBuffer = pCallInfo->responseData == NULL ?
-                       (PCHAR) MEMALLOC(pCallInfo->responseDataLen + dataSize + SIZEOF(CHAR)) :
-                       (PCHAR) REALLOC(pCallInfo->responseData,
-                                       pCallInfo->responseDataLen + dataSize + SIZEOF(CHAR));
-    if (pNewBuffer != NULL) {
-        // Append the new data
-        MEMCPY((PBYTE)pNewBuffer + pCallInfo->responseDataLen, pBuffer, dataSize);
-
-        pCallInfo->responseData = pNewBuffer;
-        pCallInfo->responseDataLen += (UINT32) dataSize;
-        pCallInfo->responseData[pCallInfo->responseDataLen] = '\0';
-    } else {
+    // Append the new data growing the buffer if needed
+    if (STATUS_FAILED(appendCallInfoResponseData(pCallInfo, (PBYTE) pBuffer, (UINT32) dataSize))) {
         return CURL_READFUNC_ABORT;
     }
 
@@ -134,8 +123,7 @@ STATUS createCurlHeaderList(PRequestInfo pRequestInfo, struct curl_slist** ppHea
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     struct curl_slist* pHeaderList = NULL;
-    PSingleListNode pCurNode;
-    UINT64 item;
+    UINT32 i;
     PCHAR pCurPtr;
     CHAR headerBuffer[MAX_REQUEST_HEADER_STRING_LEN];
     PRequestHeader pRequestHeader;
@@ -143,12 +131,8 @@ STATUS createCurlHeaderList(PRequestInfo pRequestInfo, struct curl_slist** ppHea
     CHK(pRequestInfo != NULL && ppHeaderList != NULL, STATUS_NULL_ARG);
 
     // Add headers using a temporary buffer accounting for the delimiter
-    CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-
-    // Iterate through the headers
-    while (pCurNode != NULL) {
-        CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-        pRequestHeader = (PRequestHeader) item;
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        pRequestHeader = &pRequestInfo->pRequestHeaders[i];
         pCurPtr = headerBuffer;
         MEMCPY(pCurPtr, pRequestHeader->pName, pRequestHeader->nameLen * SIZEOF(CHAR));
         pCurPtr += pRequestHeader->nameLen;
@@ -159,9 +143,6 @@ STATUS createCurlHeaderList(PRequestInfo pRequestInfo, struct curl_slist** ppHea
         *pCurPtr = '\0';
 
         pHeaderList = curl_slist_append(pHeaderList, headerBuffer);
-
-        // Iterate
-        CHK_STATUS(singleListGetNextNode(pCurNode, &pCurNode));
     }
 
     *ppHeaderList = pHeaderList;
@@ -31,6 +31,9 @@ STATUS createFileCredentialProviderWithTime(PCHAR pCredentialsFilepath,
 
     pFileCredentialProvider->credentialProvider.getCredentialsFn = getFileCredentials;
 
+    pFileCredentialProvider->lock = MUTEX_CREATE(TRUE);
+    CHK(IS_VALID_MUTEX_VALUE(pFileCredentialProvider->lock), STATUS_INVALID_OPERATION);
+
     // Store the file path in case we need to access it again
     STRCPY((PCHAR) pFileCredentialProvider->credentialsFilepath, pCredentialsFilepath);
 
@@ -71,7 +74,12 @@ STATUS freeFileCredentialProvider(PAwsCredentialProvider* ppCredentialProvider)
     CHK(pFileCredentialProvider != NULL, retStatus);
 
     // Release the underlying AWS credentials object
-    freeAwsCredentials(&pFileCredentialProvider->pAwsCredentials);
+    credentialRefresherFreeCredentials(&pFileCredentialProvider->pCredentialRefresher, &pFileCredentialProvider->pAwsCredentials,
+                                       &pFileCredentialProvider->pCopiedCredentials);
+
+    if (IS_VALID_MUTEX_VALUE(pFileCredentialProvider->lock)) {
+        MUTEX_FREE(pFileCredentialProvider->lock);
+    }
 
     // Release the object
     MEMFREE(pFileCredentialProvider);
@@ -90,14 +98,78 @@ STATUS getFileCredentials(PAwsCredentialProvider pCredentialProvider, PAwsCreden
     ENTERS();
 
     STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
     PFileCredentialProvider pFileCredentialProvider = (PFileCredentialProvider) pCredentialProvider;
 
     CHK(pFileCredentialProvider != NULL && ppAwsCredentials != NULL, STATUS_NULL_ARG);
 
-    // Fill the credentials
-    CHK_STATUS(readFileCredentials(pFileCredentialProvider));
+    MUTEX_LOCK(pFileCredentialProvider->lock);
+    locked = TRUE;
+
+    if (pFileCredentialProvider->pCredentialRefresher == NULL) {
+        CHK_STATUS(readFileCredentials(pFileCredentialProvider));
+    }
+
+    CHK_STATUS(credentialRefresherCopyCredentials(pFileCredentialProvider->pAwsCredentials, &pFileCredentialProvider->pCopiedCredentials));
+    *ppAwsCredentials = pFileCredentialProvider->pCopiedCredentials;
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pFileCredentialProvider->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS startFileCredentialProviderBackgroundRefresh(PAwsCredentialProvider pCredentialProvider)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    PFileCredentialProvider pFileCredentialProvider = (PFileCredentialProvider) pCredentialProvider;
+
+    CHK(pFileCredentialProvider != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pFileCredentialProvider->lock);
+    locked = TRUE;
+
+    CHK(pFileCredentialProvider->pCredentialRefresher == NULL, STATUS_INVALID_OPERATION);
+    CHK(pFileCredentialProvider->pAwsCredentials != NULL, STATUS_INVALID_OPERATION);
+
+    // Renew ahead of the point the token callbacks would have re-read the file themselves
+    CHK_STATUS(createCredentialRefresher(refreshFileCredentials,
+                                         (UINT64) pFileCredentialProvider,
+                                         pFileCredentialProvider->getCurrentTimeFn,
+                                         pFileCredentialProvider->customData,
+                                         CREDENTIAL_FILE_READ_GRACE_PERIOD + CREDENTIAL_REFRESH_LEAD_PERIOD,
+                                         pFileCredentialProvider->pAwsCredentials->expiration,
+                                         &pFileCredentialProvider->pCredentialRefresher));
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pFileCredentialProvider->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS refreshFileCredentials(UINT64 customData, PUINT64 pExpiration)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PFileCredentialProvider pFileCredentialProvider = (PFileCredentialProvider) customData;
 
-    *ppAwsCredentials = pFileCredentialProvider->pAwsCredentials;
+    CHK(pFileCredentialProvider != NULL && pExpiration != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(loadFileCredentials(pFileCredentialProvider));
+
+    MUTEX_LOCK(pFileCredentialProvider->lock);
+    *pExpiration = pFileCredentialProvider->pAwsCredentials->expiration;
+    MUTEX_UNLOCK(pFileCredentialProvider->lock);
 
 CleanUp:
 
@@ -114,6 +186,34 @@ CleanUp:
  */
 
 STATUS readFileCredentials(PFileCredentialProvider pFileCredentialProvider)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 currentTime;
+
+    CHK(pFileCredentialProvider != NULL && pFileCredentialProvider->credentialsFilepath != NULL, STATUS_NULL_ARG);
+
+    // Refresh the credentials by reading from the credentials file if needed
+    currentTime = pFileCredentialProvider->getCurrentTimeFn(pFileCredentialProvider->customData);
+
+    CHK(pFileCredentialProvider->pAwsCredentials == NULL ||
+        currentTime + CREDENTIAL_FILE_READ_GRACE_PERIOD > pFileCredentialProvider->pAwsCredentials->expiration,
+        retStatus);
+
+    CHK_STATUS(loadFileCredentials(pFileCredentialProvider));
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Unconditionally reads the credential file and swaps in the new AWS credentials object
+ *
+ * @param - PFileCredentialProvider - the PFileCredentialProvider object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS loadFileCredentials(PFileCredentialProvider pFileCredentialProvider)
 {
     STATUS retStatus = STATUS_SUCCESS;
     UINT64 fileLen;
@@ -124,17 +224,12 @@ STATUS readFileCredentials(PFileCredentialProvider pFileCredentialProvider)
     PCHAR expirationStr = NULL, secretKey = NULL;
     UINT32 accessKeyIdLen = 0, secretKeyLen = 0, sessionTokenLen = 0;
     UINT64 expiration, currentTime;
+    PAwsCredentials pAwsCredentials = NULL;
 
     CHK(pFileCredentialProvider != NULL && pFileCredentialProvider->credentialsFilepath != NULL, STATUS_NULL_ARG);
 
-    // Refresh the credentials by reading from the credentials file if needed
     currentTime = pFileCredentialProvider->getCurrentTimeFn(pFileCredentialProvider->customData);
 
-    CHK(pFileCredentialProvider->pAwsCredentials == NULL ||
-        currentTime + CREDENTIAL_FILE_READ_GRACE_PERIOD > pFileCredentialProvider->pAwsCredentials->expiration,
-        retStatus);
-
-
     fp = FOPEN((PCHAR) pFileCredentialProvider->credentialsFilepath, "r");
 
     CHK(fp != NULL, STATUS_OPEN_FILE_FAILED);
@@ -197,11 +292,6 @@ STATUS readFileCredentials(PFileCredentialProvider pFileCredentialProvider)
     CHK(accessKeyIdLen != 0 &&
         secretKeyLen != 0, STATUS_INVALID_AUTH_LEN);
 
-    if (pFileCredentialProvider->pAwsCredentials != NULL) {
-        freeAwsCredentials(&pFileCredentialProvider->pAwsCredentials);
-        pFileCredentialProvider->pAwsCredentials = NULL;
-    }
-
     CHK_STATUS(createAwsCredentials(accessKeyId,
                                     accessKeyIdLen,
                                     secretKey,
@@ -209,10 +299,15 @@ STATUS readFileCredentials(PFileCredentialProvider pFileCredentialProvider)
                                     sessionToken,
                                     sessionTokenLen,
                                     expiration,
-                                    &pFileCredentialProvider->pAwsCredentials));
+                                    &pAwsCredentials));
+
+    CHK_STATUS(credentialRefresherSwapCredentials(pFileCredentialProvider->lock, &pFileCredentialProvider->pAwsCredentials, pAwsCredentials));
+    pAwsCredentials = NULL;
 
 CleanUp:
 
+    freeAwsCredentials(&pAwsCredentials);
+
     if (fp != NULL) {
         FCLOSE(fp);
     }
@@ -27,6 +27,16 @@ struct __FileCredentialProvider {
     // Static Aws Credentials structure with the pointer following the main allocation
     PAwsCredentials pAwsCredentials;
 
+    // Copy of the credentials handed out by the getter. Only replaced by the getter so the callers can keep
+    // using it regardless of the background refresh
+    PAwsCredentials pCopiedCredentials;
+
+    // Lock guarding the credentials
+    MUTEX lock;
+
+    // Optional background refresher. The credentials are only read from the cache if specified.
+    PCredentialRefresher pCredentialRefresher;
+
     // Pointer to credential file path
     PCHAR credentialsFilepath[MAX_PATH_LEN + 1];
 };
@@ -39,6 +49,8 @@ STATUS getFileCredentials(PAwsCredentialProvider, PAwsCredentials*);
 
 // Internal functionality
 STATUS readFileCredentials(PFileCredentialProvider);
+STATUS loadFileCredentials(PFileCredentialProvider);
+STATUS refreshFileCredentials(UINT64, PUINT64);
 
 
 
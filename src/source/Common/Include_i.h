@@ -53,6 +53,7 @@ extern "C" {
 #include "Version.h"
 #include "Auth.h"
 #include "StaticCredentialProvider.h"
+#include "CredentialRefresher.h"
 #include "FileCredentialProvider.h"
 
 #if !(defined(KVS_BUILD_WITH_CURL) || defined(KVS_BUILD_WITH_LWS))
@@ -28,6 +28,9 @@ STATUS createIotCredentialProviderWithTime(PCHAR iotGetCredentialEndpoint,
 
     pIotCredentialProvider->credentialProvider.getCredentialsFn = getIotCredentials;
 
+    pIotCredentialProvider->lock = MUTEX_CREATE(TRUE);
+    CHK(IS_VALID_MUTEX_VALUE(pIotCredentialProvider->lock), STATUS_INVALID_OPERATION);
+
     // Store the time functionality and specify default if NULL
     pIotCredentialProvider->getCurrentTimeFn = (getCurrentTimeFn == NULL) ? kinesisVideoStreamDefaultGetCurrentTime : getCurrentTimeFn;
     pIotCredentialProvider->customData = customData;
@@ -86,7 +89,12 @@ STATUS freeIotCredentialProvider(PAwsCredentialProvider* ppCredentialProvider)
     CHK(pIotCredentialProvider != NULL, retStatus);
 
     // Release the underlying AWS credentials object
-    freeAwsCredentials(&pIotCredentialProvider->pAwsCredentials);
+    credentialRefresherFreeCredentials(&pIotCredentialProvider->pCredentialRefresher, &pIotCredentialProvider->pAwsCredentials,
+                                       &pIotCredentialProvider->pCopiedCredentials);
+
+    if (IS_VALID_MUTEX_VALUE(pIotCredentialProvider->lock)) {
+        MUTEX_FREE(pIotCredentialProvider->lock);
+    }
 
     // Release the object
     MEMFREE(pIotCredentialProvider);
@@ -105,15 +113,79 @@ STATUS getIotCredentials(PAwsCredentialProvider pCredentialProvider, PAwsCredent
     ENTERS();
 
     STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
 
     PIotCredentialProvider pIotCredentialProvider = (PIotCredentialProvider) pCredentialProvider;
 
     CHK(pIotCredentialProvider != NULL && ppAwsCredentials != NULL, STATUS_NULL_ARG);
 
-    // Fill the credentials
-    CHK_STATUS(iotCurlHandler(pIotCredentialProvider));
+    MUTEX_LOCK(pIotCredentialProvider->lock);
+    locked = TRUE;
 
-    *ppAwsCredentials = pIotCredentialProvider->pAwsCredentials;
+    if (pIotCredentialProvider->pCredentialRefresher == NULL) {
+        CHK_STATUS(iotCurlHandler(pIotCredentialProvider));
+    }
+
+    CHK_STATUS(credentialRefresherCopyCredentials(pIotCredentialProvider->pAwsCredentials, &pIotCredentialProvider->pCopiedCredentials));
+    *ppAwsCredentials = pIotCredentialProvider->pCopiedCredentials;
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pIotCredentialProvider->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS startIotCredentialProviderBackgroundRefresh(PAwsCredentialProvider pCredentialProvider)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    PIotCredentialProvider pIotCredentialProvider = (PIotCredentialProvider) pCredentialProvider;
+
+    CHK(pIotCredentialProvider != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pIotCredentialProvider->lock);
+    locked = TRUE;
+
+    CHK(pIotCredentialProvider->pCredentialRefresher == NULL, STATUS_INVALID_OPERATION);
+    CHK(pIotCredentialProvider->pAwsCredentials != NULL, STATUS_INVALID_OPERATION);
+
+    // Renew ahead of the point the token callbacks would have fetched the credentials themselves
+    CHK_STATUS(createCredentialRefresher(refreshIotCredentials,
+                                         (UINT64) pIotCredentialProvider,
+                                         pIotCredentialProvider->getCurrentTimeFn,
+                                         pIotCredentialProvider->customData,
+                                         IOT_CREDENTIAL_FETCH_GRACE_PERIOD + CREDENTIAL_REFRESH_LEAD_PERIOD,
+                                         pIotCredentialProvider->pAwsCredentials->expiration,
+                                         &pIotCredentialProvider->pCredentialRefresher));
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pIotCredentialProvider->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS refreshIotCredentials(UINT64 customData, PUINT64 pExpiration)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PIotCredentialProvider pIotCredentialProvider = (PIotCredentialProvider) customData;
+
+    CHK(pIotCredentialProvider != NULL && pExpiration != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(fetchIotCredentials(pIotCredentialProvider));
+
+    MUTEX_LOCK(pIotCredentialProvider->lock);
+    *pExpiration = pIotCredentialProvider->pAwsCredentials->expiration;
+    MUTEX_UNLOCK(pIotCredentialProvider->lock);
 
 CleanUp:
 
@@ -131,6 +203,7 @@ STATUS parseIotResponse(PIotCredentialProvider pIotCredentialProvider, PCallInfo
     jsmn_parser parser;
     jsmntok_t tokens[MAX_JSON_TOKEN_COUNT];
     PCHAR accessKeyId = NULL, secretKey = NULL, sessionToken = NULL, expirationTimestamp = NULL, pResponseStr = NULL;
+    PAwsCredentials pAwsCredentials = NULL;
     UINT64 expiration, currentTime;
     CHAR expirationTimestampStr[MAX_EXPIRATION_LEN + 1];
 
@@ -178,11 +251,6 @@ STATUS parseIotResponse(PIotCredentialProvider pIotCredentialProvider, PCallInfo
     CHK_STATUS(convertTimestampToEpoch(expirationTimestampStr, currentTime / HUNDREDS_OF_NANOS_IN_A_SECOND, &expiration));
     DLOGD("Iot credential expiration time %" PRIu64, expiration / HUNDREDS_OF_NANOS_IN_A_SECOND);
 
-    if (pIotCredentialProvider->pAwsCredentials != NULL) {
-        freeAwsCredentials(&pIotCredentialProvider->pAwsCredentials);
-        pIotCredentialProvider->pAwsCredentials = NULL;
-    }
-
     // Fix-up the expiration to be no more than max enforced token rotation to avoid extra token rotations
     // as we are caching the returned value which is likely to be an hour but we are enforcing max
     // rotation to be more frequent.
@@ -195,10 +263,15 @@ STATUS parseIotResponse(PIotCredentialProvider pIotCredentialProvider, PCallInfo
                                     sessionToken,
                                     sessionTokenLen,
                                     expiration,
-                                    &pIotCredentialProvider->pAwsCredentials));
+                                    &pAwsCredentials));
+
+    CHK_STATUS(credentialRefresherSwapCredentials(pIotCredentialProvider->lock, &pIotCredentialProvider->pAwsCredentials, pAwsCredentials));
+    pAwsCredentials = NULL;
 
 CleanUp:
 
+    freeAwsCredentials(&pAwsCredentials);
+
     LEAVES();
     return retStatus;
 }
@@ -208,12 +281,6 @@ STATUS iotCurlHandler(PIotCredentialProvider pIotCredentialProvider)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     UINT64 currentTime;
-    UINT32 formatLen = 0;
-    CHAR serviceUrl[MAX_URI_CHAR_LEN + 1];
-    PRequestInfo pRequestInfo = NULL;
-    CallInfo callInfo;
-
-    MEMSET(&callInfo, 0x00, SIZEOF(CallInfo));
 
     // Refresh the credentials
     currentTime = pIotCredentialProvider->getCurrentTimeFn(pIotCredentialProvider->customData);
@@ -222,6 +289,25 @@ STATUS iotCurlHandler(PIotCredentialProvider pIotCredentialProvider)
         currentTime + IOT_CREDENTIAL_FETCH_GRACE_PERIOD > pIotCredentialProvider->pAwsCredentials->expiration,
         retStatus);
 
+    CHK_STATUS(fetchIotCredentials(pIotCredentialProvider));
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS fetchIotCredentials(PIotCredentialProvider pIotCredentialProvider)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 formatLen = 0;
+    CHAR serviceUrl[MAX_URI_CHAR_LEN + 1];
+    PRequestInfo pRequestInfo = NULL;
+    CallInfo callInfo;
+
+    MEMSET(&callInfo, 0x00, SIZEOF(CallInfo));
+
     formatLen = SNPRINTF(serviceUrl, MAX_URI_CHAR_LEN, "%s%s%s%c%s%s", CONTROL_PLANE_URI_PREFIX,
                          pIotCredentialProvider->iotGetCredentialEndpoint,
                          ROLE_ALIASES_PATH,
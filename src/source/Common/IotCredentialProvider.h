@@ -56,6 +56,16 @@ struct __IotCredentialProvider {
     // Static Aws Credentials structure with the pointer following the main allocation
     PAwsCredentials pAwsCredentials;
 
+    // Copy of the credentials handed out by the getter. Only replaced by the getter so the callers can keep
+    // using it regardless of the background refresh
+    PAwsCredentials pCopiedCredentials;
+
+    // Lock guarding the credentials
+    MUTEX lock;
+
+    // Optional background refresher. The credentials are only read from the cache if specified.
+    PCredentialRefresher pCredentialRefresher;
+
     // Service call functionality
     BlockingServiceCallFunc serviceCallFn;
 };
@@ -69,7 +79,9 @@ STATUS getIotCredentials(PAwsCredentialProvider, PAwsCredentials*);
 
 // internal functions
 STATUS iotCurlHandler(PIotCredentialProvider);
+STATUS fetchIotCredentials(PIotCredentialProvider);
 STATUS parseIotResponse(PIotCredentialProvider, PCallInfo);
+STATUS refreshIotCredentials(UINT64, PUINT64);
 
 
 
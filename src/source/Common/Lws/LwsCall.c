@@ -100,9 +100,8 @@ INT32 lwsIotCallbackRoutine(struct lws *wsi, enum lws_callback_reasons reason,
     PBYTE* ppStartPtr;
     PCallInfo pCallInfo;
     PRequestInfo pRequestInfo = NULL;
-    PSingleListNode pCurNode;
-    UINT64 item;
-    UINT32 headerCount;
+    PCHAR pHeaderName;
+    UINT32 i;
     PRequestHeader pRequestHeader;
 
     customData = lws_get_opaque_user_data(wsi);
@@ -156,10 +155,8 @@ INT32 lwsIotCallbackRoutine(struct lws *wsi, enum lws_callback_reasons reason,
             lwsl_hexdump_notice(pDataIn, dataSize);
 
             if (dataSize != 0) {
-                CHK(NULL != (pCallInfo->responseData = (PCHAR) MEMALLOC(dataSize)),
-                    STATUS_NOT_ENOUGH_MEMORY);
-                MEMCPY(pCallInfo->responseData, pDataIn, dataSize);
-                pCallInfo->responseDataLen = (UINT32) dataSize;
+                // The response might be delivered in multiple chunks
+                CHK_STATUS(appendCallInfoResponseData(pCallInfo, (PBYTE) pDataIn, (UINT32) dataSize));
             }
 
             break;
@@ -182,30 +179,26 @@ INT32 lwsIotCallbackRoutine(struct lws *wsi, enum lws_callback_reasons reason,
 
         case LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER:
             DLOGD("Client append handshake header\n");
-            CHK_STATUS(singleListGetNodeCount(pRequestInfo->pRequestHeaders, &headerCount));
             ppStartPtr = (PBYTE*) pDataIn;
             pEndPtr = *ppStartPtr + dataSize - 1;
 
             // Iterate through the headers
-            while (headerCount != 0) {
-                CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-                CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-
-                pRequestHeader = (PRequestHeader) item;
+            for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+                pRequestHeader = &pRequestInfo->pRequestHeaders[i];
+                pHeaderName = pRequestHeader->pName;
 
                 // Append the colon at the end of the name
                 if (pRequestHeader->pName[pRequestHeader->nameLen - 1] != ':') {
                     STRCPY(pBuffer, pRequestHeader->pName);
                     pBuffer[pRequestHeader->nameLen] = ':';
                     pBuffer[pRequestHeader->nameLen + 1] = '\0';
-                    pRequestHeader->pName = pBuffer;
-                    pRequestHeader->nameLen++;
+                    pHeaderName = pBuffer;
                 }
 
-                DLOGV("Appending header - %s %s", pRequestHeader->pName, pRequestHeader->pValue);
+                DLOGV("Appending header - %s %s", pHeaderName, pRequestHeader->pValue);
 
                 status = lws_add_http_header_by_name(wsi,
-                                                     (PBYTE) pRequestHeader->pName,
+                                                     (PBYTE) pHeaderName,
                                                      (PBYTE) pRequestHeader->pValue,
                                                      pRequestHeader->valueLen,
                                                      ppStartPtr,
@@ -214,15 +207,11 @@ INT32 lwsIotCallbackRoutine(struct lws *wsi, enum lws_callback_reasons reason,
                     retValue = 1;
                     CHK(FALSE, retStatus);
                 }
-
-                // Remove the head
-                CHK_STATUS(singleListDeleteHead(pRequestInfo->pRequestHeaders));
-                MEMFREE(pRequestHeader);
-
-                // Decrement to iterate
-                headerCount--;
             }
 
+            // The headers are only appended once
+            CHK_STATUS(removeRequestHeaders(pRequestInfo));
+
             lws_client_http_body_pending(wsi, 1);
             lws_callback_on_writable(wsi);
 
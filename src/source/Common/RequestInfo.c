@@ -59,9 +59,6 @@ STATUS createRequestInfo(PCHAR url, PCHAR body, PCHAR region, PCHAR certPath,
         MEMCPY(pRequestInfo->body, body, bodySize);
     }
 
-    // Create a list of headers
-    CHK_STATUS(singleListCreate(&pRequestInfo->pRequestHeaders));
-
     // Set user agent header
     CHK_STATUS(setRequestHeader(pRequestInfo, (PCHAR) "user-agent", 0, userAgent, 0));
 
@@ -94,12 +91,9 @@ STATUS freeRequestInfo(PRequestInfo* ppRequestInfo)
     // Call is idempotent
     CHK(pRequestInfo != NULL, retStatus);
 
-    // Remove and free the headers
+    // Free the headers which didn't fit into the inline storage
     removeRequestHeaders(pRequestInfo);
 
-    // Free the header list itself
-    singleListFree(pRequestInfo->pRequestHeaders);
-
     // Release the object
     MEMFREE(pRequestInfo);
 
@@ -184,110 +178,168 @@ CleanUp:
 STATUS setRequestHeader(PRequestInfo pRequestInfo, PCHAR headerName, UINT32 headerNameLen, PCHAR headerValue, UINT32 headerValueLen)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    UINT32 count;
-    PSingleListNode pCurNode, pPrevNode = NULL;
-    PRequestHeader pRequestHeader = NULL, pCurrentHeader;
-    UINT64 item;
+    UINT32 nameLen, valueLen, size, capacity, index, low, high;
+    PRequestHeader pRequestHeaders = NULL, pRequestHeader;
+    PCHAR pData = NULL;
 
     CHK(pRequestInfo != NULL && headerName != NULL && headerValue != NULL, STATUS_NULL_ARG);
-    CHK_STATUS(singleListGetNodeCount(pRequestInfo->pRequestHeaders, &count));
-    CHK(count < MAX_REQUEST_HEADER_COUNT, STATUS_MAX_REQUEST_HEADER_COUNT);
-
-    CHK_STATUS(createRequestHeader(headerName, headerNameLen, headerValue, headerValueLen, &pRequestHeader));
-
-    // Iterate through the list and insert in an alpha order
-    CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-    while (pCurNode != NULL) {
-        CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-        pCurrentHeader = (PRequestHeader) item;
-
-        if (STRCMPI(pCurrentHeader->pName, pRequestHeader->pName) > 0) {
-            if (pPrevNode == NULL) {
-                // Insert at the head
-                CHK_STATUS(singleListInsertItemHead(pRequestInfo->pRequestHeaders, (UINT64) pRequestHeader));
-            } else {
-                CHK_STATUS(singleListInsertItemAfter(pRequestInfo->pRequestHeaders, pPrevNode,
-                                                     (UINT64) pRequestHeader));
-            }
+    CHK(pRequestInfo->requestHeaderCount < MAX_REQUEST_HEADER_COUNT, STATUS_MAX_REQUEST_HEADER_COUNT);
 
-            // Early return
-            CHK(FALSE, retStatus);
-        }
+    nameLen = headerNameLen == 0 ? (UINT32) STRLEN(headerName) : headerNameLen;
+    valueLen = headerValueLen == 0 ? (UINT32) STRLEN(headerValue) : headerValueLen;
 
-        pPrevNode = pCurNode;
+    CHK(nameLen > 0 && valueLen > 0, STATUS_INVALID_ARG);
+    CHK(nameLen < MAX_REQUEST_HEADER_NAME_LEN, STATUS_MAX_REQUEST_HEADER_NAME_LEN);
+    CHK(valueLen < MAX_REQUEST_HEADER_VALUE_LEN, STATUS_MAX_REQUEST_HEADER_VALUE_LEN);
 
-        CHK_STATUS(singleListGetNextNode(pCurNode, &pCurNode));
+    // Start with the inline headers
+    if (pRequestInfo->pRequestHeaders == NULL) {
+        pRequestInfo->pRequestHeaders = pRequestInfo->inlineRequestHeaders;
+        pRequestInfo->requestHeaderCapacity = REQUEST_INFO_INLINE_HEADER_COUNT;
     }
 
-    // If not inserted then add to the tail
-    CHK_STATUS(singleListInsertItemTail(pRequestInfo->pRequestHeaders, (UINT64) pRequestHeader));
+    // Move the headers into a larger array once full
+    if (pRequestInfo->requestHeaderCount == pRequestInfo->requestHeaderCapacity) {
+        capacity = MIN(2 * pRequestInfo->requestHeaderCapacity, MAX_REQUEST_HEADER_COUNT);
+        pRequestHeaders = (PRequestHeader) MEMALLOC(capacity * SIZEOF(RequestHeader));
+        CHK(pRequestHeaders != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        MEMCPY(pRequestHeaders, pRequestInfo->pRequestHeaders, pRequestInfo->requestHeaderCount * SIZEOF(RequestHeader));
 
-CleanUp:
+        if (pRequestInfo->pRequestHeaders != pRequestInfo->inlineRequestHeaders) {
+            MEMFREE(pRequestInfo->pRequestHeaders);
+        }
 
-    if (STATUS_FAILED(retStatus) && pRequestHeader != NULL) {
-        MEMFREE(pRequestHeader);
+        pRequestInfo->pRequestHeaders = pRequestHeaders;
+        pRequestInfo->requestHeaderCapacity = capacity;
+        pRequestHeaders = NULL;
     }
 
+    // Copy the name and the value into the inline buffer if they fit
+    size = (nameLen + 1 + valueLen + 1) * SIZEOF(CHAR);
+    if (pRequestInfo->requestHeaderDataLen + size <= REQUEST_INFO_INLINE_HEADER_DATA_SIZE) {
+        pData = pRequestInfo->requestHeaderData + pRequestInfo->requestHeaderDataLen;
+        pRequestInfo->requestHeaderDataLen += size;
+    } else {
+        pData = (PCHAR) MEMALLOC(size);
+        CHK(pData != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    }
+
+    MEMCPY(pData, headerName, nameLen * SIZEOF(CHAR));
+    pData[nameLen] = '\0';
+    MEMCPY(pData + nameLen + 1, headerValue, valueLen * SIZEOF(CHAR));
+    pData[nameLen + 1 + valueLen] = '\0';
+
+    // Binary search for the insertion point after the headers with the same name
+    low = 0;
+    high = pRequestInfo->requestHeaderCount;
+    while (low < high) {
+        index = low + (high - low) / 2;
+        if (STRCMPI(pRequestInfo->pRequestHeaders[index].pName, pData) > 0) {
+            high = index;
+        } else {
+            low = index + 1;
+        }
+    }
+
+    MEMMOVE(&pRequestInfo->pRequestHeaders[low + 1], &pRequestInfo->pRequestHeaders[low],
+            (pRequestInfo->requestHeaderCount - low) * SIZEOF(RequestHeader));
+
+    pRequestHeader = &pRequestInfo->pRequestHeaders[low];
+    pRequestHeader->pName = pData;
+    pRequestHeader->nameLen = nameLen;
+    pRequestHeader->pValue = pData + nameLen + 1;
+    pRequestHeader->valueLen = valueLen;
+    pRequestInfo->requestHeaderCount++;
+
+CleanUp:
+
     return retStatus;
 }
 
 STATUS removeRequestHeader(PRequestInfo pRequestInfo, PCHAR headerName)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    PSingleListNode pCurNode;
-    PRequestHeader pCurrentHeader = NULL;
-    UINT64 item;
+    UINT32 i;
 
     CHK(pRequestInfo != NULL && headerName != NULL, STATUS_NULL_ARG);
 
-    // Iterate through the list and insert in an alpha order
-    CHK_STATUS(singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pCurNode));
-    while (pCurNode != NULL) {
-        CHK_STATUS(singleListGetNodeData(pCurNode, &item));
-        pCurrentHeader = (PRequestHeader) item;
-
-        if (STRCMPI(pCurrentHeader->pName, headerName) == 0) {
-            CHK_STATUS(singleListDeleteNode(pRequestInfo->pRequestHeaders, pCurNode));
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        if (STRCMPI(pRequestInfo->pRequestHeaders[i].pName, headerName) == 0) {
+            freeRequestHeaderData(pRequestInfo, &pRequestInfo->pRequestHeaders[i]);
+            pRequestInfo->requestHeaderCount--;
+            MEMMOVE(&pRequestInfo->pRequestHeaders[i], &pRequestInfo->pRequestHeaders[i + 1],
+                    (pRequestInfo->requestHeaderCount - i) * SIZEOF(RequestHeader));
 
             // Early return
             CHK(FALSE, retStatus);
         }
-
-        CHK_STATUS(singleListGetNextNode(pCurNode, &pCurNode));
     }
 
 CleanUp:
 
-    SAFE_MEMFREE(pCurrentHeader);
-
     return retStatus;
 }
 
 STATUS removeRequestHeaders(PRequestInfo pRequestInfo)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    PSingleListNode pNode;
-    UINT32 itemCount;
-    PRequestHeader pRequestHeader;
+    UINT32 i;
 
     CHK(pRequestInfo != NULL, STATUS_NULL_ARG);
 
-    singleListGetNodeCount(pRequestInfo->pRequestHeaders, &itemCount);
-    while (itemCount-- != 0) {
-        // Remove and delete the data
-        singleListGetHeadNode(pRequestInfo->pRequestHeaders, &pNode);
-        pRequestHeader = (PRequestHeader) pNode->data;
-        SAFE_MEMFREE(pRequestHeader);
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        freeRequestHeaderData(pRequestInfo, &pRequestInfo->pRequestHeaders[i]);
+    }
+
+    if (pRequestInfo->pRequestHeaders != NULL && pRequestInfo->pRequestHeaders != pRequestInfo->inlineRequestHeaders) {
+        MEMFREE(pRequestInfo->pRequestHeaders);
+    }
+
+    pRequestInfo->pRequestHeaders = NULL;
+    pRequestInfo->requestHeaderCount = 0;
+    pRequestInfo->requestHeaderCapacity = 0;
+    pRequestInfo->requestHeaderDataLen = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS getRequestHeaderList(PRequestInfo pRequestInfo, PSingleList* ppHeaderList)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSingleList pHeaderList = NULL;
+    UINT32 i;
+
+    CHK(pRequestInfo != NULL && ppHeaderList != NULL, STATUS_NULL_ARG);
 
-        // Iterate
-        singleListDeleteHead(pRequestInfo->pRequestHeaders);
+    CHK_STATUS(singleListCreate(&pHeaderList));
+    for (i = 0; i < pRequestInfo->requestHeaderCount; i++) {
+        CHK_STATUS(singleListInsertItemTail(pHeaderList, (UINT64) &pRequestInfo->pRequestHeaders[i]));
     }
 
+    *ppHeaderList = pHeaderList;
+    pHeaderList = NULL;
+
 CleanUp:
 
+    if (pHeaderList != NULL) {
+        singleListFree(pHeaderList);
+    }
+
     return retStatus;
 }
 
+VOID freeRequestHeaderData(PRequestInfo pRequestInfo, PRequestHeader pRequestHeader)
+{
+    // Only the names and the values which didn't fit into the inline buffer are allocated.
+    // The inline buffer space of a removed header is reclaimed once all the headers are removed.
+    if (pRequestHeader->pName < pRequestInfo->requestHeaderData ||
+        pRequestHeader->pName >= pRequestInfo->requestHeaderData + REQUEST_INFO_INLINE_HEADER_DATA_SIZE) {
+        MEMFREE(pRequestHeader->pName);
+    }
+}
+
 SERVICE_CALL_RESULT getServiceCallResultFromHttpStatus(UINT32 httpStatus)
 {
     switch (httpStatus) {
@@ -323,6 +375,7 @@ STATUS releaseCallInfo(PCallInfo pCallInfo)
         MEMFREE(pCallInfo->responseData);
         pCallInfo->responseData = NULL;
         pCallInfo->responseDataLen = 0;
+        pCallInfo->responseDataCapacity = 0;
     }
 
     // Free the response headers
@@ -345,4 +398,41 @@ STATUS releaseCallInfo(PCallInfo pCallInfo)
 CleanUp:
 
     return retStatus;
-}
\ No newline at end of file
+}
+
+STATUS appendCallInfoResponseData(PCallInfo pCallInfo, PBYTE pData, UINT32 dataSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 requiredCapacity, newCapacity;
+    PCHAR pNewBuffer;
+
+    CHK(pCallInfo != NULL && (pData != NULL || dataSize == 0), STATUS_NULL_ARG);
+
+    // Account for the NULL terminator
+    requiredCapacity = (UINT64) pCallInfo->responseDataLen + dataSize + SIZEOF(CHAR);
+    CHK(requiredCapacity <= MAX_UINT32, STATUS_INVALID_ARG_LEN);
+
+    if (requiredCapacity > pCallInfo->responseDataCapacity) {
+        newCapacity = MAX((UINT64) pCallInfo->responseDataCapacity * 2, CALL_INFO_MIN_RESPONSE_BUFFER_SIZE);
+        newCapacity = MIN(MAX(newCapacity, requiredCapacity), MAX_UINT32);
+
+        pNewBuffer = pCallInfo->responseData == NULL ?
+                     (PCHAR) MEMALLOC((SIZE_T) newCapacity) :
+                     (PCHAR) REALLOC(pCallInfo->responseData, (SIZE_T) newCapacity);
+        CHK(pNewBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+        pCallInfo->responseData = pNewBuffer;
+        pCallInfo->responseDataCapacity = (UINT32) newCapacity;
+    }
+
+    if (dataSize != 0) {
+        MEMCPY((PBYTE) pCallInfo->responseData + pCallInfo->responseDataLen, pData, dataSize);
+    }
+
+    pCallInfo->responseDataLen += dataSize;
+    pCallInfo->responseData[pCallInfo->responseDataLen] = '\0';
+
+CleanUp:
+
+    return retStatus;
+}
@@ -10,6 +10,14 @@ Request Info internal header
 extern "C" {
 #endif
 
+/**
+ * Frees the name and the value of a request header unless they are stored in the inline buffer of the request info
+ *
+ * @param - PRequestInfo - IN - Request Info object owning the header
+ * @param - PRequestHeader - IN - Header to free the data of
+ */
+VOID freeRequestHeaderData(PRequestInfo, PRequestHeader);
+
 #ifdef  __cplusplus
 }
 #endif
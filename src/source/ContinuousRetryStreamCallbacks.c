@@ -23,13 +23,25 @@ STATUS createContinuousRetryStreamCallbacks(PClientCallbacks pCallbacksProvider,
 
     // Store the back pointer as we will be using the other callbacks
     pContinuousRetryStreamCallbacks->pCallbacksProvider = (PCallbacksProvider) pCallbacksProvider;
+    pContinuousRetryStreamCallbacks->restartLock = INVALID_MUTEX_VALUE;
+    pContinuousRetryStreamCallbacks->restartCvar = INVALID_CVAR_VALUE;
 
     // Create the mapping table
     CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pContinuousRetryStreamCallbacks->pStreamMapping));
 
+    // Create the restart tracking tables
+    CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pContinuousRetryStreamCallbacks->pPendingRestarts));
+    CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pContinuousRetryStreamCallbacks->pActiveRestarts));
+
     // Create the guard locks
     pContinuousRetryStreamCallbacks->mappingLock = pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.createMutexFn(
             pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.customData, TRUE);
+    pContinuousRetryStreamCallbacks->restartLock = pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.createMutexFn(
+            pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pContinuousRetryStreamCallbacks->restartLock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+    pContinuousRetryStreamCallbacks->restartCvar = pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.createConditionVariableFn(
+            pContinuousRetryStreamCallbacks->pCallbacksProvider->clientCallbacks.customData);
+    CHK(IS_VALID_CVAR_VALUE(pContinuousRetryStreamCallbacks->restartCvar), STATUS_INVALID_OPERATION);
 
     // Set callbacks
     pContinuousRetryStreamCallbacks->streamCallbacks.streamConnectionStaleFn = continuousRetryStreamConnectionStaleHandler;
@@ -65,6 +77,7 @@ STATUS freeContinuousRetryStreamCallbacks(PStreamCallbacks* ppStreamCallbacks)
     STATUS retStatus = STATUS_SUCCESS;
     PCallbacksProvider pCallbacksProvider;
     PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = NULL;
+    UINT32 i;
 
     CHK(ppStreamCallbacks != NULL, STATUS_NULL_ARG);
 
@@ -75,6 +88,21 @@ STATUS freeContinuousRetryStreamCallbacks(PStreamCallbacks* ppStreamCallbacks)
 
     pCallbacksProvider = pContinuousRetryStreamCallbacks->pCallbacksProvider;
 
+    // Stop the restart workers. The pending restarts are dropped.
+    if (pContinuousRetryStreamCallbacks->restartLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                        pContinuousRetryStreamCallbacks->restartLock);
+        pContinuousRetryStreamCallbacks->restartShutdown = TRUE;
+        pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                         pContinuousRetryStreamCallbacks->restartCvar);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pContinuousRetryStreamCallbacks->restartLock);
+
+        for (i = 0; i < pContinuousRetryStreamCallbacks->restartWorkerCount; i++) {
+            THREAD_JOIN(pContinuousRetryStreamCallbacks->restartWorkers[i], NULL);
+        }
+    }
+
     // Iterate every item in the mapping table and free
     CHK_STATUS(hashTableIterateEntries(pContinuousRetryStreamCallbacks->pStreamMapping,
                                        (UINT64) pContinuousRetryStreamCallbacks,
@@ -83,12 +111,26 @@ STATUS freeContinuousRetryStreamCallbacks(PStreamCallbacks* ppStreamCallbacks)
     // Free the stream handle mapping table
     hashTableFree(pContinuousRetryStreamCallbacks->pStreamMapping);
 
+    // Free the restart tracking tables
+    hashTableFree(pContinuousRetryStreamCallbacks->pPendingRestarts);
+    hashTableFree(pContinuousRetryStreamCallbacks->pActiveRestarts);
+
     // Free the locks
     if (pContinuousRetryStreamCallbacks->mappingLock != INVALID_MUTEX_VALUE) {
         pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData,
                                                         pContinuousRetryStreamCallbacks->mappingLock);
     }
 
+    if (pContinuousRetryStreamCallbacks->restartLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                        pContinuousRetryStreamCallbacks->restartLock);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pContinuousRetryStreamCallbacks->restartCvar)) {
+        pCallbacksProvider->clientCallbacks.freeConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                    pContinuousRetryStreamCallbacks->restartCvar);
+    }
+
     // Release the object
     MEMFREE(pContinuousRetryStreamCallbacks);
 
@@ -101,6 +143,24 @@ CleanUp:
     return retStatus;
 }
 
+STATUS setContinuousRetryStreamBitrateRecommendationCallback(PStreamCallbacks pStreamCallbacks,
+                                                             StreamBitrateRecommendationFunc bitrateRecommendationFn, UINT64 customData)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) pStreamCallbacks;
+
+    CHK(pContinuousRetryStreamCallbacks != NULL, STATUS_NULL_ARG);
+
+    pContinuousRetryStreamCallbacks->bitrateRecommendationFn = bitrateRecommendationFn;
+    pContinuousRetryStreamCallbacks->bitrateRecommendationCustomData = customData;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS removeMappingEntryCallback(UINT64 customData, PHashEntry pHashEntry)
 {
     ENTERS();
@@ -286,18 +346,16 @@ STATUS continuousRetryStreamErrorReportHandler(UINT64 customData, STREAM_HANDLE
                                                STATUS statusCode)
 {
     UNUSED_PARAM(uploadHandle);
-    UNUSED_PARAM(customData);
     STATUS retStatus = STATUS_SUCCESS;
-    TID threadId;
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) customData;
     DLOGW("Reporting stream error. Errored timecode: %" PRIu64 " Status: 0x%08llx", erroredTimecode, statusCode);
 
     // return success if the sdk can recover from the error
     CHK(!IS_RECOVERABLE_ERROR(statusCode), retStatus);
     CHK(IS_RETRIABLE_ERROR(statusCode), retStatus);
 
-    // Run the reset in a separate thread
-    CHK_STATUS(THREAD_CREATE(&threadId, continuousRetryStreamRestartHandler, (PVOID) streamHandle));
-    CHK_STATUS(THREAD_DETACH(threadId));
+    // Run the reset on the restart workers
+    CHK_STATUS(continuousRetryStreamScheduleRestart(pContinuousRetryStreamCallbacks, streamHandle));
 
 CleanUp:
     return retStatus;
@@ -340,6 +398,7 @@ STATUS continuousRetryStreamShutdownHandler(UINT64 customData, STREAM_HANDLE str
     PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) customData;
 
     if (!restart) {
+        CHK_STATUS(continuousRetryStreamCancelRestart(pContinuousRetryStreamCallbacks, streamHandle));
         CHK_STATUS(freeStreamMapping(pContinuousRetryStreamCallbacks, streamHandle, TRUE));
     }
 
@@ -354,6 +413,7 @@ STATUS continuousRetryStreamClosedHandler(UINT64 customData, STREAM_HANDLE strea
     STATUS retStatus = STATUS_SUCCESS;
     PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) customData;
 
+    CHK_STATUS(continuousRetryStreamCancelRestart(pContinuousRetryStreamCallbacks, streamHandle));
     CHK_STATUS(freeStreamMapping(pContinuousRetryStreamCallbacks, streamHandle, TRUE));
 
 CleanUp:
@@ -361,11 +421,113 @@ CleanUp:
     return retStatus;
 }
 
-PVOID continuousRetryStreamRestartHandler(PVOID args)
+STATUS continuousRetryStreamScheduleRestart(PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks, STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    BOOL locked = FALSE, pending = FALSE;
+    UINT64 dueTime;
+    TID threadId;
+
+    CHK(pContinuousRetryStreamCallbacks != NULL && pContinuousRetryStreamCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pContinuousRetryStreamCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pContinuousRetryStreamCallbacks->restartLock);
+    locked = TRUE;
+
+    CHK(!pContinuousRetryStreamCallbacks->restartShutdown, retStatus);
+
+    // Coalesce with the restart which has not been executed yet
+    CHK_STATUS(hashTableContains(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) streamHandle, &pending));
+    if (pending) {
+        DLOGD("Restart of stream handle %" PRIu64 " is already scheduled", streamHandle);
+        CHK(FALSE, retStatus);
+    }
+
+    // Spread the restarts of the streams which have failed at the same time
+    dueTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData) +
+              (UINT64) RAND() % CONTINUOUS_RETRY_RESTART_MAX_JITTER;
+    CHK_STATUS(hashTablePut(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) streamHandle, dueTime));
+
+    // Start another worker only if all of the existing ones are busy
+    if (pContinuousRetryStreamCallbacks->idleRestartWorkerCount == 0 &&
+        pContinuousRetryStreamCallbacks->restartWorkerCount < CONTINUOUS_RETRY_MAX_RESTART_WORKER_COUNT) {
+        CHK_STATUS(THREAD_CREATE(&threadId, continuousRetryStreamRestartWorkerRoutine, (PVOID) pContinuousRetryStreamCallbacks));
+        pContinuousRetryStreamCallbacks->restartWorkers[pContinuousRetryStreamCallbacks->restartWorkerCount++] = threadId;
+    }
+
+    pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                  pContinuousRetryStreamCallbacks->restartCvar);
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pContinuousRetryStreamCallbacks->restartLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS continuousRetryStreamCancelRestart(PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks, STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    BOOL locked = FALSE, pending = FALSE;
+
+    CHK(pContinuousRetryStreamCallbacks != NULL && pContinuousRetryStreamCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pContinuousRetryStreamCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pContinuousRetryStreamCallbacks->restartLock);
+    locked = TRUE;
+
+    // The stream is going away so there is nothing to restart
+    CHK_STATUS(hashTableContains(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) streamHandle, &pending));
+    if (pending) {
+        CHK_STATUS(hashTableRemove(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) streamHandle));
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pContinuousRetryStreamCallbacks->restartLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS continuousRetryStreamNextRestartCallback(UINT64 customData, PHashEntry pHashEntry)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PContinuousRetryNextRestart pNextRestart = (PContinuousRetryNextRestart) customData;
+    BOOL active = FALSE;
+
+    CHK(pNextRestart != NULL && pHashEntry != NULL, STATUS_INVALID_ARG);
+
+    // Restarts of the same stream are serialized
+    CHK_STATUS(hashTableContains(pNextRestart->pContinuousRetryStreamCallbacks->pActiveRestarts, pHashEntry->key, &active));
+
+    if (!active && (!IS_VALID_STREAM_HANDLE(pNextRestart->streamHandle) || pHashEntry->value < pNextRestart->dueTime)) {
+        pNextRestart->streamHandle = (STREAM_HANDLE) pHashEntry->key;
+        pNextRestart->dueTime = pHashEntry->value;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS continuousRetryStreamRestart(STREAM_HANDLE streamHandle)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    STREAM_HANDLE streamHandle = (STREAM_HANDLE) args;
     PStreamInfo pStreamInfo = NULL;
 
     // do not reset if in offline mode. Let the application handle the retry
@@ -376,5 +538,84 @@ PVOID continuousRetryStreamRestartHandler(PVOID args)
 CleanUp:
 
     LEAVES();
+    return retStatus;
+}
+
+PVOID continuousRetryStreamRestartWorkerRoutine(PVOID args)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) args;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    ContinuousRetryNextRestart nextRestart;
+    UINT64 currentTime, waitTime;
+    BOOL locked = FALSE;
+
+    CHK(pContinuousRetryStreamCallbacks != NULL && pContinuousRetryStreamCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pContinuousRetryStreamCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pContinuousRetryStreamCallbacks->restartLock);
+    locked = TRUE;
+
+    while (!pContinuousRetryStreamCallbacks->restartShutdown) {
+        nextRestart.pContinuousRetryStreamCallbacks = pContinuousRetryStreamCallbacks;
+        nextRestart.streamHandle = INVALID_STREAM_HANDLE_VALUE;
+        nextRestart.dueTime = 0;
+        CHK_STATUS(hashTableIterateEntries(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) &nextRestart,
+                                           continuousRetryStreamNextRestartCallback));
+
+        currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+        if (IS_VALID_STREAM_HANDLE(nextRestart.streamHandle) && nextRestart.dueTime <= currentTime) {
+            CHK_STATUS(hashTableRemove(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) nextRestart.streamHandle));
+            CHK_STATUS(hashTablePut(pContinuousRetryStreamCallbacks->pActiveRestarts, (UINT64) nextRestart.streamHandle,
+                                    (UINT64) nextRestart.streamHandle));
+
+            // Restart without holding the lock so the other streams can be scheduled and restarted in parallel
+            pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                              pContinuousRetryStreamCallbacks->restartLock);
+            locked = FALSE;
+
+            status = continuousRetryStreamRestart(nextRestart.streamHandle);
+            if (STATUS_FAILED(status)) {
+                DLOGW("Failed to restart stream handle %" PRIu64 " with status 0x%08x", nextRestart.streamHandle, status);
+            }
+
+            pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                            pContinuousRetryStreamCallbacks->restartLock);
+            locked = TRUE;
+
+            CHK_STATUS(hashTableRemove(pContinuousRetryStreamCallbacks->pActiveRestarts, (UINT64) nextRestart.streamHandle));
+
+            // Another restart of the same stream might have been scheduled while this one has been executing
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pContinuousRetryStreamCallbacks->restartCvar);
+        } else {
+            // Await for the earliest restart to become due or for a new one to be scheduled
+            waitTime = IS_VALID_STREAM_HANDLE(nextRestart.streamHandle) ? nextRestart.dueTime - currentTime : INFINITE_TIME_VALUE;
+
+            pContinuousRetryStreamCallbacks->idleRestartWorkerCount++;
+            status = pCallbacksProvider->clientCallbacks.waitConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                                  pContinuousRetryStreamCallbacks->restartCvar,
+                                                                                  pContinuousRetryStreamCallbacks->restartLock,
+                                                                                  waitTime);
+            pContinuousRetryStreamCallbacks->idleRestartWorkerCount--;
+            CHK(status == STATUS_SUCCESS || status == STATUS_OPERATION_TIMED_OUT, status);
+        }
+    }
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pContinuousRetryStreamCallbacks->restartLock);
+    }
+
+    LEAVES();
+
+    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
     return (PVOID) (ULONG_PTR) retStatus;
 }
\ No newline at end of file
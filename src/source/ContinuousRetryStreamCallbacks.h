@@ -10,6 +10,12 @@ extern "C" {
 struct __CallbackStateMachine;
 struct __CallbacksProvider;
 
+// Max number of the threads restarting the streams
+#define CONTINUOUS_RETRY_MAX_RESTART_WORKER_COUNT           4
+
+// Max random delay of a stream restart to spread the restarts of the streams failing at the same time
+#define CONTINUOUS_RETRY_RESTART_MAX_JITTER                 (500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
 ////////////////////////////////////////////////////////////////////////
 // Struct definition
 ////////////////////////////////////////////////////////////////////////
@@ -26,9 +32,51 @@ struct __ContinuousRetryStreamCallbacks {
 
     // Streams state machine table stream handle -> callback state machine
     PHashTable pStreamMapping;
+
+    // Lock guarding the restarts
+    MUTEX restartLock;
+
+    // Signaled when a restart is scheduled, completed or on shutdown
+    CVAR restartCvar;
+
+    // Scheduled restarts: stream handle -> time the restart is due. A stream has at most one scheduled restart.
+    PHashTable pPendingRestarts;
+
+    // Restarts being executed: stream handle -> stream handle
+    PHashTable pActiveRestarts;
+
+    // Restart worker threads which are started on demand
+    TID restartWorkers[CONTINUOUS_RETRY_MAX_RESTART_WORKER_COUNT];
+    UINT32 restartWorkerCount;
+
+    // Number of the workers awaiting a restart to become due
+    UINT32 idleRestartWorkerCount;
+
+    // Whether the restart workers should exit
+    BOOL restartShutdown;
+
+    // Application callback receiving the bitrate recommendations on latency pressure
+    StreamBitrateRecommendationFunc bitrateRecommendationFn;
+    UINT64 bitrateRecommendationCustomData;
 };
 typedef struct __ContinuousRetryStreamCallbacks* PContinuousRetryStreamCallbacks;
 
+/**
+ * Context used when looking up the next restart to execute
+ */
+typedef struct __ContinuousRetryNextRestart ContinuousRetryNextRestart;
+struct __ContinuousRetryNextRestart {
+    // Object owning the restarts
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks;
+
+    // Stream with the earliest due restart not being executed. Invalid if none
+    STREAM_HANDLE streamHandle;
+
+    // Time the restart is due
+    UINT64 dueTime;
+};
+typedef struct __ContinuousRetryNextRestart* PContinuousRetryNextRestart;
+
 struct __StreamLatencyStateMachine;
 struct __ConnectionStaleStateMachine;
 
@@ -45,7 +93,11 @@ typedef struct __CallbackStateMachine {
 STATUS removeMappingEntryCallback(UINT64, PHashEntry);
 STATUS freeStreamMapping(PContinuousRetryStreamCallbacks, STREAM_HANDLE, BOOL);
 STATUS getStreamMapping(PContinuousRetryStreamCallbacks, STREAM_HANDLE, PCallbackStateMachine*);
-PVOID continuousRetryStreamRestartHandler(PVOID);
+STATUS continuousRetryStreamScheduleRestart(PContinuousRetryStreamCallbacks, STREAM_HANDLE);
+STATUS continuousRetryStreamCancelRestart(PContinuousRetryStreamCallbacks, STREAM_HANDLE);
+STATUS continuousRetryStreamNextRestartCallback(UINT64, PHashEntry);
+STATUS continuousRetryStreamRestart(STREAM_HANDLE);
+PVOID continuousRetryStreamRestartWorkerRoutine(PVOID);
 
 ////////////////////////////////////////////////////////////////////////
 // Callback function implementations
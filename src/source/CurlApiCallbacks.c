@@ -14,6 +14,8 @@ STATUS createCurlApiCallbacks(PCallbacksProvider pCallbacksProvider, PCHAR regio
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS, status;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    UINT32 i;
+    PCHAR cacheFilePath;
 
     CHK(pCallbacksProvider != NULL && ppCurlApiCallbacks != NULL, STATUS_NULL_ARG);
     CHK(certPath == NULL || STRNLEN(certPath, MAX_PATH_LEN + 1) <= MAX_PATH_LEN, STATUS_INVALID_CERT_PATH_LENGTH);
@@ -50,6 +52,13 @@ STATUS createCurlApiCallbacks(PCallbacksProvider pCallbacksProvider, PCHAR regio
     pCurlApiCallbacks->activeUploadsLock = INVALID_MUTEX_VALUE;
     pCurlApiCallbacks->cachedEndpointsLock = INVALID_MUTEX_VALUE;
     pCurlApiCallbacks->shutdownLock = INVALID_MUTEX_VALUE;
+    pCurlApiCallbacks->streamMetricsLock = INVALID_MUTEX_VALUE;
+    pCurlApiCallbacks->streamUploadOptionsLock = INVALID_MUTEX_VALUE;
+    pCurlApiCallbacks->activeRequestsCvar = INVALID_CVAR_VALUE;
+    pCurlApiCallbacks->activeUploadsCvar = INVALID_CVAR_VALUE;
+    for (i = 0; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT; i++) {
+        pCurlApiCallbacks->uploadsIndex[i].lock = INVALID_MUTEX_VALUE;
+    }
 
     // Store the back pointer as we will be using the other callbacks
     pCurlApiCallbacks->pCallbacksProvider = pCallbacksProvider;
@@ -105,11 +114,24 @@ STATUS createCurlApiCallbacks(PCallbacksProvider pCallbacksProvider, PCHAR regio
     CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pCurlApiCallbacks->pActiveRequests));
     CHK_STATUS(doubleListCreate(&pCurlApiCallbacks->pActiveUploads));
 
+    // Create the active uploads index stripes
+    for (i = 0; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT; i++) {
+        CHK_STATUS(hashTableCreateWithParams(CURL_API_UPLOADS_INDEX_BUCKET_COUNT, CURL_API_UPLOADS_INDEX_BUCKET_LENGTH, &pCurlApiCallbacks->uploadsIndex[i].pUploads));
+        pCurlApiCallbacks->uploadsIndex[i].lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, TRUE);
+        CHK(pCurlApiCallbacks->uploadsIndex[i].lock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
+    }
+
     // Create the hash table for tracking endpoints
     CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pCurlApiCallbacks->pCachedEndpoints));
 
     CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pCurlApiCallbacks->pStreamsShuttingDown));
 
+    // Create the hash table for tracking the stream metrics
+    CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pCurlApiCallbacks->pStreamMetrics));
+
+    // Create the hash table for tracking the stream upload options
+    CHK_STATUS(hashTableCreateWithParams(STREAM_MAPPING_HASH_TABLE_BUCKET_COUNT, STREAM_MAPPING_HASH_TABLE_BUCKET_LENGTH, &pCurlApiCallbacks->pStreamUploadOptions));
+
     // Create the guard locks
     pCurlApiCallbacks->activeUploadsLock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, TRUE);
     CHK(pCurlApiCallbacks->activeUploadsLock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
@@ -119,6 +141,16 @@ STATUS createCurlApiCallbacks(PCallbacksProvider pCallbacksProvider, PCHAR regio
     CHK(pCurlApiCallbacks->cachedEndpointsLock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
     pCurlApiCallbacks->shutdownLock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, TRUE);
     CHK(pCurlApiCallbacks->shutdownLock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
+    pCurlApiCallbacks->streamMetricsLock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pCurlApiCallbacks->streamMetricsLock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
+    pCurlApiCallbacks->streamUploadOptionsLock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pCurlApiCallbacks->streamUploadOptionsLock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
+
+    // Create the completion notifications
+    pCurlApiCallbacks->activeRequestsCvar = pCallbacksProvider->clientCallbacks.createConditionVariableFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK(IS_VALID_CVAR_VALUE(pCurlApiCallbacks->activeRequestsCvar), STATUS_INVALID_OPERATION);
+    pCurlApiCallbacks->activeUploadsCvar = pCallbacksProvider->clientCallbacks.createConditionVariableFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK(IS_VALID_CVAR_VALUE(pCurlApiCallbacks->activeUploadsCvar), STATUS_INVALID_OPERATION);
 
 #if !defined __WINDOWS_BUILD__
     signal(SIGPIPE, SIG_IGN);
@@ -134,6 +166,25 @@ STATUS createCurlApiCallbacks(PCallbacksProvider pCallbacksProvider, PCHAR regio
     // CURL global initialization
     CHK(0 == curl_global_init(CURL_GLOBAL_ALL), STATUS_CURL_LIBRARY_INIT_FAILED);
 
+    // Hold the delayed requests like the retries until they are due
+    CHK_STATUS(createCurlRequestScheduler(pCurlApiCallbacks, &pCurlApiCallbacks->pCurlRequestScheduler));
+
+    // Create the derived signing key cache shared by all of the requests
+    CHK_STATUS(createSigningKeyCache(&pCurlApiCallbacks->pSigningKeyCache));
+
+    // A single writer thread writes out the dumps of all of the streaming sessions
+    if (NULL != GETENV(KVS_DEBUG_DUMP_DATA_FILE_DIR_ENV_VAR)) {
+        CHK_STATUS(createDebugDumpWriter(DEBUG_DUMP_WRITER_MAX_FILE_SIZE, DEBUG_DUMP_WRITER_MAX_FILE_COUNT, &pCurlApiCallbacks->pDebugDumpWriter));
+    }
+
+    // Load the persisted stream descriptions and endpoints so the first start after a restart skips the control plane
+    if (cacheType != API_CALL_CACHE_TYPE_NONE && NULL != (cacheFilePath = GETENV(KVS_API_CALL_CACHE_FILE_PATH_ENV_VAR))) {
+        status = createPersistedEndpointCache(cacheFilePath, &pCurlApiCallbacks->pPersistedEndpointCache);
+        if (STATUS_FAILED(status)) {
+            DLOGW("Failed to create the API call cache with error 0x%08x. Continuing without it.", status);
+        }
+    }
+
     // Not in shutdown
     ATOMIC_STORE_BOOL(&pCurlApiCallbacks->shutdown, FALSE);
 
@@ -190,6 +241,7 @@ STATUS freeCurlApiCallbacks(PCurlApiCallbacks* ppCurlApiCallbacks)
     STATUS retStatus = STATUS_SUCCESS;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider;
+    UINT32 i;
 
     CHK(ppCurlApiCallbacks != NULL, STATUS_NULL_ARG);
 
@@ -205,13 +257,49 @@ STATUS freeCurlApiCallbacks(PCurlApiCallbacks* ppCurlApiCallbacks)
     // Shutdown the CURL API callbacks with minimal wait
     curlApiCallbacksShutdown(pCurlApiCallbacks, CURL_API_CALLBACKS_SHUTDOWN_TIMEOUT);
 
+    // Stop the scheduler first as it dispatches to the network loops. Requests still scheduled are completed
+    freeCurlRequestScheduler(&pCurlApiCallbacks->pCurlRequestScheduler);
+
+    // Stop the network loops which will complete any outstanding requests
+    for (i = 0; i < pCurlApiCallbacks->networkLoopCount; i++) {
+        freeCurlNetworkLoop(&pCurlApiCallbacks->networkLoops[i]);
+    }
+
+    // All of the requests are gone by now so the pooled handles can be released
+    freeCurlHandlePool(&pCurlApiCallbacks->pCurlHandlePool);
+    freeCurlResolverCache(&pCurlApiCallbacks->pCurlResolverCache);
+    freeSigningKeyCache(&pCurlApiCallbacks->pSigningKeyCache);
+    freePersistedEndpointCache(&pCurlApiCallbacks->pPersistedEndpointCache);
+    freeDebugDumpWriter(&pCurlApiCallbacks->pDebugDumpWriter);
+
     // Release the auxiliary structures
     hashTableFree(pCurlApiCallbacks->pActiveRequests);
     doubleListFree(pCurlApiCallbacks->pActiveUploads);
     hashTableFree(pCurlApiCallbacks->pCachedEndpoints);
+    for (i = 0; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT; i++) {
+        hashTableFree(pCurlApiCallbacks->uploadsIndex[i].pUploads);
+
+        if (pCurlApiCallbacks->uploadsIndex[i].lock != INVALID_MUTEX_VALUE) {
+            pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->uploadsIndex[i].lock);
+        }
+    }
+
     hashTableClear(pCurlApiCallbacks->pStreamsShuttingDown);
     hashTableFree(pCurlApiCallbacks->pStreamsShuttingDown);
 
+    // No sessions are referencing the stream metrics anymore
+    if (pCurlApiCallbacks->pStreamMetrics != NULL) {
+        hashTableIterateEntries(pCurlApiCallbacks->pStreamMetrics, (UINT64) pCurlApiCallbacks,
+                                curlApiCallbacksStreamMetricsTableFreeCallback);
+        hashTableFree(pCurlApiCallbacks->pStreamMetrics);
+    }
+
+    if (pCurlApiCallbacks->pStreamUploadOptions != NULL) {
+        hashTableIterateEntries(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) pCurlApiCallbacks,
+                                curlApiCallbacksStreamUploadOptionsTableFreeCallback);
+        hashTableFree(pCurlApiCallbacks->pStreamUploadOptions);
+    }
+
     // Free the locks
     if (pCurlApiCallbacks->activeRequestsLock != INVALID_MUTEX_VALUE) {
         pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
@@ -221,42 +309,489 @@ STATUS freeCurlApiCallbacks(PCurlApiCallbacks* ppCurlApiCallbacks)
         pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
     }
 
-    if (pCurlApiCallbacks->cachedEndpointsLock != INVALID_MUTEX_VALUE) {
-        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->cachedEndpointsLock);
-    }
+    if (pCurlApiCallbacks->cachedEndpointsLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->cachedEndpointsLock);
+    }
+
+    if (pCurlApiCallbacks->shutdownLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->shutdownLock);
+    }
+
+    if (pCurlApiCallbacks->streamMetricsLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    }
+
+    if (pCurlApiCallbacks->streamUploadOptionsLock != INVALID_MUTEX_VALUE) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pCurlApiCallbacks->activeRequestsCvar)) {
+        pCallbacksProvider->clientCallbacks.freeConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsCvar);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pCurlApiCallbacks->activeUploadsCvar)) {
+        pCallbacksProvider->clientCallbacks.freeConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsCvar);
+    }
+
+    // Global release of CURL object
+    curl_global_cleanup();
+
+    // Release the object
+    MEMFREE(pCurlApiCallbacks);
+
+    // Set the pointer to NULL
+    *ppCurlApiCallbacks = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS freeApiCallbacksCurl(PUINT64 customData)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks;
+
+    CHK(customData != NULL, STATUS_NULL_ARG);
+    pCurlApiCallbacks = (PCurlApiCallbacks) *customData;
+    CHK_STATUS(freeCurlApiCallbacks(&pCurlApiCallbacks));
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS getCurlApiCallbacks(PClientCallbacks pClientCallbacks, PCurlApiCallbacks* ppCurlApiCallbacks)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = (PCallbacksProvider) pClientCallbacks;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    UINT32 i;
+
+    CHK(pCallbacksProvider != NULL && ppCurlApiCallbacks != NULL, STATUS_NULL_ARG);
+
+    // Find the curl API callbacks in the chain
+    for (i = 0; i < pCallbacksProvider->apiCallbacksCount && pCurlApiCallbacks == NULL; i++) {
+        if (pCallbacksProvider->pApiCallbacks[i].freeApiCallbacksFn == freeApiCallbacksCurl) {
+            pCurlApiCallbacks = (PCurlApiCallbacks) pCallbacksProvider->pApiCallbacks[i].customData;
+        }
+    }
+
+    CHK(pCurlApiCallbacks != NULL, STATUS_INVALID_ARG);
+
+CleanUp:
+
+    if (ppCurlApiCallbacks != NULL) {
+        *ppCurlApiCallbacks = pCurlApiCallbacks;
+    }
+
+    return retStatus;
+}
+
+STATUS setCurlApiCallbacksNetworkLoopCount(PClientCallbacks pClientCallbacks, UINT32 networkLoopCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    UINT32 i;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK(networkLoopCount <= MAX_CURL_NETWORK_LOOP_COUNT, STATUS_INVALID_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The loops can be set only once
+    CHK(pCurlApiCallbacks->networkLoopCount == 0, STATUS_INVALID_OPERATION);
+
+    for (i = 0; i < networkLoopCount; i++) {
+        CHK_STATUS(createCurlNetworkLoop(pCurlApiCallbacks, &pCurlApiCallbacks->networkLoops[i]));
+    }
+
+    pCurlApiCallbacks->networkLoopCount = networkLoopCount;
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && pCurlApiCallbacks != NULL && pCurlApiCallbacks->networkLoopCount == 0) {
+        for (i = 0; i < networkLoopCount; i++) {
+            freeCurlNetworkLoop(&pCurlApiCallbacks->networkLoops[i]);
+        }
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS setCurlApiCallbacksHandlePoolSize(PClientCallbacks pClientCallbacks, UINT32 maxIdleCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The pool can be set only once as the sessions in flight release their handles to it
+    CHK(pCurlApiCallbacks->pCurlHandlePool == NULL, STATUS_INVALID_OPERATION);
+
+    if (maxIdleCount != 0) {
+        CHK_STATUS(createCurlHandlePool(pCurlApiCallbacks, maxIdleCount, &pCurlApiCallbacks->pCurlHandlePool));
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS setCurlApiCallbacksResolverCache(PClientCallbacks pClientCallbacks, BOOL enable)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The cache can be set only once as the sessions in flight pick up the resolved addresses from it
+    CHK(pCurlApiCallbacks->pCurlResolverCache == NULL, STATUS_INVALID_OPERATION);
+
+    if (enable) {
+        CHK_STATUS(createCurlResolverCache(pCurlApiCallbacks, &pCurlApiCallbacks->pCurlResolverCache));
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS setCurlApiCallbacksHttp2(PClientCallbacks pClientCallbacks, BOOL enable)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // HTTP/2 can be set only once as the requests in flight are pinned to the loops by their host
+    CHK(!pCurlApiCallbacks->http2Configured, STATUS_INVALID_OPERATION);
+
+    pCurlApiCallbacks->http2Enabled = enable;
+    pCurlApiCallbacks->http2Configured = TRUE;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS setCurlApiCallbacksConnectionWarmUp(PClientCallbacks pClientCallbacks, BOOL enable)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The warm up can be set only once
+    CHK(!pCurlApiCallbacks->connectionWarmUpEnabled, STATUS_INVALID_OPERATION);
+
+    // The warmed up connection is only picked up by the putMedia session multiplexed over it on the same network loop
+    CHK(!enable || (pCurlApiCallbacks->networkLoopCount != 0 && pCurlApiCallbacks->http2Enabled), STATUS_INVALID_OPERATION);
+
+    pCurlApiCallbacks->connectionWarmUpEnabled = enable;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS getCurlStreamMetrics(PClientCallbacks pClientCallbacks, STREAM_HANDLE streamHandle, PCurlStreamMetrics pMetrics)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PCurlStreamMetricsTracker pTracker = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pClientCallbacks != NULL && pMetrics != NULL, STATUS_NULL_ARG);
+    CHK(pMetrics->version <= CURL_STREAM_METRICS_CURRENT_VERSION, STATUS_INVALID_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Hold the table lock so the tracker can't be freed by the stream shutdown while taking the snapshot
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    locked = TRUE;
+
+    CHK_STATUS(curlApiCallbacksGetStreamMetricsTracker(pCurlApiCallbacks, streamHandle, FALSE, &pTracker));
+    CHK_STATUS(curlStreamMetricsGetSnapshot(pTracker, pMetrics));
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+// Acquire the stream metrics lock before calling this function!!!
+STATUS curlApiCallbacksGetStreamMetricsTracker(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle,
+                                               BOOL create, PCurlStreamMetricsTracker* ppTracker)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 value = 0;
+    PCurlStreamMetricsTracker pTracker = NULL;
+
+    CHK(pCurlApiCallbacks != NULL && ppTracker != NULL, STATUS_NULL_ARG);
+
+    retStatus = hashTableGet(pCurlApiCallbacks->pStreamMetrics, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_SUCCESS || (retStatus == STATUS_HASH_KEY_NOT_PRESENT && create), retStatus);
+
+    if (retStatus == STATUS_SUCCESS) {
+        pTracker = (PCurlStreamMetricsTracker) value;
+    } else {
+        retStatus = STATUS_SUCCESS;
+        CHK_STATUS(createCurlStreamMetricsTracker(pCurlApiCallbacks->pCallbacksProvider, &pTracker));
+        retStatus = hashTablePut(pCurlApiCallbacks->pStreamMetrics, (UINT64) streamHandle, (UINT64) pTracker);
+        if (STATUS_FAILED(retStatus)) {
+            freeCurlStreamMetricsTracker(&pTracker);
+        }
+
+        CHK_STATUS(retStatus);
+    }
+
+CleanUp:
+
+    if (ppTracker != NULL) {
+        *ppTracker = pTracker;
+    }
+
+    return retStatus;
+}
+
+STATUS curlApiCallbacksFreeStreamMetrics(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle, BOOL removeFromTable)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PCurlStreamMetricsTracker pTracker = NULL;
+    UINT64 value = 0;
+    BOOL locked = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    locked = TRUE;
+
+    retStatus = hashTableGet(pCurlApiCallbacks->pStreamMetrics, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_HASH_KEY_NOT_PRESENT || retStatus == STATUS_SUCCESS, retStatus);
+
+    if (retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
+        // Reset the status if not found
+        retStatus = STATUS_SUCCESS;
+    } else {
+        pTracker = (PCurlStreamMetricsTracker) value;
+
+        if (removeFromTable) {
+            CHK_STATUS(hashTableRemove(pCurlApiCallbacks->pStreamMetrics, (UINT64) streamHandle));
+        }
+
+        CHK_STATUS(freeCurlStreamMetricsTracker(&pTracker));
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    }
+
+    return retStatus;
+}
+
+STATUS curlApiCallbacksStreamMetricsTableFreeCallback(UINT64 customData, PHashEntry pHashEntry)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
+
+    CHK(pCurlApiCallbacks != NULL && pHashEntry != NULL, STATUS_INVALID_ARG);
+
+    // The hash entry key is the stream handle
+    CHK_STATUS(curlApiCallbacksFreeStreamMetrics(pCurlApiCallbacks, (STREAM_HANDLE) pHashEntry->key, FALSE));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS setCurlStreamUploadOptions(PClientCallbacks pClientCallbacks, STREAM_HANDLE streamHandle, PCurlStreamUploadOptions pUploadOptions)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PCurlStreamUploadOptions pStoredOptions = NULL;
+    UINT64 value = 0;
+    BOOL locked = FALSE;
+
+    CHK(pClientCallbacks != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_STREAM_HANDLE(streamHandle), STATUS_INVALID_ARG);
+    CHK(pUploadOptions == NULL || pUploadOptions->version <= CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION, STATUS_INVALID_ARG);
+    CHK(pUploadOptions == NULL || pUploadOptions->uploadBufferSize == 0 ||
+        (pUploadOptions->uploadBufferSize >= CURL_API_MIN_UPLOAD_BUFFER_SIZE && pUploadOptions->uploadBufferSize <= CURL_API_MAX_UPLOAD_BUFFER_SIZE),
+        STATUS_INVALID_ARG);
+    CHK_STATUS(getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // Reverting to the defaults
+    if (pUploadOptions == NULL) {
+        CHK_STATUS(curlApiCallbacksFreeStreamUploadOptions(pCurlApiCallbacks, streamHandle, TRUE));
+        CHK(FALSE, retStatus);
+    }
+
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    locked = TRUE;
+
+    retStatus = hashTableGet(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT, retStatus);
+
+    if (retStatus == STATUS_SUCCESS) {
+        pStoredOptions = (PCurlStreamUploadOptions) value;
+    } else {
+        retStatus = STATUS_SUCCESS;
+        pStoredOptions = (PCurlStreamUploadOptions) MEMALLOC(SIZEOF(CurlStreamUploadOptions));
+        CHK(pStoredOptions != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+        retStatus = hashTablePut(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle, (UINT64) pStoredOptions);
+        if (STATUS_FAILED(retStatus)) {
+            MEMFREE(pStoredOptions);
+        }
+
+        CHK_STATUS(retStatus);
+    }
+
+    *pStoredOptions = *pUploadOptions;
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlApiCallbacksGetStreamUploadOptions(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle,
+                                              PCurlStreamUploadOptions pUploadOptions)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PStreamInfo pStreamInfo = NULL;
+    UINT64 value = 0, avgBandwidth = 0;
+    BOOL locked = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pUploadOptions != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Start with the defaults unless the application has set the options
+    MEMSET(pUploadOptions, 0x00, SIZEOF(CurlStreamUploadOptions));
+    pUploadOptions->version = CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION;
+    pUploadOptions->tcpNoDelay = TRUE;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    locked = TRUE;
+
+    retStatus = hashTableGet(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT, retStatus);
+    if (retStatus == STATUS_SUCCESS) {
+        *pUploadOptions = *((PCurlStreamUploadOptions) value);
+    }
+
+    retStatus = STATUS_SUCCESS;
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    locked = FALSE;
+
+    // Scale the unset upload buffer from the average bandwidth of the stream which is in bytes per second.
+    // NOTE: The socket send buffer is left to the system unless set by the application as setting it
+    // explicitly disables the send buffer autotuning of the kernel.
+    if (pUploadOptions->uploadBufferSize == 0 && STATUS_SUCCEEDED(kinesisVideoStreamGetStreamInfo(streamHandle, &pStreamInfo))) {
+        avgBandwidth = pStreamInfo->streamCaps.avgBandwidthBps;
+    }
+
+    if (pUploadOptions->uploadBufferSize == 0 && avgBandwidth != 0) {
+        pUploadOptions->uploadBufferSize = (UINT32) MAX(CURL_API_MIN_UPLOAD_BUFFER_SIZE,
+                                                        MIN(CURL_API_MAX_UPLOAD_BUFFER_SIZE,
+                                                            avgBandwidth * CURL_API_DEFAULT_UPLOAD_BUFFER_DURATION / HUNDREDS_OF_NANOS_IN_A_SECOND));
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    }
+
+    return retStatus;
+}
+
+STATUS curlApiCallbacksFreeStreamUploadOptions(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle, BOOL removeFromTable)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PCurlStreamUploadOptions pUploadOptions = NULL;
+    UINT64 value = 0;
+    BOOL locked = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    if (pCurlApiCallbacks->shutdownLock != INVALID_MUTEX_VALUE) {
-        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->shutdownLock);
-    }
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    locked = TRUE;
 
-    // Global release of CURL object
-    curl_global_cleanup();
+    retStatus = hashTableGet(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_HASH_KEY_NOT_PRESENT || retStatus == STATUS_SUCCESS, retStatus);
 
-    // Release the object
-    MEMFREE(pCurlApiCallbacks);
+    if (retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
+        // Reset the status if not found
+        retStatus = STATUS_SUCCESS;
+    } else {
+        pUploadOptions = (PCurlStreamUploadOptions) value;
 
-    // Set the pointer to NULL
-    *ppCurlApiCallbacks = NULL;
+        if (removeFromTable) {
+            CHK_STATUS(hashTableRemove(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle));
+        }
+
+        MEMFREE(pUploadOptions);
+    }
 
 CleanUp:
 
-    LEAVES();
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamUploadOptionsLock);
+    }
+
     return retStatus;
 }
 
-STATUS freeApiCallbacksCurl(PUINT64 customData)
+STATUS curlApiCallbacksStreamUploadOptionsTableFreeCallback(UINT64 customData, PHashEntry pHashEntry)
 {
-    ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PCurlApiCallbacks pCurlApiCallbacks;
+    PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
 
-    CHK(customData != NULL, STATUS_NULL_ARG);
-    pCurlApiCallbacks = (PCurlApiCallbacks) *customData;
-    CHK_STATUS(freeCurlApiCallbacks(&pCurlApiCallbacks));
+    CHK(pCurlApiCallbacks != NULL && pHashEntry != NULL, STATUS_INVALID_ARG);
+
+    // The hash entry key is the stream handle
+    CHK_STATUS(curlApiCallbacksFreeStreamUploadOptions(pCurlApiCallbacks, (STREAM_HANDLE) pHashEntry->key, FALSE));
 
 CleanUp:
 
-    LEAVES();
     return retStatus;
 }
 
@@ -270,8 +805,7 @@ STATUS curlApiCallbacksShutdown(PCurlApiCallbacks pCurlApiCallbacks, UINT64 time
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PCallbacksProvider pCallbacksProvider = NULL;
-    BOOL requestsLocked = FALSE, endpointsLocked = FALSE, shutdownLocked = FALSE, hashTableEmpty = FALSE;
-    UINT32 activeUploadCount = 0;
+    BOOL endpointsLocked = FALSE, shutdownLocked = FALSE;
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
@@ -300,19 +834,9 @@ STATUS curlApiCallbacksShutdown(PCurlApiCallbacks pCurlApiCallbacks, UINT64 time
     CHK_STATUS(curlApiCallbacksShutdownActiveUploads(pCurlApiCallbacks, INVALID_STREAM_HANDLE_VALUE,
                                                      INVALID_UPLOAD_HANDLE_VALUE, timeout, FALSE, FALSE));
 
-    do {
-        THREAD_SLEEP(CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL);
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.lockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
-        CHK_STATUS(hashTableIsEmpty(pCurlApiCallbacks->pActiveRequests, &hashTableEmpty));
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
-    } while (!hashTableEmpty);
-
-    do {
-        THREAD_SLEEP(CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL);
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.lockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
-        CHK_STATUS(doubleListGetNodeCount(pCurlApiCallbacks->pActiveUploads, &activeUploadCount));
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
-    } while (activeUploadCount != 0);
+    // Await for all of the requests and uploads to terminate
+    CHK_STATUS(curlApiCallbacksAwaitActiveRequests(pCurlApiCallbacks, INVALID_STREAM_HANDLE_VALUE));
+    CHK_STATUS(curlApiCallbacksAwaitActiveUploads(pCurlApiCallbacks, INVALID_STREAM_HANDLE_VALUE));
 
     pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->cachedEndpointsLock);
     endpointsLocked = TRUE;
@@ -330,12 +854,103 @@ CleanUp:
     }
 
     // Unlock only if previously locked
+    if (endpointsLocked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->cachedEndpointsLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/*
+ * Blocks until there are no active requests for the stream or no active requests at all if the stream handle is invalid.
+ * The requests signal their removal so the call returns as soon as the last one leaves.
+ */
+STATUS curlApiCallbacksAwaitActiveRequests(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    BOOL requestsLocked = FALSE, activeRequestExists = TRUE, hashTableEmpty = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
+    requestsLocked = TRUE;
+
+    while (TRUE) {
+        if (IS_VALID_STREAM_HANDLE(streamHandle)) {
+            CHK_STATUS(hashTableContains(pCurlApiCallbacks->pActiveRequests, streamHandle, &activeRequestExists));
+        } else {
+            CHK_STATUS(hashTableIsEmpty(pCurlApiCallbacks->pActiveRequests, &hashTableEmpty));
+            activeRequestExists = !hashTableEmpty;
+        }
+
+        CHK(activeRequestExists, retStatus);
+
+        // Every removal broadcasts the condition variable with the lock held
+        CHK_STATUS(pCallbacksProvider->clientCallbacks.waitConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                                pCurlApiCallbacks->activeRequestsCvar,
+                                                                                pCurlApiCallbacks->activeRequestsLock,
+                                                                                INFINITE_TIME_VALUE));
+    }
+
+CleanUp:
+
     if (requestsLocked) {
         pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
     }
 
-    if (endpointsLocked) {
-        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->cachedEndpointsLock);
+    LEAVES();
+    return retStatus;
+}
+
+/*
+ * Blocks until there are no active uploads for the stream or no active uploads at all if the stream handle is invalid.
+ * The uploads signal their removal so the call returns as soon as the last one leaves.
+ */
+STATUS curlApiCallbacksAwaitActiveUploads(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    BOOL uploadsLocked = FALSE;
+    UINT32 activeUploadCount;
+    PDoubleListNode pCurNode = NULL;
+    PCurlRequest pCurlRequest;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+    uploadsLocked = TRUE;
+
+    while (TRUE) {
+        activeUploadCount = 0;
+        CHK_STATUS(doubleListGetHeadNode(pCurlApiCallbacks->pActiveUploads, &pCurNode));
+        while (pCurNode != NULL) {
+            pCurlRequest = (PCurlRequest) pCurNode->data;
+            pCurNode = pCurNode->pNext;
+
+            if (!IS_VALID_STREAM_HANDLE(streamHandle) || pCurlRequest->streamHandle == streamHandle) {
+                activeUploadCount++;
+            }
+        }
+
+        CHK(activeUploadCount != 0, retStatus);
+
+        // Every removal broadcasts the condition variable with the lock held
+        CHK_STATUS(pCallbacksProvider->clientCallbacks.waitConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                                pCurlApiCallbacks->activeUploadsCvar,
+                                                                                pCurlApiCallbacks->activeUploadsLock,
+                                                                                INFINITE_TIME_VALUE));
+    }
+
+CleanUp:
+
+    if (uploadsLocked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
     }
 
     LEAVES();
@@ -428,8 +1043,9 @@ STATUS curlApiCallbacksShutdownActiveRequests(PCurlApiCallbacks pCurlApiCallback
 
         // if killThread is true and we have attempted to terminate curl and curl thread is still blocked inside
         // curl call, then kill the thread.
-        if (killThread && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
-            if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl)) {
+        // NOTE: Requests driven by a network loop have no thread of their own to kill
+        if (killThread && pCurlRequest->pNetworkLoop == NULL && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+            if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl) && IS_VALID_TID_VALUE(pCurlRequest->threadId)) {
                 THREAD_CANCEL(pCurlRequest->threadId);
             }
 
@@ -437,18 +1053,28 @@ STATUS curlApiCallbacksShutdownActiveRequests(PCurlApiCallbacks pCurlApiCallback
             // Set the terminating status on the request
             ATOMIC_STORE_BOOL(&pCurlRequest->requestInfo.terminating, TRUE);
 
-            if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl)) {
+            if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl) || pCurlRequest->pNetworkLoop != NULL) {
                 // Terminate the curl request in flight
                 terminateCurlSession(pCurlRequest->pCurlResponse, timeout);
+            } else if (ATOMIC_LOAD_BOOL(&pCurlRequest->scheduled)) {
+                // Have the scheduler hand the request over right away instead of at its call after time
+                curlRequestSchedulerWakeup(pCurlApiCallbacks->pCurlRequestScheduler);
             }
         }
 
         // if fromCurlThread is true then nothing needs to be done since this function is called right before the
         // curl thread terminates.
-        if (fromCurlThread || (killThread && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating))) {
+        // NOTE: Requests still held by the scheduler are owned by it until dispatched as terminated
+        if (fromCurlThread ||
+            (killThread && pCurlRequest->pNetworkLoop == NULL && !ATOMIC_LOAD_BOOL(&pCurlRequest->scheduled) &&
+             ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating))) {
             // if curlApiCallbacksShutdownActiveRequests is being called by curl thread, then free all resources
             // and the curl thread will then exit. Otherwise also free when we explicitly kill the thread.
-            CHK_STATUS(hashTableRemove(pCurlApiCallbacks->pActiveRequests, (UINT64) streamHandle));
+            CHK_STATUS(hashTableRemove(pCurlApiCallbacks->pActiveRequests, hashEntry[i].key));
+
+            // Wake up the stream shutdown awaiting the request completion
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeRequestsCvar);
 
             // Free the request object
             CHK_STATUS(freeCurlRequest(&pCurlRequest));
@@ -563,8 +1189,9 @@ STATUS curlApiCallbacksShutdownActiveUploads(PCurlApiCallbacks pCurlApiCallbacks
         if ((!IS_VALID_STREAM_HANDLE(streamHandle) || pCurlRequest->streamHandle == streamHandle) &&
             (!IS_VALID_UPLOAD_HANDLE(uploadHandle) || uploadHandle == pCurlRequest->uploadHandle)) {
 
-            if (killThread && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
-                if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl)) {
+            // NOTE: Requests driven by a network loop have no thread of their own to kill
+            if (killThread && pCurlRequest->pNetworkLoop == NULL && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+                if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl) && IS_VALID_TID_VALUE(pCurlRequest->threadId)) {
                     THREAD_CANCEL(pCurlRequest->threadId);
                 }
 
@@ -572,17 +1199,30 @@ STATUS curlApiCallbacksShutdownActiveUploads(PCurlApiCallbacks pCurlApiCallbacks
                 // Set the terminating status on the request
                 ATOMIC_STORE_BOOL(&pCurlRequest->requestInfo.terminating, TRUE);
 
-                if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl)) {
+                if (ATOMIC_LOAD_BOOL(&pCurlRequest->blockedInCurl) || pCurlRequest->pNetworkLoop != NULL) {
                     // Terminate the curl request in flight
                     terminateCurlSession(pCurlRequest->pCurlResponse, timeout);
+                } else if (ATOMIC_LOAD_BOOL(&pCurlRequest->scheduled)) {
+                    // Have the scheduler hand the request over right away instead of at its call after time
+                    curlRequestSchedulerWakeup(pCurlApiCallbacks->pCurlRequestScheduler);
                 }
             }
 
-            if (fromCurlThread || (killThread && ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating))) {
+            // NOTE: Requests still held by the scheduler are owned by it until dispatched as terminated
+            if (fromCurlThread ||
+                (killThread && pCurlRequest->pNetworkLoop == NULL && !ATOMIC_LOAD_BOOL(&pCurlRequest->scheduled) &&
+                 ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating))) {
                 // if curlApiCallbacksShutdownActiveUploads is being called by curl thread, then free all resources
                 // and the curl thread will then exit. Otherwise also free when we explicitly kill the thread.
                 CHK_STATUS(doubleListDeleteNode(pCurlApiCallbacks->pActiveUploads, pCurNode));
 
+                // Wake up the stream shutdown awaiting the upload completion
+                pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                                 pCurlApiCallbacks->activeUploadsCvar);
+
+                // Remove from the index which will also wait for any in-flight notification to finish
+                CHK_STATUS(curlApiCallbacksUnindexUpload(pCurlApiCallbacks, pCurlRequest->uploadHandle));
+
                 // Free the request object
                 CHK_STATUS(freeCurlRequest(&pCurlRequest));
             }
@@ -666,6 +1306,150 @@ CleanUp:
     return retStatus;
 }
 
+STATUS curlApiCallbacksStartRequest(PCurlApiCallbacks pCurlApiCallbacks, PCurlRequest pCurlRequest,
+                                    CurlRequestCompletionFunc completionFn)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    UINT64 currentTime;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pCurlRequest != NULL && completionFn != NULL,
+        STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pCurlRequest->completionFn = completionFn;
+
+    // The delayed requests, like the retries backing off, are held by the scheduler until due
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    if (pCurlApiCallbacks->pCurlRequestScheduler != NULL && currentTime < pCurlRequest->requestInfo.callAfter) {
+        CHK_STATUS(curlRequestSchedulerSubmitRequest(pCurlApiCallbacks->pCurlRequestScheduler, pCurlRequest));
+    } else {
+        CHK_STATUS(curlApiCallbacksDispatchRequest(pCurlApiCallbacks, pCurlRequest));
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Hands the request over to the executing transport - either its own thread or one of the network loops
+ */
+STATUS curlApiCallbacksDispatchRequest(PCurlApiCallbacks pCurlApiCallbacks, PCurlRequest pCurlRequest)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    TID threadId = INVALID_TID_VALUE;
+    PCurlNetworkLoop pCurlNetworkLoop = NULL;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlRequest != NULL && pCurlRequest->completionFn != NULL, STATUS_NULL_ARG);
+
+    if (pCurlApiCallbacks->networkLoopCount == 0) {
+        // Start the request/response thread
+        CHK_STATUS(THREAD_CREATE(&threadId, curlRequestThreadHandler, (PVOID) pCurlRequest));
+        CHK_STATUS(THREAD_DETACH(threadId));
+
+        // Set the thread ID in the request
+        pCurlRequest->threadId = threadId;
+    } else {
+        CHK_STATUS(curlApiCallbacksSelectNetworkLoop(pCurlApiCallbacks, pCurlRequest, &pCurlNetworkLoop));
+        CHK_STATUS(curlNetworkLoopSubmitRequest(pCurlNetworkLoop, pCurlRequest));
+    }
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && IS_VALID_TID_VALUE(threadId)) {
+        THREAD_CANCEL(threadId);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Picks the least loaded network loop. With HTTP/2 the requests are pinned to a loop by their host instead
+ * as the connections can only be multiplexed across the transfers of the same multi handle.
+ */
+STATUS curlApiCallbacksSelectNetworkLoop(PCurlApiCallbacks pCurlApiCallbacks, PCurlRequest pCurlRequest, PCurlNetworkLoop* ppCurlNetworkLoop)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlNetworkLoop pCurlNetworkLoop = NULL;
+    PCHAR pHostStart, pHostEnd, pCurPtr;
+    UINT32 i, hash, requestCount, minRequestCount = MAX_UINT32;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlRequest != NULL && ppCurlNetworkLoop != NULL, STATUS_NULL_ARG);
+    CHK(pCurlApiCallbacks->networkLoopCount != 0, STATUS_INVALID_OPERATION);
+
+    if (pCurlApiCallbacks->http2Enabled && STATUS_SUCCEEDED(getRequestHost(pCurlRequest->requestInfo.url, &pHostStart, &pHostEnd))) {
+        // FNV-1a of the host name
+        hash = 2166136261U;
+        for (pCurPtr = pHostStart; pCurPtr < pHostEnd; pCurPtr++) {
+            hash = (hash ^ (UINT8) *pCurPtr) * 16777619U;
+        }
+
+        pCurlNetworkLoop = pCurlApiCallbacks->networkLoops[hash % pCurlApiCallbacks->networkLoopCount];
+    } else {
+        for (i = 0; i < pCurlApiCallbacks->networkLoopCount; i++) {
+            CHK_STATUS(curlNetworkLoopGetRequestCount(pCurlApiCallbacks->networkLoops[i], &requestCount));
+            if (requestCount < minRequestCount) {
+                minRequestCount = requestCount;
+                pCurlNetworkLoop = pCurlApiCallbacks->networkLoops[i];
+            }
+        }
+    }
+
+CleanUp:
+
+    if (ppCurlNetworkLoop != NULL) {
+        *ppCurlNetworkLoop = pCurlNetworkLoop;
+    }
+
+    return retStatus;
+}
+
+PVOID curlRequestThreadHandler(PVOID arg)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlRequest pCurlRequest = (PCurlRequest) arg;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    UINT64 currentTime;
+
+    CHECK(pCurlRequest != NULL &&
+          pCurlRequest->pCurlApiCallbacks != NULL &&
+          pCurlRequest->pCurlApiCallbacks->pCallbacksProvider != NULL &&
+          pCurlRequest->completionFn != NULL);
+    pCallbacksProvider = pCurlRequest->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Acquire and release the startup lock to ensure the startup sequence is clear
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
+
+    // Sign the request
+    CHK_STATUS(signAwsRequestInfoWithSigningKeyCache(&pCurlRequest->requestInfo, pCurlRequest->pCurlApiCallbacks->pSigningKeyCache));
+
+    // The delayed requests are normally held by the scheduler until due. Wait out the remainder otherwise
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    if (currentTime < pCurlRequest->requestInfo.callAfter && !ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - currentTime);
+    }
+
+    // Execute the request
+    CHK_STATUS(curlCallApi(pCurlRequest));
+
+CleanUp:
+
+    // Process the result. NOTE: The request is freed by the completion routine
+    retStatus = pCurlRequest->completionFn(pCurlRequest, retStatus);
+
+    LEAVES();
+
+    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Producer Callbacks function implementations
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -694,11 +1478,7 @@ STATUS shutdownStreamCurl(UINT64 customData, STREAM_HANDLE streamHandle, BOOL re
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    BOOL shutdownLocked = FALSE, activeRequestExists = FALSE, requestLocked = FALSE, uploadsLocked = FALSE, alreadyShutdown = FALSE;
-    UINT32 activeUploadCount = 0;
-    PDoubleListNode pCurNode = NULL;
-    UINT64 data;
-    PCurlRequest pCurlRequest = NULL;
+    BOOL shutdownLocked = FALSE, alreadyShutdown = FALSE;
 
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
 
@@ -732,37 +1512,16 @@ STATUS shutdownStreamCurl(UINT64 customData, STREAM_HANDLE streamHandle, BOOL re
                                                        streamHandle,
                                                        TRUE));
 
-    // at this point all remaining threads should not be blocked and reach termination shortly. Thus spin wait for it
-    // to remove itself from the pActiveRequests hashtable and pActiveUploads list
-    do {
-        THREAD_SLEEP(CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL);
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.lockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
-        requestLocked = TRUE;
-        CHK_STATUS(hashTableContains(pCurlApiCallbacks->pActiveRequests, streamHandle, &activeRequestExists));
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
-        requestLocked = FALSE;
-    } while (activeRequestExists);
-
-    // spin until all active uploads for streamHandle has terminated
-    do {
-        THREAD_SLEEP(CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL);
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.lockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
-        uploadsLocked = TRUE;
+    // at this point all remaining threads should not be blocked and reach termination shortly. Thus wait for them
+    // to remove themselves from the pActiveRequests hashtable and pActiveUploads list
+    CHK_STATUS(curlApiCallbacksAwaitActiveRequests(pCurlApiCallbacks, streamHandle));
+    CHK_STATUS(curlApiCallbacksAwaitActiveUploads(pCurlApiCallbacks, streamHandle));
 
-        activeUploadCount = 0;
-        CHK_STATUS(doubleListGetHeadNode(pCurlApiCallbacks->pActiveUploads, &pCurNode));
-        while(pCurNode != NULL) {
-            CHK_STATUS(doubleListGetNodeData(pCurNode, &data));
-            pCurNode = pCurNode->pNext;
-
-            pCurlRequest = (PCurlRequest) data;
-            if (pCurlRequest->streamHandle == streamHandle) {
-                activeUploadCount++;
-            }
-        }
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
-        uploadsLocked = FALSE;
-    } while (activeUploadCount != 0);
+    // The stream is being freed and no sessions reference its metrics anymore
+    if (!resetStream) {
+        CHK_STATUS(curlApiCallbacksFreeStreamMetrics(pCurlApiCallbacks, streamHandle, TRUE));
+        CHK_STATUS(curlApiCallbacksFreeStreamUploadOptions(pCurlApiCallbacks, streamHandle, TRUE));
+    }
 
     // shutdown completed, remove streamHandle from pStreamsShuttingDown.
     pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.lockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->shutdownLock);
@@ -779,14 +1538,6 @@ CleanUp:
         pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->shutdownLock);
     }
 
-    if (requestLocked) {
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeRequestsLock);
-    }
-
-    if (uploadsLocked) {
-        pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.unlockMutexFn(pCurlApiCallbacks->pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
-    }
-
     LEAVES();
     return retStatus;
 }
@@ -802,13 +1553,16 @@ STATUS dataAvailableCurl(UINT64 customData, STREAM_HANDLE streamHandle, PCHAR st
     PCurlRequest pCurlRequest = NULL;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCallbacksProvider pCallbacksProvider = NULL;
+    PUploadsIndexStripe pStripe = NULL;
     BOOL locked = FALSE;
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Lock for the guards for exclusive access
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+    // Lock the index stripe only so the uploads of the other streams can proceed in parallel.
+    // The request can't be freed while the stripe is locked as it's removed from the index first.
+    pStripe = getUploadsIndexStripe(pCurlApiCallbacks, uploadHandle);
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
     locked = TRUE;
 
     CHK_STATUS(findRequestWithUploadHandle(uploadHandle, pCurlApiCallbacks, &pCurlRequest));
@@ -822,7 +1576,7 @@ STATUS dataAvailableCurl(UINT64 customData, STREAM_HANDLE streamHandle, PCHAR st
 CleanUp:
 
     if (locked) {
-        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
     }
 
     LEAVES();
@@ -857,18 +1611,25 @@ STATUS fragmentAckReceivedCurl(UINT64 customData, STREAM_HANDLE streamHandle, UP
     PCurlRequest pCurlRequest = NULL;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCallbacksProvider pCallbacksProvider = NULL;
+    PUploadsIndexStripe pStripe = NULL;
     BOOL locked = FALSE;
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Lock for the guards for exclusive access
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+    // Lock the index stripe only so the uploads of the other streams can proceed in parallel.
+    // The request can't be freed while the stripe is locked as it's removed from the index first.
+    pStripe = getUploadsIndexStripe(pCurlApiCallbacks, uploadHandle);
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
     locked = TRUE;
 
     CHK_STATUS(findRequestWithUploadHandle(uploadHandle, pCurlApiCallbacks, &pCurlRequest));
     CHK(pCurlRequest != NULL, retStatus);
 
+    if (pCurlRequest->pStreamMetricsTracker != NULL) {
+        curlStreamMetricsAckReceived(pCurlRequest->pStreamMetricsTracker, pFragmentAck);
+    }
+
     // Early return if it's been shutdown
     CHK(!pCurlRequest->pCurlResponse->endOfStream, retStatus);
 
@@ -881,7 +1642,7 @@ STATUS fragmentAckReceivedCurl(UINT64 customData, STREAM_HANDLE streamHandle, UP
 CleanUp:
 
     if (locked) {
-        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
     }
 
     LEAVES();
@@ -935,11 +1696,10 @@ STATUS createStreamCurl(UINT64 customData, PCHAR deviceName, PCHAR streamName, P
     CHAR url[MAX_PATH_LEN + 1];
     UINT64 retentionInHours, currentTime;
     PAwsCredentials pCredentials = NULL;
-    TID threadId = INVALID_TID_VALUE;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlRequest pCurlRequest = NULL;
-    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE;
+    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE, requestAdded = FALSE;
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pServiceCallContext != NULL, STATUS_INVALID_ARG);
@@ -996,20 +1756,21 @@ STATUS createStreamCurl(UINT64 customData, PCHAR deviceName, PCHAR streamName, P
     pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
     startLocked = TRUE;
 
-    // Start the request/response thread
-    CHK_STATUS(THREAD_CREATE(&threadId, createStreamCurlHandler, (PVOID) pCurlRequest));
-    CHK_STATUS(THREAD_DETACH(threadId));
-
-    // Set the thread ID in the request, add to the hash table
-    pCurlRequest->threadId = threadId;
-
+    // Add the request to the active list before starting it as the request might complete right away.
+    // The request will wait on the startup mutex until we are done with the bookkeeping
     CHK_STATUS(hashTablePut(pCurlApiCallbacks->pActiveRequests, streamHandle, (UINT64) pCurlRequest));
+    requestAdded = TRUE;
+
+    // Start the request/response session
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, createStreamCurlCompletion));
 
 CleanUp:
 
     if (STATUS_FAILED(retStatus)) {
-        if (IS_VALID_TID_VALUE(threadId)) {
-            THREAD_CANCEL(threadId);
+        if (requestAdded) {
+            hashTableRemove(pCurlApiCallbacks->pActiveRequests, streamHandle);
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeRequestsCvar);
         }
 
         freeCurlRequest(&pCurlRequest);
@@ -1071,11 +1832,10 @@ CleanUp:
     return retStatus;
 }
 
-PVOID createStreamCurlHandler(PVOID arg)
+STATUS createStreamCurlCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PCurlRequest pCurlRequest = (PCurlRequest) arg;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlResponse pCurlResponse = NULL;
@@ -1097,22 +1857,10 @@ PVOID createStreamCurlHandler(PVOID arg)
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
     streamArn[0] = '\0';
 
-    DLOGD("createStreamCurlHandler response %p", pCurlRequest->pCurlResponse);
-
-    // Acquire and release the startup lock to ensure the startup sequence is clear
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-
-    // Sign the request
-    CHK_STATUS(signAwsRequestInfo(&pCurlRequest->requestInfo));
-
-    // Wait for the specified amount of time before calling the API
-    if (pCurlRequest->requestInfo.currentTime < pCurlRequest->requestInfo.callAfter) {
-        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - pCurlRequest->requestInfo.currentTime);
-    }
+    DLOGD("createStreamCurlCompletion response %p", pCurlRequest->pCurlResponse);
 
-    // Execute the request
-    CHK_STATUS(curlCallApi(pCurlRequest));
+    // Check the result of the request execution
+    CHK_STATUS(callStatus);
     CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
 
     // Set the response object
@@ -1147,6 +1895,10 @@ CleanUp:
 
     CHK_LOG_ERR(retStatus);
 
+    if (STATUS_SUCCEEDED(retStatus) && streamArn[0] != '\0') {
+        CHK_LOG_ERR(curlApiCallbacksCacheStreamArn(pCurlApiCallbacks, pCurlRequest->streamHandle, streamArn));
+    }
+
     // Preserve the values as we need to free the request before the event notification
     if (pCurlRequest->pCurlResponse != NULL) {
         callResult = pCurlRequest->pCurlResponse->callInfo.callResult;
@@ -1171,9 +1923,7 @@ CleanUp:
     }
 
     LEAVES();
-
-    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
-    return (PVOID) (ULONG_PTR) retStatus;
+    return retStatus;
 }
 
 STATUS describeStreamCurl(UINT64 customData, PCHAR streamName, PServiceCallContext pServiceCallContext)
@@ -1183,11 +1933,10 @@ STATUS describeStreamCurl(UINT64 customData, PCHAR streamName, PServiceCallConte
     CHAR paramsJson[MAX_JSON_PARAMETER_STRING_LEN];
     CHAR url[MAX_PATH_LEN + 1];
     PAwsCredentials pCredentials = NULL;
-    TID threadId = INVALID_TID_VALUE;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCurlRequest pCurlRequest = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
-    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE;
+    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE, requestAdded = FALSE;
     UINT64 currentTime;
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
 
@@ -1234,19 +1983,21 @@ STATUS describeStreamCurl(UINT64 customData, PCHAR streamName, PServiceCallConte
     pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
     startLocked = TRUE;
 
-    // Start the request/response thread
-    CHK_STATUS(THREAD_CREATE(&threadId, describeStreamCurlHandler, (PVOID) pCurlRequest));
-    CHK_STATUS(THREAD_DETACH(threadId));
-
-    // Set the thread ID in the request, add to the hash table
-    pCurlRequest->threadId = threadId;
+    // Add the request to the active list before starting it as the request might complete right away.
+    // The request will wait on the startup mutex until we are done with the bookkeeping
     CHK_STATUS(hashTablePut(pCurlApiCallbacks->pActiveRequests, streamHandle, (UINT64) pCurlRequest));
+    requestAdded = TRUE;
+
+    // Start the request/response session
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, describeStreamCurlCompletion));
 
 CleanUp:
 
     if (STATUS_FAILED(retStatus)) {
-        if (IS_VALID_TID_VALUE(threadId)) {
-            THREAD_CANCEL(threadId);
+        if (requestAdded) {
+            hashTableRemove(pCurlApiCallbacks->pActiveRequests, streamHandle);
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeRequestsCvar);
         }
 
         freeCurlRequest(&pCurlRequest);
@@ -1279,6 +2030,8 @@ STATUS describeStreamCachingCurl(UINT64 customData, PCHAR streamName, PServiceCa
     STREAM_HANDLE streamHandle;
     StreamDescription streamDescription;
     PStreamInfo pStreamInfo;
+    PEndpointTracker pEndpointTracker;
+    UINT64 value;
     BOOL emulateApiCall = TRUE;
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pServiceCallContext != NULL, STATUS_INVALID_ARG);
@@ -1286,6 +2039,9 @@ STATUS describeStreamCachingCurl(UINT64 customData, PCHAR streamName, PServiceCa
 
     streamHandle = (STREAM_HANDLE) pServiceCallContext->customData;
 
+    // Seed the endpoint cache from the persisted results of the previous run
+    CHK_LOG_ERR(curlApiCallbacksWarmStartEndpoint(pCurlApiCallbacks, streamHandle, streamName));
+
     // Check whether we need to emulate the call
     CHK_STATUS(checkApiCallEmulation(pCurlApiCallbacks, streamHandle, &emulateApiCall));
 
@@ -1310,6 +2066,18 @@ STATUS describeStreamCachingCurl(UINT64 customData, PCHAR streamName, PServiceCa
     STRNCPY(streamDescription.streamName, streamName, MAX_STREAM_NAME_LEN);
     STRNCPY(streamDescription.streamArn, streamName, MAX_ARN_LEN);
     streamDescription.retention = pStreamInfo->retention;
+
+    // Use the actual stream ARN if the service has returned it before
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pCurlApiCallbacks->cachedEndpointsLock);
+    if (STATUS_SUCCEEDED(hashTableGet(pCurlApiCallbacks->pCachedEndpoints, (UINT64) streamHandle, &value)) &&
+        NULL != (pEndpointTracker = (PEndpointTracker) value) && pEndpointTracker->streamArn[0] != '\0') {
+        STRCPY(streamDescription.streamArn, pEndpointTracker->streamArn);
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                      pCurlApiCallbacks->cachedEndpointsLock);
+
     streamDescription.streamStatus = STREAM_STATUS_ACTIVE;
     streamDescription.creationTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
 
@@ -1324,11 +2092,10 @@ CleanUp:
     return retStatus;
 }
 
-PVOID describeStreamCurlHandler(PVOID arg)
+STATUS describeStreamCurlCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PCurlRequest pCurlRequest = (PCurlRequest) arg;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlResponse pCurlResponse = NULL;
@@ -1350,20 +2117,8 @@ PVOID describeStreamCurlHandler(PVOID arg)
     pCurlApiCallbacks = pCurlRequest->pCurlApiCallbacks;
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Acquire and release the startup lock to ensure the startup sequence is clear
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-
-    // Sign the request
-    CHK_STATUS(signAwsRequestInfo(&pCurlRequest->requestInfo));
-
-    // Wait for the specified amount of time before calling the API
-    if (pCurlRequest->requestInfo.currentTime < pCurlRequest->requestInfo.callAfter) {
-        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - pCurlRequest->requestInfo.currentTime);
-    }
-
-    // Execute the request
-    CHK_STATUS(curlCallApi(pCurlRequest));
+    // Check the result of the request execution
+    CHK_STATUS(callStatus);
     CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
 
     // Set the response object
@@ -1453,6 +2208,11 @@ PVOID describeStreamCurlHandler(PVOID arg)
 
 CleanUp:
 
+    // Remember the stream ARN for the emulated and the persisted describe calls
+    if (STATUS_SUCCEEDED(retStatus) && jsonInStreamDescription && streamDescription.streamArn[0] != '\0') {
+        CHK_LOG_ERR(curlApiCallbacksCacheStreamArn(pCurlApiCallbacks, pCurlRequest->streamHandle, streamDescription.streamArn));
+    }
+
     // Preserve the values as we need to free the request before the event notification
     if (pCurlRequest->pCurlResponse != NULL) {
         callResult = pCurlRequest->pCurlResponse->callInfo.callResult;
@@ -1486,9 +2246,7 @@ CleanUp:
     }
 
     LEAVES();
-
-    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
-    return (PVOID) (ULONG_PTR) retStatus;
+    return retStatus;
 }
 
 STATUS getStreamingEndpointCurl(UINT64 customData, PCHAR streamName, PCHAR apiName,
@@ -1499,11 +2257,10 @@ STATUS getStreamingEndpointCurl(UINT64 customData, PCHAR streamName, PCHAR apiNa
     CHAR paramsJson[MAX_JSON_PARAMETER_STRING_LEN];
     CHAR url[MAX_PATH_LEN + 1];
     PAwsCredentials pCredentials = NULL;
-    TID threadId = INVALID_TID_VALUE;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCurlRequest pCurlRequest = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
-    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE;
+    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE, requestAdded = FALSE;
     UINT64 currentTime;
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
 
@@ -1550,19 +2307,21 @@ STATUS getStreamingEndpointCurl(UINT64 customData, PCHAR streamName, PCHAR apiNa
     shutdownLocked = FALSE;
     CHK(!streamShuttingDown, STATUS_STREAM_BEING_SHUTDOWN);
 
-    // Start the request/response thread
-    CHK_STATUS(THREAD_CREATE(&threadId, getStreamingEndpointCurlHandler, (PVOID) pCurlRequest));
-    CHK_STATUS(THREAD_DETACH(threadId));
-
-    // Set the thread ID in the request, add to the hash table
-    pCurlRequest->threadId = threadId;
+    // Add the request to the active list before starting it as the request might complete right away.
+    // The request will wait on the startup mutex until we are done with the bookkeeping
     CHK_STATUS(hashTablePut(pCurlApiCallbacks->pActiveRequests, streamHandle, (UINT64) pCurlRequest));
+    requestAdded = TRUE;
+
+    // Start the request/response session
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, getStreamingEndpointCurlCompletion));
 
 CleanUp:
 
     if (STATUS_FAILED(retStatus)) {
-        if (IS_VALID_TID_VALUE(threadId)) {
-            THREAD_CANCEL(threadId);
+        if (requestAdded) {
+            hashTableRemove(pCurlApiCallbacks->pActiveRequests, streamHandle);
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeRequestsCvar);
         }
 
         freeCurlRequest(&pCurlRequest);
@@ -1602,6 +2361,9 @@ STATUS getStreamingEndpointCachingCurl(UINT64 customData, PCHAR streamName,
 
     streamHandle = (STREAM_HANDLE) pServiceCallContext->customData;
 
+    // Seed the endpoint cache from the persisted results of the previous run
+    CHK_LOG_ERR(curlApiCallbacksWarmStartEndpoint(pCurlApiCallbacks, streamHandle, streamName));
+
     // We check whether we have already made the call by checking
     // for the presence of the endpoint in the cache.
     switch(pCurlApiCallbacks->cacheType) {
@@ -1674,11 +2436,10 @@ CleanUp:
     return retStatus;
 }
 
-PVOID getStreamingEndpointCurlHandler(PVOID arg)
+STATUS getStreamingEndpointCurlCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PCurlRequest pCurlRequest = (PCurlRequest) arg;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlResponse pCurlResponse = NULL;
@@ -1693,6 +2454,7 @@ PVOID getStreamingEndpointCurlHandler(PVOID arg)
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
     SERVICE_CALL_RESULT callResult = SERVICE_CALL_RESULT_NOT_SET;
     CHAR streamingEndpoint[MAX_URI_CHAR_LEN + 1];
+    PersistedEndpoint persistedEndpoint;
 
 
     CHECK(pCurlRequest != NULL &&
@@ -1702,20 +2464,8 @@ PVOID getStreamingEndpointCurlHandler(PVOID arg)
     pCurlApiCallbacks = pCurlRequest->pCurlApiCallbacks;
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Acquire and release the startup lock to ensure the startup sequence is clear
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-
-    // Sign the request
-    CHK_STATUS(signAwsRequestInfo(&pCurlRequest->requestInfo));
-
-    // Wait for the specified amount of time before calling the API
-    if (pCurlRequest->requestInfo.currentTime < pCurlRequest->requestInfo.callAfter) {
-        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - pCurlRequest->requestInfo.currentTime);
-    }
-
-    // Execute the request
-    CHK_STATUS(curlCallApi(pCurlRequest));
+    // Check the result of the request execution
+    CHK_STATUS(callStatus);
     CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
 
     // Set the response object
@@ -1764,7 +2514,7 @@ CleanUp:
 
         if (STATUS_FAILED(retStatus) || pEndpointTracker == NULL) {
             // Create new tracker and insert in the table
-            pEndpointTracker = (PEndpointTracker) MEMALLOC(SIZEOF(EndpointTracker));
+            pEndpointTracker = (PEndpointTracker) MEMCALLOC(1, SIZEOF(EndpointTracker));
 
             if (pEndpointTracker != NULL) {
                 // Insert into the table
@@ -1777,10 +2527,33 @@ CleanUp:
             STRNCPY(pEndpointTracker->streamingEndpoint, streamingEndpoint, MAX_URI_CHAR_LEN);
             pEndpointTracker->streamingEndpoint[MAX_URI_CHAR_LEN] = '\0';
             pEndpointTracker->endpointLastUpdateTime = pCurlRequest->requestInfo.currentTime;
+
+            if (pCurlApiCallbacks->pPersistedEndpointCache != NULL) {
+                MEMSET(&persistedEndpoint, 0x00, SIZEOF(PersistedEndpoint));
+                STRCPY(persistedEndpoint.streamArn, pEndpointTracker->streamArn);
+            }
         }
 
         pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
                                                           pCurlApiCallbacks->cachedEndpointsLock);
+
+        // Store for the next start. The cache file is written out in the background
+        if (pEndpointTracker != NULL && pCurlApiCallbacks->pPersistedEndpointCache != NULL) {
+            STRCPY(persistedEndpoint.region, pCurlApiCallbacks->region);
+            STRCPY(persistedEndpoint.streamName, pCurlRequest->streamName);
+            STRCPY(persistedEndpoint.streamingEndpoint, streamingEndpoint);
+            persistedEndpoint.updateTime = pCurlRequest->requestInfo.currentTime;
+            CHK_LOG_ERR(persistedEndpointCachePut(pCurlApiCallbacks->pPersistedEndpointCache, &persistedEndpoint));
+        }
+
+        // Resolve the endpoints while the stream is getting ready to put media so the reconnects don't wait on DNS
+        if (pCurlApiCallbacks->pCurlResolverCache != NULL) {
+            CHK_LOG_ERR(curlResolverCacheAddUrl(pCurlApiCallbacks->pCurlResolverCache, streamingEndpoint));
+            CHK_LOG_ERR(curlResolverCacheAddUrl(pCurlApiCallbacks->pCurlResolverCache, pCurlApiCallbacks->controlPlaneUrl));
+        }
+
+        // Open the connection for the putMedia session to multiplex over
+        CHK_LOG_ERR(curlApiCallbacksWarmUpConnection(pCurlApiCallbacks, pCurlRequest->streamHandle, streamingEndpoint));
     }
 
     // Preserve the values as we need to free the request before the event notification
@@ -1807,9 +2580,7 @@ CleanUp:
     }
 
     LEAVES();
-
-    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
-    return (PVOID) (ULONG_PTR) retStatus;
+    return retStatus;
 }
 
 STATUS tagResourceCurl(UINT64 customData, PCHAR streamArn, UINT32 tagCount, PTag tags, PServiceCallContext pServiceCallContext)
@@ -1820,14 +2591,13 @@ STATUS tagResourceCurl(UINT64 customData, PCHAR streamArn, UINT32 tagCount, PTag
     PCHAR tagsJson = NULL;
     CHAR url[MAX_PATH_LEN + 1];
     PAwsCredentials pCredentials;
-    TID threadId = INVALID_TID_VALUE;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCurlRequest pCurlRequest = NULL;
     UINT32 i;
     INT32 charsCopied;
     PCHAR pCurPtr;
     PCallbacksProvider pCallbacksProvider = NULL;
-    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE;
+    BOOL startLocked = FALSE, requestLocked = FALSE, shutdownLocked = FALSE, streamShuttingDown = FALSE, requestAdded = FALSE;
     UINT64 currentTime;
     STREAM_HANDLE streamHandle = INVALID_STREAM_HANDLE_VALUE;
 
@@ -1890,19 +2660,21 @@ STATUS tagResourceCurl(UINT64 customData, PCHAR streamArn, UINT32 tagCount, PTag
     shutdownLocked = FALSE;
     CHK(!streamShuttingDown, STATUS_STREAM_BEING_SHUTDOWN);
 
-    // Start the request/response thread
-    CHK_STATUS(THREAD_CREATE(&threadId, tagResourceCurlHandler, (PVOID) pCurlRequest));
-    CHK_STATUS(THREAD_DETACH(threadId));
-
-    // Set the thread ID in the request, add to the hash table
-    pCurlRequest->threadId = threadId;
+    // Add the request to the active list before starting it as the request might complete right away.
+    // The request will wait on the startup mutex until we are done with the bookkeeping
     CHK_STATUS(hashTablePut(pCurlApiCallbacks->pActiveRequests, streamHandle, (UINT64) pCurlRequest));
+    requestAdded = TRUE;
+
+    // Start the request/response session
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, tagResourceCurlCompletion));
 
 CleanUp:
 
     if (STATUS_FAILED(retStatus)) {
-        if (IS_VALID_TID_VALUE(threadId)) {
-            THREAD_CANCEL(threadId);
+        if (requestAdded) {
+            hashTableRemove(pCurlApiCallbacks->pActiveRequests, streamHandle);
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeRequestsCvar);
         }
 
         freeCurlRequest(&pCurlRequest);
@@ -1969,11 +2741,10 @@ CleanUp:
     return retStatus;
 }
 
-PVOID tagResourceCurlHandler(PVOID arg)
+STATUS tagResourceCurlCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS, status = STATUS_SUCCESS;
-    PCurlRequest pCurlRequest = (PCurlRequest) arg;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlResponse pCurlResponse = NULL;
@@ -1988,20 +2759,8 @@ PVOID tagResourceCurlHandler(PVOID arg)
     pCurlApiCallbacks = pCurlRequest->pCurlApiCallbacks;
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Acquire and release the startup lock to ensure the startup sequence is clear
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-
-    // Sign the request
-    CHK_STATUS(signAwsRequestInfo(&pCurlRequest->requestInfo));
-
-    // Wait for the specified amount of time before calling the API
-    if (pCurlRequest->requestInfo.currentTime < pCurlRequest->requestInfo.callAfter) {
-        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - pCurlRequest->requestInfo.currentTime);
-    }
-
-    // Execute the request
-    CHK_STATUS(curlCallApi(pCurlRequest));
+    // Check the result of the request execution
+    CHK_STATUS(callStatus);
     CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
 
     // Set the response object
@@ -2035,9 +2794,7 @@ CleanUp:
     }
 
     LEAVES();
-
-    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
-    return (PVOID) (ULONG_PTR) retStatus;
+    return retStatus;
 }
 
 STATUS putStreamCurl(UINT64 customData, PCHAR streamName, PCHAR containerType, UINT64 startTimestamp,
@@ -2051,13 +2808,14 @@ STATUS putStreamCurl(UINT64 customData, PCHAR streamName, PCHAR containerType, U
     CHAR url[MAX_PATH_LEN + 1];
     CHAR startTimestampStr[MAX_TIMESTAMP_STR_LEN + 1] = {0};
     PAwsCredentials pCredentials = NULL;
-    TID threadId = INVALID_TID_VALUE;
     PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) customData;
     PCurlRequest pCurlRequest = NULL;
     UINT64 startTimestampMillis, currentTime;
     PCallbacksProvider pCallbacksProvider = NULL;
-    BOOL startLocked = FALSE, uploadsLocked = FALSE, streamShuttingDown = FALSE, shutdownLocked = FALSE;
+    BOOL startLocked = FALSE, uploadsLocked = FALSE, streamShuttingDown = FALSE, shutdownLocked = FALSE, uploadIndexed = FALSE,
+         metricsLocked = FALSE;
     STREAM_HANDLE streamHandle;
+    PDoubleListNode pNode = NULL;
 
     CHECK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pServiceCallContext != NULL);
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
@@ -2104,24 +2862,52 @@ STATUS putStreamCurl(UINT64 customData, PCHAR streamName, PCHAR containerType, U
     CHK_STATUS(setRequestHeader(&pCurlRequest->requestInfo, (PCHAR) "transfer-encoding", 0, (PCHAR) "chunked", 0));
     CHK_STATUS(setRequestHeader(&pCurlRequest->requestInfo, (PCHAR) "connection", 0, (PCHAR) "keep-alive", 0));
 
+    // Resolve the transport options for the session
+    CHK_STATUS(curlApiCallbacksGetStreamUploadOptions(pCurlApiCallbacks, streamHandle, &pCurlRequest->uploadOptions));
+
+    // Attach the stream metrics which outlive the session
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    metricsLocked = TRUE;
+    CHK_STATUS(curlApiCallbacksGetStreamMetricsTracker(pCurlApiCallbacks, streamHandle, TRUE, &pCurlRequest->pStreamMetricsTracker));
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->streamMetricsLock);
+    metricsLocked = FALSE;
+
     // Lock the startup mutex so the created thread will wait until we are done with bookkeeping
     pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
     startLocked = TRUE;
 
-    // Start the request/response thread
-    CHK_STATUS(THREAD_CREATE(&threadId, putStreamCurlHandler, (PVOID) pCurlRequest));
-    CHK_STATUS(THREAD_DETACH(threadId));
+    // Add the request to the active list before starting it as the request might complete right away.
+    // The request will wait on the startup mutex until we are done with the bookkeeping
+    CHK_STATUS(doubleListInsertItemTail(pCurlApiCallbacks->pActiveUploads, (UINT64) pCurlRequest));
 
-    // Set the thread ID in the request, add to the hash table
-    pCurlRequest->threadId = threadId;
+    // Remember the inserted node so the failure path removes exactly this entry
+    CHK_STATUS(doubleListGetTailNode(pCurlApiCallbacks->pActiveUploads, &pNode));
+    CHK_STATUS(curlApiCallbacksIndexUpload(pCurlApiCallbacks, pCurlRequest));
+    uploadIndexed = TRUE;
 
-    CHK_STATUS(doubleListInsertItemTail(pCurlApiCallbacks->pActiveUploads, (UINT64) pCurlRequest));
+    // Start the request/response session
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, putStreamCurlCompletion));
+
+    // Account for the session only once it has started. The completion which accounts for its end
+    // can't run before the startup mutex is released below.
+    CHK_LOG_ERR(curlStreamMetricsSessionStarted(pCurlRequest->pStreamMetricsTracker));
 
 CleanUp:
 
+    if (metricsLocked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pCurlApiCallbacks->streamMetricsLock);
+    }
+
     if (STATUS_FAILED(retStatus)) {
-        if (IS_VALID_TID_VALUE(threadId)) {
-            THREAD_CANCEL(threadId);
+        if (pNode != NULL) {
+            doubleListDeleteNode(pCurlApiCallbacks->pActiveUploads, pNode);
+            pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                             pCurlApiCallbacks->activeUploadsCvar);
+        }
+
+        if (uploadIndexed) {
+            curlApiCallbacksUnindexUpload(pCurlApiCallbacks, pCurlRequest->uploadHandle);
         }
 
         freeCurlRequest(&pCurlRequest);
@@ -2155,11 +2941,10 @@ CleanUp:
     return retStatus;
 }
 
-PVOID putStreamCurlHandler(PVOID arg)
+STATUS putStreamCurlCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PCurlRequest pCurlRequest = (PCurlRequest) arg;
     PCurlApiCallbacks pCurlApiCallbacks = NULL;
     PCallbacksProvider pCallbacksProvider = NULL;
     PCurlResponse pCurlResponse = NULL;
@@ -2175,20 +2960,8 @@ PVOID putStreamCurlHandler(PVOID arg)
     pCurlApiCallbacks = pCurlRequest->pCurlApiCallbacks;
     pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
 
-    // Acquire and release the startup lock to ensure the startup sequence is clear
-    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
-
-    // Sign the request
-    CHK_STATUS(signAwsRequestInfo(&pCurlRequest->requestInfo));
-
-    // Wait for the specified amount of time before calling the API
-    if (pCurlRequest->requestInfo.currentTime < pCurlRequest->requestInfo.callAfter) {
-        THREAD_SLEEP(pCurlRequest->requestInfo.callAfter - pCurlRequest->requestInfo.currentTime);
-    }
-
-    // Execute the request
-    CHK_STATUS(curlCallApi(pCurlRequest));
+    // Check the result of the request execution
+    CHK_STATUS(callStatus);
     CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
 
     // Set the response object
@@ -2215,6 +2988,12 @@ CleanUp:
     pCurlRequest->threadId = INVALID_TID_VALUE;
 
     requestTerminating = ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating);
+
+    if (pCurlRequest->pStreamMetricsTracker != NULL) {
+        curlStreamMetricsSessionCompleted(pCurlRequest->pStreamMetricsTracker,
+                                          pCurlRequest->pCurlResponse != NULL ? pCurlRequest->pCurlResponse->pCurl : NULL);
+    }
+
     // Free the request object
     curlApiCallbacksShutdownActiveUploads(pCurlApiCallbacks,
                                           streamHandle,
@@ -2234,18 +3013,16 @@ CleanUp:
     }
 
     LEAVES();
-    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
-    return (PVOID) (ULONG_PTR) retStatus;
+    return retStatus;
 }
 
-// Accquire activeUploads lock before calling this function!!!
+// Acquire the uploads index stripe lock for the upload handle before calling this function!!!
 STATUS findRequestWithUploadHandle(UPLOAD_HANDLE uploadHandle, PCurlApiCallbacks pCurlApiCallbacks,
                                    PCurlRequest *ppCurlRequest)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    BOOL requestFound = FALSE;
-    PDoubleListNode pNode = NULL;
+    UINT64 data = 0;
     PCurlRequest pCurlRequest = NULL;
 
     CHK(ppCurlRequest != NULL, STATUS_NULL_ARG);
@@ -2253,26 +3030,85 @@ STATUS findRequestWithUploadHandle(UPLOAD_HANDLE uploadHandle, PCurlApiCallbacks
 
     CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_INVALID_ARG);
 
-    // Iterate through the list and find the requests matching the uploadHandle
-    CHK_STATUS(doubleListGetHeadNode(pCurlApiCallbacks->pActiveUploads, &pNode));
-    while (pNode != NULL && !requestFound) {
-        pCurlRequest = (PCurlRequest) pNode->data;
+    retStatus = hashTableGet(getUploadsIndexStripe(pCurlApiCallbacks, uploadHandle)->pUploads, uploadHandle, &data);
+    if (retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
+        // Not an error - the upload might have already completed
+        retStatus = STATUS_SUCCESS;
+    }
 
-        // Get the next node before processing
-        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+    CHK_STATUS(retStatus);
+    pCurlRequest = (PCurlRequest) data;
 
-        if (pCurlRequest->uploadHandle == uploadHandle) {
-            requestFound = TRUE;
-        }
-    }
+CleanUp:
+
+    *ppCurlRequest = pCurlRequest;
+
+    LEAVES();
+    return retStatus;
+}
+
+PUploadsIndexStripe getUploadsIndexStripe(PCurlApiCallbacks pCurlApiCallbacks, UPLOAD_HANDLE uploadHandle)
+{
+    // Upload handles are assigned sequentially so the modulo spreads the uploads evenly
+    return &pCurlApiCallbacks->uploadsIndex[uploadHandle % CURL_API_UPLOADS_INDEX_STRIPE_COUNT];
+}
+
+// Acquire activeUploads lock before calling this function!!!
+STATUS curlApiCallbacksIndexUpload(PCurlApiCallbacks pCurlApiCallbacks, PCurlRequest pCurlRequest)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PUploadsIndexStripe pStripe = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && pCurlRequest != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_UPLOAD_HANDLE(pCurlRequest->uploadHandle), STATUS_INVALID_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pStripe = getUploadsIndexStripe(pCurlApiCallbacks, pCurlRequest->uploadHandle);
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
+    locked = TRUE;
+
+    CHK_STATUS(hashTablePut(pStripe->pUploads, pCurlRequest->uploadHandle, (UINT64) pCurlRequest));
 
 CleanUp:
 
-    if (!requestFound) {
-        pCurlRequest = NULL;
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
     }
 
-    *ppCurlRequest = pCurlRequest;
+    LEAVES();
+    return retStatus;
+}
+
+// Acquire activeUploads lock before calling this function!!!
+STATUS curlApiCallbacksUnindexUpload(PCurlApiCallbacks pCurlApiCallbacks, UPLOAD_HANDLE uploadHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PUploadsIndexStripe pStripe = NULL;
+    BOOL locked = FALSE, present = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_UPLOAD_HANDLE(uploadHandle), retStatus);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    pStripe = getUploadsIndexStripe(pCurlApiCallbacks, uploadHandle);
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
+    locked = TRUE;
+
+    CHK_STATUS(hashTableContains(pStripe->pUploads, uploadHandle, &present));
+    if (present) {
+        CHK_STATUS(hashTableRemove(pStripe->pUploads, uploadHandle));
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pStripe->lock);
+    }
 
     LEAVES();
     return retStatus;
@@ -2350,3 +3186,211 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS curlApiCallbacksWarmStartEndpoint(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle, PCHAR streamName)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL endpointsLocked = FALSE;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PEndpointTracker pEndpointTracker = NULL;
+    PersistedEndpoint persistedEndpoint;
+    UINT64 curTime;
+    BOOL tracked = FALSE, seeded = FALSE;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && streamName != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Nothing to do if the cache is not enabled or the stream has not been seen by the previous runs
+    CHK(pCurlApiCallbacks->pPersistedEndpointCache != NULL, retStatus);
+    retStatus = persistedEndpointCacheGet(pCurlApiCallbacks->pPersistedEndpointCache, pCurlApiCallbacks->region, streamName,
+                                          &persistedEndpoint);
+    CHK(retStatus != STATUS_HASH_KEY_NOT_PRESENT, STATUS_SUCCESS);
+    CHK_STATUS(retStatus);
+
+    // Expired entries are left for the regular calls to refresh
+    curTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK(persistedEndpoint.updateTime <= curTime && persistedEndpoint.updateTime + pCurlApiCallbacks->cacheUpdatePeriod > curTime,
+        retStatus);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pCurlApiCallbacks->cachedEndpointsLock);
+    endpointsLocked = TRUE;
+
+    // Only seed the streams which haven't got the results in this run
+    CHK_STATUS(hashTableContains(pCurlApiCallbacks->pCachedEndpoints, (UINT64) streamHandle, &tracked));
+    CHK(!tracked, retStatus);
+
+    pEndpointTracker = (PEndpointTracker) MEMCALLOC(1, SIZEOF(EndpointTracker));
+    CHK(pEndpointTracker != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    STRCPY(pEndpointTracker->streamingEndpoint, persistedEndpoint.streamingEndpoint);
+    STRCPY(pEndpointTracker->streamArn, persistedEndpoint.streamArn);
+    pEndpointTracker->endpointLastUpdateTime = persistedEndpoint.updateTime;
+
+    CHK_STATUS(hashTablePut(pCurlApiCallbacks->pCachedEndpoints, (UINT64) streamHandle, (UINT64) pEndpointTracker));
+    pEndpointTracker = NULL;
+
+    DLOGI("Warm starting stream %s with the persisted endpoint %s", streamName, persistedEndpoint.streamingEndpoint);
+
+    // Resolve the endpoint ahead of the first session as the get endpoint call is skipped
+    if (pCurlApiCallbacks->pCurlResolverCache != NULL) {
+        CHK_LOG_ERR(curlResolverCacheAddUrl(pCurlApiCallbacks->pCurlResolverCache, persistedEndpoint.streamingEndpoint));
+    }
+    seeded = TRUE;
+
+CleanUp:
+
+    SAFE_MEMFREE(pEndpointTracker);
+
+    if (endpointsLocked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pCurlApiCallbacks->cachedEndpointsLock);
+    }
+
+    // Open the connection for the first putMedia session as well
+    if (seeded) {
+        CHK_LOG_ERR(curlApiCallbacksWarmUpConnection(pCurlApiCallbacks, streamHandle, persistedEndpoint.streamingEndpoint));
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Opens the connection to the data endpoint ahead of the putMedia session. With HTTP/2 the request is pinned to the
+ * network loop the putMedia sessions to the host run on. The session then waits for the connection with PIPEWAIT and
+ * is multiplexed over it instead of doing its own TCP and TLS handshakes. The request is a signed HEAD so it's
+ * answered like any other call. Only the connection it leaves in the loop's connection cache is of interest, so any
+ * HTTP response counts as a success.
+ *
+ * NOTE: The request owns a copy of the credentials as it outlives the call. The copy is freed on completion.
+ */
+STATUS curlApiCallbacksWarmUpConnection(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle, PCHAR streamingEndpoint)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    PCurlRequest pCurlRequest = NULL;
+    PAwsCredentials pAwsCredentials = NULL, pCredentialsCopy = NULL;
+    PBYTE pToken = NULL;
+    UINT32 tokenSize = 0;
+    UINT64 currentTime, expiration;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && streamingEndpoint != NULL, STATUS_NULL_ARG);
+    CHK(pCurlApiCallbacks->connectionWarmUpEnabled && !ATOMIC_LOAD_BOOL(&pCurlApiCallbacks->shutdown), retStatus);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Sign with the credentials the regular calls are signed with
+    CHK(pCallbacksProvider->clientCallbacks.getSecurityTokenFn != NULL, STATUS_INVALID_OPERATION);
+    CHK_STATUS(pCallbacksProvider->clientCallbacks.getSecurityTokenFn(pCallbacksProvider->clientCallbacks.customData, &pToken,
+                                                                      &tokenSize, &expiration));
+    pAwsCredentials = (PAwsCredentials) pToken;
+    CHK(pAwsCredentials != NULL && tokenSize >= SIZEOF(AwsCredentials) && pAwsCredentials->size == tokenSize,
+        STATUS_INTERNAL_ERROR);
+    CHK(NULL != (pCredentialsCopy = (PAwsCredentials) MEMALLOC(tokenSize)), STATUS_NOT_ENOUGH_MEMORY);
+    MEMCPY(pCredentialsCopy, pAwsCredentials, tokenSize);
+    CHK_STATUS(deserializeAwsCredentials((PBYTE) pCredentialsCopy));
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK_STATUS(createCurlRequest(HTTP_REQUEST_VERB_HEAD, streamingEndpoint, (PCHAR) "", streamHandle,
+                                 pCurlApiCallbacks->region, currentTime,
+                                 CURL_API_DEFAULT_CONNECTION_TIMEOUT, CURL_API_CONNECTION_WARM_UP_TIMEOUT,
+                                 currentTime, pCurlApiCallbacks->certPath, pCredentialsCopy,
+                                 pCurlApiCallbacks, &pCurlRequest));
+    pCredentialsCopy = NULL;
+
+    CHK_STATUS(setRequestHeader(&pCurlRequest->requestInfo, (PCHAR) "user-agent", 0, pCurlApiCallbacks->userAgent, 0));
+
+    CHK_STATUS(curlApiCallbacksStartRequest(pCurlApiCallbacks, pCurlRequest, curlApiCallbacksWarmUpConnectionCompletion));
+    pCurlRequest = NULL;
+
+CleanUp:
+
+    if (pCurlRequest != NULL) {
+        pCredentialsCopy = pCurlRequest->requestInfo.pAwsCredentials;
+        freeCurlRequest(&pCurlRequest);
+    }
+
+    SAFE_MEMFREE(pCredentialsCopy);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlApiCallbacksWarmUpConnectionCompletion(PCurlRequest pCurlRequest, STATUS callStatus)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PAwsCredentials pCredentialsCopy;
+    UINT32 httpStatus = HTTP_STATUS_CODE_NOT_SET;
+
+    CHK(pCurlRequest != NULL, STATUS_NULL_ARG);
+    pCredentialsCopy = pCurlRequest->requestInfo.pAwsCredentials;
+
+    if (pCurlRequest->pCurlResponse != NULL) {
+        httpStatus = (UINT32) pCurlRequest->pCurlResponse->callInfo.httpStatus;
+    }
+
+    // The transport failures, like DNS or TLS ones, leave no HTTP status. The status of the response itself is irrelevant
+    if (STATUS_FAILED(callStatus) || httpStatus == HTTP_STATUS_CODE_NOT_SET) {
+        DLOGV("Failed to warm up the connection to %s with error: 0x%08x", pCurlRequest->requestInfo.url, callStatus);
+    } else {
+        DLOGV("Warmed up the connection to %s with HTTP status %u", pCurlRequest->requestInfo.url, httpStatus);
+    }
+
+    freeCurlRequest(&pCurlRequest);
+    SAFE_MEMFREE(pCredentialsCopy);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlApiCallbacksCacheStreamArn(PCurlApiCallbacks pCurlApiCallbacks, STREAM_HANDLE streamHandle, PCHAR streamArn)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL endpointsLocked = FALSE;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PEndpointTracker pEndpointTracker = NULL;
+    UINT64 value = 0;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && streamArn != NULL, STATUS_NULL_ARG);
+    CHK(STRNLEN(streamArn, MAX_ARN_LEN + 1) <= MAX_ARN_LEN, STATUS_INVALID_ARG_LEN);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // The ARN is only needed for the emulated calls
+    CHK(pCurlApiCallbacks->cacheType != API_CALL_CACHE_TYPE_NONE, retStatus);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                    pCurlApiCallbacks->cachedEndpointsLock);
+    endpointsLocked = TRUE;
+
+    retStatus = hashTableGet(pCurlApiCallbacks->pCachedEndpoints, (UINT64) streamHandle, &value);
+    CHK(retStatus == STATUS_HASH_KEY_NOT_PRESENT || retStatus == STATUS_SUCCESS, retStatus);
+    pEndpointTracker = (PEndpointTracker) value;
+
+    if (retStatus == STATUS_HASH_KEY_NOT_PRESENT || pEndpointTracker == NULL) {
+        // The tracker without the endpoint never emulates the calls until the endpoint is retrieved
+        pEndpointTracker = (PEndpointTracker) MEMCALLOC(1, SIZEOF(EndpointTracker));
+        CHK(pEndpointTracker != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        retStatus = hashTablePut(pCurlApiCallbacks->pCachedEndpoints, (UINT64) streamHandle, (UINT64) pEndpointTracker);
+        if (STATUS_FAILED(retStatus)) {
+            MEMFREE(pEndpointTracker);
+            CHK(FALSE, retStatus);
+        }
+    }
+
+    STRCPY(pEndpointTracker->streamArn, streamArn);
+
+CleanUp:
+
+    if (endpointsLocked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                          pCurlApiCallbacks->cachedEndpointsLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -32,8 +32,22 @@ extern "C" {
 // Default connection timeout
 #define CURL_API_DEFAULT_CONNECTION_TIMEOUT     (5000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
 
-// Default shutdown polling interval
-#define CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL     (200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// Completion timeout of the request opening the connection to the data endpoint ahead of the putMedia session
+#define CURL_API_CONNECTION_WARM_UP_TIMEOUT     (10 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Number of the independently locked stripes of the active uploads index
+#define CURL_API_UPLOADS_INDEX_STRIPE_COUNT     16
+
+// Active uploads index stripe hash table parameters
+#define CURL_API_UPLOADS_INDEX_BUCKET_COUNT     16
+#define CURL_API_UPLOADS_INDEX_BUCKET_LENGTH    2
+
+// Duration of the stream data the default putMedia upload buffer holds at the average bandwidth
+#define CURL_API_DEFAULT_UPLOAD_BUFFER_DURATION         (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+// Upload buffer size limits accepted by curl
+#define CURL_API_MIN_UPLOAD_BUFFER_SIZE                 (16 * 1024)
+#define CURL_API_MAX_UPLOAD_BUFFER_SIZE                 (2 * 1024 * 1024)
 
 // Max parameter JSON string for KMS key len
 #define MAX_JSON_KMS_KEY_ID_STRING_LEN      (MAX_ARN_LEN + 100)
@@ -82,9 +96,26 @@ struct __EndpointTracker {
 
     // Cached endpoint
     CHAR streamingEndpoint[MAX_URI_CHAR_LEN + 1];
+
+    // Stream ARN returned by the service. Empty if not known
+    CHAR streamArn[MAX_ARN_LEN + 1];
 };
 typedef struct __EndpointTracker* PEndpointTracker;
 
+/**
+ * Stripe of the active uploads index. Upload handles are hashed into the stripes
+ * so the lookups on the per-frame path for different streams do not contend.
+ */
+typedef struct __UploadsIndexStripe UploadsIndexStripe;
+struct __UploadsIndexStripe {
+    // Active uploads in the stripe: UPLOAD_HANDLE -> Request
+    PHashTable pUploads;
+
+    // Lock guarding the stripe
+    MUTEX lock;
+};
+typedef struct __UploadsIndexStripe* PUploadsIndexStripe;
+
 /**
  * The KVS backend specific callbacks
  */
@@ -128,6 +159,13 @@ struct __CurlApiCallbacks {
     // Lock guarding the active uploads
     MUTEX activeUploadsLock;
 
+    // Signaled with the active uploads lock held when an upload is removed from the active uploads
+    CVAR activeUploadsCvar;
+
+    // Active uploads index for the constant time lookups by the upload handle.
+    // NOTE: The stripe lock is acquired after the active uploads lock
+    UploadsIndexStripe uploadsIndex[CURL_API_UPLOADS_INDEX_STRIPE_COUNT];
+
     // Ongoing requests: STREAM_HANDLE -> Request
     PHashTable pActiveRequests;
 
@@ -136,6 +174,9 @@ struct __CurlApiCallbacks {
     // Lock guarding the active requests
     MUTEX activeRequestsLock;
 
+    // Signaled with the active requests lock held when a request is removed from the active requests
+    CVAR activeRequestsCvar;
+
     // Cached endpoints: STREAM_HANDLE -> EndpointTracker
     PHashTable pCachedEndpoints;
 
@@ -157,6 +198,51 @@ struct __CurlApiCallbacks {
     // Lock guarding the endpoints table
     MUTEX shutdownLock;
 
+    // Optional network loops driving the requests. No loops means thread per request.
+    PCurlNetworkLoop networkLoops[MAX_CURL_NETWORK_LOOP_COUNT];
+
+    // Number of the network loops
+    UINT32 networkLoopCount;
+
+    // Holds the delayed requests until they are due instead of a sleeping thread per request
+    PCurlRequestScheduler pCurlRequestScheduler;
+
+    // Whether the sessions negotiate HTTP/2 and the requests to the same host share a network loop
+    BOOL http2Enabled;
+
+    // Whether HTTP/2 has been either enabled or disabled explicitly
+    BOOL http2Configured;
+
+    // Whether the connection to the data endpoint is opened on the putMedia network loop as soon as the endpoint is known
+    BOOL connectionWarmUpEnabled;
+
+    // Pool of the easy handles keeping their live connections and sharing the TLS sessions across the requests
+    PCurlHandlePool pCurlHandlePool;
+
+    // Optional background resolved addresses of the endpoints injected into the new sessions
+    PCurlResolverCache pCurlResolverCache;
+
+    // Optional on-disk cache of the stream ARNs and data endpoints surviving the restarts
+    PPersistedEndpointCache pPersistedEndpointCache;
+
+    // Derived SigV4 signing keys shared by the requests
+    PSigningKeyCache pSigningKeyCache;
+
+    // Writer dumping the streaming sessions into mkv files. NULL if not dumping
+    PDebugDumpWriter pDebugDumpWriter;
+
+    // Stream metrics: STREAM_HANDLE -> CurlStreamMetricsTracker
+    PHashTable pStreamMetrics;
+
+    // Lock guarding the stream metrics table
+    MUTEX streamMetricsLock;
+
+    // Application set upload options: STREAM_HANDLE -> CurlStreamUploadOptions
+    PHashTable pStreamUploadOptions;
+
+    // Lock guarding the upload options table
+    MUTEX streamUploadOptionsLock;
+
     ///////////////////////////////////////////////
     // Test hooks for CURL calls
 
@@ -186,8 +272,21 @@ STATUS curlApiCallbacksShutdownActiveRequests(PCurlApiCallbacks, STREAM_HANDLE,
 STATUS curlApiCallbacksShutdownCachedEndpoints(PCurlApiCallbacks, STREAM_HANDLE, BOOL);
 STATUS curlApiCallbacksShutdownActiveUploads(PCurlApiCallbacks, STREAM_HANDLE, UPLOAD_HANDLE, UINT64, BOOL, BOOL);
 STATUS curlApiCallbacksShutdown(PCurlApiCallbacks, UINT64);
+STATUS curlApiCallbacksAwaitActiveRequests(PCurlApiCallbacks, STREAM_HANDLE);
+STATUS curlApiCallbacksAwaitActiveUploads(PCurlApiCallbacks, STREAM_HANDLE);
 STATUS freeApiCallbacksCurl(PUINT64);
 STATUS findRequestWithUploadHandle(UPLOAD_HANDLE, PCurlApiCallbacks, PCurlRequest*);
+STATUS curlApiCallbacksIndexUpload(PCurlApiCallbacks, PCurlRequest);
+STATUS curlApiCallbacksUnindexUpload(PCurlApiCallbacks, UPLOAD_HANDLE);
+PUploadsIndexStripe getUploadsIndexStripe(PCurlApiCallbacks, UPLOAD_HANDLE);
+STATUS curlApiCallbacksStartRequest(PCurlApiCallbacks, PCurlRequest, CurlRequestCompletionFunc);
+STATUS curlApiCallbacksDispatchRequest(PCurlApiCallbacks, PCurlRequest);
+STATUS curlApiCallbacksSelectNetworkLoop(PCurlApiCallbacks, PCurlRequest, PCurlNetworkLoop*);
+STATUS getCurlApiCallbacks(PClientCallbacks, PCurlApiCallbacks*);
+STATUS curlApiCallbacksGetStreamMetricsTracker(PCurlApiCallbacks, STREAM_HANDLE, BOOL, PCurlStreamMetricsTracker*);
+STATUS curlApiCallbacksFreeStreamMetrics(PCurlApiCallbacks, STREAM_HANDLE, BOOL);
+STATUS curlApiCallbacksGetStreamUploadOptions(PCurlApiCallbacks, STREAM_HANDLE, PCurlStreamUploadOptions);
+STATUS curlApiCallbacksFreeStreamUploadOptions(PCurlApiCallbacks, STREAM_HANDLE, BOOL);
 
 //////////////////////////////////////////////////////////////////////
 // Auxiliary functionality
@@ -196,8 +295,13 @@ STATUS notifyCallResult(struct __CallbacksProvider*, STATUS, STREAM_HANDLE);
 STREAM_STATUS getStreamStatusFromString(PCHAR, UINT32);
 STATUS curlApiCallbacksMarkStreamShuttingdownCallback(UINT64, PHashEntry);
 STATUS curlApiCallbacksCachedEndpointsTableShutdownCallback(UINT64, PHashEntry);
+STATUS curlApiCallbacksStreamMetricsTableFreeCallback(UINT64, PHashEntry);
+STATUS curlApiCallbacksStreamUploadOptionsTableFreeCallback(UINT64, PHashEntry);
 STATUS curlApiCallbacksFreeRequest(PCurlRequest);
 STATUS checkApiCallEmulation(PCurlApiCallbacks, STREAM_HANDLE, PBOOL);
+STATUS curlApiCallbacksWarmStartEndpoint(PCurlApiCallbacks, STREAM_HANDLE, PCHAR);
+STATUS curlApiCallbacksCacheStreamArn(PCurlApiCallbacks, STREAM_HANDLE, PCHAR);
+STATUS curlApiCallbacksWarmUpConnection(PCurlApiCallbacks, STREAM_HANDLE, PCHAR);
 
 ////////////////////////////////////////////////////////////////////////
 // API Callback function implementations
@@ -229,11 +333,13 @@ STATUS clientShutdownCurl(UINT64, CLIENT_HANDLE);
 ////////////////////////////////////////////////////////////////////////
 // API handler routines
 ////////////////////////////////////////////////////////////////////////
-PVOID createStreamCurlHandler(PVOID);
-PVOID describeStreamCurlHandler(PVOID);
-PVOID getStreamingEndpointCurlHandler(PVOID);
-PVOID tagResourceCurlHandler(PVOID);
-PVOID putStreamCurlHandler(PVOID);
+PVOID curlRequestThreadHandler(PVOID);
+STATUS createStreamCurlCompletion(PCurlRequest, STATUS);
+STATUS describeStreamCurlCompletion(PCurlRequest, STATUS);
+STATUS getStreamingEndpointCurlCompletion(PCurlRequest, STATUS);
+STATUS tagResourceCurlCompletion(PCurlRequest, STATUS);
+STATUS putStreamCurlCompletion(PCurlRequest, STATUS);
+STATUS curlApiCallbacksWarmUpConnectionCompletion(PCurlRequest, STATUS);
 
 #ifdef  __cplusplus
 }
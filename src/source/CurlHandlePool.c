@@ -0,0 +1,320 @@
+/**
+ * Kinesis Video Producer CURL easy handle pool
+ */
+#define LOG_CLASS "CurlHandlePool"
+#include "Include_i.h"
+
+/**
+ * Creates the handle pool and the curl share object
+ */
+STATUS createCurlHandlePool(PCurlApiCallbacks pCurlApiCallbacks, UINT32 maxIdleCount, PCurlHandlePool* ppCurlHandlePool)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlHandlePool pCurlHandlePool = NULL;
+    PCallbacksProvider pCallbacksProvider;
+    UINT32 i;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && ppCurlHandlePool != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Allocate the entire structure
+    pCurlHandlePool = (PCurlHandlePool) MEMCALLOC(1, SIZEOF(CurlHandlePool));
+    CHK(pCurlHandlePool != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pCurlHandlePool->pCurlApiCallbacks = pCurlApiCallbacks;
+    pCurlHandlePool->maxIdleCount = maxIdleCount;
+    pCurlHandlePool->lock = INVALID_MUTEX_VALUE;
+    for (i = 0; i < CURL_HANDLE_POOL_SHARE_LOCK_COUNT; i++) {
+        pCurlHandlePool->shareLocks[i] = INVALID_MUTEX_VALUE;
+    }
+
+    CHK_STATUS(doubleListCreate(&pCurlHandlePool->pIdleHandles));
+
+    pCurlHandlePool->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pCurlHandlePool->lock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+
+    for (i = 0; i < CURL_HANDLE_POOL_SHARE_LOCK_COUNT; i++) {
+        pCurlHandlePool->shareLocks[i] = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+        CHK(pCurlHandlePool->shareLocks[i] != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+    }
+
+    // Share the TLS session and DNS caches across the handles. The connection cache is deliberately not shared
+    // as libcurl doesn't support using it from the concurrently running transfers on different threads
+    pCurlHandlePool->pCurlShare = curl_share_init();
+    CHK(pCurlHandlePool->pCurlShare != NULL, STATUS_CURL_INIT_FAILED);
+
+    curl_share_setopt(pCurlHandlePool->pCurlShare, CURLSHOPT_LOCKFUNC, curlHandlePoolShareLock);
+    curl_share_setopt(pCurlHandlePool->pCurlShare, CURLSHOPT_UNLOCKFUNC, curlHandlePoolShareUnlock);
+    curl_share_setopt(pCurlHandlePool->pCurlShare, CURLSHOPT_USERDATA, (PVOID) pCurlHandlePool);
+    curl_share_setopt(pCurlHandlePool->pCurlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(pCurlHandlePool->pCurlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCurlHandlePool(&pCurlHandlePool);
+    }
+
+    // Set the return value if it's not NULL
+    if (ppCurlHandlePool != NULL) {
+        *ppCurlHandlePool = pCurlHandlePool;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the handle pool object
+ *
+ * NOTE: The caller should have passed a pointer which was previously created by the corresponding function
+ * NOTE: The call is idempotent
+ */
+STATUS freeCurlHandlePool(PCurlHandlePool* ppCurlHandlePool)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlHandlePool pCurlHandlePool = NULL;
+    PCallbacksProvider pCallbacksProvider;
+    PDoubleListNode pNode;
+    PPooledCurlHandle pPooledCurlHandle;
+    CURLSHcode result;
+    UINT32 i;
+
+    CHK(ppCurlHandlePool != NULL, STATUS_NULL_ARG);
+
+    pCurlHandlePool = *ppCurlHandlePool;
+
+    // Call is idempotent
+    CHK(pCurlHandlePool != NULL, retStatus);
+
+    pCallbacksProvider = pCurlHandlePool->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Clean up the idle handles
+    if (pCurlHandlePool->pIdleHandles != NULL) {
+        CHK_STATUS(doubleListGetHeadNode(pCurlHandlePool->pIdleHandles, &pNode));
+        while (pNode != NULL) {
+            pPooledCurlHandle = (PPooledCurlHandle) pNode->data;
+            curlHandlePoolCleanupHandles(pPooledCurlHandle->pCurl, pPooledCurlHandle->pCurlMulti);
+            MEMFREE(pPooledCurlHandle);
+            CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+        }
+
+        doubleListFree(pCurlHandlePool->pIdleHandles);
+    }
+
+    if (pCurlHandlePool->pCurlShare != NULL) {
+        result = curl_share_cleanup(pCurlHandlePool->pCurlShare);
+        if (result != CURLSHE_OK) {
+            DLOGW("Failed to clean up the curl share object with error: %s", curl_share_strerror(result));
+        }
+    }
+
+    for (i = 0; i < CURL_HANDLE_POOL_SHARE_LOCK_COUNT; i++) {
+        if (IS_VALID_MUTEX_VALUE(pCurlHandlePool->shareLocks[i])) {
+            pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->shareLocks[i]);
+        }
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pCurlHandlePool->lock)) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    }
+
+    // Release the object
+    MEMFREE(pCurlHandlePool);
+
+    // Set the pointer to NULL
+    *ppCurlHandlePool = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlHandlePoolAcquire(PCurlHandlePool pCurlHandlePool, PCHAR url, CURL** ppCurl, CURLM** ppCurlMulti)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    PPooledCurlHandle pPooledCurlHandle = NULL;
+    CURL* pCurl = NULL;
+    CURLM* pCurlMulti = NULL;
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+    BOOL locked = FALSE, withMulti = (ppCurlMulti != NULL);
+
+    CHK(pCurlHandlePool != NULL && url != NULL && ppCurl != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlHandlePool->pCurlApiCallbacks->pCallbacksProvider;
+
+    CHK_STATUS(curlHandlePoolGetHost(url, host, ARRAY_SIZE(host)));
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    locked = TRUE;
+
+    // Pick the most recently released handle for the host which is driven the same way
+    CHK_STATUS(doubleListGetTailNode(pCurlHandlePool->pIdleHandles, &pNode));
+    while (pNode != NULL && pPooledCurlHandle == NULL) {
+        if (0 == STRCMPI(((PPooledCurlHandle) pNode->data)->host, host) &&
+            (((PPooledCurlHandle) pNode->data)->pCurlMulti != NULL) == withMulti) {
+            pPooledCurlHandle = (PPooledCurlHandle) pNode->data;
+            CHK_STATUS(doubleListDeleteNode(pCurlHandlePool->pIdleHandles, pNode));
+        } else {
+            CHK_STATUS(doubleListGetPrevNode(pNode, &pNode));
+        }
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    locked = FALSE;
+
+    if (pPooledCurlHandle != NULL) {
+        pCurl = pPooledCurlHandle->pCurl;
+        pCurlMulti = pPooledCurlHandle->pCurlMulti;
+        MEMFREE(pPooledCurlHandle);
+    } else {
+        pCurl = curl_easy_init();
+        CHK(pCurl != NULL, STATUS_CURL_INIT_FAILED);
+    }
+
+    curl_easy_setopt(pCurl, CURLOPT_SHARE, pCurlHandlePool->pCurlShare);
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    }
+
+    if (ppCurl != NULL) {
+        *ppCurl = pCurl;
+    }
+
+    if (ppCurlMulti != NULL) {
+        *ppCurlMulti = pCurlMulti;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlHandlePoolRelease(PCurlHandlePool pCurlHandlePool, PCHAR url, CURL* pCurl, CURLM* pCurlMulti, BOOL reusable)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    PPooledCurlHandle pPooledCurlHandle = NULL, pEvicted = NULL;
+    UINT32 idleCount;
+    BOOL locked = FALSE;
+
+    CHK(pCurlHandlePool != NULL && pCurl != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlHandlePool->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Nothing to keep if the handle can't be re-used
+    CHK(reusable && url != NULL && pCurlHandlePool->maxIdleCount != 0, retStatus);
+
+    pPooledCurlHandle = (PPooledCurlHandle) MEMALLOC(SIZEOF(PooledCurlHandle));
+    CHK(pPooledCurlHandle != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    CHK_STATUS(curlHandlePoolGetHost(url, pPooledCurlHandle->host, ARRAY_SIZE(pPooledCurlHandle->host)));
+    pPooledCurlHandle->pCurl = pCurl;
+    pPooledCurlHandle->pCurlMulti = pCurlMulti;
+
+    // Reset the options referencing the freed session buffers while keeping the live connections and the caches
+    curl_easy_reset(pCurl);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    locked = TRUE;
+
+    // Evict the least recently released handle if full
+    CHK_STATUS(doubleListGetNodeCount(pCurlHandlePool->pIdleHandles, &idleCount));
+    if (idleCount >= pCurlHandlePool->maxIdleCount) {
+        CHK_STATUS(doubleListGetHeadNode(pCurlHandlePool->pIdleHandles, &pNode));
+        pEvicted = (PPooledCurlHandle) pNode->data;
+        CHK_STATUS(doubleListDeleteNode(pCurlHandlePool->pIdleHandles, pNode));
+    }
+
+    CHK_STATUS(doubleListInsertItemTail(pCurlHandlePool->pIdleHandles, (UINT64) pPooledCurlHandle));
+
+    // The handles are owned by the pool now
+    pPooledCurlHandle = NULL;
+    pCurl = NULL;
+    pCurlMulti = NULL;
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->lock);
+    }
+
+    if (pEvicted != NULL) {
+        curlHandlePoolCleanupHandles(pEvicted->pCurl, pEvicted->pCurlMulti);
+        MEMFREE(pEvicted);
+    }
+
+    curlHandlePoolCleanupHandles(pCurl, pCurlMulti);
+
+    SAFE_MEMFREE(pPooledCurlHandle);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlHandlePoolGetHost(PCHAR url, PCHAR pHost, UINT32 hostLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pStart, pEnd;
+    UINT32 len;
+
+    CHK(url != NULL && pHost != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(getRequestHost(url, &pStart, &pEnd));
+    len = (UINT32) (pEnd - pStart);
+    CHK(len < hostLen, STATUS_INVALID_ARG_LEN);
+
+    STRNCPY(pHost, pStart, len);
+    pHost[len] = '\0';
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID curlHandlePoolCleanupHandles(CURL* pCurl, CURLM* pCurlMulti)
+{
+    if (pCurlMulti != NULL) {
+        curl_multi_cleanup(pCurlMulti);
+    }
+
+    if (pCurl != NULL) {
+        curl_easy_cleanup(pCurl);
+    }
+}
+
+VOID curlHandlePoolShareLock(CURL* pCurl, curl_lock_data data, curl_lock_access access, PVOID userptr)
+{
+    PCurlHandlePool pCurlHandlePool = (PCurlHandlePool) userptr;
+    PCallbacksProvider pCallbacksProvider;
+
+    UNUSED_PARAM(pCurl);
+    UNUSED_PARAM(access);
+
+    if (pCurlHandlePool != NULL && data < CURL_HANDLE_POOL_SHARE_LOCK_COUNT) {
+        pCallbacksProvider = pCurlHandlePool->pCurlApiCallbacks->pCallbacksProvider;
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->shareLocks[data]);
+    }
+}
+
+VOID curlHandlePoolShareUnlock(CURL* pCurl, curl_lock_data data, PVOID userptr)
+{
+    PCurlHandlePool pCurlHandlePool = (PCurlHandlePool) userptr;
+    PCallbacksProvider pCallbacksProvider;
+
+    UNUSED_PARAM(pCurl);
+
+    if (pCurlHandlePool != NULL && data < CURL_HANDLE_POOL_SHARE_LOCK_COUNT) {
+        pCallbacksProvider = pCurlHandlePool->pCurlApiCallbacks->pCallbacksProvider;
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlHandlePool->shareLocks[data]);
+    }
+}
@@ -0,0 +1,141 @@
+/*******************************************
+CURL handle pool internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CURL_HANDLE_POOL_INCLUDE_I__
+#define __KINESIS_VIDEO_CURL_HANDLE_POOL_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Number of share lock slots - one per curl_lock_data value
+#define CURL_HANDLE_POOL_SHARE_LOCK_COUNT                   (CURL_LOCK_DATA_LAST)
+
+/**
+ * Forward declarations
+ */
+struct __CurlApiCallbacks;
+
+/**
+ * Idle easy handle tracked by the pool
+ */
+typedef struct __PooledCurlHandle PooledCurlHandle;
+struct __PooledCurlHandle {
+    // Host the handle has last been connected to
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+
+    // The easy handle
+    CURL* pCurl;
+
+    // Multi handle the easy handle has been driven through or NULL. Holds the live connections of the handle
+    CURLM* pCurlMulti;
+};
+typedef struct __PooledCurlHandle* PPooledCurlHandle;
+
+/**
+ * Pool of curl easy handles keyed by the endpoint host.
+ *
+ * All of the handles share the TLS session and DNS caches through a curl share object so the new sessions
+ * to the same endpoint can resume the TLS session instead of paying for the full handshake. The connection
+ * cache is not shared as libcurl doesn't support sharing it across the concurrently running transfers.
+ * Instead, the live connections are kept by whatever drives the handle:
+ * - a handle driven by curl_easy_perform keeps them in its internal cache across the sessions
+ * - a handle driven by a multi handle of its own is pooled together with that multi handle which caches them
+ * - the handles driven by a network loop re-use the connections cached by the loop's multi handle
+ */
+typedef struct __CurlHandlePool CurlHandlePool;
+struct __CurlHandlePool {
+    // Back pointer to the curl API callbacks object
+    struct __CurlApiCallbacks* pCurlApiCallbacks;
+
+    // Curl share object for the TLS session and DNS caches
+    CURLSH* pCurlShare;
+
+    // Locks guarding the shared data
+    MUTEX shareLocks[CURL_HANDLE_POOL_SHARE_LOCK_COUNT];
+
+    // Lock guarding the idle handles
+    MUTEX lock;
+
+    // Idle handles with the least recently released at the head
+    PDoubleList pIdleHandles;
+
+    // Max number of the idle handles to keep
+    UINT32 maxIdleCount;
+};
+typedef struct __CurlHandlePool* PCurlHandlePool;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a curl handle pool object
+ *
+ * @param - PCurlApiCallbacks - IN - Curl API callbacks object owning the pool
+ * @param - UINT32 - IN - Max number of idle handles to keep
+ * @param - PCurlHandlePool* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCurlHandlePool(struct __CurlApiCallbacks*, UINT32, PCurlHandlePool*);
+
+/**
+ * Frees the curl handle pool object and cleans up the idle handles.
+ *
+ * NOTE: All of the handles acquired from the pool should have been released prior to the call.
+ * NOTE: The call is idempotent
+ *
+ * @param - PCurlHandlePool* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCurlHandlePool(PCurlHandlePool*);
+
+/**
+ * Acquires an easy handle for the specified url. Returns a reset idle handle which has last been
+ * used with the same host if any or a newly created one otherwise.
+ *
+ * NOTE: The handles driven through a multi handle of their own are only handed out together with that
+ * multi handle and vice versa. A newly created handle comes with no multi handle.
+ *
+ * @param - PCurlHandlePool - IN - Pool object
+ * @param - PCHAR - IN - Url of the request
+ * @param - CURL** - OUT - The easy handle
+ * @param - CURLM** - OUT/OPT - The multi handle pooled with the easy handle or NULL if none. Should be
+ *      specified if the easy handle is to be driven through a multi handle of its own.
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlHandlePoolAcquire(PCurlHandlePool, PCHAR, CURL**, CURLM**);
+
+/**
+ * Returns the easy handle and the multi handle it's been driven through to the pool. The handles are
+ * cleaned up if they are not reusable or the pool is full.
+ *
+ * NOTE: The easy handle should have been removed from the multi handle prior to the call.
+ *
+ * @param - PCurlHandlePool - IN - Pool object
+ * @param - PCHAR - IN - Url the handle was used with
+ * @param - CURL* - IN - The easy handle
+ * @param - CURLM* - IN/OPT - The multi handle the easy handle has been driven through
+ * @param - BOOL - IN - Whether the handle can be re-used
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlHandlePoolRelease(PCurlHandlePool, PCHAR, CURL*, CURLM*, BOOL);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+STATUS curlHandlePoolGetHost(PCHAR, PCHAR, UINT32);
+VOID curlHandlePoolCleanupHandles(CURL*, CURLM*);
+VOID curlHandlePoolShareLock(CURL*, curl_lock_data, curl_lock_access, PVOID);
+VOID curlHandlePoolShareUnlock(CURL*, curl_lock_data, PVOID);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CURL_HANDLE_POOL_INCLUDE_I__ */
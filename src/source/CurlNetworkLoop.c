@@ -0,0 +1,559 @@
+/**
+ * Kinesis Video Producer CURL multi based network loop
+ */
+#define LOG_CLASS "CurlNetworkLoop"
+#include "Include_i.h"
+
+/**
+ * Creates the network loop and starts the loop thread
+ */
+STATUS createCurlNetworkLoop(PCurlApiCallbacks pCurlApiCallbacks, PCurlNetworkLoop* ppCurlNetworkLoop)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlNetworkLoop pCurlNetworkLoop = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && ppCurlNetworkLoop != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Allocate the entire structure
+    pCurlNetworkLoop = (PCurlNetworkLoop) MEMCALLOC(1, SIZEOF(CurlNetworkLoop));
+    CHK(pCurlNetworkLoop != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pCurlNetworkLoop->pCurlApiCallbacks = pCurlApiCallbacks;
+    pCurlNetworkLoop->threadId = INVALID_TID_VALUE;
+    pCurlNetworkLoop->lock = INVALID_MUTEX_VALUE;
+    pCurlNetworkLoop->requestCount = 0;
+    ATOMIC_STORE_BOOL(&pCurlNetworkLoop->shutdown, FALSE);
+
+    CHK_STATUS(doubleListCreate(&pCurlNetworkLoop->pPendingRequests));
+    CHK_STATUS(doubleListCreate(&pCurlNetworkLoop->pOwnedRequests));
+    CHK_STATUS(doubleListCreate(&pCurlNetworkLoop->pActiveRequests));
+
+    pCurlNetworkLoop->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, TRUE);
+    CHK(pCurlNetworkLoop->lock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+
+    pCurlNetworkLoop->pCurlMulti = curl_multi_init();
+    CHK(pCurlNetworkLoop->pCurlMulti != NULL, STATUS_CURL_INIT_FAILED);
+
+    // Only has an effect on the HTTP/2 sessions which are then multiplexed over a shared connection per host
+    curl_multi_setopt(pCurlNetworkLoop->pCurlMulti, CURLMOPT_PIPELINING, (long) CURLPIPE_MULTIPLEX);
+
+    // Start the loop thread
+    CHK_STATUS(THREAD_CREATE(&pCurlNetworkLoop->threadId, curlNetworkLoopRoutine, (PVOID) pCurlNetworkLoop));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCurlNetworkLoop(&pCurlNetworkLoop);
+    }
+
+    // Set the return value if it's not NULL
+    if (ppCurlNetworkLoop != NULL) {
+        *ppCurlNetworkLoop = pCurlNetworkLoop;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the network loop object
+ *
+ * NOTE: The caller should have passed a pointer which was previously created by the corresponding function
+ * NOTE: The call is idempotent
+ */
+STATUS freeCurlNetworkLoop(PCurlNetworkLoop* ppCurlNetworkLoop)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlNetworkLoop pCurlNetworkLoop = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(ppCurlNetworkLoop != NULL, STATUS_NULL_ARG);
+
+    pCurlNetworkLoop = *ppCurlNetworkLoop;
+
+    // Call is idempotent
+    CHK(pCurlNetworkLoop != NULL, retStatus);
+
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Stop the loop thread and await for it to complete the outstanding requests
+    ATOMIC_STORE_BOOL(&pCurlNetworkLoop->shutdown, TRUE);
+    if (IS_VALID_TID_VALUE(pCurlNetworkLoop->threadId)) {
+        curlNetworkLoopWakeup(pCurlNetworkLoop);
+        THREAD_JOIN(pCurlNetworkLoop->threadId, NULL);
+    }
+
+    if (pCurlNetworkLoop->pCurlMulti != NULL) {
+        curl_multi_cleanup(pCurlNetworkLoop->pCurlMulti);
+    }
+
+    doubleListFree(pCurlNetworkLoop->pPendingRequests);
+    doubleListFree(pCurlNetworkLoop->pOwnedRequests);
+    doubleListFree(pCurlNetworkLoop->pActiveRequests);
+
+    if (IS_VALID_MUTEX_VALUE(pCurlNetworkLoop->lock)) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    }
+
+    // Release the object
+    MEMFREE(pCurlNetworkLoop);
+
+    // Set the pointer to NULL
+    *ppCurlNetworkLoop = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopSubmitRequest(PCurlNetworkLoop pCurlNetworkLoop, PCurlRequest pCurlRequest)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pCurlNetworkLoop != NULL && pCurlRequest != NULL && pCurlRequest->completionFn != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    locked = TRUE;
+
+    CHK(!ATOMIC_LOAD_BOOL(&pCurlNetworkLoop->shutdown), STATUS_INVALID_OPERATION);
+
+    pCurlRequest->pNetworkLoop = pCurlNetworkLoop;
+    CHK_STATUS(doubleListInsertItemTail(pCurlNetworkLoop->pPendingRequests, (UINT64) pCurlRequest));
+    pCurlNetworkLoop->requestCount++;
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    locked = FALSE;
+
+    CHK_STATUS(curlNetworkLoopWakeup(pCurlNetworkLoop));
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && pCurlRequest != NULL) {
+        pCurlRequest->pNetworkLoop = NULL;
+    }
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopWakeup(PCurlNetworkLoop pCurlNetworkLoop)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CURLMcode result;
+
+    CHK(pCurlNetworkLoop != NULL && pCurlNetworkLoop->pCurlMulti != NULL, STATUS_NULL_ARG);
+
+    result = curl_multi_wakeup(pCurlNetworkLoop->pCurlMulti);
+    if (result != CURLM_OK) {
+        DLOGW("Failed to wake up the network loop with error: %s", curl_multi_strerror(result));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlNetworkLoopGetRequestCount(PCurlNetworkLoop pCurlNetworkLoop, PUINT32 pRequestCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlNetworkLoop != NULL && pRequestCount != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    *pRequestCount = pCurlNetworkLoop->requestCount;
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+PVOID curlNetworkLoopRoutine(PVOID arg)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlNetworkLoop pCurlNetworkLoop = (PCurlNetworkLoop) arg;
+    UINT64 waitTime;
+    INT32 runningCount;
+    CURLMcode result;
+
+    CHECK(pCurlNetworkLoop != NULL && pCurlNetworkLoop->pCurlMulti != NULL);
+
+    while (!ATOMIC_LOAD_BOOL(&pCurlNetworkLoop->shutdown)) {
+        waitTime = CURL_NETWORK_LOOP_MAX_POLL_INTERVAL;
+
+        // Add the requests which are due to the multi handle
+        CHK_LOG_ERR(curlNetworkLoopStartPendingRequests(pCurlNetworkLoop, &waitTime));
+
+        // Apply the un-pause and termination requests posted by other threads
+        CHK_LOG_ERR(curlNetworkLoopServiceActiveRequests(pCurlNetworkLoop, &waitTime));
+
+        // Drive the transfers
+        result = curl_multi_perform(pCurlNetworkLoop->pCurlMulti, &runningCount);
+        if (result != CURLM_OK) {
+            DLOGW("curl multi perform failed with error: %s", curl_multi_strerror(result));
+        }
+
+        CHK_LOG_ERR(curlNetworkLoopProcessCompletedRequests(pCurlNetworkLoop));
+
+        // Await socket activity, curl internal timeout, the next request due or an explicit wakeup
+        result = curl_multi_poll(pCurlNetworkLoop->pCurlMulti, NULL, 0,
+                                 (INT32) (waitTime / HUNDREDS_OF_NANOS_IN_A_MILLISECOND), NULL);
+        if (result != CURLM_OK) {
+            DLOGW("curl multi poll failed with error: %s", curl_multi_strerror(result));
+            THREAD_SLEEP(CURL_NETWORK_LOOP_START_RETRY_INTERVAL);
+        }
+    }
+
+    // Release whatever is still owned by the loop
+    retStatus = curlNetworkLoopCompleteAllRequests(pCurlNetworkLoop);
+
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+
+    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+/**
+ * Takes the startable requests off the pending list one at a time and starts each outside of the lock as the
+ * completion routines call back into the API callbacks. A request is only dequeued once it's about to be handled
+ * so a failure leaves nothing stranded - a request failing to start is completed with the failure status.
+ */
+STATUS curlNetworkLoopStartPendingRequests(PCurlNetworkLoop pCurlNetworkLoop, PUINT64 pWaitTime)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    PCurlRequest pCurlRequest;
+    UINT64 currentTime;
+    BOOL locked = FALSE;
+
+    CHK(pCurlNetworkLoop != NULL && pWaitTime != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    while (TRUE) {
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+        locked = TRUE;
+
+        // Find the next request which can be started
+        CHK_STATUS(doubleListGetHeadNode(pCurlNetworkLoop->pPendingRequests, &pNode));
+        for (pCurlRequest = NULL; pNode != NULL && pCurlRequest == NULL; ) {
+            pCurlRequest = (PCurlRequest) pNode->data;
+
+            // Terminating requests are picked up without waiting for their call after time to be completed
+            if (!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating) && currentTime < pCurlRequest->requestInfo.callAfter) {
+                // Wait for the specified amount of time before calling the API
+                *pWaitTime = MIN(*pWaitTime, pCurlRequest->requestInfo.callAfter - currentTime);
+                pCurlRequest = NULL;
+            } else if (!pCallbacksProvider->clientCallbacks.tryLockMutexFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                           pCurlRequest->startLock)) {
+                // The submitting thread holds the start lock until it's done with the bookkeeping.
+                // This applies to the completion of the terminating requests as well.
+                *pWaitTime = MIN(*pWaitTime, CURL_NETWORK_LOOP_START_RETRY_INTERVAL);
+                pCurlRequest = NULL;
+            } else {
+                pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
+            }
+
+            if (pCurlRequest == NULL) {
+                CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+            }
+        }
+
+        if (pCurlRequest != NULL) {
+            CHK_STATUS(doubleListDeleteNode(pCurlNetworkLoop->pPendingRequests, pNode));
+        }
+
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+        locked = FALSE;
+
+        if (pCurlRequest == NULL) {
+            break;
+        }
+
+        // Terminating requests are completed without being started
+        if (ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+            curlNetworkLoopCompleteRequest(pCurlNetworkLoop, pCurlRequest, STATUS_SUCCESS);
+        } else if (STATUS_FAILED(status = curlNetworkLoopStartRequest(pCurlNetworkLoop, pCurlRequest))) {
+            DLOGW("Failed to start the request with status 0x%08x", status);
+            curlNetworkLoopCompleteRequest(pCurlNetworkLoop, pCurlRequest, status);
+        }
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopStartRequest(PCurlNetworkLoop pCurlNetworkLoop, PCurlRequest pCurlRequest)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlResponse pCurlResponse;
+    CURLMcode result;
+    BOOL handleAdded = FALSE;
+
+    CHK(pCurlNetworkLoop != NULL && pCurlRequest != NULL && pCurlRequest->pCurlResponse != NULL, STATUS_NULL_ARG);
+    pCurlResponse = pCurlRequest->pCurlResponse;
+
+    // Sign the request. The requests without the credentials, like the connection warm up, go out as they are
+    if (pCurlRequest->requestInfo.pAwsCredentials != NULL) {
+        CHK_STATUS(signAwsRequestInfoWithSigningKeyCache(&pCurlRequest->requestInfo, pCurlNetworkLoop->pCurlApiCallbacks->pSigningKeyCache));
+    }
+
+    CHK_STATUS(curlPrepareRequest(pCurlResponse));
+
+    // Store the request so we can retrieve it on completion
+    curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_PRIVATE, (PVOID) pCurlRequest);
+
+    result = curl_multi_add_handle(pCurlNetworkLoop->pCurlMulti, pCurlResponse->pCurl);
+    if (result != CURLM_OK) {
+        DLOGW("Failed to add the curl handle to the network loop with error: %s", curl_multi_strerror(result));
+        CHK(FALSE, STATUS_INVALID_OPERATION);
+    }
+
+    handleAdded = TRUE;
+    CHK_STATUS(doubleListInsertItemTail(pCurlNetworkLoop->pActiveRequests, (UINT64) pCurlRequest));
+    CHK_STATUS(doubleListGetTailNode(pCurlNetworkLoop->pActiveRequests, &pCurlRequest->pNetworkLoopNode));
+
+    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, TRUE);
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && handleAdded) {
+        curl_multi_remove_handle(pCurlNetworkLoop->pCurlMulti, pCurlResponse->pCurl);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopServiceActiveRequests(PCurlNetworkLoop pCurlNetworkLoop, PUINT64 pWaitTime)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    PDoubleListNode pNode;
+    PCurlRequest pCurlRequest;
+    PCurlResponse pCurlResponse;
+    UINT64 currentTime;
+    CURLcode result;
+
+    CHK(pCurlNetworkLoop != NULL && pWaitTime != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlNetworkLoop->pActiveRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+        pCurlResponse = pCurlRequest->pCurlResponse;
+
+        // Get the next node before processing as the request might complete
+        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+
+        if (ATOMIC_LOAD_BOOL(&pCurlResponse->terminationRequested)) {
+            if (currentTime < pCurlResponse->terminationTime) {
+                // Give curl some time to terminate gracefully before actually timing it out.
+                *pWaitTime = MIN(*pWaitTime, pCurlResponse->terminationTime - currentTime);
+            } else {
+                DLOGV("Force stopping the curl connection for stream %s", pCurlRequest->streamName);
+                CHK_STATUS(curlNetworkLoopRemoveActiveRequest(pCurlNetworkLoop, pCurlRequest));
+                pCurlResponse->terminated = TRUE;
+                curlNetworkLoopCompleteRequest(pCurlNetworkLoop, pCurlRequest, STATUS_SUCCESS);
+            }
+        } else if (ATOMIC_LOAD_BOOL(&pCurlResponse->unpauseRequested)) {
+            ATOMIC_STORE_BOOL(&pCurlResponse->unpauseRequested, FALSE);
+            if (pCurlResponse->paused) {
+                pCurlResponse->paused = FALSE;
+                if (pCurlRequest->pStreamMetricsTracker != NULL) {
+                    curlStreamMetricsSetPaused(pCurlRequest->pStreamMetricsTracker, FALSE);
+                }
+
+                result = curl_easy_pause(pCurlResponse->pCurl, CURLPAUSE_SEND_CONT);
+                if (result != CURLE_OK) {
+                    DLOGW("Failed to un-pause curl with error: %u", result);
+                }
+            }
+        }
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopProcessCompletedRequests(PCurlNetworkLoop pCurlNetworkLoop)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    CURLMsg* pCurlMsg;
+    INT32 msgCount;
+    CURL* pCurl;
+    CURLcode result;
+    PCurlRequest pCurlRequest;
+
+    CHK(pCurlNetworkLoop != NULL, STATUS_NULL_ARG);
+
+    while ((pCurlMsg = curl_multi_info_read(pCurlNetworkLoop->pCurlMulti, &msgCount)) != NULL) {
+        if (pCurlMsg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        // The message is invalidated once the handle is removed
+        pCurl = pCurlMsg->easy_handle;
+        result = pCurlMsg->data.result;
+
+        pCurlRequest = NULL;
+        curl_easy_getinfo(pCurl, CURLINFO_PRIVATE, (PCHAR*) &pCurlRequest);
+        CHK(pCurlRequest != NULL, STATUS_INTERNAL_ERROR);
+
+        CHK_STATUS(curlNetworkLoopRemoveActiveRequest(pCurlNetworkLoop, pCurlRequest));
+
+        status = STATUS_SUCCESS;
+        if (!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+            status = curlProcessRequestResult(pCurlRequest->pCurlResponse, result);
+        }
+
+        curlNetworkLoopCompleteRequest(pCurlNetworkLoop, pCurlRequest, status);
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopRemoveActiveRequest(PCurlNetworkLoop pCurlNetworkLoop, PCurlRequest pCurlRequest)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pNode;
+
+    CHK(pCurlNetworkLoop != NULL && pCurlRequest != NULL, STATUS_NULL_ARG);
+
+    curl_multi_remove_handle(pCurlNetworkLoop->pCurlMulti, pCurlRequest->pCurlResponse->pCurl);
+    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, FALSE);
+
+    // The node has been stored when the request was added to the multi handle
+    pNode = pCurlRequest->pNetworkLoopNode;
+    pCurlRequest->pNetworkLoopNode = NULL;
+    if (pNode != NULL) {
+        CHK_STATUS(doubleListDeleteNode(pCurlNetworkLoop->pActiveRequests, pNode));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlNetworkLoopCompleteRequest(PCurlNetworkLoop pCurlNetworkLoop, PCurlRequest pCurlRequest, STATUS status)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlNetworkLoop != NULL && pCurlRequest != NULL && pCurlRequest->completionFn != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    pCurlNetworkLoop->requestCount--;
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+
+    // NOTE: The completion routine releases the request object
+    retStatus = pCurlRequest->completionFn(pCurlRequest, status);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlNetworkLoopCompleteAllRequests(PCurlNetworkLoop pCurlNetworkLoop)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    PCurlRequest pCurlRequest;
+    BOOL locked = FALSE;
+
+    CHK(pCurlNetworkLoop != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlNetworkLoop->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Take the pending requests first so nothing else gets started
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    locked = TRUE;
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlNetworkLoop->pPendingRequests, &pNode));
+    while (pNode != NULL) {
+        CHK_STATUS(doubleListInsertItemTail(pCurlNetworkLoop->pOwnedRequests, pNode->data));
+        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+    }
+
+    CHK_STATUS(doubleListClear(pCurlNetworkLoop->pPendingRequests, FALSE));
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    locked = FALSE;
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlNetworkLoop->pActiveRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+        curl_multi_remove_handle(pCurlNetworkLoop->pCurlMulti, pCurlRequest->pCurlResponse->pCurl);
+        ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, FALSE);
+        pCurlRequest->pNetworkLoopNode = NULL;
+        CHK_STATUS(doubleListInsertItemTail(pCurlNetworkLoop->pOwnedRequests, (UINT64) pCurlRequest));
+        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+    }
+
+    CHK_STATUS(doubleListClear(pCurlNetworkLoop->pActiveRequests, FALSE));
+
+    // Complete the requests as terminated so their resources get released
+    CHK_STATUS(doubleListGetHeadNode(pCurlNetworkLoop->pOwnedRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+
+        ATOMIC_STORE_BOOL(&pCurlRequest->requestInfo.terminating, TRUE);
+        pCurlRequest->pCurlResponse->terminated = TRUE;
+        curlNetworkLoopCompleteRequest(pCurlNetworkLoop, pCurlRequest, STATUS_SUCCESS);
+    }
+
+    CHK_STATUS(doubleListClear(pCurlNetworkLoop->pOwnedRequests, FALSE));
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlNetworkLoop->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -0,0 +1,135 @@
+/*******************************************
+CURL network loop internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CURL_NETWORK_LOOP_INCLUDE_I__
+#define __KINESIS_VIDEO_CURL_NETWORK_LOOP_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Max time the network loop waits for an event before re-checking its state
+#define CURL_NETWORK_LOOP_MAX_POLL_INTERVAL                 (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+// Interval to retry starting a request which is still being set up by the submitting thread
+#define CURL_NETWORK_LOOP_START_RETRY_INTERVAL              (1 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Forward declarations
+ */
+struct __CurlApiCallbacks;
+
+/**
+ * Network loop driving multiple curl sessions on a single thread using a curl multi handle.
+ *
+ * NOTE: The easy handles of the requests added to the multi handle are owned by the loop thread.
+ * Other threads should not call into curl with these handles directly and should instead post
+ * un-pause and termination requests on the response object and wake up the loop.
+ */
+typedef struct __CurlNetworkLoop CurlNetworkLoop;
+struct __CurlNetworkLoop {
+    // Back pointer to the curl API callbacks object
+    struct __CurlApiCallbacks* pCurlApiCallbacks;
+
+    // Curl multi handle driving the sessions
+    CURLM* pCurlMulti;
+
+    // Network loop thread
+    TID threadId;
+
+    // Whether the loop should exit
+    volatile ATOMIC_BOOL shutdown;
+
+    // Lock guarding the pending requests and the request count
+    MUTEX lock;
+
+    // Submitted requests awaiting to be added to the multi handle
+    PDoubleList pPendingRequests;
+
+    // Pending and active requests owned by the loop gathered for the completion on shutdown.
+    // Accessed from the loop thread only
+    PDoubleList pOwnedRequests;
+
+    // Requests added to the multi handle. Accessed from the loop thread only
+    PDoubleList pActiveRequests;
+
+    // Number of requests owned by the loop
+    UINT32 requestCount;
+};
+typedef struct __CurlNetworkLoop* PCurlNetworkLoop;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a network loop object and starts the loop thread
+ *
+ * @param - PCurlApiCallbacks - IN - Curl API callbacks object owning the loop
+ * @param - PCurlNetworkLoop* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCurlNetworkLoop(struct __CurlApiCallbacks*, PCurlNetworkLoop*);
+
+/**
+ * Stops the loop thread and frees the network loop object. Requests which are still owned
+ * by the loop are marked as terminating and completed.
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PCurlNetworkLoop* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCurlNetworkLoop(PCurlNetworkLoop*);
+
+/**
+ * Submits a request to be executed by the network loop. The request will be started once its
+ * call after time is reached and its start lock is released. The completion routine of the
+ * request is invoked on the loop thread.
+ *
+ * @param - PCurlNetworkLoop - IN - Network loop object
+ * @param - PCurlRequest - IN - Request to execute
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlNetworkLoopSubmitRequest(PCurlNetworkLoop, PCurlRequest);
+
+/**
+ * Wakes up the network loop to process the posted un-pause and termination requests
+ *
+ * @param - PCurlNetworkLoop - IN - Network loop object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlNetworkLoopWakeup(PCurlNetworkLoop);
+
+/**
+ * Returns the number of requests owned by the network loop
+ *
+ * @param - PCurlNetworkLoop - IN - Network loop object
+ * @param - PUINT32 - OUT - Request count
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlNetworkLoopGetRequestCount(PCurlNetworkLoop, PUINT32);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID curlNetworkLoopRoutine(PVOID);
+STATUS curlNetworkLoopStartPendingRequests(PCurlNetworkLoop, PUINT64);
+STATUS curlNetworkLoopStartRequest(PCurlNetworkLoop, PCurlRequest);
+STATUS curlNetworkLoopServiceActiveRequests(PCurlNetworkLoop, PUINT64);
+STATUS curlNetworkLoopProcessCompletedRequests(PCurlNetworkLoop);
+STATUS curlNetworkLoopRemoveActiveRequest(PCurlNetworkLoop, PCurlRequest);
+STATUS curlNetworkLoopCompleteRequest(PCurlNetworkLoop, PCurlRequest, STATUS);
+STATUS curlNetworkLoopCompleteAllRequests(PCurlNetworkLoop);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CURL_NETWORK_LOOP_INCLUDE_I__ */
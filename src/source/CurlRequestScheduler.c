@@ -0,0 +1,389 @@
+/**
+ * Kinesis Video Producer CURL request scheduler
+ */
+#define LOG_CLASS "CurlRequestScheduler"
+#include "Include_i.h"
+
+/**
+ * Creates the request scheduler and starts the scheduler thread
+ */
+STATUS createCurlRequestScheduler(PCurlApiCallbacks pCurlApiCallbacks, PCurlRequestScheduler* ppCurlRequestScheduler)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlRequestScheduler pCurlRequestScheduler = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && ppCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Allocate the entire structure
+    pCurlRequestScheduler = (PCurlRequestScheduler) MEMCALLOC(1, SIZEOF(CurlRequestScheduler));
+    CHK(pCurlRequestScheduler != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pCurlRequestScheduler->pCurlApiCallbacks = pCurlApiCallbacks;
+    pCurlRequestScheduler->threadId = INVALID_TID_VALUE;
+    pCurlRequestScheduler->lock = INVALID_MUTEX_VALUE;
+    pCurlRequestScheduler->cvar = INVALID_CVAR_VALUE;
+    ATOMIC_STORE_BOOL(&pCurlRequestScheduler->shutdown, FALSE);
+
+    CHK_STATUS(doubleListCreate(&pCurlRequestScheduler->pScheduledRequests));
+    CHK_STATUS(doubleListCreate(&pCurlRequestScheduler->pDispatchingRequests));
+
+    pCurlRequestScheduler->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pCurlRequestScheduler->lock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+
+    pCurlRequestScheduler->cvar = pCallbacksProvider->clientCallbacks.createConditionVariableFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK(IS_VALID_CVAR_VALUE(pCurlRequestScheduler->cvar), STATUS_INVALID_OPERATION);
+
+    // Start the scheduler thread
+    CHK_STATUS(THREAD_CREATE(&pCurlRequestScheduler->threadId, curlRequestSchedulerRoutine, (PVOID) pCurlRequestScheduler));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCurlRequestScheduler(&pCurlRequestScheduler);
+    }
+
+    // Set the return value if it's not NULL
+    if (ppCurlRequestScheduler != NULL) {
+        *ppCurlRequestScheduler = pCurlRequestScheduler;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the request scheduler object
+ *
+ * NOTE: The caller should have passed a pointer which was previously created by the corresponding function
+ * NOTE: The call is idempotent
+ */
+STATUS freeCurlRequestScheduler(PCurlRequestScheduler* ppCurlRequestScheduler)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlRequestScheduler pCurlRequestScheduler = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(ppCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+
+    pCurlRequestScheduler = *ppCurlRequestScheduler;
+
+    // Call is idempotent
+    CHK(pCurlRequestScheduler != NULL, retStatus);
+
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Stop the scheduler thread
+    if (IS_VALID_TID_VALUE(pCurlRequestScheduler->threadId)) {
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+        ATOMIC_STORE_BOOL(&pCurlRequestScheduler->shutdown, TRUE);
+        pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->cvar);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+
+        THREAD_JOIN(pCurlRequestScheduler->threadId, NULL);
+    }
+
+    // Release whatever is still scheduled
+    if (pCurlRequestScheduler->pScheduledRequests != NULL && pCurlRequestScheduler->pDispatchingRequests != NULL &&
+        IS_VALID_MUTEX_VALUE(pCurlRequestScheduler->lock)) {
+        CHK_LOG_ERR(curlRequestSchedulerCompleteAllRequests(pCurlRequestScheduler, STATUS_SUCCESS));
+    }
+
+    doubleListFree(pCurlRequestScheduler->pScheduledRequests);
+    doubleListFree(pCurlRequestScheduler->pDispatchingRequests);
+
+    if (IS_VALID_CVAR_VALUE(pCurlRequestScheduler->cvar)) {
+        pCallbacksProvider->clientCallbacks.freeConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->cvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pCurlRequestScheduler->lock)) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    }
+
+    // Release the object
+    MEMFREE(pCurlRequestScheduler);
+
+    // Set the pointer to NULL
+    *ppCurlRequestScheduler = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Inserts the request keeping the list ordered by the call after time. The retries are mostly scheduled
+ * further out than the already pending ones so the insertion point is searched for from the tail.
+ */
+STATUS curlRequestSchedulerSubmitRequest(PCurlRequestScheduler pCurlRequestScheduler, PCurlRequest pCurlRequest)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    BOOL locked = FALSE;
+
+    CHK(pCurlRequestScheduler != NULL && pCurlRequest != NULL && pCurlRequest->completionFn != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    locked = TRUE;
+
+    CHK(!ATOMIC_LOAD_BOOL(&pCurlRequestScheduler->shutdown), STATUS_INVALID_OPERATION);
+
+    CHK_STATUS(doubleListGetTailNode(pCurlRequestScheduler->pScheduledRequests, &pNode));
+    while (pNode != NULL && ((PCurlRequest) pNode->data)->requestInfo.callAfter > pCurlRequest->requestInfo.callAfter) {
+        CHK_STATUS(doubleListGetPrevNode(pNode, &pNode));
+    }
+
+    ATOMIC_STORE_BOOL(&pCurlRequest->scheduled, TRUE);
+
+    if (pNode != NULL) {
+        CHK_STATUS(doubleListInsertItemAfter(pCurlRequestScheduler->pScheduledRequests, pNode, (UINT64) pCurlRequest));
+    } else {
+        CHK_STATUS(doubleListInsertItemHead(pCurlRequestScheduler->pScheduledRequests, (UINT64) pCurlRequest));
+
+        // The scheduler thread only needs to re-arm its wait when the earliest request changes
+        pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->cvar);
+    }
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus) && pCurlRequest != NULL) {
+        ATOMIC_STORE_BOOL(&pCurlRequest->scheduled, FALSE);
+    }
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlRequestSchedulerWakeup(PCurlRequestScheduler pCurlRequestScheduler)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->cvar);
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Moves the due requests to the dispatching list under the lock and dispatches them outside of it
+ * as the transports and the completion routines call back into the API callbacks.
+ */
+PVOID curlRequestSchedulerRoutine(PVOID args)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PCurlRequestScheduler pCurlRequestScheduler = (PCurlRequestScheduler) args;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    UINT64 waitTime;
+    UINT32 dispatchCount;
+    BOOL locked = FALSE;
+
+    CHK(pCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    locked = TRUE;
+
+    while (!ATOMIC_LOAD_BOOL(&pCurlRequestScheduler->shutdown)) {
+        waitTime = INFINITE_TIME_VALUE;
+        CHK_STATUS(curlRequestSchedulerCollectDueRequests(
+            pCurlRequestScheduler, pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData),
+            &waitTime));
+
+        CHK_STATUS(doubleListGetNodeCount(pCurlRequestScheduler->pDispatchingRequests, &dispatchCount));
+        if (dispatchCount != 0) {
+            pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+            locked = FALSE;
+
+            CHK_LOG_ERR(curlRequestSchedulerDispatchRequests(pCurlRequestScheduler));
+
+            pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+            locked = TRUE;
+
+            // Re-check the list as requests might have been scheduled or terminated while dispatching
+            continue;
+        }
+
+        // Await for the earliest request to become due, for a new earliest one to be scheduled or a termination
+        status = pCallbacksProvider->clientCallbacks.waitConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                              pCurlRequestScheduler->cvar,
+                                                                              pCurlRequestScheduler->lock,
+                                                                              waitTime);
+        CHK(status == STATUS_SUCCESS || status == STATUS_OPERATION_TIMED_OUT, status);
+    }
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    // Don't strand the scheduled requests should the thread fail. The new requests are rejected from here on
+    if (STATUS_FAILED(retStatus) && pCallbacksProvider != NULL) {
+        if (!locked) {
+            pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+            locked = TRUE;
+        }
+
+        ATOMIC_STORE_BOOL(&pCurlRequestScheduler->shutdown, TRUE);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+        locked = FALSE;
+
+        CHK_LOG_ERR(curlRequestSchedulerCompleteAllRequests(pCurlRequestScheduler, retStatus));
+    }
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    }
+
+    LEAVES();
+
+    // Returning STATUS as PVOID casting first to ptr type to avoid compiler warnings on 64bit platforms.
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+/**
+ * Moves the due and the terminated requests to the dispatching list and returns the time until the earliest
+ * of the remaining ones becomes due.
+ *
+ * NOTE: Should be called under the lock
+ */
+STATUS curlRequestSchedulerCollectDueRequests(PCurlRequestScheduler pCurlRequestScheduler, UINT64 currentTime, PUINT64 pWaitTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pNode, pCurNode;
+    PCurlRequest pCurlRequest;
+
+    CHK(pCurlRequestScheduler != NULL && pWaitTime != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pScheduledRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+
+        // Get the next node before processing
+        pCurNode = pNode;
+        CHK_STATUS(doubleListGetNextNode(pNode, &pNode));
+
+        // Terminated requests are handed over right away for the transport to complete them
+        if (currentTime < pCurlRequest->requestInfo.callAfter && !ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating)) {
+            *pWaitTime = MIN(*pWaitTime, pCurlRequest->requestInfo.callAfter - currentTime);
+            continue;
+        }
+
+        CHK_STATUS(doubleListDeleteNode(pCurlRequestScheduler->pScheduledRequests, pCurNode));
+        CHK_STATUS(doubleListInsertItemTail(pCurlRequestScheduler->pDispatchingRequests, (UINT64) pCurlRequest));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlRequestSchedulerDispatchRequests(PCurlRequestScheduler pCurlRequestScheduler)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PCallbacksProvider pCallbacksProvider;
+    PDoubleListNode pNode;
+    PCurlRequest pCurlRequest;
+
+    CHK(pCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pDispatchingRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+        CHK_STATUS(doubleListDeleteNode(pCurlRequestScheduler->pDispatchingRequests, pNode));
+
+        // The request is owned by the transport from here on
+        ATOMIC_STORE_BOOL(&pCurlRequest->scheduled, FALSE);
+
+        if (STATUS_FAILED(status = curlApiCallbacksDispatchRequest(pCurlRequestScheduler->pCurlApiCallbacks, pCurlRequest))) {
+            DLOGW("Failed to dispatch the scheduled request with status 0x%08x", status);
+
+            // Ensure the startup sequence is clear before completing. NOTE: The request is freed by the completion routine
+            pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
+            pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
+            pCurlRequest->completionFn(pCurlRequest, status);
+        }
+
+        CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pDispatchingRequests, &pNode));
+    }
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Completes the scheduled requests and the ones not dispatched yet as terminated with the specified status.
+ * Called either by the scheduler thread on its way out or once it has exited so no new requests are scheduled.
+ */
+STATUS curlRequestSchedulerCompleteAllRequests(PCurlRequestScheduler pCurlRequestScheduler, STATUS completionStatus)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PDoubleListNode pNode;
+    PCurlRequest pCurlRequest;
+    BOOL locked = FALSE;
+
+    CHK(pCurlRequestScheduler != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlRequestScheduler->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Move the scheduled requests over to the dispatching list to complete them outside of the lock
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    locked = TRUE;
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pScheduledRequests, &pNode));
+    while (pNode != NULL) {
+        CHK_STATUS(doubleListInsertItemTail(pCurlRequestScheduler->pDispatchingRequests, pNode->data));
+        CHK_STATUS(doubleListDeleteNode(pCurlRequestScheduler->pScheduledRequests, pNode));
+        CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pScheduledRequests, &pNode));
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    locked = FALSE;
+
+    CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pDispatchingRequests, &pNode));
+    while (pNode != NULL) {
+        pCurlRequest = (PCurlRequest) pNode->data;
+        CHK_STATUS(doubleListDeleteNode(pCurlRequestScheduler->pDispatchingRequests, pNode));
+
+        ATOMIC_STORE_BOOL(&pCurlRequest->scheduled, FALSE);
+        ATOMIC_STORE_BOOL(&pCurlRequest->requestInfo.terminating, TRUE);
+
+        // NOTE: The request is freed by the completion routine
+        pCurlRequest->completionFn(pCurlRequest, completionStatus);
+
+        CHK_STATUS(doubleListGetHeadNode(pCurlRequestScheduler->pDispatchingRequests, &pNode));
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequestScheduler->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
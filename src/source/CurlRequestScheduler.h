@@ -0,0 +1,103 @@
+/*******************************************
+CURL request scheduler internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CURL_REQUEST_SCHEDULER_INCLUDE_I__
+#define __KINESIS_VIDEO_CURL_REQUEST_SCHEDULER_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Forward declarations
+ */
+struct __CurlApiCallbacks;
+struct __CurlRequest;
+
+/**
+ * Holds the requests which are to be called after a delay, like the retries backing off, and hands them over to
+ * the executing transport when due. A pending request costs a list entry instead of a sleeping thread.
+ */
+typedef struct __CurlRequestScheduler CurlRequestScheduler;
+struct __CurlRequestScheduler {
+    // Back pointer to the curl API callbacks object
+    struct __CurlApiCallbacks* pCurlApiCallbacks;
+
+    // Scheduled requests ordered by their call after time
+    PDoubleList pScheduledRequests;
+
+    // Requests being dispatched outside of the lock. Only accessed by the scheduler thread
+    PDoubleList pDispatchingRequests;
+
+    // Lock guarding the scheduled requests
+    MUTEX lock;
+
+    // Signaled when a new earliest request is scheduled, a request is terminated or on shutdown
+    CVAR cvar;
+
+    // Scheduler thread
+    TID threadId;
+
+    // Whether the scheduler thread should exit
+    volatile ATOMIC_BOOL shutdown;
+};
+typedef struct __CurlRequestScheduler* PCurlRequestScheduler;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a request scheduler object and starts the scheduler thread
+ *
+ * @param - PCurlApiCallbacks - IN - Curl API callbacks object owning the scheduler
+ * @param - PCurlRequestScheduler* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCurlRequestScheduler(struct __CurlApiCallbacks*, PCurlRequestScheduler*);
+
+/**
+ * Stops the scheduler thread and frees the object. The requests still scheduled are completed as terminated.
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PCurlRequestScheduler* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCurlRequestScheduler(PCurlRequestScheduler*);
+
+/**
+ * Schedules the request to be dispatched at its call after time. The request is owned by the scheduler until then.
+ *
+ * @param - PCurlRequestScheduler - IN - Request scheduler object
+ * @param - PCurlRequest - IN - Request with its completion routine set
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlRequestSchedulerSubmitRequest(PCurlRequestScheduler, struct __CurlRequest*);
+
+/**
+ * Wakes up the scheduler thread to dispatch the requests which got terminated right away
+ *
+ * @param - PCurlRequestScheduler - IN - Request scheduler object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlRequestSchedulerWakeup(PCurlRequestScheduler);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID curlRequestSchedulerRoutine(PVOID);
+STATUS curlRequestSchedulerCollectDueRequests(PCurlRequestScheduler, UINT64, PUINT64);
+STATUS curlRequestSchedulerDispatchRequests(PCurlRequestScheduler);
+STATUS curlRequestSchedulerCompleteAllRequests(PCurlRequestScheduler, STATUS);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CURL_REQUEST_SCHEDULER_INCLUDE_I__ */
@@ -0,0 +1,453 @@
+/**
+ * Kinesis Video Producer CURL resolver cache
+ */
+#define LOG_CLASS "CurlResolverCache"
+#include "Include_i.h"
+
+/**
+ * Creates the resolver cache and starts the resolver thread
+ */
+STATUS createCurlResolverCache(PCurlApiCallbacks pCurlApiCallbacks, PCurlResolverCache* ppCurlResolverCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlResolverCache pCurlResolverCache = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pCurlApiCallbacks != NULL && pCurlApiCallbacks->pCallbacksProvider != NULL && ppCurlResolverCache != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    // Allocate the entire structure
+    pCurlResolverCache = (PCurlResolverCache) MEMCALLOC(1, SIZEOF(CurlResolverCache));
+    CHK(pCurlResolverCache != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pCurlResolverCache->pCurlApiCallbacks = pCurlApiCallbacks;
+    pCurlResolverCache->threadId = INVALID_TID_VALUE;
+    pCurlResolverCache->lock = INVALID_MUTEX_VALUE;
+    pCurlResolverCache->cvar = INVALID_CVAR_VALUE;
+    ATOMIC_STORE_BOOL(&pCurlResolverCache->shutdown, FALSE);
+
+    pCurlResolverCache->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pCurlResolverCache->lock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+
+    pCurlResolverCache->cvar = pCallbacksProvider->clientCallbacks.createConditionVariableFn(pCallbacksProvider->clientCallbacks.customData);
+    CHK(IS_VALID_CVAR_VALUE(pCurlResolverCache->cvar), STATUS_INVALID_OPERATION);
+
+    // Start the resolver thread
+    CHK_STATUS(THREAD_CREATE(&pCurlResolverCache->threadId, curlResolverCacheRoutine, (PVOID) pCurlResolverCache));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCurlResolverCache(&pCurlResolverCache);
+    }
+
+    // Set the return value if it's not NULL
+    if (ppCurlResolverCache != NULL) {
+        *ppCurlResolverCache = pCurlResolverCache;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the resolver cache object
+ *
+ * NOTE: The caller should have passed a pointer which was previously created by the corresponding function
+ * NOTE: The call is idempotent
+ */
+STATUS freeCurlResolverCache(PCurlResolverCache* ppCurlResolverCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlResolverCache pCurlResolverCache = NULL;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(ppCurlResolverCache != NULL, STATUS_NULL_ARG);
+
+    pCurlResolverCache = *ppCurlResolverCache;
+
+    // Call is idempotent
+    CHK(pCurlResolverCache != NULL, retStatus);
+
+    pCallbacksProvider = pCurlResolverCache->pCurlApiCallbacks->pCallbacksProvider;
+
+    // Stop the resolver thread
+    if (IS_VALID_TID_VALUE(pCurlResolverCache->threadId)) {
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+        ATOMIC_STORE_BOOL(&pCurlResolverCache->shutdown, TRUE);
+        pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->cvar);
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+
+        THREAD_JOIN(pCurlResolverCache->threadId, NULL);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pCurlResolverCache->cvar)) {
+        pCallbacksProvider->clientCallbacks.freeConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->cvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pCurlResolverCache->lock)) {
+        pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    }
+
+    // Release the object
+    MEMFREE(pCurlResolverCache);
+
+    // Set the pointer to NULL
+    *ppCurlResolverCache = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlResolverCacheAddUrl(PCurlResolverCache pCurlResolverCache, PCHAR url)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    PCurlResolvedHost pResolvedHost;
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+    UINT32 port;
+    BOOL locked = FALSE;
+
+    CHK(pCurlResolverCache != NULL && url != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlResolverCache->pCurlApiCallbacks->pCallbacksProvider;
+
+    CHK_STATUS(curlResolverCacheParseUrl(url, host, SIZEOF(host), &port));
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    locked = TRUE;
+
+    CHK_STATUS(curlResolverCacheTrackHost(pCurlResolverCache, host, port, pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData), &pResolvedHost));
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlResolverCacheGetResolveList(PCurlResolverCache pCurlResolverCache, PCHAR url, struct curl_slist** ppResolveList)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    PCurlResolvedHost pResolvedHost = NULL;
+    struct curl_slist* pResolveList = NULL;
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+    CHAR resolveEntry[MAX_URI_CHAR_LEN + 1 + 16 + CURL_RESOLVER_CACHE_MAX_ADDRESSES_LEN + 1];
+    UINT32 port;
+    BOOL locked = FALSE;
+
+    CHK(pCurlResolverCache != NULL && url != NULL && ppResolveList != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlResolverCache->pCurlApiCallbacks->pCallbacksProvider;
+
+    CHK_STATUS(curlResolverCacheParseUrl(url, host, SIZEOF(host), &port));
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    locked = TRUE;
+
+    // Start tracking the host so the next session to it finds it resolved
+    CHK_STATUS(curlResolverCacheTrackHost(pCurlResolverCache, host, port, pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData), &pResolvedHost));
+    CHK(pResolvedHost != NULL, retStatus);
+
+    if (pResolvedHost->addresses[0] != '\0') {
+        // The entry is in the host:port:address[,address] format of CURLOPT_RESOLVE
+        SNPRINTF(resolveEntry, SIZEOF(resolveEntry), "%s:%u:%s", pResolvedHost->host, pResolvedHost->port, pResolvedHost->addresses);
+    } else {
+        // The injected addresses never expire in the DNS cache of the multi handle or of the handle pool share,
+        // so they have to be removed explicitly for the session to resolve the host on its own.
+        // Removing an entry which isn't there is a no-op.
+        SNPRINTF(resolveEntry, SIZEOF(resolveEntry), "-%s:%u", pResolvedHost->host, pResolvedHost->port);
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    locked = FALSE;
+
+    pResolveList = curl_slist_append(NULL, resolveEntry);
+    CHK(pResolveList != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    }
+
+    if (ppResolveList != NULL) {
+        *ppResolveList = pResolveList;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Resolves the due hosts one at a time without holding the lock. The earliest due host is picked first.
+ */
+PVOID curlResolverCacheRoutine(PVOID args)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PCurlResolverCache pCurlResolverCache = (PCurlResolverCache) args;
+    PCallbacksProvider pCallbacksProvider = NULL;
+    PCurlResolvedHost pResolvedHost, pDueHost;
+    CHAR host[MAX_URI_CHAR_LEN + 1], addresses[CURL_RESOLVER_CACHE_MAX_ADDRESSES_LEN + 1];
+    UINT32 i, port;
+    UINT64 currentTime;
+    BOOL locked = FALSE;
+
+    CHK(pCurlResolverCache != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlResolverCache->pCurlApiCallbacks->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    locked = TRUE;
+
+    while (!ATOMIC_LOAD_BOOL(&pCurlResolverCache->shutdown)) {
+        currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+        curlResolverCacheEvictIdleHosts(pCurlResolverCache, currentTime);
+
+        for (i = 0, pDueHost = NULL; i < pCurlResolverCache->hostCount; i++) {
+            pResolvedHost = &pCurlResolverCache->hosts[i];
+            if (pDueHost == NULL || pResolvedHost->refreshTime < pDueHost->refreshTime) {
+                pDueHost = pResolvedHost;
+            }
+        }
+
+        if (pDueHost == NULL || pDueHost->refreshTime > currentTime) {
+            // Await for the earliest refresh to become due or for a new host to be added
+            status = pCallbacksProvider->clientCallbacks.waitConditionVariableFn(pCallbacksProvider->clientCallbacks.customData,
+                                                                                  pCurlResolverCache->cvar,
+                                                                                  pCurlResolverCache->lock,
+                                                                                  pDueHost == NULL ? INFINITE_TIME_VALUE : pDueHost->refreshTime - currentTime);
+            CHK(status == STATUS_SUCCESS || status == STATUS_OPERATION_TIMED_OUT, status);
+            continue;
+        }
+
+        STRCPY(host, pDueHost->host);
+        port = pDueHost->port;
+
+        // Don't pick the host again should the resolution fail
+        pDueHost->refreshTime = currentTime + CURL_RESOLVER_CACHE_RETRY_INTERVAL;
+
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+        locked = FALSE;
+
+        status = curlResolverCacheResolve(host, addresses, SIZEOF(addresses));
+
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+        locked = TRUE;
+
+        // The host might have been evicted meanwhile
+        pResolvedHost = curlResolverCacheFindHost(pCurlResolverCache, host, port);
+        currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+        if (pResolvedHost == NULL) {
+            continue;
+        }
+
+        if (STATUS_SUCCEEDED(status)) {
+            STRCPY(pResolvedHost->addresses, addresses);
+            pResolvedHost->resolvedTime = currentTime;
+            pResolvedHost->refreshTime = currentTime + CURL_RESOLVER_CACHE_DEFAULT_TTL;
+        } else {
+            DLOGW("Failed to resolve %s with error: 0x%08x", host, status);
+
+            // Keep using the last known addresses for a while as the endpoints rarely move
+            if (pResolvedHost->resolvedTime + CURL_RESOLVER_CACHE_MAX_STALE_PERIOD <= currentTime) {
+                pResolvedHost->addresses[0] = '\0';
+            }
+        }
+    }
+
+CleanUp:
+
+    if (locked) {
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->lock);
+    }
+
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+/**
+ * Extracts the host and the port of the url. The port defaults to the one of the scheme.
+ */
+STATUS curlResolverCacheParseUrl(PCHAR url, PCHAR pHost, UINT32 hostLen, PUINT32 pPort)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pStart, pEnd, pPortEnd;
+    UINT64 port;
+    UINT32 len;
+
+    CHK(url != NULL && pHost != NULL && pPort != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(getRequestHost(url, &pStart, &pEnd));
+    len = (UINT32) (pEnd - pStart);
+    CHK(len != 0 && len < hostLen, STATUS_INVALID_ARG_LEN);
+
+    STRNCPY(pHost, pStart, len);
+    pHost[len] = '\0';
+
+    if (*pEnd == ':') {
+        for (pPortEnd = pEnd + 1; *pPortEnd >= '0' && *pPortEnd <= '9'; pPortEnd++);
+        CHK_STATUS(STRTOUI64(pEnd + 1, pPortEnd, 10, &port));
+        CHK(port != 0 && port <= 0xFFFF, STATUS_INVALID_ARG);
+        *pPort = (UINT32) port;
+    } else {
+        *pPort = (0 == STRNCMPI(url, "https", 5)) ? CURL_RESOLVER_CACHE_HTTPS_PORT : CURL_RESOLVER_CACHE_HTTP_PORT;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Finds the tracked host. Should be called with the lock held.
+ */
+PCurlResolvedHost curlResolverCacheFindHost(PCurlResolverCache pCurlResolverCache, PCHAR host, UINT32 port)
+{
+    UINT32 i;
+
+    for (i = 0; i < pCurlResolverCache->hostCount; i++) {
+        if (pCurlResolverCache->hosts[i].port == port && 0 == STRCMPI(pCurlResolverCache->hosts[i].host, host)) {
+            return &pCurlResolverCache->hosts[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Finds or starts tracking the host waking up the resolver for a new one. Returns a NULL host if the table is full.
+ * Should be called with the lock held.
+ */
+STATUS curlResolverCacheTrackHost(PCurlResolverCache pCurlResolverCache, PCHAR host, UINT32 port, UINT64 currentTime,
+                                  PCurlResolvedHost* ppResolvedHost)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider = pCurlResolverCache->pCurlApiCallbacks->pCallbacksProvider;
+    PCurlResolvedHost pResolvedHost;
+
+    pResolvedHost = curlResolverCacheFindHost(pCurlResolverCache, host, port);
+
+    if (pResolvedHost == NULL) {
+        curlResolverCacheEvictIdleHosts(pCurlResolverCache, currentTime);
+
+        // The sessions to the hosts which don't fit resolve on their own. Report it only once per table fill up
+        if (pCurlResolverCache->hostCount == CURL_RESOLVER_CACHE_MAX_HOST_COUNT) {
+            if (!pCurlResolverCache->fullReported) {
+                DLOGW("Resolver cache is full with %u hosts. Not caching %s", CURL_RESOLVER_CACHE_MAX_HOST_COUNT, host);
+                pCurlResolverCache->fullReported = TRUE;
+            }
+
+            CHK(FALSE, retStatus);
+        }
+
+        pResolvedHost = &pCurlResolverCache->hosts[pCurlResolverCache->hostCount++];
+        MEMSET(pResolvedHost, 0x00, SIZEOF(CurlResolvedHost));
+        STRCPY(pResolvedHost->host, host);
+        pResolvedHost->port = port;
+
+        // Due right away
+        pResolvedHost->refreshTime = currentTime;
+        pCallbacksProvider->clientCallbacks.signalConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlResolverCache->cvar);
+    }
+
+    pResolvedHost->lastUsedTime = currentTime;
+
+CleanUp:
+
+    if (ppResolvedHost != NULL) {
+        *ppResolvedHost = STATUS_SUCCEEDED(retStatus) ? pResolvedHost : NULL;
+    }
+
+    return retStatus;
+}
+
+/**
+ * Evicts the hosts which haven't been used for a while. Should be called with the lock held.
+ */
+VOID curlResolverCacheEvictIdleHosts(PCurlResolverCache pCurlResolverCache, UINT64 currentTime)
+{
+    UINT32 i = 0;
+
+    while (i < pCurlResolverCache->hostCount) {
+        if (pCurlResolverCache->hosts[i].lastUsedTime + CURL_RESOLVER_CACHE_IDLE_PERIOD <= currentTime) {
+            // Move the last host into the slot
+            pCurlResolverCache->hostCount--;
+            pCurlResolverCache->fullReported = FALSE;
+            if (i != pCurlResolverCache->hostCount) {
+                MEMCPY(&pCurlResolverCache->hosts[i], &pCurlResolverCache->hosts[pCurlResolverCache->hostCount], SIZEOF(CurlResolvedHost));
+            }
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Resolves the host with the system resolver into a comma separated address list
+ */
+STATUS curlResolverCacheResolve(PCHAR host, PCHAR addresses, UINT32 addressesLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    struct addrinfo hints;
+    struct addrinfo* pAddrInfo = NULL;
+    struct addrinfo* pCurAddrInfo;
+    CHAR address[INET6_ADDRSTRLEN];
+    PVOID pAddress;
+    UINT32 count = 0, offset = 0;
+    INT32 written;
+    BOOL ipv6;
+
+    CHK(host != NULL && addresses != NULL, STATUS_NULL_ARG);
+    addresses[0] = '\0';
+
+    MEMSET(&hints, 0x00, SIZEOF(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    CHK(0 == getaddrinfo(host, NULL, &hints, &pAddrInfo), STATUS_RESOLVE_HOST_FAILED);
+
+    for (pCurAddrInfo = pAddrInfo; pCurAddrInfo != NULL && count < CURL_RESOLVER_CACHE_MAX_ADDRESS_COUNT; pCurAddrInfo = pCurAddrInfo->ai_next) {
+        if (pCurAddrInfo->ai_family == AF_INET) {
+            pAddress = &((struct sockaddr_in*) pCurAddrInfo->ai_addr)->sin_addr;
+            ipv6 = FALSE;
+        } else if (pCurAddrInfo->ai_family == AF_INET6) {
+            pAddress = &((struct sockaddr_in6*) pCurAddrInfo->ai_addr)->sin6_addr;
+            ipv6 = TRUE;
+        } else {
+            continue;
+        }
+
+        if (NULL == inet_ntop(pCurAddrInfo->ai_family, pAddress, address, SIZEOF(address))) {
+            continue;
+        }
+
+        // IPv6 addresses are bracketed in the curl resolve format
+        written = SNPRINTF(addresses + offset, addressesLen - offset, "%s%s%s%s", count == 0 ? "" : ",", ipv6 ? "[" : "", address, ipv6 ? "]" : "");
+        CHK(written > 0 && offset + (UINT32) written < addressesLen, STATUS_BUFFER_TOO_SMALL);
+        offset += (UINT32) written;
+        count++;
+    }
+
+    CHK(count != 0, STATUS_RESOLVE_HOST_FAILED);
+
+CleanUp:
+
+    if (pAddrInfo != NULL) {
+        freeaddrinfo(pAddrInfo);
+    }
+
+    return retStatus;
+}
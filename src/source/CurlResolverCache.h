@@ -0,0 +1,162 @@
+/*******************************************
+CURL resolver cache internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CURL_RESOLVER_CACHE_INCLUDE_I__
+#define __KINESIS_VIDEO_CURL_RESOLVER_CACHE_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Max number of the hosts tracked by the cache
+#define CURL_RESOLVER_CACHE_MAX_HOST_COUNT                  32
+
+// Max number of the resolved addresses injected into a session per host
+#define CURL_RESOLVER_CACHE_MAX_ADDRESS_COUNT               4
+
+// Max length of a single textual address including the IPv6 brackets
+#define CURL_RESOLVER_CACHE_MAX_ADDRESS_LEN                 (INET6_ADDRSTRLEN + 2)
+
+// Max length of the comma separated address list
+#define CURL_RESOLVER_CACHE_MAX_ADDRESSES_LEN               (CURL_RESOLVER_CACHE_MAX_ADDRESS_COUNT * (CURL_RESOLVER_CACHE_MAX_ADDRESS_LEN + 1))
+
+// Period after which the resolved addresses are refreshed. The system resolver doesn't expose the record TTL
+// so this acts as the TTL of the cached addresses
+#define CURL_RESOLVER_CACHE_DEFAULT_TTL                     (30 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Retry interval of a failed resolution. The previously resolved addresses keep being used meanwhile
+#define CURL_RESOLVER_CACHE_RETRY_INTERVAL                  (2 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Max age of the addresses which failed to refresh after which the sessions resolve the host on their own
+#define CURL_RESOLVER_CACHE_MAX_STALE_PERIOD                (10 * 60 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Hosts with no sessions for this long stop being refreshed and are evicted
+#define CURL_RESOLVER_CACHE_IDLE_PERIOD                     (10 * 60 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Default ports of the schemes
+#define CURL_RESOLVER_CACHE_HTTPS_PORT                      443
+#define CURL_RESOLVER_CACHE_HTTP_PORT                       80
+
+/**
+ * Forward declarations
+ */
+struct __CurlApiCallbacks;
+
+/**
+ * Host tracked by the resolver cache
+ */
+typedef struct __CurlResolvedHost CurlResolvedHost;
+struct __CurlResolvedHost {
+    // Host name and port as they appear in the request urls
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+    UINT32 port;
+
+    // Comma separated resolved addresses in the curl resolve format. Empty if not resolved yet
+    CHAR addresses[CURL_RESOLVER_CACHE_MAX_ADDRESSES_LEN + 1];
+
+    // Time of the last successful resolution
+    UINT64 resolvedTime;
+
+    // Time the host is due to be resolved again
+    UINT64 refreshTime;
+
+    // Time the host was last used by a session
+    UINT64 lastUsedTime;
+};
+typedef struct __CurlResolvedHost* PCurlResolvedHost;
+
+/**
+ * Cache of the resolved endpoint addresses. The hosts are resolved and refreshed on a background thread
+ * and the addresses are injected into the new sessions so the session threads never block on DNS.
+ */
+typedef struct __CurlResolverCache CurlResolverCache;
+struct __CurlResolverCache {
+    // Back pointer to the curl API callbacks object
+    struct __CurlApiCallbacks* pCurlApiCallbacks;
+
+    // Tracked hosts
+    CurlResolvedHost hosts[CURL_RESOLVER_CACHE_MAX_HOST_COUNT];
+    UINT32 hostCount;
+
+    // Lock guarding the hosts
+    MUTEX lock;
+
+    // Signaled when a new host is added or on shutdown
+    CVAR cvar;
+
+    // Resolver thread
+    TID threadId;
+
+    // Whether the resolver thread should exit
+    volatile ATOMIC_BOOL shutdown;
+
+    // Whether the table being full has been reported since the last eviction
+    BOOL fullReported;
+};
+typedef struct __CurlResolverCache* PCurlResolverCache;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a resolver cache object and starts the resolver thread
+ *
+ * @param - PCurlApiCallbacks - IN - Curl API callbacks object owning the cache
+ * @param - PCurlResolverCache* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCurlResolverCache(struct __CurlApiCallbacks*, PCurlResolverCache*);
+
+/**
+ * Stops the resolver thread and frees the resolver cache object
+ *
+ * NOTE: The thread might be blocked in the system resolver for the duration of its timeout.
+ * NOTE: The call is idempotent
+ *
+ * @param - PCurlResolverCache* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCurlResolverCache(PCurlResolverCache*);
+
+/**
+ * Schedules the host of the url to be resolved in the background if it's not tracked already
+ *
+ * @param - PCurlResolverCache - IN - Resolver cache object
+ * @param - PCHAR - IN - Url of the endpoint
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlResolverCacheAddUrl(PCurlResolverCache, PCHAR);
+
+/**
+ * Returns the resolve list to set on the session for the url. The host of the url is scheduled
+ * to be resolved if it's not tracked already. The list removes the previously injected addresses
+ * from the DNS cache of the session if the host has no resolved addresses.
+ *
+ * @param - PCurlResolverCache - IN - Resolver cache object
+ * @param - PCHAR - IN - Url of the request
+ * @param - struct curl_slist** - OUT - Resolve list to be freed by the caller once the session is done. NULL if the host isn't tracked
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlResolverCacheGetResolveList(PCurlResolverCache, PCHAR, struct curl_slist**);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID curlResolverCacheRoutine(PVOID);
+STATUS curlResolverCacheParseUrl(PCHAR, PCHAR, UINT32, PUINT32);
+PCurlResolvedHost curlResolverCacheFindHost(PCurlResolverCache, PCHAR, UINT32);
+STATUS curlResolverCacheTrackHost(PCurlResolverCache, PCHAR, UINT32, UINT64, PCurlResolvedHost*);
+VOID curlResolverCacheEvictIdleHosts(PCurlResolverCache, UINT64);
+STATUS curlResolverCacheResolve(PCHAR, PCHAR, UINT32);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CURL_RESOLVER_CACHE_INCLUDE_I__ */
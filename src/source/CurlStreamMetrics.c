@@ -0,0 +1,311 @@
+/**
+ * Kinesis Video Producer per-stream curl transport metrics
+ */
+#define LOG_CLASS "CurlStreamMetrics"
+#include "Include_i.h"
+
+STATUS createCurlStreamMetricsTracker(PCallbacksProvider pCallbacksProvider, PCurlStreamMetricsTracker* ppTracker)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlStreamMetricsTracker pTracker = NULL;
+
+    CHK(pCallbacksProvider != NULL && ppTracker != NULL, STATUS_NULL_ARG);
+
+    pTracker = (PCurlStreamMetricsTracker) MEMCALLOC(1, SIZEOF(CurlStreamMetricsTracker));
+    CHK(pTracker != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pTracker->pCallbacksProvider = pCallbacksProvider;
+    pTracker->metrics.version = CURL_STREAM_METRICS_CURRENT_VERSION;
+    pTracker->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
+    CHK(pTracker->lock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        freeCurlStreamMetricsTracker(&pTracker);
+    }
+
+    if (ppTracker != NULL) {
+        *ppTracker = pTracker;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS freeCurlStreamMetricsTracker(PCurlStreamMetricsTracker* ppTracker)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlStreamMetricsTracker pTracker = NULL;
+
+    CHK(ppTracker != NULL, STATUS_NULL_ARG);
+
+    pTracker = *ppTracker;
+
+    // Call is idempotent
+    CHK(pTracker != NULL, retStatus);
+
+    if (pTracker->lock != INVALID_MUTEX_VALUE) {
+        pTracker->pCallbacksProvider->clientCallbacks.freeMutexFn(pTracker->pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+    }
+
+    MEMFREE(pTracker);
+
+    *ppTracker = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS curlStreamMetricsSessionStarted(PCurlStreamMetricsTracker pTracker)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+
+    CHK(pTracker != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    if (pTracker->metrics.uploadSessionCount != 0) {
+        pTracker->metrics.reconnectCount++;
+    }
+
+    pTracker->metrics.uploadSessionCount++;
+    pTracker->sessionStartTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    // Any pause of the previous session has been accounted for on its completion
+    pTracker->paused = FALSE;
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlStreamMetricsSessionCompleted(PCurlStreamMetricsTracker pTracker, CURL* pCurl)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    DOUBLE connectTime = 0, tlsHandshakeTime = 0, firstByteTime = 0;
+    UINT64 currentTime;
+
+    CHK(pTracker != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    // Query curl outside of the lock. The times are in seconds from the start of the transfer
+    if (pCurl != NULL) {
+        curl_easy_getinfo(pCurl, CURLINFO_CONNECT_TIME, &connectTime);
+        curl_easy_getinfo(pCurl, CURLINFO_APPCONNECT_TIME, &tlsHandshakeTime);
+        curl_easy_getinfo(pCurl, CURLINFO_STARTTRANSFER_TIME, &firstByteTime);
+    }
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    if (pTracker->sessionStartTime != 0) {
+        pTracker->uploadDuration += currentTime - pTracker->sessionStartTime;
+        pTracker->sessionStartTime = 0;
+    }
+
+    if (pTracker->paused) {
+        pTracker->metrics.pausedDuration += currentTime - pTracker->pauseStartTime;
+        pTracker->paused = FALSE;
+    }
+
+    // Nothing is uploaded until the next session starts
+    if (pTracker->bandwidthIdleStartTime == 0) {
+        pTracker->bandwidthIdleStartTime = currentTime;
+    }
+
+    if (pCurl != NULL) {
+        pTracker->metrics.connectTime = (UINT64) (connectTime * HUNDREDS_OF_NANOS_IN_A_SECOND);
+        pTracker->metrics.tlsHandshakeTime = (UINT64) (tlsHandshakeTime * HUNDREDS_OF_NANOS_IN_A_SECOND);
+        pTracker->metrics.firstByteTime = (UINT64) (firstByteTime * HUNDREDS_OF_NANOS_IN_A_SECOND);
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlStreamMetricsChunkSent(PCurlStreamMetricsTracker pTracker, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    UINT64 currentTime, elapsed;
+
+    CHK(pTracker != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+    pTracker->metrics.bytesSent += size;
+    pTracker->metrics.chunksSent++;
+
+    // Leave the pause or the gap between the sessions out of the sampling period
+    if (pTracker->bandwidthIdleStartTime != 0) {
+        if (pTracker->bandwidthSampleStartTime != 0) {
+            pTracker->bandwidthSampleStartTime += currentTime - pTracker->bandwidthIdleStartTime;
+        }
+
+        pTracker->bandwidthIdleStartTime = 0;
+    }
+
+    // Fold the bytes accumulated over the sampling period into the upload bitrate average
+    if (pTracker->bandwidthSampleStartTime == 0) {
+        pTracker->bandwidthSampleStartTime = currentTime;
+    }
+
+    pTracker->bandwidthSampleBytes += size;
+    elapsed = currentTime - pTracker->bandwidthSampleStartTime;
+    if (elapsed >= CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD) {
+        pTracker->uploadBitrate = CURL_STREAM_METRICS_EWMA_NEXT(pTracker->uploadBitrate,
+                                                                (DOUBLE) pTracker->bandwidthSampleBytes * 8 * HUNDREDS_OF_NANOS_IN_A_SECOND / elapsed);
+        pTracker->bandwidthSampleStartTime = currentTime;
+        pTracker->bandwidthSampleBytes = 0;
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlStreamMetricsSetPaused(PCurlStreamMetricsTracker pTracker, BOOL paused)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    UINT64 currentTime;
+
+    CHK(pTracker != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    // Only count the transitions
+    if (paused && !pTracker->paused) {
+        pTracker->metrics.pauseCount++;
+        pTracker->pauseStartTime = currentTime;
+        pTracker->paused = TRUE;
+        if (pTracker->bandwidthIdleStartTime == 0) {
+            pTracker->bandwidthIdleStartTime = currentTime;
+        }
+    } else if (!paused && pTracker->paused) {
+        pTracker->metrics.unpauseCount++;
+        pTracker->metrics.pausedDuration += currentTime - pTracker->pauseStartTime;
+        pTracker->paused = FALSE;
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlStreamMetricsAckReceived(PCurlStreamMetricsTracker pTracker, PFragmentAck pFragmentAck)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    PCurlStreamMetricsPendingAck pPendingAck;
+    UINT64 currentTime, roundTrip;
+    UINT64 bucketBounds[CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_COUNT] = CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_BOUNDS;
+    UINT32 i, bucket;
+
+    CHK(pTracker != NULL && pFragmentAck != NULL, STATUS_NULL_ARG);
+    CHK(pFragmentAck->ackType == FRAGMENT_ACK_TYPE_BUFFERING || pFragmentAck->ackType == FRAGMENT_ACK_TYPE_PERSISTED, retStatus);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    if (pFragmentAck->ackType == FRAGMENT_ACK_TYPE_BUFFERING) {
+        // Overwrite the oldest slot in case the persisted ACK has never arrived
+        pPendingAck = &pTracker->pendingAcks[pTracker->nextPendingAckIndex];
+        pPendingAck->timestamp = pFragmentAck->timestamp;
+        pPendingAck->bufferingTime = currentTime;
+        pPendingAck->bytesSent = pTracker->metrics.bytesSent;
+        pTracker->nextPendingAckIndex = (pTracker->nextPendingAckIndex + 1) % CURL_STREAM_METRICS_PENDING_ACK_COUNT;
+    } else {
+        pTracker->metrics.persistedAckCount++;
+
+        for (i = 0; i < CURL_STREAM_METRICS_PENDING_ACK_COUNT; i++) {
+            pPendingAck = &pTracker->pendingAcks[i];
+            if (pPendingAck->bufferingTime != 0 && pPendingAck->timestamp == pFragmentAck->timestamp) {
+                roundTrip = currentTime - pPendingAck->bufferingTime;
+                for (bucket = 0; bucket < CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_COUNT - 1 && roundTrip >= bucketBounds[bucket]; bucket++);
+                pTracker->metrics.ackRoundTripHistogram[bucket]++;
+
+                // The bytes sent between the BUFFERING ACKs of the consecutive persisted fragments have been persisted
+                if (pTracker->lastPersistedTime != 0 && currentTime > pTracker->lastPersistedTime &&
+                    pPendingAck->bytesSent > pTracker->lastPersistedBytes) {
+                    pTracker->persistedBitrate = CURL_STREAM_METRICS_EWMA_NEXT(pTracker->persistedBitrate,
+                                                                               (DOUBLE) (pPendingAck->bytesSent - pTracker->lastPersistedBytes) * 8 *
+                                                                                   HUNDREDS_OF_NANOS_IN_A_SECOND / (currentTime - pTracker->lastPersistedTime));
+                }
+
+                pTracker->lastPersistedTime = currentTime;
+                pTracker->lastPersistedBytes = pPendingAck->bytesSent;
+                pPendingAck->bufferingTime = 0;
+                break;
+            }
+        }
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlStreamMetricsGetSnapshot(PCurlStreamMetricsTracker pTracker, PCurlStreamMetrics pMetrics)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    UINT64 currentTime, uploadDuration;
+
+    CHK(pTracker != NULL && pMetrics != NULL, STATUS_NULL_ARG);
+    pCallbacksProvider = pTracker->pCallbacksProvider;
+
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    *pMetrics = pTracker->metrics;
+    pMetrics->uploadBitrate = (UINT64) pTracker->uploadBitrate;
+    pMetrics->persistedBitrate = (UINT64) pTracker->persistedBitrate;
+
+    // Account for the ongoing session and pause
+    uploadDuration = pTracker->uploadDuration;
+    if (pTracker->sessionStartTime != 0) {
+        uploadDuration += currentTime - pTracker->sessionStartTime;
+    }
+
+    if (pTracker->paused) {
+        pMetrics->pausedDuration += currentTime - pTracker->pauseStartTime;
+    }
+
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pTracker->lock);
+
+    pMetrics->chunksPerSecond = uploadDuration == 0 ? 0 :
+                                (DOUBLE) pMetrics->chunksSent * HUNDREDS_OF_NANOS_IN_A_SECOND / uploadDuration;
+
+CleanUp:
+
+    return retStatus;
+}
@@ -0,0 +1,192 @@
+/*******************************************
+CURL stream metrics internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_CURL_STREAM_METRICS_INCLUDE_I__
+#define __KINESIS_VIDEO_CURL_STREAM_METRICS_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Number of the fragments awaiting the persisted ACK tracked for the round trip measurement
+#define CURL_STREAM_METRICS_PENDING_ACK_COUNT               32
+
+// Upper bounds of the ACK round trip histogram buckets. The last bucket is unbounded.
+#define CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_BOUNDS     {50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,       \
+                                                             100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,      \
+                                                             250 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,      \
+                                                             500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,      \
+                                                             1000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,     \
+                                                             2500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,     \
+                                                             5000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,     \
+                                                             MAX_UINT64}
+
+// Period the bytes handed to curl are accumulated over before being folded into the upload bitrate average
+#define CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD         (1 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// Weight of the latest sample in the bitrate moving averages
+#define CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA            0.2
+
+#define CURL_STREAM_METRICS_EWMA_NEXT(avg, sample)          ((avg) == 0 ? (sample) : \
+                                                             CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA * (sample) + \
+                                                             (1 - CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA) * (avg))
+
+/**
+ * Forward declarations
+ */
+struct __CallbacksProvider;
+
+/**
+ * Fragment awaiting the persisted ACK
+ */
+typedef struct __CurlStreamMetricsPendingAck CurlStreamMetricsPendingAck;
+struct __CurlStreamMetricsPendingAck {
+    // Fragment timestamp from the BUFFERING ACK
+    UINT64 timestamp;
+
+    // Time the BUFFERING ACK has been received. 0 if the slot is free
+    UINT64 bufferingTime;
+
+    // Bytes handed to curl by the time the BUFFERING ACK has been received
+    UINT64 bytesSent;
+};
+typedef struct __CurlStreamMetricsPendingAck* PCurlStreamMetricsPendingAck;
+
+/**
+ * Per-stream metrics tracker. Updated by the putMedia sessions of the stream and snapshotted
+ * by the metrics query. Each stream has its own lock so the sessions of different streams don't contend.
+ */
+typedef struct __CurlStreamMetricsTracker CurlStreamMetricsTracker;
+struct __CurlStreamMetricsTracker {
+    // Back pointer to the callbacks provider for the locking and the time functions
+    struct __CallbacksProvider* pCallbacksProvider;
+
+    // Lock guarding the tracker
+    MUTEX lock;
+
+    // Accumulated metrics
+    CurlStreamMetrics metrics;
+
+    // Whether the upload is currently paused and since when
+    BOOL paused;
+    UINT64 pauseStartTime;
+
+    // Start time of the ongoing session. 0 if none
+    UINT64 sessionStartTime;
+
+    // Accumulated duration of the completed sessions
+    UINT64 uploadDuration;
+
+    // Fragments awaiting the persisted ACK
+    CurlStreamMetricsPendingAck pendingAcks[CURL_STREAM_METRICS_PENDING_ACK_COUNT];
+
+    // Next slot to use for the pending ACK
+    UINT32 nextPendingAckIndex;
+
+    // Start of the upload bitrate sampling period and the bytes handed to curl since
+    UINT64 bandwidthSampleStartTime;
+    UINT64 bandwidthSampleBytes;
+
+    // Start of the pause or the gap between the sessions excluded from the sampling period. 0 if uploading
+    UINT64 bandwidthIdleStartTime;
+
+    // Bitrate moving averages
+    DOUBLE uploadBitrate;
+    DOUBLE persistedBitrate;
+
+    // Time of the last matched persisted ACK and the bytes sent by its BUFFERING ACK. 0 if none
+    UINT64 lastPersistedTime;
+    UINT64 lastPersistedBytes;
+};
+typedef struct __CurlStreamMetricsTracker* PCurlStreamMetricsTracker;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates a stream metrics tracker
+ *
+ * @param - PCallbacksProvider - IN - Callbacks provider object
+ * @param - PCurlStreamMetricsTracker* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createCurlStreamMetricsTracker(struct __CallbacksProvider*, PCurlStreamMetricsTracker*);
+
+/**
+ * Frees the stream metrics tracker
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PCurlStreamMetricsTracker* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeCurlStreamMetricsTracker(PCurlStreamMetricsTracker*);
+
+/**
+ * Notes a putMedia session start
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsSessionStarted(PCurlStreamMetricsTracker);
+
+/**
+ * Notes a putMedia session completion and captures the connection timings of the session
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ * @param - CURL* - IN/OPT - Curl object of the completed session
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsSessionCompleted(PCurlStreamMetricsTracker, CURL*);
+
+/**
+ * Notes a chunk handed to curl
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ * @param - UINT64 - IN - Size of the chunk in bytes
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsChunkSent(PCurlStreamMetricsTracker, UINT64);
+
+/**
+ * Notes the upload being paused or un-paused
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ * @param - BOOL - IN - Whether paused
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsSetPaused(PCurlStreamMetricsTracker, BOOL);
+
+/**
+ * Notes a fragment ACK and measures the round trip on the persisted ACK
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ * @param - PFragmentAck - IN - Received ACK
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsAckReceived(PCurlStreamMetricsTracker, PFragmentAck);
+
+/**
+ * Fills in a snapshot of the metrics
+ *
+ * @param - PCurlStreamMetricsTracker - IN - Tracker object
+ * @param - PCurlStreamMetrics - OUT - Metrics snapshot
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlStreamMetricsGetSnapshot(PCurlStreamMetricsTracker, PCurlStreamMetrics);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_CURL_STREAM_METRICS_INCLUDE_I__ */
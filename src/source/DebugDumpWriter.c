@@ -0,0 +1,465 @@
+/**
+ * Kinesis Video Producer debug dump writer
+ */
+#define LOG_CLASS "DebugDumpWriter"
+#include "Include_i.h"
+
+/**
+ * Create the debug dump writer
+ */
+STATUS createDebugDumpWriter(UINT64 maxFileSize, UINT32 maxFileCount, PDebugDumpWriter* ppDebugDumpWriter)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PDebugDumpWriter pDebugDumpWriter = NULL;
+
+    CHK(ppDebugDumpWriter != NULL, STATUS_NULL_ARG);
+    CHK(maxFileSize != 0 && maxFileCount != 0, STATUS_INVALID_ARG);
+
+    pDebugDumpWriter = (PDebugDumpWriter) MEMCALLOC(1, SIZEOF(DebugDumpWriter));
+    CHK(pDebugDumpWriter != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pDebugDumpWriter->lock = INVALID_MUTEX_VALUE;
+    pDebugDumpWriter->cvar = INVALID_CVAR_VALUE;
+    pDebugDumpWriter->removedCvar = INVALID_CVAR_VALUE;
+    pDebugDumpWriter->writerThreadId = INVALID_TID_VALUE;
+    pDebugDumpWriter->maxFileSize = maxFileSize;
+    pDebugDumpWriter->maxFileCount = maxFileCount;
+    ATOMIC_STORE_BOOL(&pDebugDumpWriter->shutdown, FALSE);
+
+    CHK_STATUS(doubleListCreate(&pDebugDumpWriter->pFiles));
+
+    pDebugDumpWriter->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pDebugDumpWriter->lock), STATUS_INVALID_OPERATION);
+    pDebugDumpWriter->cvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pDebugDumpWriter->cvar), STATUS_INVALID_OPERATION);
+    pDebugDumpWriter->removedCvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pDebugDumpWriter->removedCvar), STATUS_INVALID_OPERATION);
+
+    CHK_STATUS(THREAD_CREATE(&pDebugDumpWriter->writerThreadId, debugDumpWriterRoutine, (PVOID) pDebugDumpWriter));
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        freeDebugDumpWriter(&pDebugDumpWriter);
+    }
+
+    if (ppDebugDumpWriter != NULL) {
+        *ppDebugDumpWriter = pDebugDumpWriter;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the debug dump writer
+ */
+STATUS freeDebugDumpWriter(PDebugDumpWriter* ppDebugDumpWriter)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PDebugDumpWriter pDebugDumpWriter = NULL;
+    PDoubleListNode pNode = NULL;
+    PDebugDumpFile pDebugDumpFile = NULL;
+
+    CHK(ppDebugDumpWriter != NULL, STATUS_NULL_ARG);
+
+    pDebugDumpWriter = *ppDebugDumpWriter;
+
+    // Call is idempotent
+    CHK(pDebugDumpWriter != NULL, retStatus);
+
+    // Stop the writer thread which drains the ring buffers before exiting
+    if (IS_VALID_TID_VALUE(pDebugDumpWriter->writerThreadId)) {
+        MUTEX_LOCK(pDebugDumpWriter->lock);
+        ATOMIC_STORE_BOOL(&pDebugDumpWriter->shutdown, TRUE);
+        CVAR_SIGNAL(pDebugDumpWriter->cvar);
+        MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+        THREAD_JOIN(pDebugDumpWriter->writerThreadId, NULL);
+        pDebugDumpWriter->writerThreadId = INVALID_TID_VALUE;
+    }
+
+    // Release the dumps which were never removed. Their data has been written out already.
+    if (pDebugDumpWriter->pFiles != NULL) {
+        doubleListGetHeadNode(pDebugDumpWriter->pFiles, &pNode);
+        while (pNode != NULL) {
+            pDebugDumpFile = (PDebugDumpFile) pNode->data;
+            pNode = pNode->pNext;
+            debugDumpFileFree(&pDebugDumpFile);
+        }
+
+        doubleListFree(pDebugDumpWriter->pFiles);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pDebugDumpWriter->removedCvar)) {
+        CVAR_FREE(pDebugDumpWriter->removedCvar);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pDebugDumpWriter->cvar)) {
+        CVAR_FREE(pDebugDumpWriter->cvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pDebugDumpWriter->lock)) {
+        MUTEX_FREE(pDebugDumpWriter->lock);
+    }
+
+    MEMFREE(pDebugDumpWriter);
+
+    *ppDebugDumpWriter = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Creates the dump and adds it to the list drained by the writer thread
+ */
+STATUS debugDumpWriterAddFile(PDebugDumpWriter pDebugDumpWriter, PCHAR filePathPrefix, PDebugDumpFile* ppDebugDumpFile)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PDebugDumpFile pDebugDumpFile = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pDebugDumpWriter != NULL && filePathPrefix != NULL && ppDebugDumpFile != NULL, STATUS_NULL_ARG);
+    CHK(STRNLEN(filePathPrefix, MAX_PATH_LEN + 1) <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+
+    // Allocate the struct with the ring buffer following it
+    pDebugDumpFile = (PDebugDumpFile) MEMALLOC(SIZEOF(DebugDumpFile) + DEBUG_DUMP_WRITER_BUFFER_SIZE);
+    CHK(pDebugDumpFile != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    MEMSET(pDebugDumpFile, 0x00, SIZEOF(DebugDumpFile));
+    pDebugDumpFile->ringBuffer = (PBYTE) (pDebugDumpFile + 1);
+    pDebugDumpFile->ringBufferLen = DEBUG_DUMP_WRITER_BUFFER_SIZE;
+    pDebugDumpFile->maxFileSize = pDebugDumpWriter->maxFileSize;
+    pDebugDumpFile->maxFileCount = pDebugDumpWriter->maxFileCount;
+    STRNCPY(pDebugDumpFile->filePathPrefix, filePathPrefix, MAX_PATH_LEN);
+    pDebugDumpFile->filePathPrefix[MAX_PATH_LEN] = '\0';
+
+    // Open the first file to override any existing file with the same name
+    CHK_STATUS(debugDumpFileOpen(pDebugDumpFile));
+
+    MUTEX_LOCK(pDebugDumpWriter->lock);
+    locked = TRUE;
+    CHK_STATUS(doubleListInsertItemTail(pDebugDumpWriter->pFiles, (UINT64) pDebugDumpFile));
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pDebugDumpWriter->lock);
+    }
+
+    if (STATUS_FAILED(retStatus)) {
+        debugDumpFileFree(&pDebugDumpFile);
+    }
+
+    if (ppDebugDumpFile != NULL) {
+        *ppDebugDumpFile = pDebugDumpFile;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Marks the dump for removal and waits for the writer thread to drain and release it
+ */
+STATUS debugDumpWriterRemoveFile(PDebugDumpWriter pDebugDumpWriter, PDebugDumpFile* ppDebugDumpFile)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PDebugDumpFile pDebugDumpFile = NULL;
+
+    CHK(pDebugDumpWriter != NULL && ppDebugDumpFile != NULL, STATUS_NULL_ARG);
+
+    pDebugDumpFile = *ppDebugDumpFile;
+
+    // Call is idempotent
+    CHK(pDebugDumpFile != NULL, retStatus);
+
+    MUTEX_LOCK(pDebugDumpWriter->lock);
+    pDebugDumpFile->removing = TRUE;
+    CVAR_SIGNAL(pDebugDumpWriter->cvar);
+
+    while (!pDebugDumpFile->removed) {
+        CVAR_WAIT(pDebugDumpWriter->removedCvar, pDebugDumpWriter->lock, INFINITE_TIME_VALUE);
+    }
+
+    MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+    debugDumpFileFree(&pDebugDumpFile);
+
+    *ppDebugDumpFile = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Copies the data into the ring buffer of the dump. The lock is only held for the copy.
+ */
+STATUS debugDumpWriterWrite(PDebugDumpWriter pDebugDumpWriter, PDebugDumpFile pDebugDumpFile, PBYTE pData, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT64 offset, firstPart;
+
+    CHK(pDebugDumpWriter != NULL && pDebugDumpFile != NULL && pData != NULL, STATUS_NULL_ARG);
+    CHK(size != 0, retStatus);
+
+    MUTEX_LOCK(pDebugDumpWriter->lock);
+    locked = TRUE;
+
+    if (pDebugDumpFile->ringHead - pDebugDumpFile->ringTail + size > pDebugDumpFile->ringBufferLen) {
+        // Drop rather than block the session thread on the disk
+        pDebugDumpFile->droppedBytes += size;
+        CHK(FALSE, STATUS_NOT_ENOUGH_MEMORY);
+    }
+
+    offset = pDebugDumpFile->ringHead % pDebugDumpFile->ringBufferLen;
+    firstPart = MIN(size, pDebugDumpFile->ringBufferLen - offset);
+    MEMCPY(pDebugDumpFile->ringBuffer + offset, pData, firstPart);
+    MEMCPY(pDebugDumpFile->ringBuffer, pData + firstPart, size - firstPart);
+    pDebugDumpFile->ringHead += size;
+
+    // Wake up the writer only once there is at least a half of the buffer to write out
+    if (pDebugDumpFile->ringHead - pDebugDumpFile->ringTail >= pDebugDumpFile->ringBufferLen / 2) {
+        CVAR_SIGNAL(pDebugDumpWriter->cvar);
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pDebugDumpWriter->lock);
+    }
+
+    return retStatus;
+}
+
+/**
+ * Drains the ring buffers of the dumps into the files and releases the removed dumps.
+ * Only the writer thread deletes the list nodes so the list is walked without holding the lock.
+ */
+PVOID debugDumpWriterRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDebugDumpWriter pDebugDumpWriter = (PDebugDumpWriter) args;
+    PDoubleListNode pNode = NULL, pNextNode = NULL;
+    PDebugDumpFile pDebugDumpFile = NULL;
+    BOOL stopped = FALSE, pending = FALSE;
+
+    CHK(pDebugDumpWriter != NULL, STATUS_NULL_ARG);
+
+    do {
+        MUTEX_LOCK(pDebugDumpWriter->lock);
+
+        // Wait only if none of the dumps has any data or is being removed
+        pending = FALSE;
+        doubleListGetHeadNode(pDebugDumpWriter->pFiles, &pNode);
+        while (pNode != NULL && !pending) {
+            pDebugDumpFile = (PDebugDumpFile) pNode->data;
+            pending = pDebugDumpFile->ringHead != pDebugDumpFile->ringTail || pDebugDumpFile->removing;
+            pNode = pNode->pNext;
+        }
+
+        if (!pending && !ATOMIC_LOAD_BOOL(&pDebugDumpWriter->shutdown)) {
+            CVAR_WAIT(pDebugDumpWriter->cvar, pDebugDumpWriter->lock, DEBUG_DUMP_WRITER_DRAIN_INTERVAL);
+        }
+
+        // The data handed over before the shutdown is still drained
+        stopped = ATOMIC_LOAD_BOOL(&pDebugDumpWriter->shutdown);
+        doubleListGetHeadNode(pDebugDumpWriter->pFiles, &pNode);
+
+        MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+        while (pNode != NULL) {
+            pDebugDumpFile = (PDebugDumpFile) pNode->data;
+            CHK_LOG_ERR(debugDumpWriterDrainFile(pDebugDumpWriter, pDebugDumpFile));
+
+            MUTEX_LOCK(pDebugDumpWriter->lock);
+            pNextNode = pNode->pNext;
+
+            // The session no longer writes once it's removing the dump so there is nothing left after the drain
+            if (pDebugDumpFile->removing && pDebugDumpFile->ringHead == pDebugDumpFile->ringTail) {
+                doubleListDeleteNode(pDebugDumpWriter->pFiles, pNode);
+                pDebugDumpFile->removed = TRUE;
+                CVAR_BROADCAST(pDebugDumpWriter->removedCvar);
+            }
+
+            MUTEX_UNLOCK(pDebugDumpWriter->lock);
+            pNode = pNextNode;
+        }
+    } while (!stopped);
+
+CleanUp:
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+/**
+ * Writes out the buffered data of the dump. The region between the tail and the snapshotted head
+ * is owned by the writer thread until the tail is advanced so it's written out without the lock.
+ */
+STATUS debugDumpWriterDrainFile(PDebugDumpWriter pDebugDumpWriter, PDebugDumpFile pDebugDumpFile)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 head, tail, offset, size, firstPart;
+
+    CHK(pDebugDumpWriter != NULL && pDebugDumpFile != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pDebugDumpWriter->lock);
+    head = pDebugDumpFile->ringHead;
+    tail = pDebugDumpFile->ringTail;
+    pDebugDumpFile->fileDroppedBytes += pDebugDumpFile->droppedBytes;
+    pDebugDumpFile->droppedBytes = 0;
+    MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+    CHK(head != tail, retStatus);
+
+    size = head - tail;
+    offset = tail % pDebugDumpFile->ringBufferLen;
+    firstPart = MIN(size, pDebugDumpFile->ringBufferLen - offset);
+
+    retStatus = debugDumpFileFlush(pDebugDumpFile, pDebugDumpFile->ringBuffer + offset, firstPart);
+    if (STATUS_SUCCEEDED(retStatus) && size != firstPart) {
+        retStatus = debugDumpFileFlush(pDebugDumpFile, pDebugDumpFile->ringBuffer, size - firstPart);
+    }
+
+    if (STATUS_FAILED(retStatus)) {
+        DLOGW("Failed to write to debug dump file %s with error: 0x%08x", pDebugDumpFile->filePathPrefix, retStatus);
+    }
+
+    // Release the region regardless of the outcome so the session doesn't start dropping the data
+    MUTEX_LOCK(pDebugDumpWriter->lock);
+    pDebugDumpFile->ringTail = head;
+    MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Writes the data into the current file rotating it first if it has reached the max size.
+ * The oldest file is deleted on the rotation to keep only the max number of the files.
+ */
+STATUS debugDumpFileFlush(PDebugDumpFile pDebugDumpFile, PBYTE pData, UINT64 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CHAR filePath[MAX_PATH_LEN + 1];
+
+    CHK(pDebugDumpFile != NULL && pData != NULL, STATUS_NULL_ARG);
+
+    if (pDebugDumpFile->fileSize >= pDebugDumpFile->maxFileSize) {
+        debugDumpFileClose(pDebugDumpFile);
+        pDebugDumpFile->fileIndex++;
+
+        if (pDebugDumpFile->fileIndex >= pDebugDumpFile->maxFileCount) {
+            CHK_STATUS(debugDumpFileGetPath(pDebugDumpFile, pDebugDumpFile->fileIndex - pDebugDumpFile->maxFileCount, filePath));
+            if (0 != FREMOVE(filePath)) {
+                DLOGW("Failed to delete the debug dump file %s", filePath);
+            }
+        }
+
+        CHK_STATUS(debugDumpFileOpen(pDebugDumpFile));
+    }
+
+    CHK(pDebugDumpFile->pFile != NULL, STATUS_OPEN_FILE_FAILED);
+    CHK(FWRITE(pData, (SIZE_T) size, 1, pDebugDumpFile->pFile) == 1, STATUS_WRITE_TO_FILE_FAILED);
+    pDebugDumpFile->fileSize += size;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Builds the path of the file with the index. The first file keeps the name without the index.
+ */
+STATUS debugDumpFileGetPath(PDebugDumpFile pDebugDumpFile, UINT32 fileIndex, PCHAR filePath)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    INT32 charWritten;
+
+    CHK(pDebugDumpFile != NULL && filePath != NULL, STATUS_NULL_ARG);
+
+    if (fileIndex == 0) {
+        charWritten = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s%s", pDebugDumpFile->filePathPrefix, DEBUG_DUMP_WRITER_FILE_EXTENSION);
+    } else {
+        charWritten = SNPRINTF(filePath, MAX_PATH_LEN + 1, "%s_%u%s", pDebugDumpFile->filePathPrefix, fileIndex,
+                               DEBUG_DUMP_WRITER_FILE_EXTENSION);
+    }
+
+    CHK(charWritten > 0 && charWritten <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Opens the file for the current index truncating any existing file with the same name
+ */
+STATUS debugDumpFileOpen(PDebugDumpFile pDebugDumpFile)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pDebugDumpFile != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(debugDumpFileGetPath(pDebugDumpFile, pDebugDumpFile->fileIndex, pDebugDumpFile->filePath));
+
+    pDebugDumpFile->pFile = FOPEN(pDebugDumpFile->filePath, "wb");
+    CHK(pDebugDumpFile->pFile != NULL, STATUS_OPEN_FILE_FAILED);
+
+    // The ring buffer is already written out in large batches so skip the extra copy into the stdio buffer
+    setvbuf(pDebugDumpFile->pFile, NULL, _IONBF, 0);
+    pDebugDumpFile->fileSize = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Closes the current file reporting the data dropped from it
+ */
+VOID debugDumpFileClose(PDebugDumpFile pDebugDumpFile)
+{
+    if (pDebugDumpFile->fileDroppedBytes != 0) {
+        DLOGW("%" PRIu64 " bytes were dropped from the debug dump file %s due to the buffer being full",
+              pDebugDumpFile->fileDroppedBytes, pDebugDumpFile->filePath);
+        pDebugDumpFile->fileDroppedBytes = 0;
+    }
+
+    if (pDebugDumpFile->pFile != NULL) {
+        FCLOSE(pDebugDumpFile->pFile);
+        pDebugDumpFile->pFile = NULL;
+    }
+}
+
+/**
+ * Closes the file and frees the dump
+ */
+VOID debugDumpFileFree(PDebugDumpFile* ppDebugDumpFile)
+{
+    PDebugDumpFile pDebugDumpFile = NULL;
+
+    if (ppDebugDumpFile == NULL || *ppDebugDumpFile == NULL) {
+        return;
+    }
+
+    pDebugDumpFile = *ppDebugDumpFile;
+
+    // The writer thread has drained the dump so all of the drops are attributed to the file by now
+    pDebugDumpFile->fileDroppedBytes += pDebugDumpFile->droppedBytes;
+    pDebugDumpFile->droppedBytes = 0;
+    debugDumpFileClose(pDebugDumpFile);
+
+    MEMFREE(pDebugDumpFile);
+
+    *ppDebugDumpFile = NULL;
+}
@@ -0,0 +1,175 @@
+/*******************************************
+Debug dump writer internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_DEBUG_DUMP_WRITER_INCLUDE_I__
+#define __KINESIS_VIDEO_DEBUG_DUMP_WRITER_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Size of the buffer holding the dumped data of a session awaiting the writer thread
+#define DEBUG_DUMP_WRITER_BUFFER_SIZE                       (4 * 1024 * 1024)
+
+// Default size after which the dump continues in a new file
+#define DEBUG_DUMP_WRITER_MAX_FILE_SIZE                     (256 * 1024 * 1024)
+
+// Default number of the most recent files kept per dump. The oldest file is deleted on the rotation past it
+#define DEBUG_DUMP_WRITER_MAX_FILE_COUNT                    8
+
+// Max time the dumped data stays in the buffer before the writer thread picks it up
+#define DEBUG_DUMP_WRITER_DRAIN_INTERVAL                    (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+// Extension of the dump files
+#define DEBUG_DUMP_WRITER_FILE_EXTENSION                    ".mkv"
+
+/**
+ * Dump of a single putMedia session. The file is kept open and the session thread only copies
+ * the data into the buffer. The data is dropped if the writer can't keep up. The dump is rotated
+ * into a new file once the current one reaches the max size, keeping only the most recent files.
+ */
+typedef struct __DebugDumpFile DebugDumpFile;
+struct __DebugDumpFile {
+    // Path of the files without the extension. Rotated files have the index appended
+    CHAR filePathPrefix[MAX_PATH_LEN + 1];
+
+    // File being written to and its path. Accessed from the writer thread only once added
+    FILE* pFile;
+    CHAR filePath[MAX_PATH_LEN + 1];
+
+    // Size after which the dump is rotated and the number of the most recent files kept
+    UINT64 maxFileSize;
+    UINT32 maxFileCount;
+
+    // Bytes written into the current file and the index of the current file. Accessed from the writer thread only once added
+    UINT64 fileSize;
+    UINT32 fileIndex;
+
+    // Ring buffer of the data awaiting the writer thread. Located after the struct
+    PBYTE ringBuffer;
+    UINT64 ringBufferLen;
+
+    // Monotonically increasing write and read positions in the ring buffer
+    UINT64 ringHead;
+    UINT64 ringTail;
+
+    // Number of bytes dropped due to the ring buffer being full since the writer thread last picked them up
+    UINT64 droppedBytes;
+
+    // Bytes dropped while the current file was being written. Reported once the file is closed.
+    // Accessed from the writer thread only once added
+    UINT64 fileDroppedBytes;
+
+    // Set once the session is done with the dump. The writer thread drains and releases it then.
+    BOOL removing;
+    BOOL removed;
+};
+typedef struct __DebugDumpFile* PDebugDumpFile;
+
+/**
+ * Writes out the dumps of all of the putMedia sessions on a single background thread
+ */
+typedef struct __DebugDumpWriter DebugDumpWriter;
+struct __DebugDumpWriter {
+    // Dumps being written out
+    PDoubleList pFiles;
+
+    // Lock protecting the list and the ring buffer positions. Not held while writing the files
+    MUTEX lock;
+
+    // Signaled to wake up the writer thread
+    CVAR cvar;
+
+    // Broadcast by the writer thread once it has released a removed dump
+    CVAR removedCvar;
+
+    // Writer thread draining the ring buffers into the files
+    TID writerThreadId;
+
+    // Whether the writer thread should exit after draining the ring buffers
+    volatile ATOMIC_BOOL shutdown;
+
+    // Rotation limits applied to the dumps
+    UINT64 maxFileSize;
+    UINT32 maxFileCount;
+};
+typedef struct __DebugDumpWriter* PDebugDumpWriter;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates the debug dump writer and starts the writer thread
+ *
+ * @param - UINT64 - IN - Size after which a dump continues in a new file
+ * @param - UINT32 - IN - Max number of the files kept per dump
+ * @param - PDebugDumpWriter* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createDebugDumpWriter(UINT64, UINT32, PDebugDumpWriter*);
+
+/**
+ * Writes out the buffered data, stops the writer thread and frees the writer
+ *
+ * NOTE: The call is idempotent. The dumps should have been removed already.
+ *
+ * @param - PDebugDumpWriter* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeDebugDumpWriter(PDebugDumpWriter*);
+
+/**
+ * Creates a dump, truncates its first file and hands it over to the writer thread
+ *
+ * @param - PDebugDumpWriter - IN - Writer object
+ * @param - PCHAR - IN - Path of the dump files without the extension
+ * @param - PDebugDumpFile* - OUT - The newly created dump
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS debugDumpWriterAddFile(PDebugDumpWriter, PCHAR, PDebugDumpFile*);
+
+/**
+ * Waits for the writer thread to write out the buffered data of the dump and frees it
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PDebugDumpWriter - IN - Writer object
+ * @param - PDebugDumpFile* - IN/OUT - The dump to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS debugDumpWriterRemoveFile(PDebugDumpWriter, PDebugDumpFile*);
+
+/**
+ * Hands the data over to the writer thread. Never blocks on the file IO.
+ *
+ * @param - PDebugDumpWriter - IN - Writer object
+ * @param - PDebugDumpFile - IN - Dump to write to
+ * @param - PBYTE - IN - Data to dump
+ * @param - UINT32 - IN - Size of the data
+ *
+ * @return - STATUS code of the execution. STATUS_NOT_ENOUGH_MEMORY if the data was dropped
+ */
+STATUS debugDumpWriterWrite(PDebugDumpWriter, PDebugDumpFile, PBYTE, UINT32);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID debugDumpWriterRoutine(PVOID);
+STATUS debugDumpWriterDrainFile(PDebugDumpWriter, PDebugDumpFile);
+STATUS debugDumpFileFlush(PDebugDumpFile, PBYTE, UINT64);
+STATUS debugDumpFileGetPath(PDebugDumpFile, UINT32, PCHAR);
+STATUS debugDumpFileOpen(PDebugDumpFile);
+VOID debugDumpFileClose(PDebugDumpFile);
+VOID debugDumpFileFree(PDebugDumpFile*);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_DEBUG_DUMP_WRITER_INCLUDE_I__ */
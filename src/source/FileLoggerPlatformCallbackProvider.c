@@ -160,10 +160,173 @@ VOID fileLoggerLogPrintFn(UINT32 level, PCHAR tag, PCHAR fmt, ...)
     }
 }
 
-STATUS createFileLogger(UINT64 maxStringBufferLen, UINT64 maxLogFileCount, PCHAR logFileDir, BOOL printLog)
+VOID asyncFileLoggerLogPrintFn(UINT32 level, PCHAR tag, PCHAR fmt, ...)
+{
+    CHAR logFmtString[MAX_LOG_FORMAT_LENGTH + 1];
+    CHAR record[ASYNC_FILE_LOGGER_MAX_RECORD_SIZE];
+    INT32 recordLen = 0;
+    va_list valist;
+
+    UNUSED_PARAM(tag);
+
+    if (level >= GET_LOGGER_LOG_LEVEL() && gFileLogger != NULL) {
+        // Format outside of any lock so the logging threads only contend on the record copy
+        addLogMetadata(logFmtString, (UINT32) ARRAY_SIZE(logFmtString), fmt, level);
+
+        if (gFileLogger->printLog) {
+            va_start(valist, fmt);
+            vprintf(logFmtString, valist);
+            va_end(valist);
+        }
+
+        va_start(valist, fmt);
+#if defined _WIN32 || defined _WIN64
+        // _vsnprintf returns -1 on truncation
+        recordLen = _vsnprintf(record, ARRAY_SIZE(record), logFmtString, valist);
+        if (recordLen == -1) {
+            recordLen = (INT32) ARRAY_SIZE(record) - 1;
+        }
+#else
+        recordLen = vsnprintf(record, ARRAY_SIZE(record), logFmtString, valist);
+#endif
+        va_end(valist);
+
+        if (recordLen < 0) {
+            PRINTF("vsnprintf failed\n");
+            return;
+        }
+
+        // vsnprintf returns the untruncated length
+        recordLen = MIN(recordLen, (INT32) ARRAY_SIZE(record) - 1);
+
+        asyncFileLoggerEnqueueRecord(record, (UINT32) recordLen);
+    }
+}
+
+STATUS asyncFileLoggerEnqueueRecord(PCHAR pRecord, UINT32 recordLen)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    CHK(gFileLogger == NULL, retStatus); // dont allocate again if already allocated
+    UINT64 requiredLen = SIZEOF(UINT32) + recordLen * SIZEOF(CHAR), usedLen;
+
+    CHK(gFileLogger != NULL && pRecord != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(gFileLogger->ringLock);
+
+    usedLen = gFileLogger->ringHead - gFileLogger->ringTail;
+    if (usedLen + requiredLen > gFileLogger->ringBufferLen) {
+        // Never block the logging thread on the writer - drop and account for the record instead
+        gFileLogger->droppedCount++;
+        retStatus = STATUS_NOT_ENOUGH_MEMORY;
+    } else {
+        asyncFileLoggerRingWrite((PBYTE) &recordLen, SIZEOF(UINT32));
+        asyncFileLoggerRingWrite((PBYTE) pRecord, recordLen * SIZEOF(CHAR));
+
+        // Wake up the writer early only when the ring buffer is getting full. Otherwise it drains on its interval.
+        if (usedLen < gFileLogger->ringBufferLen / 2 && usedLen + requiredLen >= gFileLogger->ringBufferLen / 2) {
+            CVAR_SIGNAL(gFileLogger->ringCvar);
+        }
+    }
+
+    MUTEX_UNLOCK(gFileLogger->ringLock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID asyncFileLoggerRingWrite(PBYTE pData, UINT64 size)
+{
+    UINT64 offset = gFileLogger->ringHead % gFileLogger->ringBufferLen;
+    UINT64 firstPart = MIN(size, gFileLogger->ringBufferLen - offset);
+
+    MEMCPY(gFileLogger->ringBuffer + offset, pData, firstPart);
+    MEMCPY(gFileLogger->ringBuffer, pData + firstPart, size - firstPart);
+    gFileLogger->ringHead += size;
+}
+
+VOID asyncFileLoggerRingRead(PBYTE pData, UINT64 size)
+{
+    UINT64 offset = gFileLogger->ringTail % gFileLogger->ringBufferLen;
+    UINT64 firstPart = MIN(size, gFileLogger->ringBufferLen - offset);
+
+    MEMCPY(pData, gFileLogger->ringBuffer + offset, firstPart);
+    MEMCPY(pData + firstPart, gFileLogger->ringBuffer, size - firstPart);
+    gFileLogger->ringTail += size;
+}
+
+PVOID asyncFileLoggerWriterRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PFileLogger pFileLogger = (PFileLogger) args;
+    BOOL stopped = FALSE, pending = FALSE;
+    UINT32 recordLen;
+    UINT64 droppedCount;
+    INT32 noticeLen;
+
+    CHK(pFileLogger != NULL && pFileLogger == gFileLogger, STATUS_INVALID_ARG);
+
+    // The writer thread must not log through the logger itself so the errors are reported with PRINTF
+    do {
+        MUTEX_LOCK(pFileLogger->ringLock);
+
+        if (pFileLogger->ringHead == pFileLogger->ringTail && !ATOMIC_LOAD_BOOL(&pFileLogger->shutdown)) {
+            CVAR_WAIT(pFileLogger->ringCvar, pFileLogger->ringLock, ASYNC_FILE_LOGGER_DRAIN_INTERVAL);
+        }
+
+        stopped = ATOMIC_LOAD_BOOL(&pFileLogger->shutdown);
+
+        // Move the whole records which fit into the string buffer. Last char is reserved for the null terminator.
+        pending = FALSE;
+        while (!pending && pFileLogger->ringHead != pFileLogger->ringTail) {
+            asyncFileLoggerRingRead((PBYTE) &recordLen, SIZEOF(UINT32));
+            if (pFileLogger->currentOffset + recordLen >= pFileLogger->stringBufferLen) {
+                // Leave the record in the ring buffer until the string buffer is flushed
+                pFileLogger->ringTail -= SIZEOF(UINT32);
+                pending = TRUE;
+            } else {
+                asyncFileLoggerRingRead((PBYTE) (pFileLogger->stringBuffer + pFileLogger->currentOffset), recordLen * SIZEOF(CHAR));
+                pFileLogger->currentOffset += recordLen;
+            }
+        }
+
+        droppedCount = pFileLogger->droppedCount - pFileLogger->reportedDroppedCount;
+
+        MUTEX_UNLOCK(pFileLogger->ringLock);
+
+        if (droppedCount != 0) {
+            noticeLen = SNPRINTF(pFileLogger->stringBuffer + pFileLogger->currentOffset,
+                                 pFileLogger->stringBufferLen - pFileLogger->currentOffset,
+                                 "%" PRIu64 " log records were dropped due to the log buffer being full\n",
+                                 droppedCount);
+            if (noticeLen > 0 && pFileLogger->currentOffset + noticeLen < pFileLogger->stringBufferLen) {
+                pFileLogger->currentOffset += noticeLen;
+                pFileLogger->reportedDroppedCount += droppedCount;
+            } else {
+                // Report after the flush
+                pending = TRUE;
+            }
+        }
+
+        if (pending) {
+            status = flushLogToFile();
+            if (STATUS_FAILED(status)) {
+                PRINTF("flush log to file failed with 0x%08x\n", status);
+            }
+        }
+    } while (!stopped || pending);
+
+CleanUp:
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+STATUS createFileLogger(UINT64 maxStringBufferLen, UINT64 maxLogFileCount, PCHAR logFileDir, BOOL printLog, BOOL asyncMode)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL existing = gFileLogger != NULL;
+    // the existing logger can't switch between the sync and async mode
+    CHK(!existing || gFileLogger->asyncMode == asyncMode, STATUS_INVALID_OPERATION);
+    CHK(!existing, retStatus); // dont allocate again if already allocated
     CHK(maxStringBufferLen <= MAX_FILE_LOGGER_STRING_BUFFER_SIZE &&
         maxStringBufferLen >= MIN_FILE_LOGGER_STRING_BUFFER_SIZE &&
         maxLogFileCount <= MAX_FILE_LOGGER_LOG_FILE_COUNT &&
@@ -173,13 +336,18 @@ STATUS createFileLogger(UINT64 maxStringBufferLen, UINT64 maxLogFileCount, PCHAR
     CHAR fileIndexBuffer[KVS_PRODUCER_FILE_INDEX_BUFFER_SIZE];
     UINT64 charWritten = 0, indexFileSize = KVS_PRODUCER_FILE_INDEX_BUFFER_SIZE;
 
-    // allocate the struct and string buffer together
-    gFileLogger = (PFileLogger) MEMALLOC(SIZEOF(FileLogger) + maxStringBufferLen * SIZEOF(CHAR));
+    // allocate the struct, string buffer and the ring buffer in async mode together
+    gFileLogger = (PFileLogger) MEMALLOC(SIZEOF(FileLogger) + maxStringBufferLen * SIZEOF(CHAR) + (asyncMode ? maxStringBufferLen : 0));
+    CHK(gFileLogger != NULL, STATUS_NOT_ENOUGH_MEMORY);
     MEMSET(gFileLogger, 0x00, SIZEOF(FileLogger));
     // point stringBuffer to the right place
     gFileLogger->stringBuffer = (PCHAR) (gFileLogger + 1);
     gFileLogger->stringBufferLen = maxStringBufferLen;
     gFileLogger->lock = MUTEX_CREATE(FALSE);
+    gFileLogger->ringLock = INVALID_MUTEX_VALUE;
+    gFileLogger->ringCvar = INVALID_CVAR_VALUE;
+    gFileLogger->writerThreadId = INVALID_TID_VALUE;
+    gFileLogger->asyncMode = asyncMode;
     gFileLogger->currentOffset = 0;
     gFileLogger->maxFileCount = maxLogFileCount;
     gFileLogger->currentFileIndex = 0;
@@ -201,9 +369,25 @@ STATUS createFileLogger(UINT64 maxStringBufferLen, UINT64 maxLogFileCount, PCHAR
         STRTOUI64(fileIndexBuffer, NULL, 10, &gFileLogger->currentFileIndex);
     }
 
+    if (asyncMode) {
+        // ring buffer follows the string buffer
+        gFileLogger->ringBuffer = (PBYTE) (gFileLogger->stringBuffer + maxStringBufferLen);
+        gFileLogger->ringBufferLen = maxStringBufferLen;
+        gFileLogger->fileLoggerLogPrintFn = asyncFileLoggerLogPrintFn;
+        ATOMIC_STORE_BOOL(&gFileLogger->shutdown, FALSE);
+
+        gFileLogger->ringLock = MUTEX_CREATE(FALSE);
+        CHK(IS_VALID_MUTEX_VALUE(gFileLogger->ringLock), STATUS_INVALID_OPERATION);
+        gFileLogger->ringCvar = CVAR_CREATE();
+        CHK(IS_VALID_CVAR_VALUE(gFileLogger->ringCvar), STATUS_INVALID_OPERATION);
+
+        CHK_STATUS(THREAD_CREATE(&gFileLogger->writerThreadId, asyncFileLoggerWriterRoutine, (PVOID) gFileLogger));
+    }
+
 CleanUp:
 
-    if (STATUS_FAILED(retStatus)) {
+    // leave the existing logger running
+    if (STATUS_FAILED(retStatus) && !existing) {
         freeFileLogger();
         gFileLogger = NULL;
     }
@@ -216,6 +400,17 @@ STATUS freeFileLogger()
     STATUS retStatus = STATUS_SUCCESS;
     CHK(gFileLogger != NULL, retStatus);
 
+    // stop the writer thread which drains the ring buffer before exiting
+    if (IS_VALID_TID_VALUE(gFileLogger->writerThreadId)) {
+        MUTEX_LOCK(gFileLogger->ringLock);
+        ATOMIC_STORE_BOOL(&gFileLogger->shutdown, TRUE);
+        CVAR_SIGNAL(gFileLogger->ringCvar);
+        MUTEX_UNLOCK(gFileLogger->ringLock);
+
+        THREAD_JOIN(gFileLogger->writerThreadId, NULL);
+        gFileLogger->writerThreadId = INVALID_TID_VALUE;
+    }
+
     // flush out remaining log
     MUTEX_LOCK(gFileLogger->lock);
     retStatus = flushLogToFile();
@@ -227,6 +422,14 @@ STATUS freeFileLogger()
 
     MUTEX_FREE(gFileLogger->lock);
 
+    if (IS_VALID_CVAR_VALUE(gFileLogger->ringCvar)) {
+        CVAR_FREE(gFileLogger->ringCvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(gFileLogger->ringLock)) {
+        MUTEX_FREE(gFileLogger->ringLock);
+    }
+
     MEMFREE(gFileLogger);
     gFileLogger = NULL;
 
@@ -252,26 +455,66 @@ STATUS addFileLoggerPlatformCallbacksProvider(PClientCallbacks pClientCallbacks,
                                               UINT64 maxLogFileCount,
                                               PCHAR logFileDir,
                                               BOOL printLog)
+{
+    return addFileLoggerPlatformCallbacksProviderWithMode(pClientCallbacks, stringBufferSize, maxLogFileCount, logFileDir, printLog, FALSE);
+}
+
+STATUS addAsyncFileLoggerPlatformCallbacksProvider(PClientCallbacks pClientCallbacks,
+                                                   UINT64 stringBufferSize,
+                                                   UINT64 maxLogFileCount,
+                                                   PCHAR logFileDir,
+                                                   BOOL printLog)
+{
+    return addFileLoggerPlatformCallbacksProviderWithMode(pClientCallbacks, stringBufferSize, maxLogFileCount, logFileDir, printLog, TRUE);
+}
+
+STATUS getFileLoggerDroppedLogCount(PUINT64 pDroppedCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pDroppedCount != NULL, STATUS_NULL_ARG);
+    CHK(gFileLogger != NULL, STATUS_INVALID_OPERATION);
+
+    *pDroppedCount = 0;
+    if (gFileLogger->asyncMode) {
+        MUTEX_LOCK(gFileLogger->ringLock);
+        *pDroppedCount = gFileLogger->droppedCount;
+        MUTEX_UNLOCK(gFileLogger->ringLock);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS addFileLoggerPlatformCallbacksProviderWithMode(PClientCallbacks pClientCallbacks,
+                                                      UINT64 stringBufferSize,
+                                                      UINT64 maxLogFileCount,
+                                                      PCHAR logFileDir,
+                                                      BOOL printLog,
+                                                      BOOL asyncMode)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PCallbacksProvider pCallbackProvider = (PCallbacksProvider) pClientCallbacks;
     PlatformCallbacks fileLoggerPlatformCallbacks;
+    BOOL created = FALSE;
 
     CHK(pCallbackProvider != NULL, STATUS_NULL_ARG);
 
-    CHK_STATUS(createFileLogger(stringBufferSize, maxLogFileCount, logFileDir, printLog));
+    CHK_STATUS(createFileLogger(stringBufferSize, maxLogFileCount, logFileDir, printLog, asyncMode));
+    created = TRUE;
 
     MEMSET(&fileLoggerPlatformCallbacks, 0x00, SIZEOF(PlatformCallbacks));
     fileLoggerPlatformCallbacks.customData = (UINT64) NULL;
     fileLoggerPlatformCallbacks.version = PLATFORM_CALLBACKS_CURRENT_VERSION;
-    fileLoggerPlatformCallbacks.logPrintFn = fileLoggerLogPrintFn;
+    fileLoggerPlatformCallbacks.logPrintFn = gFileLogger->fileLoggerLogPrintFn;
     fileLoggerPlatformCallbacks.freePlatformCallbacksFn = freeFileLoggerPlatformCallbacksFunc;
 
     CHK_STATUS(setPlatformCallbacks(pClientCallbacks, &fileLoggerPlatformCallbacks));
 
 CleanUp:
 
-    if (!STATUS_SUCCEEDED(retStatus)) {
+    if (!STATUS_SUCCEEDED(retStatus) && created) {
         freeFileLogger();
     }
 
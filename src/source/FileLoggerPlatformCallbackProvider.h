@@ -45,12 +45,49 @@ typedef struct {
 
     // file logger logPrint callback
     logPrintFunc fileLoggerLogPrintFn;
+
+    // whether the records are handed over to the writer thread instead of being written by the logging thread
+    BOOL asyncMode;
+
+    // ring buffer of the length prefixed formatted records awaiting the writer thread. Located after the stringBuffer.
+    PBYTE ringBuffer;
+
+    // size of the ring buffer in bytes
+    UINT64 ringBufferLen;
+
+    // monotonically increasing write and read positions in the ring buffer
+    UINT64 ringHead;
+    UINT64 ringTail;
+
+    // number of records dropped due to the ring buffer being full
+    UINT64 droppedCount;
+
+    // number of dropped records already reported in the log file. Accessed from the writer thread only
+    UINT64 reportedDroppedCount;
+
+    // lock protecting the ring buffer. Held only for copying the formatted records in and out
+    MUTEX ringLock;
+
+    // signaled to wake up the writer thread
+    CVAR ringCvar;
+
+    // writer thread draining the ring buffer into stringBuffer and flushing it to the files
+    TID writerThreadId;
+
+    // whether the writer thread should exit
+    volatile ATOMIC_BOOL shutdown;
 } FileLogger, *PFileLogger;
 
 #define MAX_FILE_LOGGER_STRING_BUFFER_SIZE          3 * 1024 * 1024
 #define MIN_FILE_LOGGER_STRING_BUFFER_SIZE          10 * 1024
 #define MAX_FILE_LOGGER_LOG_FILE_COUNT              10 * 1024
 
+// max size of a single formatted record in async mode. Longer records are truncated
+#define ASYNC_FILE_LOGGER_MAX_RECORD_SIZE           4 * 1024
+
+// max time the records stay in the ring buffer before the writer thread picks them up
+#define ASYNC_FILE_LOGGER_DRAIN_INTERVAL            (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
 ////////////////////////////////////////////////////////////////////////
 // file logger function implementations
 ////////////////////////////////////////////////////////////////////////
@@ -69,10 +106,13 @@ STATUS flushLogToFile();
  * @param - UINT64 - IN - Max number of log file. When exceeded, the oldest file will be deleted when new one is generated
  * @param - PCHAR - IN - Directory in which the log file will be generated
  * @param - BOOL - IN - print log to std out too
+ * @param - BOOL - IN - hand the formatted records over to a writer thread instead of writing the files on the logging thread
+ *
+ * NOTE: Returns STATUS_INVALID_OPERATION if the logger has already been created in the other mode
  *
  * @return - STATUS of execution
  */
-STATUS createFileLogger(UINT64, UINT64, PCHAR, BOOL);
+STATUS createFileLogger(UINT64, UINT64, PCHAR, BOOL, BOOL);
 /**
  * This function frees the static pFileLogger in FileLoggerPlatformCallbacks.c
  *
@@ -87,6 +127,39 @@ STATUS freeFileLogger();
  */
 STATUS freeFileLoggerPlatformCallbacksFunc(PUINT64);
 
+/**
+ * Async mode logPrint callback. Formats the record on the calling thread and copies it into the ring buffer.
+ * The record is dropped and accounted for in droppedCount if the ring buffer is full.
+ */
+VOID asyncFileLoggerLogPrintFn(UINT32, PCHAR, PCHAR, ...);
+
+/**
+ * Copies the formatted record into the ring buffer
+ *
+ * @param - PCHAR - IN - Formatted record
+ * @param - UINT32 - IN - Record length in chars
+ *
+ * @return - STATUS of execution. STATUS_NOT_ENOUGH_MEMORY if the record was dropped
+ */
+STATUS asyncFileLoggerEnqueueRecord(PCHAR, UINT32);
+
+/**
+ * Writer thread routine. Moves the records from the ring buffer into the stringBuffer in batches and
+ * flushes the stringBuffer into the log file once the next record doesn't fit.
+ */
+PVOID asyncFileLoggerWriterRoutine(PVOID);
+
+/**
+ * Adds the file logger platform callbacks in the sync or async mode
+ */
+STATUS addFileLoggerPlatformCallbacksProviderWithMode(PClientCallbacks, UINT64, UINT64, PCHAR, BOOL, BOOL);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+VOID asyncFileLoggerRingWrite(PBYTE, UINT64);
+VOID asyncFileLoggerRingRead(PBYTE, UINT64);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -0,0 +1,247 @@
+/**
+ * Kinesis Video Producer fragment ACK tokenizer
+ */
+#define LOG_CLASS "FragmentAckTokenizer"
+#include "Include_i.h"
+
+#define IS_FRAGMENT_ACK_WHITESPACE(c)       ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+#define IS_FRAGMENT_ACK_DIGIT(c)            ((c) >= '0' && (c) <= '9')
+
+#define FRAGMENT_ACK_TOKEN_EQUALS(token, len, literal) \
+        ((len) == SIZEOF(literal) - 1 && 0 == MEMCMP((token), (literal), (len)))
+
+STATUS fragmentAckTokenizerInit(PFragmentAckTokenizer pTokenizer, FragmentAckTokenizerAckFunc ackFn, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pTokenizer != NULL && ackFn != NULL, STATUS_NULL_ARG);
+
+    MEMSET(pTokenizer, 0x00, SIZEOF(FragmentAckTokenizer));
+    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START;
+    pTokenizer->ackFn = ackFn;
+    pTokenizer->customData = customData;
+    fragmentAckTokenizerResetAck(pTokenizer);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS fragmentAckTokenizerProcess(PFragmentAckTokenizer pTokenizer, PCHAR pBuffer, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    UINT32 i = 0, seqLen;
+    CHAR c;
+
+    CHK(pTokenizer != NULL && (pBuffer != NULL || size == 0), STATUS_NULL_ARG);
+
+    while (i < size) {
+        c = pBuffer[i];
+
+        switch (pTokenizer->state) {
+            case FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START:
+                if (c == '{') {
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_KEY_START;
+                } else if (!IS_FRAGMENT_ACK_WHITESPACE(c)) {
+                    pTokenizer->skippedBytes++;
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_KEY_START:
+                if (c == '"') {
+                    pTokenizer->tokenLen = 0;
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_KEY;
+                } else if (c == '}') {
+                    status = fragmentAckTokenizerEndObject(pTokenizer);
+                    retStatus = STATUS_FAILED(retStatus) ? retStatus : status;
+                } else if (c != ',' && !IS_FRAGMENT_ACK_WHITESPACE(c)) {
+                    // Malformed ACK - drop it and look for the next one
+                    pTokenizer->skippedBytes++;
+                    fragmentAckTokenizerResetAck(pTokenizer);
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START;
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_KEY:
+                if (c == '"') {
+                    pTokenizer->key = fragmentAckTokenizerGetKey(pTokenizer->token, pTokenizer->tokenLen);
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_DELIMITER;
+                } else if (pTokenizer->tokenLen < FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN) {
+                    pTokenizer->token[pTokenizer->tokenLen++] = c;
+                } else {
+                    // Too long to be one of ours. Keeps the length beyond the max so it doesn't match.
+                    pTokenizer->tokenLen = FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN + 1;
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_DELIMITER:
+                if (c == ':') {
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_VALUE_START;
+                } else if (!IS_FRAGMENT_ACK_WHITESPACE(c)) {
+                    pTokenizer->skippedBytes++;
+                    fragmentAckTokenizerResetAck(pTokenizer);
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START;
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_VALUE_START:
+                if (c == '"') {
+                    pTokenizer->tokenLen = 0;
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_STRING_VALUE;
+                } else if (IS_FRAGMENT_ACK_DIGIT(c)) {
+                    pTokenizer->number = 0;
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_NUMBER_VALUE;
+
+                    // Re-process as a part of the number
+                    continue;
+                } else if (!IS_FRAGMENT_ACK_WHITESPACE(c)) {
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_LITERAL_VALUE;
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_STRING_VALUE:
+                if (c == '"') {
+                    if (pTokenizer->key == FRAGMENT_ACK_TOKENIZER_KEY_EVENT_TYPE) {
+                        pTokenizer->fragmentAck.ackType = fragmentAckTokenizerGetAckType(pTokenizer->token, pTokenizer->tokenLen);
+                    }
+
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_KEY_START;
+                    break;
+                }
+
+                // Only the event type and the fragment number values are kept and neither keeps the escape char
+                if (c == '\\') {
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_STRING_ESCAPE;
+                } else if (pTokenizer->key == FRAGMENT_ACK_TOKENIZER_KEY_EVENT_TYPE) {
+                    if (pTokenizer->tokenLen < FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN) {
+                        pTokenizer->token[pTokenizer->tokenLen++] = c;
+                    } else {
+                        pTokenizer->tokenLen = FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN + 1;
+                    }
+                } else if (pTokenizer->key == FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_NUMBER) {
+                    seqLen = pTokenizer->tokenLen;
+                    if (seqLen < MAX_FRAGMENT_SEQUENCE_NUMBER) {
+                        pTokenizer->fragmentAck.sequenceNumber[seqLen] = c;
+                        pTokenizer->fragmentAck.sequenceNumber[seqLen + 1] = '\0';
+                        pTokenizer->tokenLen++;
+                    }
+                }
+
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_STRING_ESCAPE:
+                // The escaped char is never a part of the values we keep so it's skipped
+                pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_STRING_VALUE;
+                break;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_NUMBER_VALUE:
+                if (IS_FRAGMENT_ACK_DIGIT(c)) {
+                    pTokenizer->number = pTokenizer->number * 10 + (UINT64) (c - '0');
+                    break;
+                }
+
+                fragmentAckTokenizerStoreNumber(pTokenizer);
+                pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_KEY_START;
+
+                // The terminating char is processed as the start of the next key
+                continue;
+
+            case FRAGMENT_ACK_TOKENIZER_STATE_LITERAL_VALUE:
+                if (c == ',' || c == '}') {
+                    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_KEY_START;
+
+                    // The terminating char is processed as the start of the next key
+                    continue;
+                }
+
+                break;
+        }
+
+        i++;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID fragmentAckTokenizerResetAck(PFragmentAckTokenizer pTokenizer)
+{
+    pTokenizer->key = FRAGMENT_ACK_TOKENIZER_KEY_UNKNOWN;
+    pTokenizer->tokenLen = 0;
+    pTokenizer->number = 0;
+    pTokenizer->fragmentAck.version = FRAGMENT_ACK_CURRENT_VERSION;
+    pTokenizer->fragmentAck.ackType = FRAGMENT_ACK_TYPE_UNDEFINED;
+    pTokenizer->fragmentAck.timestamp = 0;
+    pTokenizer->fragmentAck.sequenceNumber[0] = '\0';
+    pTokenizer->fragmentAck.result = SERVICE_CALL_RESULT_OK;
+}
+
+FRAGMENT_ACK_TOKENIZER_KEY fragmentAckTokenizerGetKey(PCHAR pToken, UINT32 tokenLen)
+{
+    if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_KEY_EVENT_TYPE)) {
+        return FRAGMENT_ACK_TOKENIZER_KEY_EVENT_TYPE;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_KEY_FRAGMENT_TIMECODE)) {
+        return FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_TIMECODE;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_KEY_FRAGMENT_NUMBER)) {
+        return FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_NUMBER;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_KEY_ERROR_ID)) {
+        return FRAGMENT_ACK_TOKENIZER_KEY_ERROR_ID;
+    }
+
+    return FRAGMENT_ACK_TOKENIZER_KEY_UNKNOWN;
+}
+
+FRAGMENT_ACK_TYPE fragmentAckTokenizerGetAckType(PCHAR pToken, UINT32 tokenLen)
+{
+    if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_EVENT_TYPE_BUFFERING)) {
+        return FRAGMENT_ACK_TYPE_BUFFERING;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_EVENT_TYPE_RECEIVED)) {
+        return FRAGMENT_ACK_TYPE_RECEIVED;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_EVENT_TYPE_PERSISTED)) {
+        return FRAGMENT_ACK_TYPE_PERSISTED;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_EVENT_TYPE_ERROR)) {
+        return FRAGMENT_ACK_TYPE_ERROR;
+    } else if (FRAGMENT_ACK_TOKEN_EQUALS(pToken, tokenLen, FRAGMENT_ACK_EVENT_TYPE_IDLE)) {
+        return FRAGMENT_ACK_TYPE_IDLE;
+    }
+
+    return FRAGMENT_ACK_TYPE_UNDEFINED;
+}
+
+VOID fragmentAckTokenizerStoreNumber(PFragmentAckTokenizer pTokenizer)
+{
+    switch (pTokenizer->key) {
+        case FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_TIMECODE:
+            pTokenizer->fragmentAck.timestamp = pTokenizer->number;
+            break;
+
+        case FRAGMENT_ACK_TOKENIZER_KEY_ERROR_ID:
+            pTokenizer->fragmentAck.result = (SERVICE_CALL_RESULT) pTokenizer->number;
+            break;
+
+        default:
+            // Not used
+            break;
+    }
+}
+
+STATUS fragmentAckTokenizerEndObject(PFragmentAckTokenizer pTokenizer)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Objects without a known event type are skipped
+    if (pTokenizer->fragmentAck.ackType != FRAGMENT_ACK_TYPE_UNDEFINED) {
+        retStatus = pTokenizer->ackFn(pTokenizer->customData, &pTokenizer->fragmentAck);
+    }
+
+    fragmentAckTokenizerResetAck(pTokenizer);
+    pTokenizer->state = FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START;
+
+    return retStatus;
+}
@@ -0,0 +1,152 @@
+/*******************************************
+Fragment ACK tokenizer internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_FRAGMENT_ACK_TOKENIZER_INCLUDE_I__
+#define __KINESIS_VIDEO_FRAGMENT_ACK_TOKENIZER_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Max length of the key names and the event type values we are matching. Longer ones are ignored
+#define FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN                32
+
+// ACK key names
+#define FRAGMENT_ACK_KEY_EVENT_TYPE                         "EventType"
+#define FRAGMENT_ACK_KEY_FRAGMENT_TIMECODE                  "FragmentTimecode"
+#define FRAGMENT_ACK_KEY_FRAGMENT_NUMBER                    "FragmentNumber"
+#define FRAGMENT_ACK_KEY_ERROR_ID                           "ErrorId"
+
+// ACK event type values
+#define FRAGMENT_ACK_EVENT_TYPE_BUFFERING                   "BUFFERING"
+#define FRAGMENT_ACK_EVENT_TYPE_RECEIVED                    "RECEIVED"
+#define FRAGMENT_ACK_EVENT_TYPE_PERSISTED                   "PERSISTED"
+#define FRAGMENT_ACK_EVENT_TYPE_ERROR                       "ERROR"
+#define FRAGMENT_ACK_EVENT_TYPE_IDLE                        "IDLE"
+
+/**
+ * Tokenizer states
+ */
+typedef enum {
+    // Skipping to the start of the next ACK object
+    FRAGMENT_ACK_TOKENIZER_STATE_OBJECT_START,
+
+    // Expecting a key, a comma or the end of the object
+    FRAGMENT_ACK_TOKENIZER_STATE_KEY_START,
+
+    // Inside the key string
+    FRAGMENT_ACK_TOKENIZER_STATE_KEY,
+
+    // Expecting the colon after the key
+    FRAGMENT_ACK_TOKENIZER_STATE_DELIMITER,
+
+    // Expecting the value
+    FRAGMENT_ACK_TOKENIZER_STATE_VALUE_START,
+
+    // Inside a string value
+    FRAGMENT_ACK_TOKENIZER_STATE_STRING_VALUE,
+
+    // Inside an escape sequence of a string value
+    FRAGMENT_ACK_TOKENIZER_STATE_STRING_ESCAPE,
+
+    // Inside a numeric value
+    FRAGMENT_ACK_TOKENIZER_STATE_NUMBER_VALUE,
+
+    // Inside a literal value which is skipped
+    FRAGMENT_ACK_TOKENIZER_STATE_LITERAL_VALUE,
+} FRAGMENT_ACK_TOKENIZER_STATE;
+
+/**
+ * ACK keys the tokenizer extracts
+ */
+typedef enum {
+    FRAGMENT_ACK_TOKENIZER_KEY_UNKNOWN,
+    FRAGMENT_ACK_TOKENIZER_KEY_EVENT_TYPE,
+    FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_TIMECODE,
+    FRAGMENT_ACK_TOKENIZER_KEY_FRAGMENT_NUMBER,
+    FRAGMENT_ACK_TOKENIZER_KEY_ERROR_ID,
+} FRAGMENT_ACK_TOKENIZER_KEY;
+
+/**
+ * Called for each complete ACK
+ *
+ * @param - UINT64 - IN - Custom data passed to the tokenizer
+ * @param - PFragmentAck - IN - The parsed ACK. Only valid for the duration of the call
+ *
+ * @return - STATUS code of the execution
+ */
+typedef STATUS (*FragmentAckTokenizerAckFunc)(UINT64, PFragmentAck);
+
+/**
+ * Incremental tokenizer of the putMedia ACK stream. The state is carried over between the chunks
+ * so the ACKs can be split at any byte and any number of ACKs can arrive in one chunk. The values are
+ * decoded straight into the ACK being built without buffering the payload.
+ */
+typedef struct __FragmentAckTokenizer FragmentAckTokenizer;
+struct __FragmentAckTokenizer {
+    // Current state
+    FRAGMENT_ACK_TOKENIZER_STATE state;
+
+    // Key the current value belongs to
+    FRAGMENT_ACK_TOKENIZER_KEY key;
+
+    // Key name or event type value being matched. Only as many chars as needed for the matching are kept
+    CHAR token[FRAGMENT_ACK_TOKENIZER_MAX_TOKEN_LEN + 1];
+    UINT32 tokenLen;
+
+    // Numeric value being accumulated
+    UINT64 number;
+
+    // ACK being built
+    FragmentAck fragmentAck;
+
+    // Number of the bytes skipped due to the malformed ACKs
+    UINT64 skippedBytes;
+
+    // ACK dispatch function and its custom data
+    FragmentAckTokenizerAckFunc ackFn;
+    UINT64 customData;
+};
+typedef struct __FragmentAckTokenizer* PFragmentAckTokenizer;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Initializes the tokenizer
+ *
+ * @param - PFragmentAckTokenizer - IN - Tokenizer object
+ * @param - FragmentAckTokenizerAckFunc - IN - Function called for each complete ACK
+ * @param - UINT64 - IN - Custom data to pass to the function
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS fragmentAckTokenizerInit(PFragmentAckTokenizer, FragmentAckTokenizerAckFunc, UINT64);
+
+/**
+ * Processes the next chunk of the ACK stream dispatching the completed ACKs
+ *
+ * @param - PFragmentAckTokenizer - IN - Tokenizer object
+ * @param - PCHAR - IN - Chunk of the ACK stream
+ * @param - UINT32 - IN - Size of the chunk
+ *
+ * @return - STATUS code of the execution. The first failure of the ACK dispatch is returned after the whole chunk is processed
+ */
+STATUS fragmentAckTokenizerProcess(PFragmentAckTokenizer, PCHAR, UINT32);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+VOID fragmentAckTokenizerResetAck(PFragmentAckTokenizer);
+FRAGMENT_ACK_TOKENIZER_KEY fragmentAckTokenizerGetKey(PCHAR, UINT32);
+FRAGMENT_ACK_TYPE fragmentAckTokenizerGetAckType(PCHAR, UINT32);
+VOID fragmentAckTokenizerStoreNumber(PFragmentAckTokenizer);
+STATUS fragmentAckTokenizerEndObject(PFragmentAckTokenizer);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_FRAGMENT_ACK_TOKENIZER_INCLUDE_I__ */
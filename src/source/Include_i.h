@@ -29,6 +29,10 @@ typedef StreamLatencyStateMachine* PStreamLatencyStateMachine;
 
 #if !defined __WINDOWS_BUILD__
 #include <signal.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#else
+#include <ws2tcpip.h>
 #endif
 
 /**
@@ -51,10 +55,18 @@ typedef enum {
 ////////////////////////////////////////////////////
 // Project internal includes
 ////////////////////////////////////////////////////
+#include "DebugDumpWriter.h"
+#include "FragmentAckTokenizer.h"
 #include "Request.h"
 #include "Response.h"
 #include "CallbacksProvider.h"
 #include "FileAuthCallbacks.h"
+#include "CurlNetworkLoop.h"
+#include "CurlRequestScheduler.h"
+#include "CurlHandlePool.h"
+#include "CurlResolverCache.h"
+#include "PersistedEndpointCache.h"
+#include "CurlStreamMetrics.h"
 #include "CurlApiCallbacks.h"
 #include "DeviceInfoProvider.h"
 #include "CallbacksProvider.h"
@@ -103,6 +103,25 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Opts the IotCredential Auth callback object into renewing the credentials in the background
+ */
+STATUS startIotAuthCallbacksBackgroundRefresh(PAuthCallbacks pAuthCallbacks)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PIotAuthCallbacks pIotAuthCallbacks = (PIotAuthCallbacks) pAuthCallbacks;
+
+    CHK(pIotAuthCallbacks != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(startIotCredentialProviderBackgroundRefresh((PAwsCredentialProvider) pIotAuthCallbacks->pCredentialProvider));
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS freeIotAuthCallbacksFunc(PUINT64 customData)
 {
     ENTERS();
@@ -0,0 +1,423 @@
+/**
+ * Kinesis Video Producer persisted endpoint cache
+ */
+#define LOG_CLASS "PersistedEndpointCache"
+#include "Include_i.h"
+
+/**
+ * Creates the cache and loads the cache file
+ */
+STATUS createPersistedEndpointCache(PCHAR filePath, PPersistedEndpointCache* ppPersistedEndpointCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PPersistedEndpointCache pPersistedEndpointCache = NULL;
+
+    CHK(filePath != NULL && ppPersistedEndpointCache != NULL, STATUS_NULL_ARG);
+    CHK(filePath[0] != '\0' && STRNLEN(filePath, MAX_PATH_LEN + 1) <= MAX_PATH_LEN, STATUS_INVALID_ARG);
+
+    pPersistedEndpointCache = (PPersistedEndpointCache) MEMCALLOC(1, SIZEOF(PersistedEndpointCache));
+    CHK(pPersistedEndpointCache != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    STRCPY(pPersistedEndpointCache->filePath, filePath);
+    pPersistedEndpointCache->cvar = INVALID_CVAR_VALUE;
+    pPersistedEndpointCache->writerThreadId = INVALID_TID_VALUE;
+    ATOMIC_STORE_BOOL(&pPersistedEndpointCache->shutdown, FALSE);
+
+    pPersistedEndpointCache->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pPersistedEndpointCache->lock), STATUS_INVALID_OPERATION);
+    pPersistedEndpointCache->cvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pPersistedEndpointCache->cvar), STATUS_INVALID_OPERATION);
+
+    // A missing or a corrupt file means a cold start rather than a failure
+    status = persistedEndpointCacheLoad(pPersistedEndpointCache);
+    if (STATUS_FAILED(status)) {
+        DLOGW("Failed to load the API call cache file %s with error: 0x%08x", filePath, status);
+    } else {
+        DLOGI("Loaded %u streams from the API call cache file %s", pPersistedEndpointCache->entryCount, filePath);
+    }
+
+    CHK_STATUS(THREAD_CREATE(&pPersistedEndpointCache->writerThreadId, persistedEndpointCacheWriterRoutine, (PVOID) pPersistedEndpointCache));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (STATUS_FAILED(retStatus)) {
+        freePersistedEndpointCache(&pPersistedEndpointCache);
+    }
+
+    if (ppPersistedEndpointCache != NULL) {
+        *ppPersistedEndpointCache = pPersistedEndpointCache;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Frees the cache object
+ */
+STATUS freePersistedEndpointCache(PPersistedEndpointCache* ppPersistedEndpointCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PPersistedEndpointCache pPersistedEndpointCache = NULL;
+    UINT32 i;
+
+    CHK(ppPersistedEndpointCache != NULL, STATUS_NULL_ARG);
+
+    pPersistedEndpointCache = *ppPersistedEndpointCache;
+
+    // Call is idempotent
+    CHK(pPersistedEndpointCache != NULL, retStatus);
+
+    // Stop the writer thread which writes out the pending update before exiting
+    if (IS_VALID_TID_VALUE(pPersistedEndpointCache->writerThreadId)) {
+        MUTEX_LOCK(pPersistedEndpointCache->lock);
+        ATOMIC_STORE_BOOL(&pPersistedEndpointCache->shutdown, TRUE);
+        CVAR_SIGNAL(pPersistedEndpointCache->cvar);
+        MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+
+        THREAD_JOIN(pPersistedEndpointCache->writerThreadId, NULL);
+        pPersistedEndpointCache->writerThreadId = INVALID_TID_VALUE;
+    }
+
+    for (i = 0; i < pPersistedEndpointCache->entryCount; i++) {
+        SAFE_MEMFREE(pPersistedEndpointCache->entries[i]);
+    }
+
+    if (IS_VALID_CVAR_VALUE(pPersistedEndpointCache->cvar)) {
+        CVAR_FREE(pPersistedEndpointCache->cvar);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pPersistedEndpointCache->lock)) {
+        MUTEX_FREE(pPersistedEndpointCache->lock);
+    }
+
+    MEMFREE(pPersistedEndpointCache);
+
+    *ppPersistedEndpointCache = NULL;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS persistedEndpointCacheGet(PPersistedEndpointCache pPersistedEndpointCache, PCHAR region, PCHAR streamName,
+                                 PPersistedEndpoint pPersistedEndpoint)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPersistedEndpoint pEntry;
+    BOOL locked = FALSE;
+
+    CHK(pPersistedEndpointCache != NULL && region != NULL && streamName != NULL && pPersistedEndpoint != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pPersistedEndpointCache->lock);
+    locked = TRUE;
+
+    pEntry = persistedEndpointCacheFind(pPersistedEndpointCache, region, streamName);
+    CHK(pEntry != NULL, STATUS_HASH_KEY_NOT_PRESENT);
+
+    MEMCPY(pPersistedEndpoint, pEntry, SIZEOF(PersistedEndpoint));
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS persistedEndpointCachePut(PPersistedEndpointCache pPersistedEndpointCache, PPersistedEndpoint pPersistedEndpoint)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPersistedEndpoint pEntry;
+    UINT32 i;
+    BOOL locked = FALSE;
+
+    CHK(pPersistedEndpointCache != NULL && pPersistedEndpoint != NULL, STATUS_NULL_ARG);
+    CHK(pPersistedEndpoint->region[0] != '\0' && pPersistedEndpoint->streamName[0] != '\0' &&
+        pPersistedEndpoint->streamingEndpoint[0] != '\0', STATUS_INVALID_ARG);
+
+    MUTEX_LOCK(pPersistedEndpointCache->lock);
+    locked = TRUE;
+
+    pEntry = persistedEndpointCacheFind(pPersistedEndpointCache, pPersistedEndpoint->region, pPersistedEndpoint->streamName);
+
+    if (pEntry == NULL && pPersistedEndpointCache->entryCount < PERSISTED_ENDPOINT_CACHE_MAX_ENTRY_COUNT) {
+        pEntry = (PPersistedEndpoint) MEMALLOC(SIZEOF(PersistedEndpoint));
+        CHK(pEntry != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pPersistedEndpointCache->entries[pPersistedEndpointCache->entryCount++] = pEntry;
+    } else if (pEntry == NULL) {
+        // Replace the least recently updated entry
+        pEntry = pPersistedEndpointCache->entries[0];
+        for (i = 1; i < pPersistedEndpointCache->entryCount; i++) {
+            if (pPersistedEndpointCache->entries[i]->updateTime < pEntry->updateTime) {
+                pEntry = pPersistedEndpointCache->entries[i];
+            }
+        }
+    }
+
+    MEMCPY(pEntry, pPersistedEndpoint, SIZEOF(PersistedEndpoint));
+
+    // The writer only needs waking up for the first update of a batch
+    if (!pPersistedEndpointCache->dirty) {
+        pPersistedEndpointCache->dirty = TRUE;
+        CVAR_SIGNAL(pPersistedEndpointCache->cvar);
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+    }
+
+    return retStatus;
+}
+
+/**
+ * Writes out the updates. The updates made within the write delay of the first one are batched into a single write.
+ */
+PVOID persistedEndpointCacheWriterRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    PPersistedEndpointCache pPersistedEndpointCache = (PPersistedEndpointCache) args;
+    BOOL stopped = FALSE;
+
+    CHK(pPersistedEndpointCache != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pPersistedEndpointCache->lock);
+
+    while (!stopped) {
+        if (!pPersistedEndpointCache->dirty && !ATOMIC_LOAD_BOOL(&pPersistedEndpointCache->shutdown)) {
+            CVAR_WAIT(pPersistedEndpointCache->cvar, pPersistedEndpointCache->lock, INFINITE_TIME_VALUE);
+        }
+
+        if (pPersistedEndpointCache->dirty && !ATOMIC_LOAD_BOOL(&pPersistedEndpointCache->shutdown)) {
+            CVAR_WAIT(pPersistedEndpointCache->cvar, pPersistedEndpointCache->lock, PERSISTED_ENDPOINT_CACHE_WRITE_DELAY);
+        }
+
+        // The update made before the shutdown is still written out
+        stopped = ATOMIC_LOAD_BOOL(&pPersistedEndpointCache->shutdown);
+
+        if (pPersistedEndpointCache->dirty) {
+            pPersistedEndpointCache->dirty = FALSE;
+
+            MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+            status = persistedEndpointCacheSave(pPersistedEndpointCache);
+            if (STATUS_FAILED(status)) {
+                DLOGW("Failed to write the API call cache file %s with error: 0x%08x", pPersistedEndpointCache->filePath, status);
+            }
+
+            MUTEX_LOCK(pPersistedEndpointCache->lock);
+        }
+    }
+
+    MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+
+CleanUp:
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+/**
+ * Reads the cache file. The malformed lines are skipped.
+ */
+STATUS persistedEndpointCacheLoad(PPersistedEndpointCache pPersistedEndpointCache)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pBuffer = NULL, pLine, pLineEnd, pContentEnd, pEnd;
+    PPersistedEndpoint pEntry = NULL;
+    UINT64 fileSize = 0;
+    BOOL fileFound = FALSE;
+
+    CHK(pPersistedEndpointCache != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(fileExists(pPersistedEndpointCache->filePath, &fileFound));
+    CHK(fileFound, retStatus);
+
+    CHK_STATUS(readFile(pPersistedEndpointCache->filePath, TRUE, NULL, &fileSize));
+    CHK(fileSize <= PERSISTED_ENDPOINT_CACHE_MAX_FILE_SIZE, STATUS_INVALID_ARG_LEN);
+
+    pBuffer = (PCHAR) MEMALLOC((SIZE_T) fileSize + 1);
+    CHK(pBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    CHK_STATUS(readFile(pPersistedEndpointCache->filePath, TRUE, (PBYTE) pBuffer, &fileSize));
+    pBuffer[fileSize] = '\0';
+    pEnd = pBuffer + fileSize;
+
+    // Files of other versions are discarded
+    CHK(0 == STRNCMP(pBuffer, PERSISTED_ENDPOINT_CACHE_FILE_HEADER, STRLEN(PERSISTED_ENDPOINT_CACHE_FILE_HEADER)), STATUS_INVALID_ARG);
+
+    for (pLine = pBuffer; pLine < pEnd && pPersistedEndpointCache->entryCount < PERSISTED_ENDPOINT_CACHE_MAX_ENTRY_COUNT; pLine = pLineEnd + 1) {
+        for (pLineEnd = pLine; pLineEnd < pEnd && *pLineEnd != '\n'; pLineEnd++);
+
+        // Drop the carriage return of the files edited on Windows
+        pContentEnd = pLineEnd;
+        if (pContentEnd > pLine && *(pContentEnd - 1) == '\r') {
+            pContentEnd--;
+        }
+
+        *pContentEnd = '\0';
+
+        if (*pLine == '#' || *pLine == '\0') {
+            continue;
+        }
+
+        if (pEntry == NULL) {
+            pEntry = (PPersistedEndpoint) MEMALLOC(SIZEOF(PersistedEndpoint));
+            CHK(pEntry != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        }
+
+        if (STATUS_FAILED(persistedEndpointCacheParseLine(pLine, pContentEnd, pEntry))) {
+            DLOGW("Skipping a malformed line in the API call cache file %s", pPersistedEndpointCache->filePath);
+        } else if (persistedEndpointCacheFind(pPersistedEndpointCache, pEntry->region, pEntry->streamName) == NULL) {
+            pPersistedEndpointCache->entries[pPersistedEndpointCache->entryCount++] = pEntry;
+            pEntry = NULL;
+        }
+    }
+
+CleanUp:
+
+    SAFE_MEMFREE(pEntry);
+    SAFE_MEMFREE(pBuffer);
+
+    return retStatus;
+}
+
+/**
+ * Rewrites the cache file. The entries are serialized under the lock and the file is written without it.
+ * The content is written to a temporary file first which then replaces the cache file.
+ */
+STATUS persistedEndpointCacheSave(PPersistedEndpointCache pPersistedEndpointCache)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pBuffer = NULL;
+    PPersistedEndpoint pEntry;
+    CHAR tempFilePath[MAX_PATH_LEN + SIZEOF(PERSISTED_ENDPOINT_CACHE_TEMP_FILE_SUFFIX)];
+    UINT32 i, bufferSize, offset;
+    INT32 written;
+    BOOL locked = FALSE;
+
+    CHK(pPersistedEndpointCache != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pPersistedEndpointCache->lock);
+    locked = TRUE;
+
+    bufferSize = pPersistedEndpointCache->entryCount * PERSISTED_ENDPOINT_CACHE_MAX_LINE_LEN + STRLEN(PERSISTED_ENDPOINT_CACHE_FILE_HEADER) + 2;
+    pBuffer = (PCHAR) MEMALLOC(bufferSize);
+    CHK(pBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    offset = (UINT32) SNPRINTF(pBuffer, bufferSize, "%s\n", PERSISTED_ENDPOINT_CACHE_FILE_HEADER);
+
+    // region stream-name update-time stream-arn data-endpoint
+    for (i = 0; i < pPersistedEndpointCache->entryCount; i++) {
+        pEntry = pPersistedEndpointCache->entries[i];
+        written = SNPRINTF(pBuffer + offset, bufferSize - offset, "%s %s %" PRIu64 " %s %s\n", pEntry->region, pEntry->streamName,
+                           pEntry->updateTime, pEntry->streamArn[0] == '\0' ? PERSISTED_ENDPOINT_CACHE_EMPTY_VALUE : pEntry->streamArn,
+                           pEntry->streamingEndpoint);
+        CHK(written > 0 && offset + (UINT32) written < bufferSize, STATUS_BUFFER_TOO_SMALL);
+        offset += (UINT32) written;
+    }
+
+    MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+    locked = FALSE;
+
+    SNPRINTF(tempFilePath, SIZEOF(tempFilePath), "%s%s", pPersistedEndpointCache->filePath, PERSISTED_ENDPOINT_CACHE_TEMP_FILE_SUFFIX);
+    CHK_STATUS(writeFile(tempFilePath, TRUE, FALSE, (PBYTE) pBuffer, offset));
+
+#if defined __WINDOWS_BUILD__
+    CHK(MoveFileExA(tempFilePath, pPersistedEndpointCache->filePath, MOVEFILE_REPLACE_EXISTING), STATUS_WRITE_TO_FILE_FAILED);
+#else
+    CHK(0 == rename(tempFilePath, pPersistedEndpointCache->filePath), STATUS_WRITE_TO_FILE_FAILED);
+#endif
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pPersistedEndpointCache->lock);
+    }
+
+    SAFE_MEMFREE(pBuffer);
+
+    return retStatus;
+}
+
+/**
+ * Parses a space separated entry line
+ */
+STATUS persistedEndpointCacheParseLine(PCHAR pLine, PCHAR pLineEnd, PPersistedEndpoint pPersistedEndpoint)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pCurPtr = pLine;
+    CHAR updateTime[32];
+
+    CHK(pLine != NULL && pLineEnd != NULL && pPersistedEndpoint != NULL, STATUS_NULL_ARG);
+
+    MEMSET(pPersistedEndpoint, 0x00, SIZEOF(PersistedEndpoint));
+
+    CHK_STATUS(persistedEndpointCacheCopyToken(&pCurPtr, pLineEnd, pPersistedEndpoint->region, SIZEOF(pPersistedEndpoint->region)));
+    CHK_STATUS(persistedEndpointCacheCopyToken(&pCurPtr, pLineEnd, pPersistedEndpoint->streamName, SIZEOF(pPersistedEndpoint->streamName)));
+    CHK_STATUS(persistedEndpointCacheCopyToken(&pCurPtr, pLineEnd, updateTime, SIZEOF(updateTime)));
+    CHK_STATUS(persistedEndpointCacheCopyToken(&pCurPtr, pLineEnd, pPersistedEndpoint->streamArn, SIZEOF(pPersistedEndpoint->streamArn)));
+    CHK_STATUS(persistedEndpointCacheCopyToken(&pCurPtr, pLineEnd, pPersistedEndpoint->streamingEndpoint, SIZEOF(pPersistedEndpoint->streamingEndpoint)));
+    CHK(pCurPtr == pLineEnd, STATUS_INVALID_ARG);
+
+    CHK_STATUS(STRTOUI64(updateTime, NULL, 10, &pPersistedEndpoint->updateTime));
+
+    if (0 == STRCMP(pPersistedEndpoint->streamArn, PERSISTED_ENDPOINT_CACHE_EMPTY_VALUE)) {
+        pPersistedEndpoint->streamArn[0] = '\0';
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Copies the next space delimited token advancing past it
+ */
+STATUS persistedEndpointCacheCopyToken(PCHAR* ppCurPtr, PCHAR pLineEnd, PCHAR pToken, UINT32 tokenSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR pStart, pCurPtr;
+    UINT32 len;
+
+    CHK(ppCurPtr != NULL && *ppCurPtr != NULL && pLineEnd != NULL && pToken != NULL, STATUS_NULL_ARG);
+
+    for (pStart = *ppCurPtr; pStart < pLineEnd && *pStart == ' '; pStart++);
+    for (pCurPtr = pStart; pCurPtr < pLineEnd && *pCurPtr != ' ' && *pCurPtr != '\0'; pCurPtr++);
+
+    len = (UINT32) (pCurPtr - pStart);
+    CHK(len != 0 && len < tokenSize, STATUS_INVALID_ARG_LEN);
+
+    MEMCPY(pToken, pStart, len);
+    pToken[len] = '\0';
+
+    // Skip the trailing spaces so the end of the line can be detected
+    for (; pCurPtr < pLineEnd && *pCurPtr == ' '; pCurPtr++);
+    *ppCurPtr = pCurPtr;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Finds the entry of the stream. Should be called with the lock held.
+ */
+PPersistedEndpoint persistedEndpointCacheFind(PPersistedEndpointCache pPersistedEndpointCache, PCHAR region, PCHAR streamName)
+{
+    UINT32 i;
+
+    for (i = 0; i < pPersistedEndpointCache->entryCount; i++) {
+        if (0 == STRCMP(pPersistedEndpointCache->entries[i]->streamName, streamName) &&
+            0 == STRCMP(pPersistedEndpointCache->entries[i]->region, region)) {
+            return pPersistedEndpointCache->entries[i];
+        }
+    }
+
+    return NULL;
+}
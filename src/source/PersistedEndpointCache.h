@@ -0,0 +1,149 @@
+/*******************************************
+Persisted endpoint cache internal include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_PERSISTED_ENDPOINT_CACHE_INCLUDE_I__
+#define __KINESIS_VIDEO_PERSISTED_ENDPOINT_CACHE_INCLUDE_I__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Environment variable pointing to the cache file. The cache is disabled if not set
+#define KVS_API_CALL_CACHE_FILE_PATH_ENV_VAR                "KVS_API_CALL_CACHE_FILE_PATH"
+
+// Max number of the streams kept in the cache. The least recently updated one is replaced when full
+#define PERSISTED_ENDPOINT_CACHE_MAX_ENTRY_COUNT            256
+
+// Header line of the cache file. Files with a different header are ignored
+#define PERSISTED_ENDPOINT_CACHE_FILE_HEADER                "# KVS API call cache v1"
+
+// Stands in for the unknown stream ARN in the cache file
+#define PERSISTED_ENDPOINT_CACHE_EMPTY_VALUE                "-"
+
+// Max length of an entry line in the cache file
+#define PERSISTED_ENDPOINT_CACHE_MAX_LINE_LEN               (MAX_REGION_NAME_LEN + MAX_STREAM_NAME_LEN + MAX_ARN_LEN + MAX_URI_CHAR_LEN + 32)
+
+// Max size of the cache file
+#define PERSISTED_ENDPOINT_CACHE_MAX_FILE_SIZE              (PERSISTED_ENDPOINT_CACHE_MAX_ENTRY_COUNT * PERSISTED_ENDPOINT_CACHE_MAX_LINE_LEN + 64)
+
+// Suffix of the file the cache is written to before it's renamed over the cache file
+#define PERSISTED_ENDPOINT_CACHE_TEMP_FILE_SUFFIX           ".tmp"
+
+// Period the updates are collected for before the file is written out so the streams starting together cause a single write
+#define PERSISTED_ENDPOINT_CACHE_WRITE_DELAY                (1 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+/**
+ * Control plane results of a stream persisted across the restarts
+ */
+typedef struct __PersistedEndpoint PersistedEndpoint;
+struct __PersistedEndpoint {
+    // Key of the entry
+    CHAR region[MAX_REGION_NAME_LEN + 1];
+    CHAR streamName[MAX_STREAM_NAME_LEN + 1];
+
+    // Stream ARN. Empty if not known
+    CHAR streamArn[MAX_ARN_LEN + 1];
+
+    // Data endpoint of the stream
+    CHAR streamingEndpoint[MAX_URI_CHAR_LEN + 1];
+
+    // Wall clock time the data endpoint was retrieved. The entry is valid for the endpoint caching period from then
+    UINT64 updateTime;
+};
+typedef struct __PersistedEndpoint* PPersistedEndpoint;
+
+/**
+ * Write-behind on-disk cache of the stream ARNs and data endpoints keyed by the region and the stream name.
+ * Loaded once on creation so the streams can skip the control plane calls on the first start after a restart.
+ * The file is rewritten by a writer thread shortly after the updates so the callers never block on the file system.
+ * The file is replaced atomically so a crash mid-write leaves the previous version in place.
+ */
+typedef struct __PersistedEndpointCache PersistedEndpointCache;
+struct __PersistedEndpointCache {
+    // Path of the cache file
+    CHAR filePath[MAX_PATH_LEN + 1];
+
+    // Cached entries. Allocated on demand as the max sized entries are large
+    PPersistedEndpoint entries[PERSISTED_ENDPOINT_CACHE_MAX_ENTRY_COUNT];
+    UINT32 entryCount;
+
+    // Lock guarding the entries
+    MUTEX lock;
+
+    // Signaled on an update and on shutdown
+    CVAR cvar;
+
+    // Whether the entries have been updated since the file was last written
+    BOOL dirty;
+
+    // Writer thread
+    TID writerThreadId;
+
+    // Whether the writer thread should exit once the pending update is written
+    volatile ATOMIC_BOOL shutdown;
+};
+typedef struct __PersistedEndpointCache* PPersistedEndpointCache;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates the cache and loads the cache file if it exists. An unreadable file is ignored.
+ *
+ * @param - PCHAR - IN - Path of the cache file
+ * @param - PPersistedEndpointCache* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createPersistedEndpointCache(PCHAR, PPersistedEndpointCache*);
+
+/**
+ * Frees the cache object writing out the pending update
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PPersistedEndpointCache* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freePersistedEndpointCache(PPersistedEndpointCache*);
+
+/**
+ * Returns the cached entry of the stream
+ *
+ * @param - PPersistedEndpointCache - IN - Cache object
+ * @param - PCHAR - IN - Region
+ * @param - PCHAR - IN - Stream name
+ * @param - PPersistedEndpoint - OUT - Copy of the entry
+ *
+ * @return - STATUS code of the execution. STATUS_HASH_KEY_NOT_PRESENT if the stream is not cached
+ */
+STATUS persistedEndpointCacheGet(PPersistedEndpointCache, PCHAR, PCHAR, PPersistedEndpoint);
+
+/**
+ * Stores the entry and schedules the cache file to be written out
+ *
+ * @param - PPersistedEndpointCache - IN - Cache object
+ * @param - PPersistedEndpoint - IN - Entry to store. Replaces the existing entry of the stream
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS persistedEndpointCachePut(PPersistedEndpointCache, PPersistedEndpoint);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID persistedEndpointCacheWriterRoutine(PVOID);
+STATUS persistedEndpointCacheLoad(PPersistedEndpointCache);
+STATUS persistedEndpointCacheSave(PPersistedEndpointCache);
+STATUS persistedEndpointCacheParseLine(PCHAR, PCHAR, PPersistedEndpoint);
+STATUS persistedEndpointCacheCopyToken(PCHAR*, PCHAR, PCHAR, UINT32);
+PPersistedEndpoint persistedEndpointCacheFind(PPersistedEndpointCache, PCHAR, PCHAR);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_PERSISTED_ENDPOINT_CACHE_INCLUDE_I__ */
@@ -46,7 +46,10 @@ STATUS createCurlRequest(HTTP_REQUEST_VERB curlVerb, PCHAR url, PCHAR body, STRE
     pCurlRequest->pCurlApiCallbacks = pCurlApiCallbacks;
     ATOMIC_STORE_BOOL(&pCurlRequest->requestInfo.terminating, FALSE);
     ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, FALSE);
+    ATOMIC_STORE_BOOL(&pCurlRequest->scheduled, FALSE);
     pCurlRequest->threadId = INVALID_TID_VALUE;
+    pCurlRequest->completionFn = NULL;
+    pCurlRequest->pNetworkLoop = NULL;
     pCurlRequest->requestInfo.bodySize = bodySize;
     pCurlRequest->requestInfo.currentTime = currentTime;
 
@@ -68,9 +71,6 @@ STATUS createCurlRequest(HTTP_REQUEST_VERB curlVerb, PCHAR url, PCHAR body, STRE
         pCurlRequest->uploadHandle = (UPLOAD_HANDLE) pCurlApiCallbacks->streamingRequestCount++;
     }
 
-    // Create a list of headers
-    CHK_STATUS(singleListCreate(&pCurlRequest->requestInfo.pRequestHeaders));
-
     // Create the mutex
     pCurlRequest->startLock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, FALSE);
     CHK(pCurlRequest->startLock != INVALID_MUTEX_VALUE, STATUS_INVALID_OPERATION);
@@ -126,11 +126,9 @@ STATUS freeCurlRequest(PCurlRequest* ppCurlRequest)
         pCallbacksProvider->clientCallbacks.freeMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlRequest->startLock);
     }
 
-    // Remove and free the headers
+    // Free the headers which didn't fit into the inline storage
     removeRequestHeaders(&pCurlRequest->requestInfo);
 
-    stackQueueFree(pCurlRequest->requestInfo.pRequestHeaders);
-
     // Release the object
     MEMFREE(pCurlRequest);
 
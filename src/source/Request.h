@@ -15,6 +15,14 @@ extern "C" {
  */
 struct __CurlApiCallbacks;
 struct __CurlResponse;
+struct __CurlRequest;
+struct __CurlNetworkLoop;
+struct __CurlStreamMetricsTracker;
+
+/**
+ * Request completion routine which is invoked with the status of the execution once the curl session is done
+ */
+typedef STATUS (*CurlRequestCompletionFunc)(struct __CurlRequest*, STATUS);
 
 /**
  * Curl Request structure
@@ -50,6 +58,25 @@ struct __CurlRequest {
 
     // upload handle if request.streaming is TRUE
     UPLOAD_HANDLE uploadHandle;
+
+    // Routine processing the result of the request
+    CurlRequestCompletionFunc completionFn;
+
+    // Network loop driving the request or NULL if the request runs on its own thread
+    struct __CurlNetworkLoop* pNetworkLoop;
+
+    // Node of the request in the active requests of the network loop. Accessed from the loop thread only
+    PDoubleListNode pNetworkLoopNode;
+
+    // Whether the request is held by the scheduler awaiting its call after time and has no transport yet
+    volatile ATOMIC_BOOL scheduled;
+
+    // Metrics of the stream the putMedia session is for or NULL for the control plane requests
+    struct __CurlStreamMetricsTracker* pStreamMetricsTracker;
+
+    // Transport options of the putMedia session
+    CurlStreamUploadOptions uploadOptions;
+
     // Body of the request will follow if specified
 };
 typedef struct __CurlRequest* PCurlRequest;
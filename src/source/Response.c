@@ -16,6 +16,8 @@ STATUS createCurlResponse(PCurlRequest pCurlRequest, PCurlResponse* ppCurlRespon
     PCallbacksProvider pCallbacksProvider;
     PCHAR debugDumpDataFileDir = NULL;
     UINT32 debugDumpDataFileDirLen = 0;
+    CHAR debugDumpFilePathPrefix[MAX_PATH_LEN + 1];
+    BOOL ownThread;
 
     CHK(ppCurlResponse != NULL &&
         pCurlRequest != NULL &&
@@ -29,41 +31,76 @@ STATUS createCurlResponse(PCurlRequest pCurlRequest, PCurlResponse* ppCurlRespon
     pCurlResponse = (PCurlResponse) MEMCALLOC(1, SIZEOF(CurlResponse));
     CHK(pCurlResponse != NULL, STATUS_NOT_ENOUGH_MEMORY);
     pCurlResponse->terminated = FALSE;
+    ATOMIC_STORE_BOOL(&pCurlResponse->unpauseRequested, FALSE);
+    ATOMIC_STORE_BOOL(&pCurlResponse->terminationRequested, FALSE);
+
+    // Set the parent object
+    pCurlResponse->pCurlRequest = pCurlRequest;
 
     // init putMedia related members
     pCurlResponse->endOfStream = FALSE;
     pCurlResponse->paused = TRUE;
-    pCurlResponse->debugDumpFile = FALSE;
-    pCurlResponse->debugDumpFilePath[0] = '\0';
+    pCurlResponse->pDebugDumpFile = NULL;
 
-    if ((debugDumpDataFileDir = getenv(KVS_DEBUG_DUMP_DATA_FILE_DIR_ENV_VAR)) != NULL && pCurlRequest->streaming) {
+    if (pCurlApiCallbacks->pDebugDumpWriter != NULL && pCurlRequest->streaming &&
+        (debugDumpDataFileDir = getenv(KVS_DEBUG_DUMP_DATA_FILE_DIR_ENV_VAR)) != NULL) {
         // debugDumpDataFileDirLen is MAX_PATH_LEN + 1 at max plus null terminator.
-        debugDumpDataFileDirLen = (UINT32) SNPRINTF(pCurlResponse->debugDumpFilePath, MAX_PATH_LEN + 1, (PCHAR) "%s/%s_%" PRIu64 ".mkv",
+        debugDumpDataFileDirLen = (UINT32) SNPRINTF(debugDumpFilePathPrefix, MAX_PATH_LEN + 1, (PCHAR) "%s/%s_%" PRIu64,
                  debugDumpDataFileDir, pCurlRequest->streamName, (UINT64) pCurlRequest->uploadHandle);
         CHK(debugDumpDataFileDirLen <= MAX_PATH_LEN, STATUS_PATH_TOO_LONG);
-        pCurlResponse->debugDumpFile = TRUE;
-        pCurlResponse->debugDumpFilePath[MAX_PATH_LEN] = '\0';
-        // create file to override any existing file with the same name
-        CHK_STATUS(createFile(pCurlResponse->debugDumpFilePath, 0));
+        debugDumpFilePathPrefix[MAX_PATH_LEN] = '\0';
+        // the writer keeps the file open and writes it out on its own thread
+        CHK_STATUS(debugDumpWriterAddFile(pCurlApiCallbacks->pDebugDumpWriter, debugDumpFilePathPrefix, &pCurlResponse->pDebugDumpFile));
     }
+
+    CHK_STATUS(fragmentAckTokenizerInit(&pCurlResponse->ackTokenizer, curlResponseAckReceived, (UINT64) pCurlRequest));
     // end init putMedia related members
 
     // Create the mutex
     pCurlResponse->lock = pCallbacksProvider->clientCallbacks.createMutexFn(pCallbacksProvider->clientCallbacks.customData, TRUE);
     CHK(pCurlResponse->lock != INVALID_MUTEX_VALUE , STATUS_INVALID_OPERATION);
 
-    // Set the parent object
-    pCurlResponse->pCurlRequest = pCurlRequest;
-
+    // The streaming sessions running on their own thread are driven through a multi handle of their own so the
+    // data availability and the termination can wake them up while they are paused. The control plane calls
+    // are short and are performed with curl_easy_perform. The network loops drive all of the requests through
+    // the multi handle of the loop instead. The loop count is set once before any request is created.
+    ownThread = (pCurlApiCallbacks->networkLoopCount == 0);
     CHK_STATUS(initializeCurlSession(&pCurlRequest->requestInfo,
                                      &pCurlResponse->callInfo,
+                                     pCurlApiCallbacks->pCurlHandlePool,
                                      &pCurlResponse->pCurl,
+                                     ownThread && pCurlRequest->streaming ? &pCurlResponse->pCurlMulti : NULL,
                                      pCurlRequest,
                                      writeHeaderCallback,
                                      postReadCallback,
                                      postWriteCallback,
                                      postResponseWriteCallback));
 
+    // Apply the transport options of the putMedia session
+    if (pCurlRequest->streaming) {
+        CHK_STATUS(setCurlUploadOptions(pCurlResponse->pCurl, pCurlRequest));
+    }
+
+    // Nothing can wake up curl_easy_perform so the termination is picked up from the progress callback instead
+    if (ownThread && pCurlResponse->pCurlMulti == NULL) {
+        curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_XFERINFOFUNCTION, terminationProgressCallback);
+        curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_XFERINFODATA, pCurlResponse);
+        curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    if (pCurlApiCallbacks->http2Enabled) {
+        CHK_STATUS(setCurlHttp2Options(pCurlResponse->pCurl, pCurlResponse->pCurlMulti));
+    }
+
+    // Inject the addresses resolved in the background so the session doesn't block on DNS. Best effort
+    if (pCurlApiCallbacks->pCurlResolverCache != NULL) {
+        CHK_LOG_ERR(curlResolverCacheGetResolveList(pCurlApiCallbacks->pCurlResolverCache, pCurlRequest->requestInfo.url,
+                                                    &pCurlResponse->pResolveList));
+        if (pCurlResponse->pResolveList != NULL) {
+            curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_RESOLVE, pCurlResponse->pResolveList);
+        }
+    }
+
 CleanUp:
 
     if (STATUS_FAILED(retStatus)) {
@@ -121,6 +158,11 @@ STATUS freeCurlResponse(PCurlResponse* ppCurlResponse)
         locked = FALSE;
     }
 
+    // Write out the remaining dumped data now that curl no longer reads
+    if (pCurlResponse->pDebugDumpFile != NULL) {
+        debugDumpWriterRemoveFile(pCurlResponse->pCurlRequest->pCurlApiCallbacks->pDebugDumpWriter, &pCurlResponse->pDebugDumpFile);
+    }
+
     // Release the object
     MEMFREE(pCurlResponse);
 
@@ -132,7 +174,9 @@ CleanUp:
 
 STATUS initializeCurlSession(PRequestInfo pRequestInfo,
                              PCallInfo pCallInfo,
+                             PCurlHandlePool pCurlHandlePool,
                              CURL** ppCurl,
+                             CURLM** ppCurlMulti,
                              PVOID data,
                              CurlCallbackFunc writeHeaderFn,
                              CurlCallbackFunc readFn,
@@ -143,6 +187,7 @@ STATUS initializeCurlSession(PRequestInfo pRequestInfo,
     STATUS retStatus = STATUS_SUCCESS;
     BOOL secureConnection;
     CURL* pCurl = NULL;
+    CURLM* pCurlMulti = NULL;
     UINT32 length;
     STAT_STRUCT entryStat;
 
@@ -152,9 +197,22 @@ STATUS initializeCurlSession(PRequestInfo pRequestInfo,
     pCallInfo->httpStatus = HTTP_STATUS_CODE_NOT_SET;
     pCallInfo->callResult = SERVICE_CALL_RESULT_NOT_SET;
 
-    // Initialize curl and set options
-    pCurl = curl_easy_init();
-    CHK(pCurl != NULL, STATUS_CURL_INIT_FAILED);
+    // Initialize curl and set options. Pooled handles share the TLS sessions and come with the multi handle
+    // caching their connections if they are driven through one
+    if (pCurlHandlePool != NULL) {
+        CHK_STATUS(curlHandlePoolAcquire(pCurlHandlePool, pRequestInfo->url, &pCurl, ppCurlMulti == NULL ? NULL : &pCurlMulti));
+    } else {
+        pCurl = curl_easy_init();
+        CHK(pCurl != NULL, STATUS_CURL_INIT_FAILED);
+    }
+
+    if (ppCurlMulti != NULL) {
+        *ppCurlMulti = pCurlMulti;
+        if (pCurlMulti == NULL) {
+            *ppCurlMulti = curl_multi_init();
+            CHK(*ppCurlMulti != NULL, STATUS_CURL_INIT_FAILED);
+        }
+    }
 
     // set up the friendly error message buffer
     pCallInfo->errorBuffer[0] = '\0';
@@ -216,6 +274,10 @@ STATUS initializeCurlSession(PRequestInfo pRequestInfo,
             curl_easy_setopt(pCurl, CURLOPT_PUT, 1L);
             break;
 
+        case HTTP_REQUEST_VERB_HEAD:
+            curl_easy_setopt(pCurl, CURLOPT_NOBODY, 1L);
+            break;
+
         case HTTP_REQUEST_VERB_POST:
             curl_easy_setopt(pCurl, CURLOPT_POST, 1L);
             if (pRequestInfo->body == NULL) {
@@ -239,33 +301,218 @@ STATUS initializeCurlSession(PRequestInfo pRequestInfo,
             break;
     }
 
-    // Create the response headers list
-    CHK_STATUS(stackQueueCreate(&pCallInfo->pResponseHeaders));
+    // The response headers aren't queued - the consumed ones are kept in the arena of the response
 
     *ppCurl = pCurl;
+    pCurl = NULL;
 
 CleanUp:
 
+    if (pCurl != NULL) {
+        curl_easy_cleanup(pCurl);
+    }
+
     LEAVES();
     return retStatus;
 }
 
+STATUS setCurlUploadOptions(CURL* pCurl, PCurlRequest pCurlRequest)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlStreamUploadOptions pUploadOptions;
+
+    CHK(pCurl != NULL && pCurlRequest != NULL, STATUS_NULL_ARG);
+    pUploadOptions = &pCurlRequest->uploadOptions;
+
+    // Larger reads amortize the per read overhead of the putMedia read callback
+    if (pUploadOptions->uploadBufferSize != 0) {
+        curl_easy_setopt(pCurl, CURLOPT_UPLOAD_BUFFERSIZE, (long) pUploadOptions->uploadBufferSize);
+    }
+
+    curl_easy_setopt(pCurl, CURLOPT_TCP_NODELAY, pUploadOptions->tcpNoDelay ? 1L : 0L);
+
+    if (pUploadOptions->tcpKeepAliveIdleTime != 0) {
+        curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPIDLE, (long) MAX(1, pUploadOptions->tcpKeepAliveIdleTime / HUNDREDS_OF_NANOS_IN_A_SECOND));
+        if (pUploadOptions->tcpKeepAliveInterval != 0) {
+            curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPINTVL, (long) MAX(1, pUploadOptions->tcpKeepAliveInterval / HUNDREDS_OF_NANOS_IN_A_SECOND));
+        }
+    }
+
+    // The send buffer can only be set on the socket itself
+    if (pUploadOptions->socketSendBufferSize != 0) {
+        curl_easy_setopt(pCurl, CURLOPT_SOCKOPTFUNCTION, uploadSocketOptionCallback);
+        curl_easy_setopt(pCurl, CURLOPT_SOCKOPTDATA, pCurlRequest);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS setCurlHttp2Options(CURL* pCurl, CURLM* pCurlMulti)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pCurl != NULL, STATUS_NULL_ARG);
+
+    // HTTP/2 is negotiated through ALPN so plain HTTP and the endpoints without HTTP/2 stay on HTTP/1.1.
+    // The connection specific headers of the requests are dropped by curl on HTTP/2.
+    curl_easy_setopt(pCurl, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+
+    // Wait for a connection being established to the same host to multiplex over rather than opening a new one
+    curl_easy_setopt(pCurl, CURLOPT_PIPEWAIT, 1L);
+
+    if (pCurlMulti != NULL) {
+        curl_multi_setopt(pCurlMulti, CURLMOPT_PIPELINING, (long) CURLPIPE_MULTIPLEX);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+INT32 uploadSocketOptionCallback(PVOID customData, curl_socket_t socket, curlsocktype purpose)
+{
+    PCurlRequest pCurlRequest = (PCurlRequest) customData;
+    INT32 sendBufferSize = 0, requestedSize;
+    socklen_t optionLen = SIZEOF(sendBufferSize);
+
+    if (pCurlRequest != NULL && purpose == CURLSOCKTYPE_IPCXN) {
+        requestedSize = (INT32) pCurlRequest->uploadOptions.socketSendBufferSize;
+
+        // Never shrink the system default
+        if (getsockopt(socket, SOL_SOCKET, SO_SNDBUF, (PCHAR) &sendBufferSize, &optionLen) != 0 || sendBufferSize < requestedSize) {
+            if (setsockopt(socket, SOL_SOCKET, SO_SNDBUF, (PCHAR) &requestedSize, SIZEOF(requestedSize)) != 0) {
+                DLOGW("Failed to set the send buffer size of %d bytes for stream %s", requestedSize, pCurlRequest->streamName);
+            }
+        }
+    }
+
+    return CURL_SOCKOPT_OK;
+}
+
+INT32 terminationProgressCallback(PVOID customData, curl_off_t downloadTotal, curl_off_t downloadNow, curl_off_t uploadTotal,
+                                  curl_off_t uploadNow)
+{
+    PCurlResponse pCurlResponse = (PCurlResponse) customData;
+    PCallbacksProvider pCallbacksProvider;
+    UINT64 currentTime;
+
+    UNUSED_PARAM(downloadTotal);
+    UNUSED_PARAM(downloadNow);
+    UNUSED_PARAM(uploadTotal);
+    UNUSED_PARAM(uploadNow);
+
+    if (pCurlResponse == NULL || pCurlResponse->terminated || !ATOMIC_LOAD_BOOL(&pCurlResponse->terminationRequested)) {
+        return 0;
+    }
+
+    // Give curl some time to terminate gracefully before actually aborting it
+    pCallbacksProvider = pCurlResponse->pCurlRequest->pCurlApiCallbacks->pCallbacksProvider;
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    if (currentTime < pCurlResponse->terminationTime) {
+        return 0;
+    }
+
+    DLOGV("Aborting the terminated curl session");
+    pCurlResponse->terminated = TRUE;
+
+    // Any non-zero value aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+    return 1;
+}
+
+STATUS curlResponseStoreHeader(PCurlResponse pCurlResponse, PCHAR pName, UINT32 nameLen, PCHAR pValue, UINT32 valueLen,
+                               PRequestHeader* ppRequestHeader)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRequestHeader pRequestHeader;
+    PCHAR pArena;
+
+    CHK(pCurlResponse != NULL && pName != NULL && pValue != NULL && ppRequestHeader != NULL, STATUS_NULL_ARG);
+    CHK(pCurlResponse->responseHeaderCount < CURL_RESPONSE_MAX_HEADER_COUNT &&
+        pCurlResponse->responseHeaderArenaOffset + nameLen + 1 + valueLen + 1 <= CURL_RESPONSE_HEADER_ARENA_SIZE,
+        STATUS_NOT_ENOUGH_MEMORY);
+
+    pArena = pCurlResponse->responseHeaderArena + pCurlResponse->responseHeaderArenaOffset;
+    pRequestHeader = &pCurlResponse->responseHeaders[pCurlResponse->responseHeaderCount];
+
+    pRequestHeader->pName = pArena;
+    pRequestHeader->nameLen = nameLen;
+    MEMCPY(pRequestHeader->pName, pName, nameLen * SIZEOF(CHAR));
+    pRequestHeader->pName[nameLen] = '\0';
+
+    pRequestHeader->pValue = pArena + nameLen + 1;
+    pRequestHeader->valueLen = valueLen;
+    MEMCPY(pRequestHeader->pValue, pValue, valueLen * SIZEOF(CHAR));
+    pRequestHeader->pValue[valueLen] = '\0';
+
+    pCurlResponse->responseHeaderArenaOffset += nameLen + 1 + valueLen + 1;
+    pCurlResponse->responseHeaderCount++;
+
+    *ppRequestHeader = pRequestHeader;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlResponseResetHeaders(PCurlResponse pCurlResponse)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pCurlResponse != NULL, STATUS_NULL_ARG);
+
+    pCurlResponse->responseHeaderCount = 0;
+    pCurlResponse->responseHeaderArenaOffset = 0;
+    pCurlResponse->callInfo.pRequestId = NULL;
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS closeCurlHandles(PCurlResponse pCurlResponse)
 {
     STATUS retStatus = STATUS_SUCCESS;
+    PCurlHandlePool pCurlHandlePool = NULL;
 
     CHK(pCurlResponse != NULL, STATUS_NULL_ARG);
 
+    if (pCurlResponse->pCurlRequest != NULL && pCurlResponse->pCurlRequest->pCurlApiCallbacks != NULL) {
+        pCurlHandlePool = pCurlResponse->pCurlRequest->pCurlApiCallbacks->pCurlHandlePool;
+    }
+
     if (pCurlResponse->pRequestHeaders != NULL) {
         curl_slist_free_all(pCurlResponse->pRequestHeaders);
         pCurlResponse->pRequestHeaders = NULL;
     }
 
-    if (pCurlResponse->pCurl) {
+    if (pCurlResponse->pCurl != NULL && pCurlHandlePool != NULL) {
+        // Keep the handle alive for the next session unless it has been force terminated. The multi handle
+        // driving it goes with it as that's where its live connections are cached.
+        curlHandlePoolRelease(pCurlHandlePool, pCurlResponse->pCurlRequest->requestInfo.url, pCurlResponse->pCurl,
+                              pCurlResponse->pCurlMulti, !pCurlResponse->terminated);
+        pCurlResponse->pCurl = NULL;
+        pCurlResponse->pCurlMulti = NULL;
+    }
+
+    if (pCurlResponse->pCurlMulti != NULL) {
+        curl_multi_cleanup(pCurlResponse->pCurlMulti);
+        pCurlResponse->pCurlMulti = NULL;
+    }
+
+    if (pCurlResponse->pCurl != NULL) {
         curl_easy_cleanup(pCurlResponse->pCurl);
         pCurlResponse->pCurl = NULL;
     }
 
+    // The handle references the list until it's reset
+    if (pCurlResponse->pResolveList != NULL) {
+        curl_slist_free_all(pCurlResponse->pResolveList);
+        pCurlResponse->pResolveList = NULL;
+    }
+
     CHK_STATUS(releaseCallInfo(&pCurlResponse->callInfo));
 
 CleanUp:
@@ -275,7 +522,9 @@ CleanUp:
 
 VOID terminateCurlSession(PCurlResponse pCurlResponse, UINT64 timeout)
 {
-    if (pCurlResponse != NULL) {
+    PCallbacksProvider pCallbacksProvider;
+
+    if (pCurlResponse != NULL && !pCurlResponse->terminated && pCurlResponse->pCurlRequest != NULL) {
         DLOGV("Force stopping the curl connection");
 
         // Currently, it seems that the only "good" way to stop CURL is to set
@@ -285,16 +534,12 @@ VOID terminateCurlSession(PCurlResponse pCurlResponse, UINT64 timeout)
         // by the time the terminate() call is issued. We can't control this timing
         // of the CURL internal buffers so we need to introduce a timeout here before
         // the main curl termination path.
-        if (!pCurlResponse->terminated) {
-            // give curl sometime to terminate gracefully before actually timing it out.
-            THREAD_SLEEP(timeout);
-            // unpause curl in case curl is paused
-            curl_easy_pause(pCurlResponse->pCurl, CURLPAUSE_SEND_CONT);
-            curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_TIMEOUT_MS, TIMEOUT_AFTER_STREAM_STOPPED);
-            // after timing out curl, give some time for it to take effect.
-            THREAD_SLEEP(timeout);
-            pCurlResponse->terminated = TRUE;
-        }
+        // The curl handle is owned by the thread driving it - the network loop or the request thread - so we
+        // can't touch it here. Let the owner un-pause and time out the session once the timeout elapses.
+        pCallbacksProvider = pCurlResponse->pCurlRequest->pCurlApiCallbacks->pCallbacksProvider;
+        pCurlResponse->terminationTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData) + timeout;
+        ATOMIC_STORE_BOOL(&pCurlResponse->terminationRequested, TRUE);
+        curlResponseWakeup(pCurlResponse);
     }
 }
 
@@ -391,13 +636,46 @@ STATUS createCurlHeaderList(PRequestInfo pRequestInfo, struct curl_slist** ppHea
 
 STATUS curlCompleteSync(PCurlResponse pCurlResponse)
 {
-    STATUS retStatus = STATUS_SUCCESS, status = STATUS_SUCCESS;
-    PCHAR url;
-    struct curl_slist* header;
-    PCurlApiCallbacks pCurlApiCallbacks;
+    STATUS retStatus = STATUS_SUCCESS;
     CURLcode result;
     PCurlRequest pCurlRequest;
-    CHAR headers[MAX_REQUEST_HEADER_COUNT * (MAX_REQUEST_HEADER_STRING_LEN + MAX_REQUEST_HEADER_OUTPUT_DELIMITER)];
+
+    CHK(pCurlResponse != NULL &&
+        pCurlResponse->pCurlRequest != NULL &&
+        pCurlResponse->pCurlRequest->pCurlApiCallbacks != NULL, STATUS_NULL_ARG);
+    pCurlRequest = pCurlResponse->pCurlRequest;
+
+    CHK_STATUS(curlPrepareRequest(pCurlResponse));
+
+    // first check the request is not being terminated
+    CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
+    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, TRUE);
+
+    // NOTE: Blocking call!
+    if (pCurlResponse->pCurlMulti != NULL) {
+        CHK_STATUS(curlPerformWithWakeup(pCurlResponse, &result));
+    } else {
+        result = curl_easy_perform(pCurlResponse->pCurl);
+    }
+
+    // The thread is out of curl and must not be cancelled or have the session terminated anymore
+    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, FALSE);
+    CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
+
+    CHK_STATUS(curlProcessRequestResult(pCurlResponse, result));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
+STATUS curlPrepareRequest(PCurlResponse pCurlResponse)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlApiCallbacks pCurlApiCallbacks;
+    PCurlRequest pCurlRequest;
 
     CHK(pCurlResponse != NULL &&
         pCurlResponse->pCurlRequest != NULL &&
@@ -415,15 +693,19 @@ STATUS curlCompleteSync(PCurlResponse pCurlResponse)
         CHK_STATUS(pCurlApiCallbacks->curlEasyPerformHookFn(pCurlResponse));
     }
 
-    // first check the request is not being terminated
-    CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
-    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, TRUE);
+CleanUp:
 
-    // NOTE: Blocking call!
-    result = curl_easy_perform(pCurlResponse->pCurl);
+    return retStatus;
+}
 
-    ATOMIC_STORE_BOOL(&pCurlRequest->blockedInCurl, TRUE);
-    CHK(!ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating), retStatus);
+STATUS curlProcessRequestResult(PCurlResponse pCurlResponse, CURLcode result)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCHAR url;
+    struct curl_slist* header;
+    CHAR headers[MAX_REQUEST_HEADER_COUNT * (MAX_REQUEST_HEADER_STRING_LEN + MAX_REQUEST_HEADER_OUTPUT_DELIMITER)];
+
+    CHK(pCurlResponse != NULL, STATUS_NULL_ARG);
 
     if (result != CURLE_OK && pCurlResponse->terminated) {
         // The transmission has been force terminated.
@@ -461,37 +743,149 @@ STATUS curlCompleteSync(PCurlResponse pCurlResponse)
 
 CleanUp:
 
-    CHK_LOG_ERR(retStatus);
-
-    return STATUS_FAILED(retStatus) ? retStatus : status;
+    return retStatus;
 }
 
 STATUS notifyDataAvailable(PCurlResponse pCurlResponse, UINT64 durationAvailable, UINT64 sizeAvailable)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    CURLcode result;
 
     CHK(pCurlResponse != NULL, STATUS_NULL_ARG);
 
     // pCurlResponse should be a putMedia session
-    if (!pCurlResponse->terminated) {
+    if (!pCurlResponse->terminated && pCurlResponse->pCurl != NULL) {
         DLOGV("Note data received: duration(100ns): %" PRIu64 " bytes %" PRIu64 " for stream handle %" PRIu64,
               durationAvailable, sizeAvailable, pCurlResponse->pCurlRequest->uploadHandle);
 
-        if (pCurlResponse->paused && pCurlResponse->pCurl != NULL) {
-            pCurlResponse->paused = FALSE;
-            // frequent pause unpause causes curl segfault in offline scenario
-            THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
-            // un-pause curl
-            result = curl_easy_pause(pCurlResponse->pCurl, CURLPAUSE_SEND_CONT);
-            if (result != CURLE_OK) {
-                DLOGW("Failed to un-pause curl with error: %u", result);
+        // The curl object can only be safely un-paused by the thread driving it. Post the request regardless
+        // of the paused state as the read callback might be just about to pause and wake the owner up.
+        ATOMIC_STORE_BOOL(&pCurlResponse->unpauseRequested, TRUE);
+        CHK_STATUS(curlResponseWakeup(pCurlResponse));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlResponseWakeup(PCurlResponse pCurlResponse)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CURLMcode result;
+
+    CHK(pCurlResponse != NULL && pCurlResponse->pCurlRequest != NULL, STATUS_NULL_ARG);
+
+    if (pCurlResponse->pCurlRequest->pNetworkLoop != NULL) {
+        CHK_STATUS(curlNetworkLoopWakeup(pCurlResponse->pCurlRequest->pNetworkLoop));
+    } else if (pCurlResponse->pCurlMulti != NULL) {
+        result = curl_multi_wakeup(pCurlResponse->pCurlMulti);
+        if (result != CURLM_OK) {
+            DLOGW("Failed to wake up the curl session with error: %s", curl_multi_strerror(result));
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS curlPerformWithWakeup(PCurlResponse pCurlResponse, CURLcode* pResult)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCallbacksProvider pCallbacksProvider;
+    CURLMcode multiResult;
+    CURLcode result = CURLE_OK;
+    CURLMsg* pCurlMsg;
+    INT32 runningCount = 1, msgCount;
+    UINT64 currentTime, pollInterval;
+    BOOL handleAdded = FALSE;
+
+    CHK(pCurlResponse != NULL && pCurlResponse->pCurlMulti != NULL && pCurlResponse->pCurlRequest != NULL && pResult != NULL,
+        STATUS_NULL_ARG);
+    pCallbacksProvider = pCurlResponse->pCurlRequest->pCurlApiCallbacks->pCallbacksProvider;
+
+    multiResult = curl_multi_add_handle(pCurlResponse->pCurlMulti, pCurlResponse->pCurl);
+    if (multiResult != CURLM_OK) {
+        DLOGW("Failed to add the curl handle with error: %s", curl_multi_strerror(multiResult));
+        CHK(FALSE, STATUS_INVALID_OPERATION);
+    }
+
+    handleAdded = TRUE;
+
+    while (runningCount != 0) {
+        pollInterval = CURL_SESSION_MAX_POLL_INTERVAL;
+
+        // Process the termination request posted by terminateCurlSession
+        if (!pCurlResponse->terminated && ATOMIC_LOAD_BOOL(&pCurlResponse->terminationRequested)) {
+            currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+            if (currentTime < pCurlResponse->terminationTime) {
+                // Give curl some time to terminate gracefully before actually timing it out.
+                pollInterval = MIN(pollInterval, pCurlResponse->terminationTime - currentTime);
+            } else {
+                DLOGV("Force stopping the curl connection for stream %s", pCurlResponse->pCurlRequest->streamName);
+                curl_easy_setopt(pCurlResponse->pCurl, CURLOPT_TIMEOUT_MS,
+                                 (long) (TIMEOUT_AFTER_STREAM_STOPPED / HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+
+                // un-pause curl in case curl is paused so the timeout is picked up right away
+                pCurlResponse->paused = FALSE;
+                result = curl_easy_pause(pCurlResponse->pCurl, CURLPAUSE_SEND_CONT);
+                if (result != CURLE_OK) {
+                    DLOGW("Failed to un-pause curl with error: %u", result);
+                }
+
+                pCurlResponse->terminated = TRUE;
+            }
+        }
+
+        // Process the un-pause request posted by the data availability notification
+        if (ATOMIC_LOAD_BOOL(&pCurlResponse->unpauseRequested)) {
+            ATOMIC_STORE_BOOL(&pCurlResponse->unpauseRequested, FALSE);
+            if (pCurlResponse->paused) {
+                pCurlResponse->paused = FALSE;
+                if (pCurlResponse->pCurlRequest->pStreamMetricsTracker != NULL) {
+                    curlStreamMetricsSetPaused(pCurlResponse->pCurlRequest->pStreamMetricsTracker, FALSE);
+                }
+
+                result = curl_easy_pause(pCurlResponse->pCurl, CURLPAUSE_SEND_CONT);
+                if (result != CURLE_OK) {
+                    DLOGW("Failed to un-pause curl with error: %u", result);
+                }
+            }
+        }
+
+        multiResult = curl_multi_perform(pCurlResponse->pCurlMulti, &runningCount);
+        if (multiResult != CURLM_OK) {
+            DLOGW("curl multi perform failed with error: %s", curl_multi_strerror(multiResult));
+            CHK(FALSE, STATUS_INVALID_OPERATION);
+        }
+
+        if (runningCount != 0) {
+            // Await socket activity, curl internal timeout, the termination time or an explicit wakeup
+            multiResult = curl_multi_poll(pCurlResponse->pCurlMulti, NULL, 0,
+                                          (INT32) (pollInterval / HUNDREDS_OF_NANOS_IN_A_MILLISECOND), NULL);
+            if (multiResult != CURLM_OK) {
+                DLOGW("curl multi poll failed with error: %s", curl_multi_strerror(multiResult));
+                CHK(FALSE, STATUS_INVALID_OPERATION);
             }
         }
     }
 
+    // Extract the result of the transfer
+    result = CURLE_OK;
+    while ((pCurlMsg = curl_multi_info_read(pCurlResponse->pCurlMulti, &msgCount)) != NULL) {
+        if (pCurlMsg->msg == CURLMSG_DONE) {
+            result = pCurlMsg->data.result;
+        }
+    }
+
+    *pResult = result;
+
 CleanUp:
 
+    if (handleAdded) {
+        curl_multi_remove_handle(pCurlResponse->pCurlMulti, pCurlResponse->pCurl);
+    }
+
     return retStatus;
 }
 
@@ -503,7 +897,7 @@ SIZE_T writeHeaderCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cu
     PCurlResponse pCurlResponse;
     SIZE_T dataSize, nameLen, valueLen;
     PCHAR pValueStart, pValueEnd;
-    PRequestHeader pRequestHeader;
+    PRequestHeader pRequestHeader = NULL;
 
     PCurlRequest pCurlRequest = (PCurlRequest) customData;
     if (pCurlRequest == NULL) {
@@ -517,11 +911,24 @@ SIZE_T writeHeaderCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cu
         return CURL_READFUNC_ABORT;
     }
 
+    // Interim responses and redirects start a new block of headers which replaces the previous one
+    if (dataSize >= SIZEOF(CURL_RESPONSE_STATUS_LINE_PREFIX) - 1 &&
+        STRNCMP(pBuffer, CURL_RESPONSE_STATUS_LINE_PREFIX, SIZEOF(CURL_RESPONSE_STATUS_LINE_PREFIX) - 1) == 0) {
+        curlResponseResetHeaders(pCurlResponse);
+        return dataSize;
+    }
+
     PCHAR pDelimiter = STRNCHR(pBuffer, (UINT32) dataSize, ':');
     if (pDelimiter != NULL) {
         // parse the header name
         nameLen = pDelimiter - pBuffer;
 
+        // Skip the headers the producer doesn't consume without copying them. Header names are case-insensitive.
+        if (nameLen != SIZEOF(KVS_REQUEST_ID_HEADER_NAME) - 1 ||
+            STRNCMPI(pBuffer, KVS_REQUEST_ID_HEADER_NAME, (UINT32) nameLen) != 0) {
+            return dataSize;
+        }
+
         // The value should be after the delimiter
         pDelimiter++;
 
@@ -533,15 +940,11 @@ SIZE_T writeHeaderCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cu
 
         // Only process if we have less than max
         if (nameLen < MAX_REQUEST_HEADER_NAME_LEN && valueLen < MAX_REQUEST_HEADER_VALUE_LEN) {
-            createRequestHeader(pBuffer, (UINT32) nameLen, pValueStart, (UINT32) valueLen, &pRequestHeader);
+            curlResponseStoreHeader(pCurlResponse, pBuffer, (UINT32) nameLen, pValueStart, (UINT32) valueLen, &pRequestHeader);
 
             if (pRequestHeader != NULL) {
-                stackQueueEnqueue(pCurlResponse->callInfo.pResponseHeaders, (UINT64) pRequestHeader);
-
-                if (STRNCMP(KVS_REQUEST_ID_HEADER_NAME, pRequestHeader->pName, nameLen) == 0) {
-                    pCurlResponse->callInfo.pRequestId = pRequestHeader;
-                    DLOGI("RequestId: %.*s", pCurlResponse->callInfo.pRequestId->valueLen, pCurlResponse->callInfo.pRequestId->pValue);
-                }
+                pCurlResponse->callInfo.pRequestId = pRequestHeader;
+                DLOGI("RequestId: %.*s", pCurlResponse->callInfo.pRequestId->valueLen, pCurlResponse->callInfo.pRequestId->pValue);
             }
         }
     }
@@ -552,7 +955,6 @@ SIZE_T writeHeaderCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cu
 SIZE_T postResponseWriteCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID customData)
 {
     DLOGV("postResponseWriteCallback (curl callback) invoked");
-    PCHAR pNewBuffer;
     PCurlRequest pCurlRequest = (PCurlRequest) customData;
     PCurlResponse pCurlResponse;
 
@@ -565,24 +967,8 @@ SIZE_T postResponseWriteCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PV
 
     pCurlResponse = pCurlRequest->pCurlResponse;
 
-    // Alloc and copy if needed
-    pNewBuffer = (PCHAR) MEMALLOC(pCurlResponse->callInfo.responseDataLen + dataSize + SIZEOF(CHAR));
-    if (pNewBuffer != NULL) {
-        // Copy forward the old
-        MEMCPY(pNewBuffer, pCurlResponse->callInfo.responseData, pCurlResponse->callInfo.responseDataLen);
-
-        // Append the new data
-        MEMCPY((PBYTE)pNewBuffer + pCurlResponse->callInfo.responseDataLen, pBuffer, dataSize);
-
-        // Free the old if exists
-        if (pCurlResponse->callInfo.responseData != NULL) {
-            MEMFREE(pCurlResponse->callInfo.responseData);
-        }
-
-        pCurlResponse->callInfo.responseData = pNewBuffer;
-        pCurlResponse->callInfo.responseDataLen += (UINT32) dataSize;
-        pCurlResponse->callInfo.responseData[pCurlResponse->callInfo.responseDataLen] = '\0';
-    } else {
+    // Append the new data growing the buffer geometrically if needed
+    if (STATUS_FAILED(appendCallInfoResponseData(&pCurlResponse->callInfo, (PBYTE) pBuffer, (UINT32) dataSize))) {
         return CURL_READFUNC_ABORT;
     }
 
@@ -606,7 +992,7 @@ SIZE_T postWriteCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cust
     pCurlResponse = pCurlRequest->pCurlResponse;
     pCurlApiCallbacks = pCurlRequest->pCurlApiCallbacks;
 
-    DLOGD("Curl post body write function for stream with handle: %s and upload handle: %" PRIu64 " returned: %.*s",
+    DLOGV("Curl post body write function for stream with handle: %s and upload handle: %" PRIu64 " returned: %.*s",
           pCurlRequest->streamName, pCurlResponse->pCurlRequest->uploadHandle, dataSize, pBuffer);
 
     bufferSize = dataSize;
@@ -618,10 +1004,8 @@ SIZE_T postWriteCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID cust
                                                               (PUINT32) &bufferSize));
     }
 
-    CHK_STATUS(kinesisVideoStreamParseFragmentAck(pCurlResponse->pCurlRequest->streamHandle,
-                                                  pCurlResponse->pCurlRequest->uploadHandle,
-                                                  pBuffer,
-                                                  (UINT32) bufferSize));
+    // The ACKs can be split across the writes and several can arrive in one
+    CHK_STATUS(fragmentAckTokenizerProcess(&pCurlResponse->ackTokenizer, pBuffer, (UINT32) bufferSize));
 
 CleanUp:
 
@@ -635,6 +1019,20 @@ CleanUp:
     return dataSize;
 }
 
+STATUS curlResponseAckReceived(UINT64 customData, PFragmentAck pFragmentAck)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCurlRequest pCurlRequest = (PCurlRequest) customData;
+
+    CHK(pCurlRequest != NULL && pFragmentAck != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(kinesisVideoStreamFragmentAck(pCurlRequest->streamHandle, pCurlRequest->uploadHandle, pFragmentAck));
+
+CleanUp:
+
+    return retStatus;
+}
+
 SIZE_T postReadCallback(PCHAR pBuffer, SIZE_T size, SIZE_T numItems, PVOID customData)
 {
     DLOGV("postBodyStreamingReadFunc (curl callback) invoked");
@@ -735,13 +1133,19 @@ CleanUp:
     if (bytesWritten != CURL_READFUNC_ABORT && bytesWritten != CURL_READFUNC_PAUSE) {
         DLOGD("Wrote %u bytes to Kinesis Video. Upload stream handle: %" PRIu64, bytesWritten, uploadHandle);
 
-        if (bytesWritten != 0 && pCurlResponse->debugDumpFile) {
-            retStatus = writeFile(pCurlResponse->debugDumpFilePath, TRUE, TRUE, (PBYTE) pBuffer, bytesWritten);
-            if (STATUS_FAILED(retStatus)) {
-                DLOGW("Failed to write to debug dump file with error: 0x%08x", retStatus);
-            }
+        if (bytesWritten != 0 && pCurlRequest->pStreamMetricsTracker != NULL) {
+            curlStreamMetricsChunkSent(pCurlRequest->pStreamMetricsTracker, (UINT64) bytesWritten);
+        }
+
+        // Dropped data is counted by the writer and reported when the dump is removed
+        if (bytesWritten != 0 && pCurlResponse->pDebugDumpFile != NULL) {
+            debugDumpWriterWrite(pCurlRequest->pCurlApiCallbacks->pDebugDumpWriter, pCurlResponse->pDebugDumpFile, (PBYTE) pBuffer, bytesWritten);
         }
     } else if (bytesWritten == CURL_READFUNC_PAUSE) {
+        if (!pCurlResponse->paused && pCurlRequest->pStreamMetricsTracker != NULL) {
+            curlStreamMetricsSetPaused(pCurlRequest->pStreamMetricsTracker, TRUE);
+        }
+
         pCurlResponse->paused = TRUE;
     }
 
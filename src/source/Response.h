@@ -19,12 +19,29 @@ extern "C" {
 // Pause/unpause interval for curl
 #define CURL_PAUSE_UNPAUSE_INTERVAL                             (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
 
+// Max time the streaming session waits for an event before re-checking its state
+#define CURL_SESSION_MAX_POLL_INTERVAL                          (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
 // CA file extension
 #define CA_CERT_FILE_SUFFIX                                     ".pem"
 
 // Debug dump data file environment variable
 #define KVS_DEBUG_DUMP_DATA_FILE_DIR_ENV_VAR                    "KVS_DEBUG_DUMP_DATA_FILE_DIR"
 
+// Size of the per response arena the consumed response headers are copied into
+#define CURL_RESPONSE_HEADER_ARENA_SIZE                         512
+
+// Max number of the consumed response headers kept per response
+#define CURL_RESPONSE_MAX_HEADER_COUNT                          4
+
+// Prefix of the status line starting a new block of response headers
+#define CURL_RESPONSE_STATUS_LINE_PREFIX                        "HTTP/"
+
+/**
+ * Forward declarations
+ */
+struct __CurlHandlePool;
+
 /**
  * CURL callback function definitions
  */
@@ -41,12 +58,26 @@ struct __CurlResponse {
     // Curl object to use for the calls
     CURL* pCurl;
 
+    // Multi handle driving a streaming session which runs on its own thread.
+    // Allows other threads to wake up the session without touching the curl object.
+    CURLM* pCurlMulti;
+
     // Request Curl headers list
     struct curl_slist* pRequestHeaders;
 
-    // Curl call data
+    // Pre-resolved addresses of the endpoint. NULL if the session resolves the host on its own
+    struct curl_slist* pResolveList;
+
+    // Curl call data. The request id points into the response headers below
     CallInfo callInfo;
 
+    // Response headers consumed by the producer. Only these are kept - the rest are skipped without copying.
+    // Names and values are carved out of the arena which is reset when a new block of headers starts.
+    RequestHeader responseHeaders[CURL_RESPONSE_MAX_HEADER_COUNT];
+    UINT32 responseHeaderCount;
+    CHAR responseHeaderArena[CURL_RESPONSE_HEADER_ARENA_SIZE];
+    UINT32 responseHeaderArenaOffset;
+
     // Whether the call was force-terminated
     volatile BOOL terminated;
 
@@ -59,11 +90,20 @@ struct __CurlResponse {
     // Whether curl is paused
     volatile BOOL paused;
 
-    // Whether to dump streaming session into mkv file
-    BOOL debugDumpFile;
+    // Whether the thread owning the curl object should un-pause curl
+    volatile ATOMIC_BOOL unpauseRequested;
+
+    // Whether the thread owning the curl object should force terminate the session after the termination time
+    volatile ATOMIC_BOOL terminationRequested;
+
+    // Time after which the owning thread force terminates the session
+    UINT64 terminationTime;
+
+    // Dump of the streaming session written out by the debug dump writer. NULL if not dumping
+    PDebugDumpFile pDebugDumpFile;
 
-    // Path of debug dump file
-    CHAR debugDumpFilePath[MAX_PATH_LEN + 1];
+    // Tokenizer of the ACK stream carrying the partial ACK over between the writes
+    FragmentAckTokenizer ackTokenizer;
 
     // Lock for exclusive access
     MUTEX lock;
@@ -131,6 +171,48 @@ VOID terminateCurlSession(PCurlResponse, UINT64);
  */
 STATUS curlCompleteSync(PCurlResponse);
 
+/**
+ * Prepares the curl session to be executed by setting the request headers.
+ * Invokes the curl easy perform test hook if specified.
+ *
+ * @param - PCurlResponse - IN - Response object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlPrepareRequest(PCurlResponse);
+
+/**
+ * Translates the result of a completed curl transfer into the call info of the response
+ *
+ * @param - PCurlResponse - IN - Response object
+ * @param - CURLcode - IN - Result of the curl transfer
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlProcessRequestResult(PCurlResponse, CURLcode);
+
+/**
+ * Performs the streaming curl session on the calling thread using the multi handle of the response
+ * so the session can be woken up by other threads to process the un-pause requests.
+ *
+ * NOTE: This is a blocking API
+ *
+ * @param - PCurlResponse - IN - Response object
+ * @param - CURLcode* - OUT - Result of the curl transfer
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlPerformWithWakeup(PCurlResponse, CURLcode*);
+
+/**
+ * Wakes up the thread owning the curl object to process the posted requests
+ *
+ * @param - PCurlResponse - IN - Response object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlResponseWakeup(PCurlResponse);
+
 /**
  * Notifies when data is available to read
  *
@@ -156,7 +238,10 @@ SERVICE_CALL_RESULT getServiceCallResultFromCurlStatus(CURLcode);
  *
  * @param - PRequestInfo - IN - Request info object
  * @param - PCurlCallInfo - IN - Curl call info object to initialize values for
+ * @param - PCurlHandlePool - IN/OPT - Pool to acquire the curl object from
  * @param - Curl** - OUT - Curl object pointer to be set
+ * @param - CURLM** - OUT/OPT - Multi handle to drive the curl object through. Acquired from the pool together
+ *      with the curl object or newly created. Not created if not specified.
  * @param - PVOID - IN - Data object to pass to Curl
  * @param - CurlCallbackFunc - IN - Curl write header callback
  * @param - CurlCallbackFunc - IN - Curl read callback
@@ -165,7 +250,50 @@ SERVICE_CALL_RESULT getServiceCallResultFromCurlStatus(CURLcode);
  *
  * @return - STATUS code of the execution
  */
-STATUS initializeCurlSession(PRequestInfo, PCallInfo, CURL**, PVOID, CurlCallbackFunc, CurlCallbackFunc, CurlCallbackFunc, CurlCallbackFunc);
+STATUS initializeCurlSession(PRequestInfo, PCallInfo, struct __CurlHandlePool*, CURL**, CURLM**, PVOID, CurlCallbackFunc, CurlCallbackFunc, CurlCallbackFunc, CurlCallbackFunc);
+
+/**
+ * Applies the transport options of the putMedia session to the curl object
+ *
+ * @param - CURL* - IN - Curl object of the session
+ * @param - PCurlRequest - IN - Streaming request with the resolved upload options
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS setCurlUploadOptions(CURL*, struct __CurlRequest*);
+
+/**
+ * Opts the session into HTTP/2 multiplexing
+ *
+ * @param - CURL* - IN - Curl object of the session
+ * @param - CURLM* - IN/OPT - Multi handle driving the session if it has its own
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS setCurlHttp2Options(CURL*, CURLM*);
+
+/**
+ * Copies a response header into the arena of the response
+ *
+ * @param - PCurlResponse - IN - Response object
+ * @param - PCHAR - IN - Header name
+ * @param - UINT32 - IN - Header name length
+ * @param - PCHAR - IN - Header value
+ * @param - UINT32 - IN - Header value length
+ * @param - PRequestHeader* - OUT - Stored header pointing into the arena
+ *
+ * @return - STATUS code of the execution. STATUS_NOT_ENOUGH_MEMORY if the arena is exhausted
+ */
+STATUS curlResponseStoreHeader(PCurlResponse, PCHAR, UINT32, PCHAR, UINT32, PRequestHeader*);
+
+/**
+ * Drops the stored response headers and rewinds the arena
+ *
+ * @param - PCurlResponse - IN - Response object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS curlResponseResetHeaders(PCurlResponse);
 
 ////////////////////////////////////////////////////
 // Curl callbacks
@@ -174,6 +302,9 @@ SIZE_T writeHeaderCallback(PCHAR, SIZE_T, SIZE_T, PVOID);
 SIZE_T postWriteCallback(PCHAR, SIZE_T, SIZE_T, PVOID);
 SIZE_T postReadCallback(PCHAR, SIZE_T, SIZE_T, PVOID);
 SIZE_T postResponseWriteCallback(PCHAR, SIZE_T, SIZE_T, PVOID);
+STATUS curlResponseAckReceived(UINT64, PFragmentAck);
+INT32 uploadSocketOptionCallback(PVOID, curl_socket_t, curlsocktype);
+INT32 terminationProgressCallback(PVOID, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
 
 #ifdef  __cplusplus
 }
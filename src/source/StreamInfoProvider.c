@@ -235,3 +235,21 @@ CleanUp:
     return retStatus;
 }
 
+STATUS setStreamInfoBasedOnMeasuredBitrate(UINT64 measuredBitrate, UINT32 storageSize, UINT64 avgBitrate, UINT32 totalStreamCount,
+                                           PStreamInfo pStreamInfo)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Use the measured bitrate if the stream has been uploading
+    if (measuredBitrate != 0) {
+        DLOGD("Using measured bitrate of %" PRIu64 " bps instead of %" PRIu64 " bps", measuredBitrate, avgBitrate);
+        avgBitrate = measuredBitrate;
+    }
+
+    CHK_STATUS(setStreamInfoBasedOnStorageSize(storageSize, avgBitrate, totalStreamCount, pStreamInfo));
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+    return retStatus;
+}
+
@@ -46,13 +46,66 @@ CleanUp:
     return retStatus;
 }
 
-VOID streamLatencyStateMachineSetThrottlePipelineState(PStreamLatencyStateMachine pStreamLatencyStateMachine)
+STATUS streamLatencyStateMachineToThrottlePipelineState(STREAM_HANDLE streamHandle,
+                                                        PStreamLatencyStateMachine pStreamLatencyStateMachine)
 {
+    STATUS retStatus = STATUS_SUCCESS;
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks;
+    UINT64 targetBitrate;
+
+    CHK(pStreamLatencyStateMachine != NULL, STATUS_NULL_ARG);
+
     DLOGD("Stream Latency State Machine move to THROTTLE_PIPELINE_STATE");
     pStreamLatencyStateMachine->currentState = STREAM_CALLBACK_HANDLING_STATE_THROTTLE_PIPELINE_STATE;
     STREAM_LATENCY_STATE_MACHINE_UPDATE_TIMESTAMP(pStreamLatencyStateMachine);
 
-    // no-op for now. Should send qos event to upstream
+    // Nothing to throttle unless the application is listening
+    pContinuousRetryStreamCallbacks = pStreamLatencyStateMachine->pCallbackStateMachine->pContinuousRetryStreamCallbacks;
+    CHK(pContinuousRetryStreamCallbacks->bitrateRecommendationFn != NULL, retStatus);
+
+    CHK_STATUS(streamLatencyStateMachineGetTargetBitrate(streamHandle, &targetBitrate));
+    DLOGI("Recommending bitrate of %" PRIu64 " bps for stream handle %" PRIu64, targetBitrate, streamHandle);
+    CHK_STATUS(pContinuousRetryStreamCallbacks->bitrateRecommendationFn(pContinuousRetryStreamCallbacks->bitrateRecommendationCustomData,
+                                                                         streamHandle, targetBitrate));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS streamLatencyStateMachineGetTargetBitrate(STREAM_HANDLE streamHandle, PUINT64 pTargetBitrate)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    StreamMetrics streamMetrics;
+    PStreamInfo pStreamInfo = NULL;
+    UINT64 targetBitrate, maxBitrate, minBitrate;
+
+    CHK(pTargetBitrate != NULL, STATUS_NULL_ARG);
+
+    streamMetrics.version = STREAM_METRICS_CURRENT_VERSION;
+    CHK_STATUS(kinesisVideoStreamGetMetrics(streamHandle, &streamMetrics));
+    CHK_STATUS(kinesisVideoStreamGetStreamInfo(streamHandle, &pStreamInfo));
+
+    // The encoder should not produce more than the connection is able to drain
+    targetBitrate = streamMetrics.currentTransferRate * 8 * STREAM_LATENCY_BITRATE_UPLOAD_RATE_PERCENT / 100;
+
+    // Lower it further in proportion to the buffered duration exceeding the latency target so the backlog drains
+    if (pStreamInfo->streamCaps.maxLatency != 0 && streamMetrics.currentViewDuration > pStreamInfo->streamCaps.maxLatency) {
+        targetBitrate = targetBitrate * pStreamInfo->streamCaps.maxLatency / streamMetrics.currentViewDuration;
+    }
+
+    // Keep within the configured average bandwidth which is in bytes per second
+    maxBitrate = (UINT64) pStreamInfo->streamCaps.avgBandwidthBps * 8;
+    if (maxBitrate != 0) {
+        minBitrate = maxBitrate * STREAM_LATENCY_MIN_BITRATE_PERCENT / 100;
+        targetBitrate = MAX(minBitrate, MIN(maxBitrate, targetBitrate));
+    }
+
+    *pTargetBitrate = targetBitrate;
+
+CleanUp:
+
+    return retStatus;
 }
 
 VOID streamLatencyStateMachineSetInfiniteRetryState(PStreamLatencyStateMachine pStreamLatencyStateMachine)
@@ -101,7 +154,7 @@ STATUS streamLatencyStateMachineHandleStreamLatency(STREAM_HANDLE streamHandle,
                 break;
             case STREAM_CALLBACK_HANDLING_STATE_RESET_CONNECTION_STATE:
                 DLOGD("Stream Latency State Machine starting from RESET_CONNECTION_STATE");
-                streamLatencyStateMachineSetThrottlePipelineState(pStreamLatencyStateMachine);
+                CHK_STATUS(streamLatencyStateMachineToThrottlePipelineState(streamHandle, pStreamLatencyStateMachine));
                 break;
             case STREAM_CALLBACK_HANDLING_STATE_THROTTLE_PIPELINE_STATE:
                 DLOGD("Stream Latency State Machine starting from THROTTLE_PIPELINE_STATE");
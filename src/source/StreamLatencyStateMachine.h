@@ -10,6 +10,12 @@ extern "C" {
 #define GRACE_PERIOD_STREAM_LATENCY_STATE_MACHINE                   (30 * HUNDREDS_OF_NANOS_IN_A_SECOND)
 #define VERIFICATION_PERIOD_STREAM_LATENCY_STATE_MACHINE            (60 * HUNDREDS_OF_NANOS_IN_A_SECOND)
 
+// Share of the measured upload rate recommended to the encoder, leaving room for the protocol overhead
+#define STREAM_LATENCY_BITRATE_UPLOAD_RATE_PERCENT                  80
+
+// Lowest recommended bitrate as a share of the configured average bandwidth of the stream
+#define STREAM_LATENCY_MIN_BITRATE_PERCENT                          10
+
 #define STREAM_LATENCY_STATE_MACHINE_UPDATE_TIMESTAMP(stateMachine) {\
     (stateMachine)->quietTime = (stateMachine)->currTime + GRACE_PERIOD_STREAM_LATENCY_STATE_MACHINE;\
     (stateMachine)->backToNormalTime = (stateMachine)->quietTime + VERIFICATION_PERIOD_STREAM_LATENCY_STATE_MACHINE;\
@@ -39,7 +45,8 @@ STATUS setStreamLatencyStateMachine(struct __CallbackStateMachine*, STREAM_CALLB
 
 STATUS streamLatencyStateMachineHandleStreamLatency(STREAM_HANDLE, PStreamLatencyStateMachine);
 STATUS streamLatencyStateMachineToResetConnectionState(STREAM_HANDLE, PStreamLatencyStateMachine);
-VOID streamLatencyStateMachineSetThrottlePipelineState(PStreamLatencyStateMachine);
+STATUS streamLatencyStateMachineToThrottlePipelineState(STREAM_HANDLE, PStreamLatencyStateMachine);
+STATUS streamLatencyStateMachineGetTargetBitrate(STREAM_HANDLE, PUINT64);
 VOID streamLatencyStateMachineSetInfiniteRetryState(PStreamLatencyStateMachine);
 STATUS streamLatencyStateMachineDoInfiniteRetry(STREAM_HANDLE, PStreamLatencyStateMachine);
 
@@ -5,6 +5,46 @@ namespace com { namespace amazonaws { namespace kinesis { namespace video {
 class AuthCallbackTest : public ProducerClientTestBase {
 };
 
+static volatile SIZE_T gRefreshTestTime;
+
+UINT64 getRefreshTestTime(UINT64 customData)
+{
+    UNUSED_PARAM(customData);
+    return (UINT64) ATOMIC_LOAD(&gRefreshTestTime);
+}
+
+VOID writeRefreshTestCredentials(PCHAR filePath, PCHAR accessKeyId)
+{
+    FILE* fp = FOPEN(filePath, "w");
+    ASSERT_TRUE(fp != NULL);
+    fprintf(fp, "CREDENTIALS %s %s", accessKeyId, TEST_SECRET_KEY);
+    FCLOSE(fp);
+}
+
+UINT64 advanceRefreshTestTime(PFileCredentialProvider pFileCredentialProvider, UINT64 time, UINT64 expiration)
+{
+    PCredentialRefresher pCredentialRefresher = pFileCredentialProvider->pCredentialRefresher;
+    UINT64 currentExpiration = expiration;
+    UINT32 i;
+
+    ATOMIC_STORE(&gRefreshTestTime, (SIZE_T) time);
+
+    // The refresher waits on the real clock so wake it up to re-evaluate the injected time
+    MUTEX_LOCK(pCredentialRefresher->lock);
+    CVAR_SIGNAL(pCredentialRefresher->cvar);
+    MUTEX_UNLOCK(pCredentialRefresher->lock);
+
+    // The renewed credentials expire relative to the injected time
+    for (i = 0; i < 100 && currentExpiration == expiration; i++) {
+        THREAD_SLEEP(20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        MUTEX_LOCK(pFileCredentialProvider->lock);
+        currentExpiration = pFileCredentialProvider->pAwsCredentials->expiration;
+        MUTEX_UNLOCK(pFileCredentialProvider->lock);
+    }
+
+    return currentExpiration;
+}
+
 TEST_F(AuthCallbackTest, RotatingStaticAuthCallback_ReturnsExtendedExpiration)
 {
 
@@ -107,6 +147,88 @@ TEST_F(AuthCallbackTest, verify_fileAuthCallback_provider_works)
     EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
 }
 
+TEST_F(AuthCallbackTest, fileCredentialProvider_backgroundRefresh)
+{
+    PAwsCredentialProvider pCredentialProvider = NULL;
+    PAwsCredentials pAwsCredentials = NULL;
+    CHAR credentialsFilePath[] = "BackgroundRefreshTestCredentials";
+    FILE* fp;
+
+    fp = FOPEN(credentialsFilePath, "w");
+    ASSERT_TRUE(fp != NULL);
+    fprintf(fp, "CREDENTIALS %s %s", TEST_ACCESS_KEY, TEST_SECRET_KEY);
+    FCLOSE(fp);
+
+    EXPECT_EQ(STATUS_SUCCESS, createFileCredentialProvider(credentialsFilePath, &pCredentialProvider));
+
+    EXPECT_NE(STATUS_SUCCESS, startFileCredentialProviderBackgroundRefresh(NULL));
+    EXPECT_EQ(STATUS_SUCCESS, startFileCredentialProviderBackgroundRefresh(pCredentialProvider));
+    EXPECT_EQ(STATUS_INVALID_OPERATION, startFileCredentialProviderBackgroundRefresh(pCredentialProvider));
+
+    // The credentials are served from the cache
+    EXPECT_EQ(0, FREMOVE(credentialsFilePath));
+    EXPECT_EQ(STATUS_SUCCESS, pCredentialProvider->getCredentialsFn(pCredentialProvider, &pAwsCredentials));
+    EXPECT_EQ(0, STRNCMP(TEST_ACCESS_KEY, pAwsCredentials->accessKeyId, pAwsCredentials->accessKeyIdLen));
+    EXPECT_EQ(0, STRNCMP(TEST_SECRET_KEY, pAwsCredentials->secretKey, pAwsCredentials->secretKeyLen));
+
+    // Stops the refresh thread
+    EXPECT_EQ(STATUS_SUCCESS, freeFileCredentialProvider(&pCredentialProvider));
+    EXPECT_EQ(STATUS_SUCCESS, freeFileCredentialProvider(&pCredentialProvider));
+}
+
+TEST_F(AuthCallbackTest, credentialRefresher_refreshesBeforeExpirationAndHandsOutCopies)
+{
+    PAwsCredentialProvider pCredentialProvider = NULL;
+    PFileCredentialProvider pFileCredentialProvider;
+    PAwsCredentials pFirstCredentials = NULL, pSecondCredentials = NULL;
+    CHAR credentialsFilePath[] = "CredentialRefresherTestCredentials";
+    CHAR firstAccessKeyId[] = "FIRSTACCESSKEYID";
+    CHAR secondAccessKeyId[] = "SECONDACCESSKEYID";
+    UINT64 refreshAheadPeriod = CREDENTIAL_FILE_READ_GRACE_PERIOD + CREDENTIAL_REFRESH_LEAD_PERIOD;
+    UINT64 refreshTime, firstExpiration, secondExpiration, thirdExpiration;
+
+    ATOMIC_STORE(&gRefreshTestTime, (SIZE_T) (1000 * HUNDREDS_OF_NANOS_IN_A_SECOND));
+
+    writeRefreshTestCredentials(credentialsFilePath, firstAccessKeyId);
+    EXPECT_EQ(STATUS_SUCCESS, createFileCredentialProviderWithTime(credentialsFilePath, getRefreshTestTime, 0, &pCredentialProvider));
+    pFileCredentialProvider = (PFileCredentialProvider) pCredentialProvider;
+    EXPECT_EQ(STATUS_SUCCESS, pCredentialProvider->getCredentialsFn(pCredentialProvider, &pFirstCredentials));
+    EXPECT_EQ(STATUS_SUCCESS, startFileCredentialProviderBackgroundRefresh(pCredentialProvider));
+
+    // The getter hands out a copy of the credentials
+    EXPECT_NE(pFileCredentialProvider->pAwsCredentials, pFirstCredentials);
+    firstExpiration = pFirstCredentials->expiration;
+
+    // Nothing is renewed short of the refresh time
+    writeRefreshTestCredentials(credentialsFilePath, secondAccessKeyId);
+    refreshTime = firstExpiration - refreshAheadPeriod;
+    EXPECT_EQ(firstExpiration, advanceRefreshTestTime(pFileCredentialProvider, refreshTime - HUNDREDS_OF_NANOS_IN_A_SECOND, firstExpiration));
+
+    // Renewed ahead of the point the get credentials call would have read the file itself
+    EXPECT_LT(refreshTime + CREDENTIAL_FILE_READ_GRACE_PERIOD, firstExpiration);
+    secondExpiration = advanceRefreshTestTime(pFileCredentialProvider, refreshTime, firstExpiration);
+    ASSERT_NE(firstExpiration, secondExpiration);
+
+    // Renewed once more before the caller comes back for the credentials
+    writeRefreshTestCredentials(credentialsFilePath, firstAccessKeyId);
+    thirdExpiration = advanceRefreshTestTime(pFileCredentialProvider, secondExpiration - refreshAheadPeriod, secondExpiration);
+    ASSERT_NE(secondExpiration, thirdExpiration);
+
+    // The copy handed out earlier is untouched by any number of the background refreshes
+    EXPECT_EQ(firstExpiration, pFirstCredentials->expiration);
+    EXPECT_EQ(0, STRNCMP(firstAccessKeyId, pFirstCredentials->accessKeyId, pFirstCredentials->accessKeyIdLen));
+
+    // The next get credentials call picks up the background renewal rather than reading the file itself
+    writeRefreshTestCredentials(credentialsFilePath, secondAccessKeyId);
+    EXPECT_EQ(STATUS_SUCCESS, pCredentialProvider->getCredentialsFn(pCredentialProvider, &pSecondCredentials));
+    EXPECT_EQ(thirdExpiration, pSecondCredentials->expiration);
+    EXPECT_EQ(0, STRNCMP(firstAccessKeyId, pSecondCredentials->accessKeyId, pSecondCredentials->accessKeyIdLen));
+    EXPECT_NE(pFileCredentialProvider->pAwsCredentials, pSecondCredentials);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeFileCredentialProvider(&pCredentialProvider));
+    EXPECT_EQ(0, FREMOVE(credentialsFilePath));
+}
+
 }  // namespace video
 }  // namespace kinesis
 }  // namespace amazonaws
@@ -201,6 +201,176 @@ TEST_F(AwsCredentialsTest, deserializeAwsCredentials)
     pDeserialized->sessionToken = pStored;
 }
 
+TEST_F(AwsCredentialsTest, signAwsRequestInfoWithSigningKeyCache)
+{
+    PAwsCredentials pAwsCredentials = NULL, pRotatedCredentials = NULL;
+    PSigningKeyCache pSigningKeyCache = NULL;
+    PRequestInfo pRequestInfos[4];
+    CHAR authHeaders[4][MAX_AUTH_LEN + 1];
+    PRequestHeader pRequestHeader;
+    UINT64 currentTime = GETTIME();
+    UINT32 i, j;
+
+    EXPECT_EQ(STATUS_SUCCESS, createAwsCredentials(TEST_ACCESS_KEY, 0, TEST_SECRET_KEY, 0, TEST_SESSION_TOKEN, 0,
+                                                   MAX_UINT64, &pAwsCredentials));
+    EXPECT_EQ(STATUS_SUCCESS, createAwsCredentials(TEST_ACCESS_KEY, 0, (PCHAR) "RotatedSecretKey", 0, TEST_SESSION_TOKEN, 0,
+                                                   MAX_UINT64, &pRotatedCredentials));
+
+    EXPECT_NE(STATUS_SUCCESS, createSigningKeyCache(NULL));
+    EXPECT_EQ(STATUS_SUCCESS, createSigningKeyCache(&pSigningKeyCache));
+
+    MEMSET(authHeaders, 0x00, SIZEOF(authHeaders));
+    for (i = 0; i < ARRAY_SIZE(pRequestInfos); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, createRequestInfo((PCHAR) "https://kinesisvideo.us-west-2.amazonaws.com/describeStream",
+                                                    (PCHAR) "{}", TEST_DEFAULT_REGION, NULL, NULL, NULL,
+                                                    SSL_CERTIFICATE_TYPE_NOT_SPECIFIED, TEST_USER_AGENT,
+                                                    0, 0, 0, 0,
+                                                    i == 3 ? pRotatedCredentials : pAwsCredentials,
+                                                    &pRequestInfos[i]));
+        pRequestInfos[i]->currentTime = currentTime;
+    }
+
+    // Uncached, cache miss, cache hit and the rotated secret with the same access key id
+    EXPECT_EQ(STATUS_SUCCESS, signAwsRequestInfo(pRequestInfos[0]));
+    EXPECT_EQ(STATUS_SUCCESS, signAwsRequestInfoWithSigningKeyCache(pRequestInfos[1], pSigningKeyCache));
+    EXPECT_EQ(STATUS_SUCCESS, signAwsRequestInfoWithSigningKeyCache(pRequestInfos[2], pSigningKeyCache));
+    EXPECT_EQ(STATUS_SUCCESS, signAwsRequestInfoWithSigningKeyCache(pRequestInfos[3], pSigningKeyCache));
+
+    for (i = 0; i < ARRAY_SIZE(pRequestInfos); i++) {
+        for (j = 0; j < pRequestInfos[i]->requestHeaderCount; j++) {
+            pRequestHeader = &pRequestInfos[i]->pRequestHeaders[j];
+            if (0 == STRCMP(pRequestHeader->pName, "Authorization")) {
+                STRNCPY(authHeaders[i], pRequestHeader->pValue, MIN(pRequestHeader->valueLen, MAX_AUTH_LEN));
+            }
+        }
+
+        EXPECT_NE(0, STRLEN(authHeaders[i]));
+    }
+
+    EXPECT_EQ(0, STRCMP(authHeaders[0], authHeaders[1]));
+    EXPECT_EQ(0, STRCMP(authHeaders[0], authHeaders[2]));
+    EXPECT_NE(0, STRCMP(authHeaders[0], authHeaders[3]));
+
+    for (i = 0; i < ARRAY_SIZE(pRequestInfos); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, freeRequestInfo(&pRequestInfos[i]));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, freeSigningKeyCache(&pSigningKeyCache));
+    EXPECT_EQ(STATUS_SUCCESS, freeSigningKeyCache(&pSigningKeyCache));
+    EXPECT_EQ(STATUS_SUCCESS, freeAwsCredentials(&pAwsCredentials));
+    EXPECT_EQ(STATUS_SUCCESS, freeAwsCredentials(&pRotatedCredentials));
+}
+
+TEST_F(AwsCredentialsTest, appendCallInfoResponseData)
+{
+    CallInfo callInfo;
+    CHAR chunk[100];
+    UINT32 i, capacity;
+
+    MEMSET(&callInfo, 0x00, SIZEOF(CallInfo));
+    MEMSET(chunk, 'a', SIZEOF(chunk));
+
+    EXPECT_NE(STATUS_SUCCESS, appendCallInfoResponseData(NULL, (PBYTE) chunk, SIZEOF(chunk)));
+    EXPECT_NE(STATUS_SUCCESS, appendCallInfoResponseData(&callInfo, NULL, SIZEOF(chunk)));
+
+    // Empty response is still NULL terminated
+    EXPECT_EQ(STATUS_SUCCESS, appendCallInfoResponseData(&callInfo, NULL, 0));
+    EXPECT_EQ(0, callInfo.responseDataLen);
+    EXPECT_EQ(CALL_INFO_MIN_RESPONSE_BUFFER_SIZE, callInfo.responseDataCapacity);
+    EXPECT_EQ('\0', callInfo.responseData[0]);
+
+    for (i = 0; i < 100; i++) {
+        capacity = callInfo.responseDataCapacity;
+        EXPECT_EQ(STATUS_SUCCESS, appendCallInfoResponseData(&callInfo, (PBYTE) chunk, SIZEOF(chunk)));
+
+        // Capacity only ever doubles
+        EXPECT_TRUE(callInfo.responseDataCapacity == capacity || callInfo.responseDataCapacity == 2 * capacity);
+        EXPECT_LT(callInfo.responseDataLen, callInfo.responseDataCapacity);
+    }
+
+    EXPECT_EQ(100 * SIZEOF(chunk), callInfo.responseDataLen);
+    EXPECT_EQ(100 * SIZEOF(chunk), STRLEN(callInfo.responseData));
+    EXPECT_EQ(16 * CALL_INFO_MIN_RESPONSE_BUFFER_SIZE, callInfo.responseDataCapacity);
+
+    EXPECT_EQ(STATUS_SUCCESS, releaseCallInfo(&callInfo));
+    EXPECT_EQ(NULL, callInfo.responseData);
+    EXPECT_EQ(0, callInfo.responseDataCapacity);
+}
+
+TEST_F(AwsCredentialsTest, setRequestHeader_sortedInlineStorage)
+{
+    PRequestInfo pRequestInfo = NULL;
+    CHAR name[32];
+    CHAR longValue[MAX_REQUEST_HEADER_VALUE_LEN];
+    PSingleList pHeaderList = NULL;
+    PSingleListNode pCurNode;
+    UINT64 item;
+    UINT32 i;
+
+    MEMSET(longValue, 'v', SIZEOF(longValue) - 1);
+    longValue[SIZEOF(longValue) - 1] = '\0';
+
+    EXPECT_EQ(STATUS_SUCCESS, createRequestInfo((PCHAR) "https://kinesisvideo.us-west-2.amazonaws.com/describeStream",
+                                                (PCHAR) "{}", TEST_DEFAULT_REGION, NULL, NULL, NULL,
+                                                SSL_CERTIFICATE_TYPE_NOT_SPECIFIED, TEST_USER_AGENT,
+                                                0, 0, 0, 0, NULL, &pRequestInfo));
+
+    // user-agent is set on creation and stored inline
+    EXPECT_EQ(1, pRequestInfo->requestHeaderCount);
+    EXPECT_EQ(pRequestInfo->inlineRequestHeaders, pRequestInfo->pRequestHeaders);
+
+    EXPECT_NE(STATUS_SUCCESS, setRequestHeader(NULL, (PCHAR) "a", 0, (PCHAR) "b", 0));
+    EXPECT_NE(STATUS_SUCCESS, setRequestHeader(pRequestInfo, (PCHAR) "", 0, (PCHAR) "b", 0));
+
+    // Kept in a case-insensitive alphabetical order
+    EXPECT_EQ(STATUS_SUCCESS, setRequestHeader(pRequestInfo, (PCHAR) "X-Amz-Date", 0, (PCHAR) "20200101T000000Z", 0));
+    EXPECT_EQ(STATUS_SUCCESS, setRequestHeader(pRequestInfo, (PCHAR) "Authorization", 0, (PCHAR) "AWS4", 0));
+    EXPECT_EQ(STATUS_SUCCESS, setRequestHeader(pRequestInfo, (PCHAR) "host", 0, (PCHAR) "kinesisvideo", 0));
+    EXPECT_EQ(4, pRequestInfo->requestHeaderCount);
+    EXPECT_EQ(0, STRCMP("Authorization", pRequestInfo->pRequestHeaders[0].pName));
+    EXPECT_EQ(0, STRCMP("host", pRequestInfo->pRequestHeaders[1].pName));
+    EXPECT_EQ(0, STRCMP("user-agent", pRequestInfo->pRequestHeaders[2].pName));
+    EXPECT_EQ(0, STRCMP("X-Amz-Date", pRequestInfo->pRequestHeaders[3].pName));
+    EXPECT_EQ(0, STRCMP("AWS4", pRequestInfo->pRequestHeaders[0].pValue));
+
+    // The compatibility list walks the same headers in the same order
+    EXPECT_NE(STATUS_SUCCESS, getRequestHeaderList(NULL, &pHeaderList));
+    EXPECT_NE(STATUS_SUCCESS, getRequestHeaderList(pRequestInfo, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, getRequestHeaderList(pRequestInfo, &pHeaderList));
+    EXPECT_EQ(STATUS_SUCCESS, singleListGetHeadNode(pHeaderList, &pCurNode));
+    for (i = 0; pCurNode != NULL; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, singleListGetNodeData(pCurNode, &item));
+        EXPECT_EQ(&pRequestInfo->pRequestHeaders[i], (PRequestHeader) item);
+        EXPECT_EQ(STATUS_SUCCESS, singleListGetNextNode(pCurNode, &pCurNode));
+    }
+
+    EXPECT_EQ(pRequestInfo->requestHeaderCount, i);
+    EXPECT_EQ(STATUS_SUCCESS, singleListFree(pHeaderList));
+
+    EXPECT_EQ(STATUS_SUCCESS, removeRequestHeader(pRequestInfo, (PCHAR) "HOST"));
+    EXPECT_EQ(3, pRequestInfo->requestHeaderCount);
+    EXPECT_EQ(0, STRCMP("user-agent", pRequestInfo->pRequestHeaders[1].pName));
+
+    // Overflowing the inline storage moves into the allocated storage while keeping the order
+    EXPECT_EQ(STATUS_SUCCESS, setRequestHeader(pRequestInfo, (PCHAR) "x-long", 0, longValue, 0));
+    for (i = 0; i < 2 * REQUEST_INFO_INLINE_HEADER_COUNT; i++) {
+        SNPRINTF(name, SIZEOF(name), "x-header-%02u", i);
+        EXPECT_EQ(STATUS_SUCCESS, setRequestHeader(pRequestInfo, name, 0, (PCHAR) "value", 0));
+    }
+
+    EXPECT_EQ(4 + 2 * REQUEST_INFO_INLINE_HEADER_COUNT, pRequestInfo->requestHeaderCount);
+    EXPECT_NE(pRequestInfo->inlineRequestHeaders, pRequestInfo->pRequestHeaders);
+    for (i = 1; i < pRequestInfo->requestHeaderCount; i++) {
+        EXPECT_LE(STRCMPI(pRequestInfo->pRequestHeaders[i - 1].pName, pRequestInfo->pRequestHeaders[i].pName), 0);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, removeRequestHeaders(pRequestInfo));
+    EXPECT_EQ(0, pRequestInfo->requestHeaderCount);
+    EXPECT_EQ(NULL, pRequestInfo->pRequestHeaders);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeRequestInfo(&pRequestInfo));
+}
+
 }  // namespace video
 }  // namespace kinesis
 }  // namespace amazonaws
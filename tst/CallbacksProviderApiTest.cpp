@@ -1,10 +1,202 @@
 #include "ProducerTestFixture.h"
+#ifndef _WIN32
+#include "benchmark/MockKinesisVideoService.h"
+#endif
 
 namespace com { namespace amazonaws { namespace kinesis { namespace video {
 
 class CallbacksProviderApiTest : public ProducerClientTestBase {
 };
 
+PVOID removeActiveUploadRoutine(PVOID arg)
+{
+    PCurlApiCallbacks pCurlApiCallbacks = (PCurlApiCallbacks) arg;
+    PCallbacksProvider pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+    PDoubleListNode pNode = NULL;
+
+    THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+    doubleListGetHeadNode(pCurlApiCallbacks->pActiveUploads, &pNode);
+    doubleListDeleteNode(pCurlApiCallbacks->pActiveUploads, pNode);
+    pCallbacksProvider->clientCallbacks.broadcastConditionVariableFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsCvar);
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+
+    return NULL;
+}
+
+#ifndef _WIN32
+#define TEST_MOCK_SERVICE_AWAIT_INTERVAL (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TEST_MOCK_SERVICE_AWAIT_COUNT    500
+
+/**
+ * Producer running against the local mock service
+ */
+typedef struct {
+    PMockKinesisVideoService pService;
+    PClientCallbacks pClientCallbacks;
+    PDeviceInfo pDeviceInfo;
+    PStreamInfo pStreamInfo;
+    CLIENT_HANDLE clientHandle;
+    STREAM_HANDLE streamHandle;
+} MockServiceProducer, *PMockServiceProducer;
+
+/**
+ * Starts the mock service and creates the callbacks provider calling it. The transport can be configured
+ * before the stream is created with createMockServiceStream.
+ */
+STATUS createMockServiceCallbacks(PMockServiceProducer pProducer)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PAuthCallbacks pAuthCallbacks = NULL;
+
+    MEMSET(pProducer, 0x00, SIZEOF(MockServiceProducer));
+    pProducer->clientHandle = INVALID_CLIENT_HANDLE_VALUE;
+    pProducer->streamHandle = INVALID_STREAM_HANDLE_VALUE;
+
+    CHK_STATUS(createMockKinesisVideoService(0, &pProducer->pService));
+    CHK_STATUS(createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT, API_CALL_CACHE_TYPE_NONE,
+                                                      ENDPOINT_UPDATE_PERIOD_SENTINEL_VALUE, TEST_DEFAULT_REGION,
+                                                      pProducer->pService->url, NULL, NULL, NULL, &pProducer->pClientCallbacks));
+    CHK_STATUS(createStaticAuthCallbacks(pProducer->pClientCallbacks, TEST_ACCESS_KEY, TEST_SECRET_KEY, NULL, MAX_UINT64, &pAuthCallbacks));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS createMockServiceStream(PMockServiceProducer pProducer, PCHAR streamName)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK_STATUS(createDefaultDeviceInfo(&pProducer->pDeviceInfo));
+    pProducer->pDeviceInfo->clientInfo.loggerLogLevel = LOG_LEVEL_WARN;
+    CHK_STATUS(setDeviceInfoStorageSize(pProducer->pDeviceInfo, TEST_STORAGE_SIZE_IN_BYTES));
+    CHK_STATUS(createKinesisVideoClientSync(pProducer->pDeviceInfo, pProducer->pClientCallbacks, &pProducer->clientHandle));
+
+    CHK_STATUS(createRealtimeVideoStreamInfoProvider(streamName, TEST_RETENTION_PERIOD, TEST_STREAM_BUFFER_DURATION, &pProducer->pStreamInfo));
+    CHK_STATUS(createKinesisVideoStreamSync(pProducer->clientHandle, pProducer->pStreamInfo, &pProducer->streamHandle));
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID freeMockServiceProducer(PMockServiceProducer pProducer)
+{
+    if (IS_VALID_STREAM_HANDLE(pProducer->streamHandle)) {
+        freeKinesisVideoStream(&pProducer->streamHandle);
+    }
+
+    if (IS_VALID_CLIENT_HANDLE(pProducer->clientHandle)) {
+        freeKinesisVideoClient(&pProducer->clientHandle);
+    }
+
+    freeStreamInfoProvider(&pProducer->pStreamInfo);
+    freeCallbacksProvider(&pProducer->pClientCallbacks);
+    freeDeviceInfo(&pProducer->pDeviceInfo);
+    freeMockKinesisVideoService(&pProducer->pService);
+}
+
+typedef struct {
+    volatile UINT32 count;
+    CHAR url[MAX_URI_CHAR_LEN + 1];
+    PCurlNetworkLoop pNetworkLoop;
+    BOOL withCredentials;
+} RecordedWarmUp, *PRecordedWarmUp;
+
+STATUS recordWarmUpHookFunc(PCurlResponse pCurlResponse)
+{
+    PCurlRequest pCurlRequest = pCurlResponse->pCurlRequest;
+    PRecordedWarmUp pRecordedWarmUp = (PRecordedWarmUp) pCurlRequest->pCurlApiCallbacks->hookCustomData;
+
+    // The control plane calls and putMedia are all POSTs
+    if (pCurlRequest->requestInfo.verb == HTTP_REQUEST_VERB_HEAD) {
+        STRCPY(pRecordedWarmUp->url, pCurlRequest->requestInfo.url);
+        pRecordedWarmUp->pNetworkLoop = pCurlRequest->pNetworkLoop;
+        pRecordedWarmUp->withCredentials = (pCurlRequest->requestInfo.pAwsCredentials != NULL);
+        pRecordedWarmUp->count++;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Puts a key frame starting a fragment which has the client start the putMedia session
+ */
+STATUS putMockServiceFrame(PMockServiceProducer pProducer)
+{
+    Frame frame;
+    BYTE frameData[TEST_FRAME_SIZE];
+
+    // Zeroed frame data can't be mistaken for the MKV elements by the mock service
+    MEMSET(frameData, 0x00, SIZEOF(frameData));
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.trackId = DEFAULT_VIDEO_TRACK_ID;
+    frame.duration = TEST_FRAME_DURATION;
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    frame.decodingTs = GETTIME();
+    frame.presentationTs = frame.decodingTs;
+    frame.size = SIZEOF(frameData);
+    frame.frameData = frameData;
+
+    return putKinesisVideoFrame(pProducer->streamHandle, &frame);
+}
+
+UINT32 getActiveUploadCount(PCurlApiCallbacks pCurlApiCallbacks)
+{
+    PCallbacksProvider pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+    UINT32 count = 0;
+
+    pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+    doubleListGetNodeCount(pCurlApiCallbacks->pActiveUploads, &count);
+    pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+
+    return count;
+}
+
+/**
+ * Awaits for the putMedia session to have sent more than the specified number of bytes and to have paused for more data
+ */
+PCurlRequest awaitPausedUpload(PMockServiceProducer pProducer, PCurlApiCallbacks pCurlApiCallbacks, UINT64 sentBytes)
+{
+    PCallbacksProvider pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+    PDoubleListNode pNode = NULL;
+    PCurlRequest pCurlRequest = NULL;
+    UINT64 putMediaBytes = 0;
+    UINT32 i;
+
+    for (i = 0; i < TEST_MOCK_SERVICE_AWAIT_COUNT && pCurlRequest == NULL; i++) {
+        mockKinesisVideoServiceGetStats(pProducer->pService, &putMediaBytes, NULL);
+
+        pCallbacksProvider->clientCallbacks.lockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+        doubleListGetHeadNode(pCurlApiCallbacks->pActiveUploads, &pNode);
+        if (putMediaBytes > sentBytes && pNode != NULL && ((PCurlRequest) pNode->data)->pCurlResponse->paused) {
+            pCurlRequest = (PCurlRequest) pNode->data;
+        }
+        pCallbacksProvider->clientCallbacks.unlockMutexFn(pCallbacksProvider->clientCallbacks.customData, pCurlApiCallbacks->activeUploadsLock);
+
+        if (pCurlRequest == NULL) {
+            THREAD_SLEEP(TEST_MOCK_SERVICE_AWAIT_INTERVAL);
+        }
+    }
+
+    return pCurlRequest;
+}
+
+BOOL awaitNoActiveUploads(PCurlApiCallbacks pCurlApiCallbacks)
+{
+    UINT32 i;
+
+    for (i = 0; i < TEST_MOCK_SERVICE_AWAIT_COUNT && getActiveUploadCount(pCurlApiCallbacks) != 0; i++) {
+        THREAD_SLEEP(TEST_MOCK_SERVICE_AWAIT_INTERVAL);
+    }
+
+    return getActiveUploadCount(pCurlApiCallbacks) == 0;
+}
+#endif
+
 TEST_F(CallbacksProviderApiTest, createDefaultCallbacksProvider_variations)
 {
     PClientCallbacks pClientCallbacks = NULL;
@@ -257,6 +449,673 @@ TEST_F(CallbacksProviderApiTest, createDefaultCallbacksProvider_variations)
     EXPECT_EQ(NULL, pClientCallbacks);
 }
 
+TEST_F(CallbacksProviderApiTest, setCurlApiCallbacksNetworkLoopCount_variations)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+
+    EXPECT_EQ(STATUS_NULL_ARG, setCurlApiCallbacksNetworkLoopCount(NULL, 1));
+    EXPECT_EQ(STATUS_INVALID_ARG, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, MAX_CURL_NETWORK_LOOP_COUNT + 1));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, 0));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, 2));
+
+    // Can't change the loops once set
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, 1));
+
+    // Frees the loops as well
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(NULL, pClientCallbacks);
+}
+
+TEST_F(CallbacksProviderApiTest, setCurlApiCallbacksHttp2_pinsRequestsToLoopByHost)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequest pControlRequest = (PCurlRequest) MEMCALLOC(1, SIZEOF(CurlRequest));
+    PCurlRequest pPutMediaRequest = (PCurlRequest) MEMCALLOC(1, SIZEOF(CurlRequest));
+    PCurlNetworkLoop pControlLoop = NULL, pPutMediaLoop = NULL;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+
+    EXPECT_EQ(STATUS_NULL_ARG, setCurlApiCallbacksHttp2(NULL, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, 4));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksHttp2(pClientCallbacks, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+    EXPECT_TRUE(pCurlApiCallbacks->http2Enabled);
+
+    // The calls to the same host land on the same loop to share the connection
+    STRCPY(pControlRequest->requestInfo.url, "https://s-1234abcd.kinesisvideo.us-west-2.amazonaws.com/getDataEndpoint");
+    STRCPY(pPutMediaRequest->requestInfo.url, "https://s-1234abcd.kinesisvideo.us-west-2.amazonaws.com:443/putMedia");
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksSelectNetworkLoop(pCurlApiCallbacks, pControlRequest, &pControlLoop));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksSelectNetworkLoop(pCurlApiCallbacks, pPutMediaRequest, &pPutMediaLoop));
+    EXPECT_NE((PCurlNetworkLoop) NULL, pControlLoop);
+    EXPECT_EQ(pControlLoop, pPutMediaLoop);
+
+    // Can't be turned off as the requests in flight are pinned
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksHttp2(pClientCallbacks, FALSE));
+    EXPECT_TRUE(pCurlApiCallbacks->http2Enabled);
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+
+    // Falls back to the least loaded loop without HTTP/2
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, 4));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksHttp2(pClientCallbacks, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+    EXPECT_FALSE(pCurlApiCallbacks->http2Enabled);
+
+    // Can't be turned on either once turned off
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksHttp2(pClientCallbacks, TRUE));
+    EXPECT_FALSE(pCurlApiCallbacks->http2Enabled);
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksSelectNetworkLoop(pCurlApiCallbacks, pPutMediaRequest, &pPutMediaLoop));
+    EXPECT_EQ(pCurlApiCallbacks->networkLoops[0], pPutMediaLoop);
+
+    MEMFREE(pControlRequest);
+    MEMFREE(pPutMediaRequest);
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(NULL, pClientCallbacks);
+}
+
+#ifndef _WIN32
+TEST_F(CallbacksProviderApiTest, setCurlApiCallbacksConnectionWarmUp_warmsUpOnPutMediaLoop)
+{
+    MockServiceProducer producer;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    RecordedWarmUp recordedWarmUp;
+    PCurlRequest pPutMediaRequest = (PCurlRequest) MEMCALLOC(1, SIZEOF(CurlRequest));
+    PCurlNetworkLoop pPutMediaLoop = NULL;
+    UINT32 i;
+
+    MEMSET(&recordedWarmUp, 0x00, SIZEOF(RecordedWarmUp));
+    ASSERT_EQ(STATUS_SUCCESS, createMockServiceCallbacks(&producer));
+
+    EXPECT_EQ(STATUS_NULL_ARG, setCurlApiCallbacksConnectionWarmUp(NULL, TRUE));
+
+    // Needs the network loops and HTTP/2 for the putMedia session to share the connection
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksConnectionWarmUp(producer.pClientCallbacks, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(producer.pClientCallbacks, 4));
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksConnectionWarmUp(producer.pClientCallbacks, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksHttp2(producer.pClientCallbacks, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksConnectionWarmUp(producer.pClientCallbacks, TRUE));
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksConnectionWarmUp(producer.pClientCallbacks, TRUE));
+
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(producer.pClientCallbacks, &pCurlApiCallbacks));
+    pCurlApiCallbacks->hookCustomData = (UINT64) &recordedWarmUp;
+    pCurlApiCallbacks->curlEasyPerformHookFn = recordWarmUpHookFunc;
+
+    // The data endpoint is looked up as the stream is created
+    EXPECT_EQ(STATUS_SUCCESS, createMockServiceStream(&producer, (PCHAR) "warm-up-stream"));
+    for (i = 0; i < TEST_MOCK_SERVICE_AWAIT_COUNT && recordedWarmUp.count == 0; i++) {
+        THREAD_SLEEP(TEST_MOCK_SERVICE_AWAIT_INTERVAL);
+    }
+
+    // Single signed warm up to the data endpoint on the loop the putMedia sessions to the endpoint run on
+    EXPECT_EQ(1, recordedWarmUp.count);
+    EXPECT_STREQ(producer.pService->url, recordedWarmUp.url);
+    EXPECT_TRUE(recordedWarmUp.withCredentials);
+    SNPRINTF(pPutMediaRequest->requestInfo.url, MAX_URI_CHAR_LEN, "%s%s", producer.pService->url, PUT_MEDIA_API_POSTFIX);
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksSelectNetworkLoop(pCurlApiCallbacks, pPutMediaRequest, &pPutMediaLoop));
+    EXPECT_EQ(pPutMediaLoop, recordedWarmUp.pNetworkLoop);
+
+    MEMFREE(pPutMediaRequest);
+    freeMockServiceProducer(&producer);
+}
+#endif
+
+#ifndef _WIN32
+TEST_F(CallbacksProviderApiTest, terminateCurlSession_stopsPausedSessionOnItsThread)
+{
+    MockServiceProducer producer;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequest pCurlRequest = NULL;
+
+    ASSERT_EQ(STATUS_SUCCESS, createMockServiceCallbacks(&producer));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(producer.pClientCallbacks, &pCurlApiCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, createMockServiceStream(&producer, (PCHAR) "terminate-paused-stream"));
+
+    // The session runs on its own thread and pauses once the frame is sent
+    EXPECT_EQ(STATUS_SUCCESS, putMockServiceFrame(&producer));
+    pCurlRequest = awaitPausedUpload(&producer, pCurlApiCallbacks, 0);
+    ASSERT_NE((PCurlRequest) NULL, pCurlRequest);
+    EXPECT_EQ((PCurlNetworkLoop) NULL, pCurlRequest->pNetworkLoop);
+    EXPECT_TRUE(IS_VALID_TID_VALUE(pCurlRequest->threadId));
+
+    // The streaming session is driven through a multi handle of its own so the termination can wake it up
+    EXPECT_NE((CURLM*) NULL, pCurlRequest->pCurlResponse->pCurlMulti);
+
+    // Only posts the termination. The session thread un-pauses and times the session out once the grace period elapses
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksShutdownActiveUploads(pCurlApiCallbacks, producer.streamHandle, INVALID_UPLOAD_HANDLE_VALUE,
+                                                                    CURL_API_CALLBACKS_SHUTDOWN_TIMEOUT, FALSE, FALSE));
+    EXPECT_TRUE(awaitNoActiveUploads(pCurlApiCallbacks));
+
+    freeMockServiceProducer(&producer);
+}
+#endif
+
+#ifndef _WIN32
+TEST_F(CallbacksProviderApiTest, curlNetworkLoop_drivesPutMediaSession)
+{
+    MockServiceProducer producer;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequest pCurlRequest = NULL;
+    UINT64 putMediaBytes = 0;
+
+    ASSERT_EQ(STATUS_SUCCESS, createMockServiceCallbacks(&producer));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(producer.pClientCallbacks, &pCurlApiCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksNetworkLoopCount(producer.pClientCallbacks, 1));
+
+    // The stream only gets ready once the control plane calls have completed on the loop
+    EXPECT_EQ(STATUS_SUCCESS, createMockServiceStream(&producer, (PCHAR) "network-loop-stream"));
+
+    EXPECT_EQ(STATUS_SUCCESS, putMockServiceFrame(&producer));
+    pCurlRequest = awaitPausedUpload(&producer, pCurlApiCallbacks, 0);
+    ASSERT_NE((PCurlRequest) NULL, pCurlRequest);
+    EXPECT_EQ(pCurlApiCallbacks->networkLoops[0], pCurlRequest->pNetworkLoop);
+
+    // The loop drives the session through its own multi handle and keeps the node of the active request
+    EXPECT_EQ((CURLM*) NULL, pCurlRequest->pCurlResponse->pCurlMulti);
+    EXPECT_NE((PDoubleListNode) NULL, pCurlRequest->pNetworkLoopNode);
+
+    // The loop un-pauses the session for the new data
+    EXPECT_EQ(STATUS_SUCCESS, mockKinesisVideoServiceGetStats(producer.pService, &putMediaBytes, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, putMockServiceFrame(&producer));
+    EXPECT_EQ(pCurlRequest, awaitPausedUpload(&producer, pCurlApiCallbacks, putMediaBytes));
+
+    // The loop terminates the session and completes the request
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksShutdownActiveUploads(pCurlApiCallbacks, producer.streamHandle, INVALID_UPLOAD_HANDLE_VALUE,
+                                                                    CURL_API_CALLBACKS_SHUTDOWN_TIMEOUT, FALSE, FALSE));
+    EXPECT_TRUE(awaitNoActiveUploads(pCurlApiCallbacks));
+
+    freeMockServiceProducer(&producer);
+}
+#endif
+
+TEST_F(CallbacksProviderApiTest, terminationProgressCallback_abortsOnceGracePeriodElapses)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    CurlRequest curlRequest;
+    CurlResponse curlResponse;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    MEMSET(&curlRequest, 0x00, SIZEOF(CurlRequest));
+    MEMSET(&curlResponse, 0x00, SIZEOF(CurlResponse));
+    curlRequest.pCurlApiCallbacks = pCurlApiCallbacks;
+    curlResponse.pCurlRequest = &curlRequest;
+    ATOMIC_STORE_BOOL(&curlResponse.terminationRequested, FALSE);
+
+    // The control plane session performed with curl_easy_perform keeps running until it's terminated
+    EXPECT_EQ(0, terminationProgressCallback(NULL, 0, 0, 0, 0));
+    EXPECT_EQ(0, terminationProgressCallback(&curlResponse, 0, 0, 0, 0));
+
+    // and the grace period elapses
+    curlResponse.terminationTime = MAX_UINT64;
+    ATOMIC_STORE_BOOL(&curlResponse.terminationRequested, TRUE);
+    EXPECT_EQ(0, terminationProgressCallback(&curlResponse, 0, 0, 0, 0));
+    EXPECT_FALSE(curlResponse.terminated);
+
+    curlResponse.terminationTime = 0;
+    EXPECT_NE(0, terminationProgressCallback(&curlResponse, 0, 0, 0, 0));
+    EXPECT_TRUE(curlResponse.terminated);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CallbacksProviderApiTest, curlHandlePool_reusesHandlesPerHost)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    CURL* pCurl = NULL;
+    CURL* pPooledCurl = NULL;
+    CURL* pOtherCurl = NULL;
+    CURLM* pCurlMulti = NULL;
+    CURLM* pPooledCurlMulti = NULL;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The pool is opt-in and can be set only once
+    EXPECT_EQ((PCurlHandlePool) NULL, pCurlApiCallbacks->pCurlHandlePool);
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksHandlePoolSize(pClientCallbacks, DEFAULT_CURL_HANDLE_POOL_MAX_IDLE_COUNT));
+    EXPECT_NE((PCurlHandlePool) NULL, pCurlApiCallbacks->pCurlHandlePool);
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksHandlePoolSize(pClientCallbacks, DEFAULT_CURL_HANDLE_POOL_MAX_IDLE_COUNT));
+
+    EXPECT_NE(STATUS_SUCCESS, curlHandlePoolAcquire(NULL, (PCHAR) "https://host-a.amazonaws.com/describeStream", &pCurl, NULL));
+    EXPECT_NE(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, NULL, &pCurl, NULL));
+
+    // Released handle is re-used for the same host only
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/describeStream", &pCurl, NULL));
+    EXPECT_TRUE(pCurl != NULL);
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/describeStream", pCurl, NULL, TRUE));
+
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", &pOtherCurl, NULL));
+    EXPECT_TRUE(pOtherCurl != pCurl);
+
+    // Handle driven by curl_easy_perform isn't handed out for being driven through a multi handle
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/createStream", &pPooledCurl, &pCurlMulti));
+    EXPECT_TRUE(pPooledCurl != pCurl);
+    EXPECT_EQ((CURLM*) NULL, pCurlMulti);
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/createStream", pPooledCurl, NULL, FALSE));
+
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/createStream", &pPooledCurl, NULL));
+    EXPECT_TRUE(pPooledCurl == pCurl);
+
+    // Non-reusable handles are cleaned up
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", pOtherCurl, NULL, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-a.amazonaws.com/createStream", pPooledCurl, NULL, TRUE));
+
+    // The multi handle is pooled together with the easy handle it has driven
+    pCurlMulti = curl_multi_init();
+    EXPECT_TRUE(pCurlMulti != NULL);
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", &pOtherCurl, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", pOtherCurl, pCurlMulti, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolAcquire(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", &pPooledCurl, &pPooledCurlMulti));
+    EXPECT_TRUE(pPooledCurl == pOtherCurl);
+    EXPECT_TRUE(pPooledCurlMulti == pCurlMulti);
+    EXPECT_EQ(STATUS_SUCCESS, curlHandlePoolRelease(pCurlApiCallbacks->pCurlHandlePool, (PCHAR) "https://host-b.amazonaws.com/putMedia", pPooledCurl, pPooledCurlMulti, TRUE));
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+#ifndef _WIN32
+/**
+ * Performs a HEAD request on a pooled handle driven the same way the sessions drive it and returns the
+ * number of the new connections the request had to open
+ */
+STATUS performPooledHeadRequest(PCurlHandlePool pCurlHandlePool, PCHAR url, BOOL withMulti, PUINT32 pConnectCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CURL* pCurl = NULL;
+    CURLM* pCurlMulti = NULL;
+    CURLMsg* pCurlMsg;
+    CURLcode result = CURLE_OK;
+    INT32 runningCount = 1, msgCount;
+    long connectCount = 0;
+
+    CHK_STATUS(curlHandlePoolAcquire(pCurlHandlePool, url, &pCurl, withMulti ? &pCurlMulti : NULL));
+    if (withMulti && pCurlMulti == NULL) {
+        pCurlMulti = curl_multi_init();
+        CHK(pCurlMulti != NULL, STATUS_CURL_INIT_FAILED);
+    }
+
+    curl_easy_setopt(pCurl, CURLOPT_URL, url);
+    curl_easy_setopt(pCurl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(pCurl, CURLOPT_NOSIGNAL, 1L);
+
+    if (withMulti) {
+        CHK(CURLM_OK == curl_multi_add_handle(pCurlMulti, pCurl), STATUS_INVALID_OPERATION);
+        while (runningCount != 0) {
+            CHK(CURLM_OK == curl_multi_perform(pCurlMulti, &runningCount), STATUS_INVALID_OPERATION);
+            if (runningCount != 0) {
+                CHK(CURLM_OK == curl_multi_poll(pCurlMulti, NULL, 0, 100, NULL), STATUS_INVALID_OPERATION);
+            }
+        }
+
+        while ((pCurlMsg = curl_multi_info_read(pCurlMulti, &msgCount)) != NULL) {
+            if (pCurlMsg->msg == CURLMSG_DONE) {
+                result = pCurlMsg->data.result;
+            }
+        }
+
+        curl_multi_remove_handle(pCurlMulti, pCurl);
+    } else {
+        result = curl_easy_perform(pCurl);
+    }
+
+    CHK(result == CURLE_OK, STATUS_INVALID_OPERATION);
+    curl_easy_getinfo(pCurl, CURLINFO_NUM_CONNECTS, &connectCount);
+    *pConnectCount = (UINT32) connectCount;
+
+CleanUp:
+
+    if (pCurl != NULL) {
+        curlHandlePoolRelease(pCurlHandlePool, url, pCurl, pCurlMulti, STATUS_SUCCEEDED(retStatus));
+    }
+
+    return retStatus;
+}
+
+TEST_F(CallbacksProviderApiTest, curlHandlePool_reusesConnectionsOfReleasedHandles)
+{
+    MockServiceProducer producer;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    UINT32 connectCount;
+
+    EXPECT_EQ(STATUS_SUCCESS, createMockServiceCallbacks(&producer));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(producer.pClientCallbacks, &pCurlApiCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksHandlePoolSize(producer.pClientCallbacks, DEFAULT_CURL_HANDLE_POOL_MAX_IDLE_COUNT));
+
+    // The second request on the released handle goes over the connection opened by the first one
+    EXPECT_EQ(STATUS_SUCCESS, performPooledHeadRequest(pCurlApiCallbacks->pCurlHandlePool, producer.pService->url, FALSE, &connectCount));
+    EXPECT_EQ(1, connectCount);
+    EXPECT_EQ(STATUS_SUCCESS, performPooledHeadRequest(pCurlApiCallbacks->pCurlHandlePool, producer.pService->url, FALSE, &connectCount));
+    EXPECT_EQ(0, connectCount);
+
+    // Same for the handle driven through a multi handle of its own as the multi handle is pooled with it
+    EXPECT_EQ(STATUS_SUCCESS, performPooledHeadRequest(pCurlApiCallbacks->pCurlHandlePool, producer.pService->url, TRUE, &connectCount));
+    EXPECT_EQ(1, connectCount);
+    EXPECT_EQ(STATUS_SUCCESS, performPooledHeadRequest(pCurlApiCallbacks->pCurlHandlePool, producer.pService->url, TRUE, &connectCount));
+    EXPECT_EQ(0, connectCount);
+
+    freeMockServiceProducer(&producer);
+}
+#endif
+
+TEST_F(CallbacksProviderApiTest, curlResolverCache_injectsResolvedAddresses)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    struct curl_slist* pResolveList = NULL;
+    CHAR host[MAX_URI_CHAR_LEN + 1];
+    UINT32 port, i;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // The cache is opt-in and can be set only once
+    EXPECT_EQ((PCurlResolverCache) NULL, pCurlApiCallbacks->pCurlResolverCache);
+    EXPECT_EQ(STATUS_SUCCESS, setCurlApiCallbacksResolverCache(pClientCallbacks, TRUE));
+    EXPECT_NE((PCurlResolverCache) NULL, pCurlApiCallbacks->pCurlResolverCache);
+    EXPECT_EQ(STATUS_INVALID_OPERATION, setCurlApiCallbacksResolverCache(pClientCallbacks, FALSE));
+
+    EXPECT_EQ(STATUS_SUCCESS, curlResolverCacheParseUrl((PCHAR) "https://s-1234abcd.kinesisvideo.us-west-2.amazonaws.com/putMedia", host, SIZEOF(host), &port));
+    EXPECT_STREQ("s-1234abcd.kinesisvideo.us-west-2.amazonaws.com", host);
+    EXPECT_EQ(443, port);
+    EXPECT_EQ(STATUS_SUCCESS, curlResolverCacheParseUrl((PCHAR) "http://127.0.0.1:8080/putMedia", host, SIZEOF(host), &port));
+    EXPECT_STREQ("127.0.0.1", host);
+    EXPECT_EQ(8080, port);
+
+    // The first session to the host resolves on its own while the host gets resolved in the background.
+    // Any stale injected addresses are removed from the DNS cache of the session
+    EXPECT_EQ(STATUS_SUCCESS, curlResolverCacheGetResolveList(pCurlApiCallbacks->pCurlResolverCache, (PCHAR) "http://127.0.0.1:8080/describeStream", &pResolveList));
+    ASSERT_TRUE(pResolveList != NULL);
+    EXPECT_STREQ("-127.0.0.1:8080", pResolveList->data);
+
+    for (i = 0; i < 500 && pResolveList->data[0] == '-'; i++) {
+        curl_slist_free_all(pResolveList);
+        pResolveList = NULL;
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS, curlResolverCacheGetResolveList(pCurlApiCallbacks->pCurlResolverCache, (PCHAR) "http://127.0.0.1:8080/putMedia", &pResolveList));
+        ASSERT_TRUE(pResolveList != NULL);
+    }
+
+    EXPECT_STREQ("127.0.0.1:8080:127.0.0.1", pResolveList->data);
+    curl_slist_free_all(pResolveList);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CallbacksProviderApiTest, persistedEndpointCache_reloadsEntriesFromFile)
+{
+    PPersistedEndpointCache pPersistedEndpointCache = NULL;
+    PersistedEndpoint persistedEndpoint;
+    CHAR filePath[MAX_PATH_LEN + 1], tempFilePath[MAX_PATH_LEN + 1];
+    PCHAR corruptFile = (PCHAR) "# KVS API call cache v1\nus-west-2 broken\n";
+    BOOL fileFound;
+
+    SNPRINTF(filePath, SIZEOF(filePath), "/tmp/kvs_api_call_cache_%" PRIu64, GETTIME());
+    SNPRINTF(tempFilePath, SIZEOF(tempFilePath), "%s%s", filePath, PERSISTED_ENDPOINT_CACHE_TEMP_FILE_SUFFIX);
+
+    // Missing file is a cold start
+    EXPECT_EQ(STATUS_SUCCESS, createPersistedEndpointCache(filePath, &pPersistedEndpointCache));
+    EXPECT_EQ(STATUS_HASH_KEY_NOT_PRESENT, persistedEndpointCacheGet(pPersistedEndpointCache, TEST_DEFAULT_REGION, TEST_STREAM_NAME, &persistedEndpoint));
+
+    MEMSET(&persistedEndpoint, 0x00, SIZEOF(PersistedEndpoint));
+    STRCPY(persistedEndpoint.region, TEST_DEFAULT_REGION);
+    STRCPY(persistedEndpoint.streamName, TEST_STREAM_NAME);
+    STRCPY(persistedEndpoint.streamArn, "arn:aws:kinesisvideo:us-west-2:123456789012:stream/ScaryTestStream_0/1234");
+    STRCPY(persistedEndpoint.streamingEndpoint, "https://s-1234abcd.kinesisvideo.us-west-2.amazonaws.com");
+    persistedEndpoint.updateTime = 12345;
+    EXPECT_EQ(STATUS_SUCCESS, persistedEndpointCachePut(pPersistedEndpointCache, &persistedEndpoint));
+
+    // Unknown ARN round trips as empty
+    STRCPY(persistedEndpoint.streamName, "OtherStream");
+    persistedEndpoint.streamArn[0] = '\0';
+    EXPECT_EQ(STATUS_SUCCESS, persistedEndpointCachePut(pPersistedEndpointCache, &persistedEndpoint));
+
+    // The updates are written out in the background after the write delay
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &fileFound));
+    EXPECT_FALSE(fileFound);
+
+    // Freeing the cache writes out the pending updates
+    EXPECT_EQ(STATUS_SUCCESS, freePersistedEndpointCache(&pPersistedEndpointCache));
+    EXPECT_EQ(NULL, pPersistedEndpointCache);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(filePath, &fileFound));
+    EXPECT_TRUE(fileFound);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists(tempFilePath, &fileFound));
+    EXPECT_FALSE(fileFound);
+
+    EXPECT_EQ(STATUS_SUCCESS, createPersistedEndpointCache(filePath, &pPersistedEndpointCache));
+    EXPECT_EQ(2, pPersistedEndpointCache->entryCount);
+    EXPECT_EQ(STATUS_SUCCESS, persistedEndpointCacheGet(pPersistedEndpointCache, TEST_DEFAULT_REGION, TEST_STREAM_NAME, &persistedEndpoint));
+    EXPECT_STREQ("arn:aws:kinesisvideo:us-west-2:123456789012:stream/ScaryTestStream_0/1234", persistedEndpoint.streamArn);
+    EXPECT_STREQ("https://s-1234abcd.kinesisvideo.us-west-2.amazonaws.com", persistedEndpoint.streamingEndpoint);
+    EXPECT_EQ(12345, persistedEndpoint.updateTime);
+    EXPECT_EQ(STATUS_SUCCESS, persistedEndpointCacheGet(pPersistedEndpointCache, TEST_DEFAULT_REGION, (PCHAR) "OtherStream", &persistedEndpoint));
+    EXPECT_STREQ("", persistedEndpoint.streamArn);
+    EXPECT_EQ(STATUS_HASH_KEY_NOT_PRESENT, persistedEndpointCacheGet(pPersistedEndpointCache, (PCHAR) "eu-west-1", TEST_STREAM_NAME, &persistedEndpoint));
+    EXPECT_EQ(STATUS_SUCCESS, freePersistedEndpointCache(&pPersistedEndpointCache));
+
+    // Malformed lines are skipped
+    EXPECT_EQ(STATUS_SUCCESS, writeFile(filePath, TRUE, FALSE, (PBYTE) corruptFile, STRLEN(corruptFile)));
+    EXPECT_EQ(STATUS_SUCCESS, createPersistedEndpointCache(filePath, &pPersistedEndpointCache));
+    EXPECT_EQ(0, pPersistedEndpointCache->entryCount);
+    EXPECT_EQ(STATUS_SUCCESS, freePersistedEndpointCache(&pPersistedEndpointCache));
+
+    remove(filePath);
+}
+
+TEST_F(CallbacksProviderApiTest, uploadsIndex_findRequestWithUploadHandle)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequest pCurlRequest = NULL;
+    CurlRequest requests[CURL_API_UPLOADS_INDEX_STRIPE_COUNT + 1];
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    MEMSET(requests, 0x00, SIZEOF(requests));
+
+    // Two of the uploads share the same stripe
+    for (i = 0; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT + 1; i++) {
+        requests[i].uploadHandle = i;
+        EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksIndexUpload(pCurlApiCallbacks, &requests[i]));
+    }
+
+    for (i = 0; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT + 1; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, findRequestWithUploadHandle(i, pCurlApiCallbacks, &pCurlRequest));
+        EXPECT_EQ(&requests[i], pCurlRequest);
+    }
+
+    // Unknown and invalid upload handles are not found
+    EXPECT_EQ(STATUS_SUCCESS, findRequestWithUploadHandle(CURL_API_UPLOADS_INDEX_STRIPE_COUNT + 1, pCurlApiCallbacks, &pCurlRequest));
+    EXPECT_EQ((PCurlRequest) NULL, pCurlRequest);
+    EXPECT_EQ(STATUS_SUCCESS, findRequestWithUploadHandle(INVALID_UPLOAD_HANDLE_VALUE, pCurlApiCallbacks, &pCurlRequest));
+    EXPECT_EQ((PCurlRequest) NULL, pCurlRequest);
+
+    // Removing an upload doesn't affect the one in the same stripe
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksUnindexUpload(pCurlApiCallbacks, 0));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksUnindexUpload(pCurlApiCallbacks, 0));
+    EXPECT_EQ(STATUS_SUCCESS, findRequestWithUploadHandle(0, pCurlApiCallbacks, &pCurlRequest));
+    EXPECT_EQ((PCurlRequest) NULL, pCurlRequest);
+    EXPECT_EQ(STATUS_SUCCESS, findRequestWithUploadHandle(CURL_API_UPLOADS_INDEX_STRIPE_COUNT, pCurlApiCallbacks, &pCurlRequest));
+    EXPECT_EQ(&requests[CURL_API_UPLOADS_INDEX_STRIPE_COUNT], pCurlRequest);
+
+    for (i = 1; i < CURL_API_UPLOADS_INDEX_STRIPE_COUNT + 1; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksUnindexUpload(pCurlApiCallbacks, i));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CallbacksProviderApiTest, getCurlStreamMetrics_tracksStreamSessions)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlStreamMetricsTracker pTracker = NULL, pSameTracker = NULL;
+    CurlStreamMetrics metrics;
+    FragmentAck fragmentAck;
+    STREAM_HANDLE streamHandle = (STREAM_HANDLE) 1;
+    UINT32 i, histogramCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    MEMSET(&metrics, 0x00, SIZEOF(CurlStreamMetrics));
+    metrics.version = CURL_STREAM_METRICS_CURRENT_VERSION;
+
+    EXPECT_EQ(STATUS_NULL_ARG, getCurlStreamMetrics(NULL, streamHandle, &metrics));
+    EXPECT_EQ(STATUS_NULL_ARG, getCurlStreamMetrics(pClientCallbacks, streamHandle, NULL));
+
+    // No metrics before the first session
+    EXPECT_EQ(STATUS_HASH_KEY_NOT_PRESENT, getCurlStreamMetrics(pClientCallbacks, streamHandle, &metrics));
+
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamMetricsTracker(pCurlApiCallbacks, streamHandle, TRUE, &pTracker));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamMetricsTracker(pCurlApiCallbacks, streamHandle, TRUE, &pSameTracker));
+    EXPECT_EQ(pTracker, pSameTracker);
+
+    // Two sessions make a reconnect
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSessionStarted(pTracker));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 100));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSetPaused(pTracker, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSetPaused(pTracker, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSetPaused(pTracker, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSessionCompleted(pTracker, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSessionStarted(pTracker));
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 50));
+
+    // The persisted ACK is matched with the buffering ACK of the same fragment
+    MEMSET(&fragmentAck, 0x00, SIZEOF(FragmentAck));
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_BUFFERING;
+    fragmentAck.timestamp = 1000;
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsAckReceived(pTracker, &fragmentAck));
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_RECEIVED;
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsAckReceived(pTracker, &fragmentAck));
+    fragmentAck.ackType = FRAGMENT_ACK_TYPE_PERSISTED;
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsAckReceived(pTracker, &fragmentAck));
+    fragmentAck.timestamp = 2000;
+    EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsAckReceived(pTracker, &fragmentAck));
+
+    EXPECT_EQ(STATUS_SUCCESS, getCurlStreamMetrics(pClientCallbacks, streamHandle, &metrics));
+    EXPECT_EQ(150, metrics.bytesSent);
+    EXPECT_EQ(2, metrics.chunksSent);
+    EXPECT_EQ(1, metrics.pauseCount);
+    EXPECT_EQ(1, metrics.unpauseCount);
+    EXPECT_EQ(2, metrics.uploadSessionCount);
+    EXPECT_EQ(1, metrics.reconnectCount);
+    EXPECT_EQ(2, metrics.persistedAckCount);
+    for (i = 0; i < CURL_STREAM_METRICS_ACK_HISTOGRAM_BUCKET_COUNT; i++) {
+        histogramCount += (UINT32) metrics.ackRoundTripHistogram[i];
+    }
+
+    EXPECT_EQ(1, histogramCount);
+
+    // Metrics are released with the stream
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksFreeStreamMetrics(pCurlApiCallbacks, streamHandle, TRUE));
+    EXPECT_EQ(STATUS_HASH_KEY_NOT_PRESENT, getCurlStreamMetrics(pClientCallbacks, streamHandle, &metrics));
+
+    // Leftover metrics are released with the callbacks provider
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamMetricsTracker(pCurlApiCallbacks, streamHandle, TRUE, &pTracker));
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CallbacksProviderApiTest, setCurlStreamUploadOptions_variations)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    CurlStreamUploadOptions uploadOptions, resolvedOptions;
+    STREAM_HANDLE streamHandle = (STREAM_HANDLE) 1;
+    BOOL present = FALSE;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    MEMSET(&uploadOptions, 0x00, SIZEOF(CurlStreamUploadOptions));
+    uploadOptions.version = CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION;
+    uploadOptions.uploadBufferSize = 256 * 1024;
+    uploadOptions.socketSendBufferSize = 1024 * 1024;
+    uploadOptions.tcpNoDelay = FALSE;
+    uploadOptions.tcpKeepAliveIdleTime = 30 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    uploadOptions.tcpKeepAliveInterval = 5 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+
+    EXPECT_EQ(STATUS_NULL_ARG, setCurlStreamUploadOptions(NULL, streamHandle, &uploadOptions));
+    EXPECT_EQ(STATUS_INVALID_ARG, setCurlStreamUploadOptions(pClientCallbacks, INVALID_STREAM_HANDLE_VALUE, &uploadOptions));
+
+    uploadOptions.version = CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION + 1;
+    EXPECT_EQ(STATUS_INVALID_ARG, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    uploadOptions.version = CURL_STREAM_UPLOAD_OPTIONS_CURRENT_VERSION;
+
+    uploadOptions.uploadBufferSize = CURL_API_MAX_UPLOAD_BUFFER_SIZE + 1;
+    EXPECT_EQ(STATUS_INVALID_ARG, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    uploadOptions.uploadBufferSize = 256 * 1024;
+
+    // The options set by the application are used as is
+    EXPECT_EQ(STATUS_SUCCESS, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamUploadOptions(pCurlApiCallbacks, streamHandle, &resolvedOptions));
+    EXPECT_EQ(uploadOptions.uploadBufferSize, resolvedOptions.uploadBufferSize);
+    EXPECT_EQ(uploadOptions.socketSendBufferSize, resolvedOptions.socketSendBufferSize);
+    EXPECT_EQ(uploadOptions.tcpNoDelay, resolvedOptions.tcpNoDelay);
+    EXPECT_EQ(uploadOptions.tcpKeepAliveIdleTime, resolvedOptions.tcpKeepAliveIdleTime);
+    EXPECT_EQ(uploadOptions.tcpKeepAliveInterval, resolvedOptions.tcpKeepAliveInterval);
+
+    // Setting again overrides
+    uploadOptions.tcpNoDelay = TRUE;
+    EXPECT_EQ(STATUS_SUCCESS, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamUploadOptions(pCurlApiCallbacks, streamHandle, &resolvedOptions));
+    EXPECT_TRUE(resolvedOptions.tcpNoDelay);
+
+    // Reverting to the defaults
+    EXPECT_EQ(STATUS_SUCCESS, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, hashTableContains(pCurlApiCallbacks->pStreamUploadOptions, (UINT64) streamHandle, &present));
+    EXPECT_FALSE(present);
+
+    // The unset socket send buffer is left to the system
+    uploadOptions.socketSendBufferSize = 0;
+    EXPECT_EQ(STATUS_SUCCESS, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksGetStreamUploadOptions(pCurlApiCallbacks, streamHandle, &resolvedOptions));
+    EXPECT_EQ(0, resolvedOptions.socketSendBufferSize);
+
+    // Options left behind are released with the callbacks
+    EXPECT_EQ(STATUS_SUCCESS, setCurlStreamUploadOptions(pClientCallbacks, streamHandle, &uploadOptions));
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CallbacksProviderApiTest, awaitActiveUploads_returnsOnCompletionSignal)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    CurlRequest request;
+    TID threadId;
+    UINT64 startTime;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+
+    // Nothing to await
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksAwaitActiveRequests(pCurlApiCallbacks, INVALID_STREAM_HANDLE_VALUE));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksAwaitActiveUploads(pCurlApiCallbacks, INVALID_STREAM_HANDLE_VALUE));
+
+    MEMSET(&request, 0x00, SIZEOF(CurlRequest));
+    request.streamHandle = (STREAM_HANDLE) 1;
+    EXPECT_EQ(STATUS_SUCCESS, doubleListInsertItemTail(pCurlApiCallbacks->pActiveUploads, (UINT64) &request));
+
+    // Uploads of the other streams are not awaited
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksAwaitActiveUploads(pCurlApiCallbacks, (STREAM_HANDLE) 2));
+
+    // Returns as soon as the upload is removed rather than on the next re-check
+    startTime = GETTIME();
+    EXPECT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadId, removeActiveUploadRoutine, (PVOID) pCurlApiCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, curlApiCallbacksAwaitActiveUploads(pCurlApiCallbacks, request.streamHandle));
+    EXPECT_GT(CURL_API_DEFAULT_SHUTDOWN_POLLING_INTERVAL, GETTIME() - startTime);
+    THREAD_JOIN(threadId, NULL);
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
 TEST_F(CallbacksProviderApiTest, createStreamVerifyCallbackChainInteration)
 {
     PDeviceInfo pDeviceInfo;
@@ -423,6 +1282,56 @@ TEST_F(CallbacksProviderApiTest, createStreamVerifyCallbackChainStopsOnStopStatu
     EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
 }
 
+TEST_F(CallbacksProviderApiTest, writeHeaderCallback_keepsRequestIdOnly)
+{
+    CurlRequest curlRequest;
+    PCurlResponse pCurlResponse = (PCurlResponse) MEMCALLOC(1, SIZEOF(CurlResponse));
+    CHAR statusLine[] = "HTTP/1.1 200 OK\r\n";
+    CHAR dateHeader[] = "Date: Mon, 27 Jul 2020 12:28:53 GMT\r\n";
+    CHAR requestIdHeader[] = "X-Amzn-RequestId:  d5ebe8e7-8d9c-4f1a-a3b0-000000000000 \r\n";
+    CHAR longHeader[CURL_RESPONSE_HEADER_ARENA_SIZE + 32];
+    UINT32 i;
+
+    MEMSET(&curlRequest, 0x00, SIZEOF(CurlRequest));
+    curlRequest.pCurlResponse = pCurlResponse;
+
+    EXPECT_EQ(CURL_READFUNC_ABORT, writeHeaderCallback(dateHeader, 1, STRLEN(dateHeader), NULL));
+
+    EXPECT_EQ(STRLEN(statusLine), writeHeaderCallback(statusLine, 1, STRLEN(statusLine), &curlRequest));
+    EXPECT_EQ(STRLEN(dateHeader), writeHeaderCallback(dateHeader, 1, STRLEN(dateHeader), &curlRequest));
+
+    // Headers which aren't consumed are not stored
+    EXPECT_EQ(0, pCurlResponse->responseHeaderCount);
+    EXPECT_EQ(0, pCurlResponse->responseHeaderArenaOffset);
+    EXPECT_EQ(NULL, pCurlResponse->callInfo.pRequestId);
+
+    // Request id is matched regardless of the case and trimmed
+    EXPECT_EQ(STRLEN(requestIdHeader), writeHeaderCallback(requestIdHeader, 1, STRLEN(requestIdHeader), &curlRequest));
+    EXPECT_EQ(1, pCurlResponse->responseHeaderCount);
+    EXPECT_TRUE(pCurlResponse->callInfo.pRequestId != NULL);
+    EXPECT_EQ(0, STRCMP("d5ebe8e7-8d9c-4f1a-a3b0-000000000000", pCurlResponse->callInfo.pRequestId->pValue));
+    EXPECT_EQ(36, pCurlResponse->callInfo.pRequestId->valueLen);
+
+    // A new block of headers resets the arena
+    EXPECT_EQ(STRLEN(statusLine), writeHeaderCallback(statusLine, 1, STRLEN(statusLine), &curlRequest));
+    EXPECT_EQ(0, pCurlResponse->responseHeaderCount);
+    EXPECT_EQ(0, pCurlResponse->responseHeaderArenaOffset);
+    EXPECT_EQ(NULL, pCurlResponse->callInfo.pRequestId);
+
+    // Exhausting the arena fails the store instead of allocating
+    MEMSET(longHeader, 'a', SIZEOF(longHeader));
+    for (i = 0; i < CURL_RESPONSE_MAX_HEADER_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, curlResponseStoreHeader(pCurlResponse, longHeader, 1, longHeader, 1, &pCurlResponse->callInfo.pRequestId));
+    }
+
+    EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, curlResponseStoreHeader(pCurlResponse, longHeader, 1, longHeader, 1, &pCurlResponse->callInfo.pRequestId));
+    EXPECT_EQ(STATUS_SUCCESS, curlResponseResetHeaders(pCurlResponse));
+    EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, curlResponseStoreHeader(pCurlResponse, longHeader, 16, longHeader, CURL_RESPONSE_HEADER_ARENA_SIZE,
+                                                                &pCurlResponse->callInfo.pRequestId));
+
+    MEMFREE(pCurlResponse);
+}
+
 }  // namespace video
 }  // namespace kinesis
 }  // namespace amazonaws
@@ -0,0 +1,149 @@
+#include "ProducerTestFixture.h"
+
+namespace com { namespace amazonaws { namespace kinesis { namespace video {
+
+class CurlRequestSchedulerTest : public ProducerClientTestBase {
+};
+
+// Completions are counted on the scheduler thread
+static volatile SIZE_T gTerminatedRequestCount = 0;
+static volatile SIZE_T gFailedRequestCount = 0;
+
+static STATUS countTerminatedRequestFunc(PCurlRequest pCurlRequest, STATUS status)
+{
+    if (ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating) && status == STATUS_SUCCESS) {
+        ATOMIC_INCREMENT(&gTerminatedRequestCount);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static STATUS countFailedRequestFunc(PCurlRequest pCurlRequest, STATUS status)
+{
+    if (ATOMIC_LOAD_BOOL(&pCurlRequest->requestInfo.terminating) && status == STATUS_INVALID_OPERATION) {
+        ATOMIC_INCREMENT(&gFailedRequestCount);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static STATUS failWaitConditionVariableFunc(UINT64 customData, CVAR cvar, MUTEX mutex, UINT64 timeout)
+{
+    UNUSED_PARAM(customData);
+    UNUSED_PARAM(cvar);
+    UNUSED_PARAM(mutex);
+    UNUSED_PARAM(timeout);
+
+    return STATUS_INVALID_OPERATION;
+}
+
+TEST_F(CurlRequestSchedulerTest, requestScheduler_ordersRequestsByCallAfterTime)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequestScheduler pCurlRequestScheduler;
+    PCallbacksProvider pCallbacksProvider;
+    PDoubleListNode pNode;
+    CurlRequest requests[3];
+    UINT64 currentTime;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+    pCurlRequestScheduler = pCurlApiCallbacks->pCurlRequestScheduler;
+    ASSERT_TRUE(pCurlRequestScheduler != NULL);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    MEMSET(requests, 0x00, SIZEOF(requests));
+    ATOMIC_STORE(&gTerminatedRequestCount, 0);
+
+    // Far in the future so the scheduler thread doesn't dispatch them
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    requests[0].requestInfo.callAfter = currentTime + 2 * HUNDREDS_OF_NANOS_IN_AN_HOUR;
+    requests[1].requestInfo.callAfter = currentTime + HUNDREDS_OF_NANOS_IN_AN_HOUR;
+    requests[2].requestInfo.callAfter = currentTime + 3 * HUNDREDS_OF_NANOS_IN_AN_HOUR;
+
+    // The completion routine is required
+    EXPECT_EQ(STATUS_NULL_ARG, curlRequestSchedulerSubmitRequest(pCurlRequestScheduler, &requests[0]));
+
+    for (i = 0; i < ARRAY_SIZE(requests); i++) {
+        requests[i].completionFn = countTerminatedRequestFunc;
+        EXPECT_EQ(STATUS_SUCCESS, curlRequestSchedulerSubmitRequest(pCurlRequestScheduler, &requests[i]));
+        EXPECT_TRUE(ATOMIC_LOAD_BOOL(&requests[i].scheduled));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, doubleListGetHeadNode(pCurlRequestScheduler->pScheduledRequests, &pNode));
+    EXPECT_EQ((UINT64) &requests[1], pNode->data);
+    EXPECT_EQ(STATUS_SUCCESS, doubleListGetNextNode(pNode, &pNode));
+    EXPECT_EQ((UINT64) &requests[0], pNode->data);
+    EXPECT_EQ(STATUS_SUCCESS, doubleListGetNextNode(pNode, &pNode));
+    EXPECT_EQ((UINT64) &requests[2], pNode->data);
+
+    // The requests still scheduled are completed as terminated on shutdown
+    EXPECT_EQ(STATUS_SUCCESS, freeCurlRequestScheduler(&pCurlApiCallbacks->pCurlRequestScheduler));
+    EXPECT_EQ(NULL, pCurlApiCallbacks->pCurlRequestScheduler);
+    EXPECT_EQ(ARRAY_SIZE(requests), ATOMIC_LOAD(&gTerminatedRequestCount));
+    for (i = 0; i < ARRAY_SIZE(requests); i++) {
+        EXPECT_FALSE(ATOMIC_LOAD_BOOL(&requests[i].scheduled));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+TEST_F(CurlRequestSchedulerTest, requestScheduler_completesRequestsOnFailure)
+{
+    PClientCallbacks pClientCallbacks = NULL;
+    PCurlApiCallbacks pCurlApiCallbacks = NULL;
+    PCurlRequestScheduler pCurlRequestScheduler;
+    PCallbacksProvider pCallbacksProvider;
+    WaitConditionVariableFunc waitConditionVariableFn;
+    CurlRequest requests[3];
+    UINT64 currentTime;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, getCurlApiCallbacks(pClientCallbacks, &pCurlApiCallbacks));
+    pCurlRequestScheduler = pCurlApiCallbacks->pCurlRequestScheduler;
+    ASSERT_TRUE(pCurlRequestScheduler != NULL);
+    pCallbacksProvider = pCurlApiCallbacks->pCallbacksProvider;
+
+    MEMSET(requests, 0x00, SIZEOF(requests));
+    ATOMIC_STORE(&gFailedRequestCount, 0);
+
+    // Far in the future so the scheduler thread doesn't dispatch them
+    currentTime = pCallbacksProvider->clientCallbacks.getCurrentTimeFn(pCallbacksProvider->clientCallbacks.customData);
+    for (i = 0; i < ARRAY_SIZE(requests); i++) {
+        requests[i].requestInfo.callAfter = currentTime + HUNDREDS_OF_NANOS_IN_AN_HOUR;
+        requests[i].completionFn = countFailedRequestFunc;
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, curlRequestSchedulerSubmitRequest(pCurlRequestScheduler, &requests[0]));
+    EXPECT_EQ(STATUS_SUCCESS, curlRequestSchedulerSubmitRequest(pCurlRequestScheduler, &requests[1]));
+
+    // Fail the next wait of the scheduler thread
+    waitConditionVariableFn = pCallbacksProvider->clientCallbacks.waitConditionVariableFn;
+    pCallbacksProvider->clientCallbacks.waitConditionVariableFn = failWaitConditionVariableFunc;
+    EXPECT_EQ(STATUS_SUCCESS, curlRequestSchedulerWakeup(pCurlRequestScheduler));
+
+    // The scheduled requests are completed with the failure rather than stranded
+    for (i = 0; i < 500 && ATOMIC_LOAD(&gFailedRequestCount) != 2; i++) {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+
+    EXPECT_EQ(2, ATOMIC_LOAD(&gFailedRequestCount));
+    EXPECT_FALSE(ATOMIC_LOAD_BOOL(&requests[0].scheduled));
+    EXPECT_FALSE(ATOMIC_LOAD_BOOL(&requests[1].scheduled));
+
+    // No new requests are accepted once the scheduler thread is gone
+    EXPECT_EQ(STATUS_INVALID_OPERATION, curlRequestSchedulerSubmitRequest(pCurlRequestScheduler, &requests[2]));
+    EXPECT_FALSE(ATOMIC_LOAD_BOOL(&requests[2].scheduled));
+
+    pCallbacksProvider->clientCallbacks.waitConditionVariableFn = waitConditionVariableFn;
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+    EXPECT_EQ(2, ATOMIC_LOAD(&gFailedRequestCount));
+}
+
+}  // namespace video
+}  // namespace kinesis
+}  // namespace amazonaws
+}  // namespace com;
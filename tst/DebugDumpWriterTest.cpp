@@ -0,0 +1,115 @@
+#include "ProducerTestFixture.h"
+
+namespace com { namespace amazonaws { namespace kinesis { namespace video {
+
+class DebugDumpWriterTest : public ProducerClientTestBase {
+};
+
+TEST_F(DebugDumpWriterTest, debugDumpWriter_writesOutOnRemove)
+{
+    PDebugDumpWriter pDebugDumpWriter = NULL;
+    PDebugDumpFile pDebugDumpFile = NULL, pOtherDebugDumpFile = NULL;
+    UINT32 chunkSize = 64 * 1024, i;
+    PBYTE chunk = (PBYTE) MEMALLOC(DEBUG_DUMP_WRITER_BUFFER_SIZE + 1);
+    PBYTE fileBuffer = (PBYTE) MEMALLOC(4 * chunkSize);
+    UINT64 fileBufferLen = 0;
+
+    MEMSET(chunk, 'a', DEBUG_DUMP_WRITER_BUFFER_SIZE + 1);
+
+    EXPECT_NE(STATUS_SUCCESS, createDebugDumpWriter(DEBUG_DUMP_WRITER_MAX_FILE_SIZE, DEBUG_DUMP_WRITER_MAX_FILE_COUNT, NULL));
+    EXPECT_NE(STATUS_SUCCESS, createDebugDumpWriter(DEBUG_DUMP_WRITER_MAX_FILE_SIZE, 0, &pDebugDumpWriter));
+    EXPECT_EQ(STATUS_SUCCESS, createDebugDumpWriter(DEBUG_DUMP_WRITER_MAX_FILE_SIZE, DEBUG_DUMP_WRITER_MAX_FILE_COUNT, &pDebugDumpWriter));
+
+    EXPECT_NE(STATUS_SUCCESS, debugDumpWriterAddFile(pDebugDumpWriter, NULL, &pDebugDumpFile));
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterAddFile(pDebugDumpWriter, (PCHAR) (TEST_TEMP_DIR_PATH "debugDump"), &pDebugDumpFile));
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterAddFile(pDebugDumpWriter, (PCHAR) (TEST_TEMP_DIR_PATH "otherDebugDump"), &pOtherDebugDumpFile));
+
+    // the file is truncated on creation
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "debugDump.mkv"), TRUE, NULL, &fileBufferLen));
+    EXPECT_EQ(0, fileBufferLen);
+
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterWrite(pDebugDumpWriter, pDebugDumpFile, chunk, chunkSize));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterWrite(pDebugDumpWriter, pOtherDebugDumpFile, chunk, chunkSize));
+
+    // data which can never fit is dropped instead of blocking
+    EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, debugDumpWriterWrite(pDebugDumpWriter, pDebugDumpFile, chunk, DEBUG_DUMP_WRITER_BUFFER_SIZE + 1));
+
+    // everything handed over is on disk once removed
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterRemoveFile(pDebugDumpWriter, &pDebugDumpFile));
+    EXPECT_EQ(NULL, pDebugDumpFile);
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterRemoveFile(pDebugDumpWriter, &pDebugDumpFile));
+
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "debugDump.mkv"), TRUE, NULL, &fileBufferLen));
+    EXPECT_EQ(4 * chunkSize, fileBufferLen);
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "debugDump.mkv"), TRUE, fileBuffer, &fileBufferLen));
+    EXPECT_EQ(0, MEMCMP(chunk, fileBuffer, chunkSize));
+    EXPECT_EQ(0, MEMCMP(chunk, fileBuffer + 3 * chunkSize, chunkSize));
+
+    // the dumps which were not removed are written out when the writer is freed
+    EXPECT_EQ(STATUS_SUCCESS, freeDebugDumpWriter(&pDebugDumpWriter));
+    EXPECT_EQ(NULL, pDebugDumpWriter);
+    EXPECT_EQ(STATUS_SUCCESS, freeDebugDumpWriter(&pDebugDumpWriter));
+
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "otherDebugDump.mkv"), TRUE, NULL, &fileBufferLen));
+    EXPECT_EQ(chunkSize, fileBufferLen);
+
+    MEMFREE(chunk);
+    MEMFREE(fileBuffer);
+}
+
+TEST_F(DebugDumpWriterTest, debugDumpWriter_keepsMostRecentFilesOnRotation)
+{
+    PDebugDumpWriter pDebugDumpWriter = NULL;
+    PDebugDumpFile pDebugDumpFile = NULL;
+    UINT32 chunkSize = 1024, i, j;
+    BYTE chunk[1024];
+    UINT64 fileBufferLen = 0;
+    BOOL drained, fileFound;
+
+    MEMSET(chunk, 'a', SIZEOF(chunk));
+
+    // Each chunk fills up a file and only two files are kept
+    EXPECT_EQ(STATUS_SUCCESS, createDebugDumpWriter(chunkSize, 2, &pDebugDumpWriter));
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterAddFile(pDebugDumpWriter, (PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump"), &pDebugDumpFile));
+
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterWrite(pDebugDumpWriter, pDebugDumpFile, chunk, chunkSize));
+
+        // Let the writer drain each chunk separately for it to land in its own file
+        for (j = 0, drained = FALSE; j < 500 && !drained; j++) {
+            MUTEX_LOCK(pDebugDumpWriter->lock);
+            drained = pDebugDumpFile->ringHead == pDebugDumpFile->ringTail;
+            MUTEX_UNLOCK(pDebugDumpWriter->lock);
+
+            if (!drained) {
+                THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+            }
+        }
+
+        EXPECT_TRUE(drained);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, debugDumpWriterRemoveFile(pDebugDumpWriter, &pDebugDumpFile));
+    EXPECT_EQ(STATUS_SUCCESS, freeDebugDumpWriter(&pDebugDumpWriter));
+
+    // The two oldest files have been deleted on the rotation
+    EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump.mkv"), &fileFound));
+    EXPECT_FALSE(fileFound);
+    EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump_1.mkv"), &fileFound));
+    EXPECT_FALSE(fileFound);
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump_2.mkv"), TRUE, NULL, &fileBufferLen));
+    EXPECT_EQ(chunkSize, fileBufferLen);
+    EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump_3.mkv"), TRUE, NULL, &fileBufferLen));
+    EXPECT_EQ(chunkSize, fileBufferLen);
+
+    FREMOVE((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump_2.mkv"));
+    FREMOVE((PCHAR) (TEST_TEMP_DIR_PATH "rotatedDebugDump_3.mkv"));
+}
+
+}  // namespace video
+}  // namespace kinesis
+}  // namespace amazonaws
+}  // namespace com;
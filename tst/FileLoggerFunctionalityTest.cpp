@@ -3,6 +3,11 @@
 // length of time and log level string in log: "2019-11-09 19:11:16 VERBOSE "
 #define TIMESTRING_OFFSET               28
 
+// concurrent writers of the async logger and the records each of them logs
+#define ASYNC_FILE_LOGGER_TEST_WRITER_COUNT         4
+#define ASYNC_FILE_LOGGER_TEST_RECORD_COUNT         100
+#define ASYNC_FILE_LOGGER_TEST_RECORD_SIZE          64
+
 namespace com { namespace amazonaws { namespace kinesis { namespace video {
 
     class FileLoggerFunctionalityTest : public ProducerClientTestBase
@@ -14,6 +19,26 @@ namespace com { namespace amazonaws { namespace kinesis { namespace video {
             }
     };
 
+    typedef struct {
+        LogPrintFunc logFunc;
+        CHAR recordChar;
+    } AsyncFileLoggerTestWriter, *PAsyncFileLoggerTestWriter;
+
+    static PVOID asyncFileLoggerTestWriterRoutine(PVOID args)
+    {
+        PAsyncFileLoggerTestWriter pWriter = (PAsyncFileLoggerTestWriter) args;
+        CHAR logMessage[ASYNC_FILE_LOGGER_TEST_RECORD_SIZE + 1];
+        UINT32 i;
+
+        MEMSET(logMessage, pWriter->recordChar, ASYNC_FILE_LOGGER_TEST_RECORD_SIZE);
+        logMessage[ASYNC_FILE_LOGGER_TEST_RECORD_SIZE] = '\0';
+        for (i = 0; i < ASYNC_FILE_LOGGER_TEST_RECORD_COUNT; i++) {
+            pWriter->logFunc(LOG_LEVEL_ERROR, NULL, (PCHAR) "%s", logMessage);
+        }
+
+        return NULL;
+    }
+
     TEST_F(FileLoggerFunctionalityTest, basicFileLoggerUsage)
     {
         PClientCallbacks pClientCallbacks = NULL;
@@ -385,6 +410,225 @@ namespace com { namespace amazonaws { namespace kinesis { namespace video {
         MEMFREE(logMessage);
         MEMFREE(fileBuffer);
     }
+
+    TEST_F(FileLoggerFunctionalityTest, asyncFileLoggerFlushesRecordsOnFree)
+    {
+        PClientCallbacks pClientCallbacks = NULL;
+        UINT32 logMessageSize = MIN_FILE_LOGGER_STRING_BUFFER_SIZE / 4;
+        PCHAR logMessage = (PCHAR) MEMALLOC(logMessageSize + 1);
+        PCHAR fileBuffer = (PCHAR) MEMALLOC(MIN_FILE_LOGGER_STRING_BUFFER_SIZE);
+        UINT64 fileBufferLen = MIN_FILE_LOGGER_STRING_BUFFER_SIZE, droppedCount = 0;
+        BOOL fileFound = FALSE;
+        LogPrintFunc logFunc;
+
+        EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                         API_CALL_CACHE_TYPE_NONE,
+                                                                         TEST_CACHING_ENDPOINT_PERIOD,
+                                                                         TEST_DEFAULT_REGION,
+                                                                         TEST_CONTROL_PLANE_URI,
+                                                                         EMPTY_STRING,
+                                                                         NULL,
+                                                                         TEST_USER_AGENT,
+                                                                         &pClientCallbacks));
+
+        // make sure the files dont exist
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLogIndex");
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLog.0");
+
+        EXPECT_EQ(STATUS_SUCCESS, addAsyncFileLoggerPlatformCallbacksProvider(pClientCallbacks, MIN_FILE_LOGGER_STRING_BUFFER_SIZE, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+        logFunc = pClientCallbacks->logPrintFn;
+
+        MEMSET(logMessage, 'a', logMessageSize);
+        logMessage[logMessageSize] = '\0';
+        logFunc(LOG_LEVEL_ERROR, NULL, (PCHAR) "%s", logMessage);
+
+        MEMSET(logMessage, 'b', logMessageSize);
+        logMessage[logMessageSize] = '\0';
+        logFunc(LOG_LEVEL_ERROR, NULL, (PCHAR) "%s", logMessage);
+
+        // both records fit into the ring buffer
+        EXPECT_EQ(STATUS_SUCCESS, getFileLoggerDroppedLogCount(&droppedCount));
+        EXPECT_EQ(0, droppedCount);
+
+        // records stay in memory until the string buffer fills up or the logger is freed
+        EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), &fileFound));
+        EXPECT_EQ(FALSE, fileFound);
+
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+        EXPECT_EQ(STATUS_INVALID_OPERATION, getFileLoggerDroppedLogCount(&droppedCount));
+
+        EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), &fileFound));
+        EXPECT_EQ(TRUE, fileFound);
+
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, NULL, &fileBufferLen));
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, (PBYTE) fileBuffer, &fileBufferLen));
+        fileBuffer[fileBufferLen] = '\0';
+
+        // records are written in order. Skip over the first record and the timestamp string of the second one
+        EXPECT_EQ('a', fileBuffer[TIMESTRING_OFFSET]);
+        EXPECT_EQ(0, STRNCMP(logMessage, fileBuffer + 2 * TIMESTRING_OFFSET + logMessageSize + 1, STRLEN(logMessage)));
+
+        MEMFREE(logMessage);
+        MEMFREE(fileBuffer);
+    }
+
+    TEST_F(FileLoggerFunctionalityTest, asyncFileLoggerCountsAndReportsDroppedRecords)
+    {
+        PClientCallbacks pClientCallbacks = NULL;
+        PCHAR record = (PCHAR) MEMALLOC(MIN_FILE_LOGGER_STRING_BUFFER_SIZE);
+        PCHAR fileBuffer = (PCHAR) MEMALLOC(MIN_FILE_LOGGER_STRING_BUFFER_SIZE);
+        UINT64 fileBufferLen = MIN_FILE_LOGGER_STRING_BUFFER_SIZE, droppedCount = 0;
+        BOOL fileFound = FALSE;
+
+        EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                         API_CALL_CACHE_TYPE_NONE,
+                                                                         TEST_CACHING_ENDPOINT_PERIOD,
+                                                                         TEST_DEFAULT_REGION,
+                                                                         TEST_CONTROL_PLANE_URI,
+                                                                         EMPTY_STRING,
+                                                                         NULL,
+                                                                         TEST_USER_AGENT,
+                                                                         &pClientCallbacks));
+
+        // make sure the files dont exist
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLogIndex");
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLog.0");
+
+        EXPECT_EQ(STATUS_SUCCESS, addAsyncFileLoggerPlatformCallbacksProvider(pClientCallbacks, MIN_FILE_LOGGER_STRING_BUFFER_SIZE, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+
+        // the ring buffer is of the string buffer size so a record of that size along with its length never fits
+        MEMSET(record, 'a', MIN_FILE_LOGGER_STRING_BUFFER_SIZE);
+        EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, asyncFileLoggerEnqueueRecord(record, MIN_FILE_LOGGER_STRING_BUFFER_SIZE));
+        EXPECT_EQ(STATUS_NOT_ENOUGH_MEMORY, asyncFileLoggerEnqueueRecord(record, MIN_FILE_LOGGER_STRING_BUFFER_SIZE));
+        EXPECT_EQ(STATUS_SUCCESS, getFileLoggerDroppedLogCount(&droppedCount));
+        EXPECT_EQ(2, droppedCount);
+
+        // a record which fits is still taken
+        EXPECT_EQ(STATUS_SUCCESS, asyncFileLoggerEnqueueRecord(record, MIN_FILE_LOGGER_STRING_BUFFER_SIZE / 4));
+        EXPECT_EQ(STATUS_SUCCESS, getFileLoggerDroppedLogCount(&droppedCount));
+        EXPECT_EQ(2, droppedCount);
+
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+
+        // both the record taken and the notice of the dropped ones end up in the log
+        EXPECT_EQ(STATUS_SUCCESS, fileExists((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), &fileFound));
+        EXPECT_EQ(TRUE, fileFound);
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, NULL, &fileBufferLen));
+        ASSERT_GT((UINT64) MIN_FILE_LOGGER_STRING_BUFFER_SIZE, fileBufferLen);
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, (PBYTE) fileBuffer, &fileBufferLen));
+        fileBuffer[fileBufferLen] = '\0';
+        EXPECT_TRUE(STRCHR(fileBuffer, 'a') != NULL);
+        EXPECT_TRUE(STRSTR(fileBuffer, "log records were dropped due to the log buffer being full") != NULL);
+
+        MEMFREE(record);
+        MEMFREE(fileBuffer);
+    }
+
+    TEST_F(FileLoggerFunctionalityTest, asyncFileLoggerKeepsRecordsOfConcurrentWritersWhole)
+    {
+        PClientCallbacks pClientCallbacks = NULL;
+        AsyncFileLoggerTestWriter writers[ASYNC_FILE_LOGGER_TEST_WRITER_COUNT];
+        TID threadIds[ASYNC_FILE_LOGGER_TEST_WRITER_COUNT];
+        UINT32 recordCounts[ASYNC_FILE_LOGGER_TEST_WRITER_COUNT];
+        UINT64 stringBufferSize = 1024 * 1024, fileBufferLen = 0, droppedCount = 0;
+        PCHAR fileBuffer = (PCHAR) MEMALLOC(stringBufferSize);
+        PCHAR pCurPtr, pLineEnd;
+        UINT32 i, j;
+
+        EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                         API_CALL_CACHE_TYPE_NONE,
+                                                                         TEST_CACHING_ENDPOINT_PERIOD,
+                                                                         TEST_DEFAULT_REGION,
+                                                                         TEST_CONTROL_PLANE_URI,
+                                                                         EMPTY_STRING,
+                                                                         NULL,
+                                                                         TEST_USER_AGENT,
+                                                                         &pClientCallbacks));
+
+        // make sure the files dont exist
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLogIndex");
+        FREMOVE(TEST_TEMP_DIR_PATH "kvsProducerLog.0");
+
+        // all of the records fit into the ring buffer so none is dropped
+        EXPECT_EQ(STATUS_SUCCESS, addAsyncFileLoggerPlatformCallbacksProvider(pClientCallbacks, stringBufferSize, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+
+        for (i = 0; i < ASYNC_FILE_LOGGER_TEST_WRITER_COUNT; i++) {
+            writers[i].logFunc = pClientCallbacks->logPrintFn;
+            writers[i].recordChar = (CHAR) ('a' + i);
+            recordCounts[i] = 0;
+            EXPECT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadIds[i], asyncFileLoggerTestWriterRoutine, (PVOID) &writers[i]));
+        }
+
+        for (i = 0; i < ASYNC_FILE_LOGGER_TEST_WRITER_COUNT; i++) {
+            THREAD_JOIN(threadIds[i], NULL);
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS, getFileLoggerDroppedLogCount(&droppedCount));
+        EXPECT_EQ(0, droppedCount);
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+
+        fileBufferLen = stringBufferSize;
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, NULL, &fileBufferLen));
+        ASSERT_GT(stringBufferSize, fileBufferLen);
+        EXPECT_EQ(STATUS_SUCCESS, readFile((PCHAR) (TEST_TEMP_DIR_PATH "kvsProducerLog.0"), TRUE, (PBYTE) fileBuffer, &fileBufferLen));
+        fileBuffer[fileBufferLen] = '\0';
+
+        // every record is a whole line of a single writer char
+        for (pCurPtr = fileBuffer; *pCurPtr != '\0'; pCurPtr = pLineEnd + 1) {
+            pLineEnd = STRCHR(pCurPtr, '\n');
+            ASSERT_TRUE(pLineEnd != NULL);
+            ASSERT_EQ(TIMESTRING_OFFSET + ASYNC_FILE_LOGGER_TEST_RECORD_SIZE, pLineEnd - pCurPtr);
+            i = (UINT32) (pCurPtr[TIMESTRING_OFFSET] - 'a');
+            ASSERT_GT((UINT32) ASYNC_FILE_LOGGER_TEST_WRITER_COUNT, i);
+            for (j = 0; j < ASYNC_FILE_LOGGER_TEST_RECORD_SIZE; j++) {
+                EXPECT_EQ(writers[i].recordChar, pCurPtr[TIMESTRING_OFFSET + j]);
+            }
+
+            recordCounts[i]++;
+        }
+
+        for (i = 0; i < ASYNC_FILE_LOGGER_TEST_WRITER_COUNT; i++) {
+            EXPECT_EQ(ASYNC_FILE_LOGGER_TEST_RECORD_COUNT, recordCounts[i]);
+        }
+
+        MEMFREE(fileBuffer);
+    }
+
+    TEST_F(FileLoggerFunctionalityTest, fileLoggerRejectsSwitchingMode)
+    {
+        PClientCallbacks pClientCallbacks = NULL, pOtherClientCallbacks = NULL;
+        UINT64 droppedCount = 0;
+
+        EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                         API_CALL_CACHE_TYPE_NONE,
+                                                                         TEST_CACHING_ENDPOINT_PERIOD,
+                                                                         TEST_DEFAULT_REGION,
+                                                                         TEST_CONTROL_PLANE_URI,
+                                                                         EMPTY_STRING,
+                                                                         NULL,
+                                                                         TEST_USER_AGENT,
+                                                                         &pClientCallbacks));
+        EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                         API_CALL_CACHE_TYPE_NONE,
+                                                                         TEST_CACHING_ENDPOINT_PERIOD,
+                                                                         TEST_DEFAULT_REGION,
+                                                                         TEST_CONTROL_PLANE_URI,
+                                                                         EMPTY_STRING,
+                                                                         NULL,
+                                                                         TEST_USER_AGENT,
+                                                                         &pOtherClientCallbacks));
+
+        EXPECT_EQ(STATUS_SUCCESS, addAsyncFileLoggerPlatformCallbacksProvider(pClientCallbacks, MIN_FILE_LOGGER_STRING_BUFFER_SIZE, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+
+        // the shared logger can't be switched to the sync mode and keeps running in the async mode
+        EXPECT_EQ(STATUS_INVALID_OPERATION, addFileLoggerPlatformCallbacksProvider(pOtherClientCallbacks, MIN_FILE_LOGGER_STRING_BUFFER_SIZE, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+        EXPECT_EQ(STATUS_SUCCESS, getFileLoggerDroppedLogCount(&droppedCount));
+        EXPECT_EQ(STATUS_SUCCESS, addAsyncFileLoggerPlatformCallbacksProvider(pOtherClientCallbacks, MIN_FILE_LOGGER_STRING_BUFFER_SIZE, 5, TEST_TEMP_DIR_PATH_NO_ENDING_SEPARTOR, FALSE));
+
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pOtherClientCallbacks));
+        EXPECT_EQ(STATUS_INVALID_OPERATION, getFileLoggerDroppedLogCount(&droppedCount));
+    }
 }
 }
 }
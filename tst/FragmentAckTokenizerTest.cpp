@@ -0,0 +1,120 @@
+#include "ProducerTestFixture.h"
+
+namespace com { namespace amazonaws { namespace kinesis { namespace video {
+
+class FragmentAckTokenizerTest : public ProducerClientTestBase {
+};
+
+#define TEST_MAX_RECORDED_ACK_COUNT 8
+
+typedef struct {
+    FragmentAck acks[TEST_MAX_RECORDED_ACK_COUNT];
+    UINT32 ackCount;
+} RecordedAcks, *PRecordedAcks;
+
+static STATUS recordFragmentAckFunc(UINT64 customData, PFragmentAck pFragmentAck)
+{
+    PRecordedAcks pRecordedAcks = (PRecordedAcks) customData;
+    if (pRecordedAcks->ackCount < TEST_MAX_RECORDED_ACK_COUNT) {
+        pRecordedAcks->acks[pRecordedAcks->ackCount] = *pFragmentAck;
+    }
+
+    pRecordedAcks->ackCount++;
+    return STATUS_SUCCESS;
+}
+
+TEST_F(FragmentAckTokenizerTest, fragmentAckTokenizer_splitAndCoalescedAcks)
+{
+    FragmentAckTokenizer tokenizer;
+    RecordedAcks recordedAcks;
+    CHAR acks[] = "{\"EventType\":\"BUFFERING\",\"FragmentTimecode\":12345,\"FragmentNumber\":\"91343852333\"}\n"
+                  "{ \"EventType\" : \"ERROR\", \"FragmentTimecode\" : 12345, \"ErrorId\" : 4004, \"ErrorCode\" : \"a\\\"b\" }"
+                  "garbage{\"Unknown\":true,\"EventType\":\"PERSISTED\",\"FragmentTimecode\":67890}"
+                  "{\"EventType\":\"IDLE\"}";
+    UINT32 i, size = (UINT32) STRLEN(acks);
+
+    EXPECT_NE(STATUS_SUCCESS, fragmentAckTokenizerInit(NULL, recordFragmentAckFunc, 0));
+    EXPECT_NE(STATUS_SUCCESS, fragmentAckTokenizerInit(&tokenizer, NULL, 0));
+
+    // Whole payload in one chunk and the same payload one byte at a time produce the same ACKs
+    for (i = 1; i <= size; i += size - 1) {
+        UINT32 offset, len;
+        MEMSET(&recordedAcks, 0x00, SIZEOF(recordedAcks));
+        EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerInit(&tokenizer, recordFragmentAckFunc, (UINT64) &recordedAcks));
+
+        for (offset = 0; offset < size; offset += len) {
+            len = MIN(i, size - offset);
+            EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks + offset, len));
+        }
+
+        EXPECT_EQ(4, recordedAcks.ackCount);
+
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_BUFFERING, recordedAcks.acks[0].ackType);
+        EXPECT_EQ(12345, recordedAcks.acks[0].timestamp);
+        EXPECT_EQ(0, STRCMP("91343852333", recordedAcks.acks[0].sequenceNumber));
+        EXPECT_EQ(SERVICE_CALL_RESULT_OK, recordedAcks.acks[0].result);
+
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_ERROR, recordedAcks.acks[1].ackType);
+        EXPECT_EQ(12345, recordedAcks.acks[1].timestamp);
+        EXPECT_EQ(4004, (UINT32) recordedAcks.acks[1].result);
+        EXPECT_EQ('\0', recordedAcks.acks[1].sequenceNumber[0]);
+
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_PERSISTED, recordedAcks.acks[2].ackType);
+        EXPECT_EQ(67890, recordedAcks.acks[2].timestamp);
+
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_IDLE, recordedAcks.acks[3].ackType);
+        EXPECT_EQ(STRLEN("garbage"), tokenizer.skippedBytes);
+    }
+
+    // Partial ACK is held until the rest arrives
+    MEMSET(&recordedAcks, 0x00, SIZEOF(recordedAcks));
+    EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerInit(&tokenizer, recordFragmentAckFunc, (UINT64) &recordedAcks));
+    EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks, 40));
+    EXPECT_EQ(0, recordedAcks.ackCount);
+    EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks + 40, 50));
+    EXPECT_EQ(1, recordedAcks.ackCount);
+
+    // Payload split across two writes at every offset, including inside the keys, values and escapes
+    for (i = 1; i < size; i++) {
+        MEMSET(&recordedAcks, 0x00, SIZEOF(recordedAcks));
+        EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerInit(&tokenizer, recordFragmentAckFunc, (UINT64) &recordedAcks));
+        EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks, i));
+        EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks + i, size - i));
+
+        EXPECT_EQ(4, recordedAcks.ackCount);
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_BUFFERING, recordedAcks.acks[0].ackType);
+        EXPECT_EQ(0, STRCMP("91343852333", recordedAcks.acks[0].sequenceNumber));
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_ERROR, recordedAcks.acks[1].ackType);
+        EXPECT_EQ(4004, (UINT32) recordedAcks.acks[1].result);
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_PERSISTED, recordedAcks.acks[2].ackType);
+        EXPECT_EQ(FRAGMENT_ACK_TYPE_IDLE, recordedAcks.acks[3].ackType);
+    }
+}
+
+TEST_F(FragmentAckTokenizerTest, fragmentAckTokenizer_skipsEscapesInKeptValues)
+{
+    FragmentAckTokenizer tokenizer;
+    RecordedAcks recordedAcks;
+    CHAR acks[] = "{\"EventType\":\"\\\"RECEIVED\",\"FragmentTimecode\":1,\"FragmentNumber\":\"12\\\"34\"}"
+                  "{\"EventType\":\"PERSISTED\",\"FragmentTimecode\":2,\"FragmentNumber\":\"56\"}";
+    UINT32 size = (UINT32) STRLEN(acks);
+
+    // Several ACKs in one write with the escape chars dropped from the event type and the fragment number
+    MEMSET(&recordedAcks, 0x00, SIZEOF(recordedAcks));
+    EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerInit(&tokenizer, recordFragmentAckFunc, (UINT64) &recordedAcks));
+    EXPECT_EQ(STATUS_SUCCESS, fragmentAckTokenizerProcess(&tokenizer, acks, size));
+
+    EXPECT_EQ(2, recordedAcks.ackCount);
+    EXPECT_EQ(FRAGMENT_ACK_TYPE_RECEIVED, recordedAcks.acks[0].ackType);
+    EXPECT_EQ(1, recordedAcks.acks[0].timestamp);
+    EXPECT_EQ(0, STRCMP("1234", recordedAcks.acks[0].sequenceNumber));
+    EXPECT_EQ(FRAGMENT_ACK_TYPE_PERSISTED, recordedAcks.acks[1].ackType);
+    EXPECT_EQ(2, recordedAcks.acks[1].timestamp);
+    EXPECT_EQ(0, STRCMP("56", recordedAcks.acks[1].sequenceNumber));
+    EXPECT_EQ(0, tokenizer.skippedBytes);
+}
+
+}  // namespace video
+}  // namespace kinesis
+}  // namespace amazonaws
+}  // namespace com;
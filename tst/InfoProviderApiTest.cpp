@@ -5,6 +5,14 @@ namespace com { namespace amazonaws { namespace kinesis { namespace video {
     class InfoProviderApiTest : public ProducerClientTestBase {
     };
 
+    static UINT64 gTestTime = 0;
+
+    static UINT64 getTestTimeFunc(UINT64 customData)
+    {
+        UNUSED_PARAM(customData);
+        return gTestTime;
+    }
+
     TEST_F(InfoProviderApiTest, CreateDefaultDeviceInfo_Returns_Success)
     {
         PDeviceInfo pDeviceInfo;
@@ -250,6 +258,81 @@ namespace com { namespace amazonaws { namespace kinesis { namespace video {
         EXPECT_EQ(STATUS_SUCCESS, freeStreamInfoProvider(&pStreamInfo));
     }
 
+    TEST_F(InfoProviderApiTest, setStreamInfoBasedOnMeasuredBitrateApiTest) {
+        PStreamInfo pStreamInfo;
+        PClientCallbacks pClientCallbacks = NULL;
+        PCurlStreamMetricsTracker pTracker = NULL;
+        CurlStreamMetrics curlStreamMetrics;
+        GetCurrentTimeFunc getCurrentTimeFn;
+        UINT64 bufferDuration, uploadBitrate;
+
+        EXPECT_EQ(STATUS_SUCCESS,
+                  createRealtimeVideoStreamInfoProvider(TEST_STREAM_NAME,
+                                                        TEST_RETENTION_PERIOD,
+                                                        TEST_STREAM_BUFFER_DURATION,
+                                                        &pStreamInfo));
+        EXPECT_EQ(STATUS_SUCCESS, createTestCallbacksProvider(&pClientCallbacks));
+
+        EXPECT_EQ(STATUS_NULL_ARG, setStreamInfoBasedOnMeasuredBitrate(0, 2 * 1024 * 1024, 1000000, 1, NULL));
+
+        // Nothing has been measured for the stream so the given bitrate is used
+        EXPECT_EQ(STATUS_SUCCESS, setStreamInfoBasedOnStorageSize(2 * 1024 * 1024, 1000000, 1, pStreamInfo));
+        bufferDuration = pStreamInfo->streamCaps.bufferDuration;
+        pStreamInfo->streamCaps.bufferDuration = TEST_STREAM_BUFFER_DURATION;
+        EXPECT_EQ(STATUS_SUCCESS, setStreamInfoBasedOnMeasuredBitrate(0, 2 * 1024 * 1024, 1000000, 1, pStreamInfo));
+        EXPECT_EQ(bufferDuration, pStreamInfo->streamCaps.bufferDuration);
+
+        // Feed the upload samples on a controlled clock: 1 Mbps over the first second and 2 Mbps over the next one
+        getCurrentTimeFn = ((PCallbacksProvider) pClientCallbacks)->clientCallbacks.getCurrentTimeFn;
+        ((PCallbacksProvider) pClientCallbacks)->clientCallbacks.getCurrentTimeFn = getTestTimeFunc;
+        gTestTime = HUNDREDS_OF_NANOS_IN_A_SECOND;
+        EXPECT_EQ(STATUS_SUCCESS, createCurlStreamMetricsTracker((PCallbacksProvider) pClientCallbacks, &pTracker));
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 125000));
+        gTestTime += CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD;
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 0));
+
+        // The first sample seeds the average
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsGetSnapshot(pTracker, &curlStreamMetrics));
+        EXPECT_EQ(1000000, curlStreamMetrics.uploadBitrate);
+
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 250000));
+        gTestTime += CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD;
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 0));
+
+        // The average then moves by the weight of the latest sample
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsGetSnapshot(pTracker, &curlStreamMetrics));
+        EXPECT_EQ((UINT64) (CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA * 2000000 + (1 - CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA) * 1000000),
+                  curlStreamMetrics.uploadBitrate);
+        uploadBitrate = curlStreamMetrics.uploadBitrate;
+
+        // Neither a pause nor the gap between the sessions is averaged in
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 125000));
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSetPaused(pTracker, TRUE));
+        gTestTime += 10 * CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD;
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSetPaused(pTracker, FALSE));
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSessionCompleted(pTracker, NULL));
+        gTestTime += 10 * CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD;
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsSessionStarted(pTracker));
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 125000));
+        gTestTime += CURL_STREAM_METRICS_BANDWIDTH_SAMPLE_PERIOD;
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsChunkSent(pTracker, 0));
+        EXPECT_EQ(STATUS_SUCCESS, curlStreamMetricsGetSnapshot(pTracker, &curlStreamMetrics));
+        EXPECT_NEAR(CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA * 2000000 + (1 - CURL_STREAM_METRICS_BANDWIDTH_EWMA_ALPHA) * uploadBitrate,
+                    (DOUBLE) curlStreamMetrics.uploadBitrate, 1);
+
+        // The measured bitrate takes precedence over the given one
+        EXPECT_EQ(STATUS_SUCCESS, setStreamInfoBasedOnStorageSize(2 * 1024 * 1024, curlStreamMetrics.uploadBitrate, 1, pStreamInfo));
+        bufferDuration = pStreamInfo->streamCaps.bufferDuration;
+        pStreamInfo->streamCaps.bufferDuration = TEST_STREAM_BUFFER_DURATION;
+        EXPECT_EQ(STATUS_SUCCESS, setStreamInfoBasedOnMeasuredBitrate(curlStreamMetrics.uploadBitrate, 2 * 1024 * 1024, 1000000, 1, pStreamInfo));
+        EXPECT_EQ(bufferDuration, pStreamInfo->streamCaps.bufferDuration);
+
+        EXPECT_EQ(STATUS_SUCCESS, freeCurlStreamMetricsTracker(&pTracker));
+        ((PCallbacksProvider) pClientCallbacks)->clientCallbacks.getCurrentTimeFn = getCurrentTimeFn;
+        EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+        EXPECT_EQ(STATUS_SUCCESS, freeStreamInfoProvider(&pStreamInfo));
+    }
+
     TEST_F(InfoProviderApiTest, CreateOfflineAudioVideoStreamInfoProvider_Returns_ValidVideoStreamInfo)
     {
         PStreamInfo pStreamInfo;
@@ -154,6 +154,91 @@ TEST_F(ProducerContinuousRetryTest, test_stream_recover_after_reset_connnection_
     mStreams[0] = INVALID_STREAM_HANDLE_VALUE;
 }
 
+TEST_F(ProducerContinuousRetryTest, continuousRetryScheduleRestart_coalescesPerStream)
+{
+    PDeviceInfo pDeviceInfo;
+    CLIENT_HANDLE clientHandle;
+    STREAM_HANDLE streamHandle;
+    PStreamInfo pStreamInfo;
+    PClientCallbacks pClientCallbacks;
+    PStreamCallbacks pStreamCallbacks;
+    PContinuousRetryStreamCallbacks pContinuousRetryStreamCallbacks;
+    CHAR streamName[MAX_STREAM_NAME_LEN + 1];
+    UINT64 currentTime = GETTIME();
+    UINT32 pendingCount = 0, activeCount = 0;
+    BOOL pending = FALSE;
+
+    STRNCPY(streamName, (PCHAR) TEST_STREAM_NAME, MAX_STREAM_NAME_LEN);
+    streamName[MAX_STREAM_NAME_LEN] = '\0';
+    EXPECT_EQ(STATUS_SUCCESS, createDefaultDeviceInfo(&pDeviceInfo));
+    pDeviceInfo->clientInfo.loggerLogLevel = this->loggerLogLevel;
+    EXPECT_EQ(STATUS_SUCCESS, createRealtimeVideoStreamInfoProvider(streamName, TEST_RETENTION_PERIOD, TEST_STREAM_BUFFER_DURATION, &pStreamInfo));
+    pStreamInfo->streamCaps.nalAdaptationFlags = NAL_ADAPTATION_FLAG_NONE;
+
+    EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                     API_CALL_CACHE_TYPE_NONE,
+                                                                     TEST_CACHING_ENDPOINT_PERIOD,
+                                                                     mRegion,
+                                                                     TEST_CONTROL_PLANE_URI,
+                                                                     mCaCertPath,
+                                                                     NULL,
+                                                                     NULL,
+                                                                     &pClientCallbacks));
+
+    mApiCallbacks.version = API_CALLBACKS_CURRENT_VERSION;
+    mApiCallbacks.customData = (UINT64) this;
+    mApiCallbacks.freeApiCallbacksFn = testFreeApiCallbackFunc;
+    mApiCallbacks.putStreamFn = testPutStreamFunc;
+    mApiCallbacks.tagResourceFn = testTagResourceFunc;
+    mApiCallbacks.getStreamingEndpointFn = testGetStreamingEndpointFunc;
+    mApiCallbacks.describeStreamFn = testDescribeStreamFunc;
+    mApiCallbacks.createStreamFn = testCreateStreamFunc;
+    mApiCallbacks.createDeviceFn = testCreateDeviceFunc;
+    addApiCallbacks(pClientCallbacks, &mApiCallbacks);
+
+    UINT64 expiration = currentTime + TEST_STREAMING_TOKEN_DURATION;
+    PAuthCallbacks pAuthCallbacks;
+    EXPECT_EQ(STATUS_SUCCESS, createRotatingStaticAuthCallbacks(pClientCallbacks,
+                                                                mAccessKey,
+                                                                mSecretKey,
+                                                                mSessionToken,
+                                                                expiration,
+                                                                TEST_STREAMING_TOKEN_DURATION,
+                                                                &pAuthCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, createContinuousRetryStreamCallbacks(pClientCallbacks, &pStreamCallbacks));
+    pContinuousRetryStreamCallbacks = (PContinuousRetryStreamCallbacks) pStreamCallbacks;
+
+    EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoClientSync(pDeviceInfo, pClientCallbacks, &clientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(clientHandle, pStreamInfo, &streamHandle));
+
+    // Back to back errors of the same stream result in a single pending restart
+    EXPECT_EQ(STATUS_SUCCESS, continuousRetryStreamScheduleRestart(pContinuousRetryStreamCallbacks, streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, continuousRetryStreamScheduleRestart(pContinuousRetryStreamCallbacks, streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, hashTableGetCount(pContinuousRetryStreamCallbacks->pPendingRestarts, &pendingCount));
+    EXPECT_GE(1, pendingCount);
+    EXPECT_GE(1, pContinuousRetryStreamCallbacks->restartWorkerCount);
+
+    // The restart is executed once the jitter elapses
+    THREAD_SLEEP(CONTINUOUS_RETRY_RESTART_MAX_JITTER + 500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    EXPECT_EQ(STATUS_SUCCESS, hashTableGetCount(pContinuousRetryStreamCallbacks->pPendingRestarts, &pendingCount));
+    EXPECT_EQ(STATUS_SUCCESS, hashTableGetCount(pContinuousRetryStreamCallbacks->pActiveRestarts, &activeCount));
+    EXPECT_EQ(0, pendingCount);
+    EXPECT_EQ(0, activeCount);
+
+    // Cancelled restart is dropped
+    EXPECT_EQ(STATUS_SUCCESS, continuousRetryStreamScheduleRestart(pContinuousRetryStreamCallbacks, streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, continuousRetryStreamCancelRestart(pContinuousRetryStreamCallbacks, streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, hashTableContains(pContinuousRetryStreamCallbacks->pPendingRestarts, (UINT64) streamHandle, &pending));
+    EXPECT_FALSE(pending);
+
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStreamSync(streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&clientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeDeviceInfo(&pDeviceInfo));
+    EXPECT_EQ(STATUS_SUCCESS, freeStreamInfoProvider(&pStreamInfo));
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
 }
 }
 }
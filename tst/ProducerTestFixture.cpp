@@ -469,6 +469,24 @@ VOID ProducerClientTestBase::createDefaultProducerClient(API_CALL_CACHE_TYPE cac
     pCurlApiCallbacks->curlWriteCallbackHookFn = curlWriteCallbackHookFunc;
 }
 
+STATUS ProducerClientTestBase::createTestCallbacksProvider(PClientCallbacks* ppClientCallbacks)
+{
+    return createDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                          TEST_ACCESS_KEY,
+                                          TEST_SECRET_KEY,
+                                          TEST_SESSION_TOKEN,
+                                          TEST_STREAMING_TOKEN_DURATION,
+                                          TEST_DEFAULT_REGION,
+                                          TEST_CONTROL_PLANE_URI,
+                                          mCaCertPath,
+                                          NULL,
+                                          TEST_USER_AGENT,
+                                          API_CALL_CACHE_TYPE_NONE,
+                                          TEST_CACHING_ENDPOINT_PERIOD,
+                                          TRUE,
+                                          ppClientCallbacks);
+}
+
 VOID ProducerClientTestBase::updateFrame()
 {
     mFrame.index++;
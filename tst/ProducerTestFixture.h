@@ -212,6 +212,9 @@ protected:
                             UINT32 bufferDuration = TEST_STREAM_BUFFER_DURATION,
                             BOOL sync = TRUE);
     VOID freeStreams(BOOL sync = FALSE);
+
+    // Creates the default callbacks provider with the static test credentials
+    STATUS createTestCallbacksProvider(PClientCallbacks* ppClientCallbacks);
     VOID printFrameInfo(PFrame pFrame);
 
     // Test API callback funcs
@@ -0,0 +1,95 @@
+#include "ProducerTestFixture.h"
+
+namespace com { namespace amazonaws { namespace kinesis { namespace video {
+
+class StreamLatencyStateMachineTest : public ProducerClientTestBase {
+};
+
+static STATUS recordBitrateRecommendationFunc(UINT64 customData, STREAM_HANDLE streamHandle, UINT64 bitrate)
+{
+    UNUSED_PARAM(streamHandle);
+    *((PUINT64) customData) = bitrate;
+    return STATUS_SUCCESS;
+}
+
+TEST_F(StreamLatencyStateMachineTest, streamLatencyThrottle_recommendsBitrate)
+{
+    PDeviceInfo pDeviceInfo;
+    CLIENT_HANDLE clientHandle;
+    STREAM_HANDLE streamHandle;
+    PStreamInfo pStreamInfo;
+    PClientCallbacks pClientCallbacks;
+    PStreamCallbacks pStreamCallbacks;
+    PCallbackStateMachine pCallbackStateMachine;
+    CHAR streamName[MAX_STREAM_NAME_LEN + 1];
+    UINT64 currentTime = GETTIME();
+    UINT64 targetBitrate = 0, recommendedBitrate = 0, minBitrate;
+
+    STRNCPY(streamName, (PCHAR) TEST_STREAM_NAME, MAX_STREAM_NAME_LEN);
+    streamName[MAX_STREAM_NAME_LEN] = '\0';
+    EXPECT_EQ(STATUS_SUCCESS, createDefaultDeviceInfo(&pDeviceInfo));
+    pDeviceInfo->clientInfo.loggerLogLevel = this->loggerLogLevel;
+    EXPECT_EQ(STATUS_SUCCESS, createRealtimeVideoStreamInfoProvider(streamName, TEST_RETENTION_PERIOD, TEST_STREAM_BUFFER_DURATION, &pStreamInfo));
+    pStreamInfo->streamCaps.nalAdaptationFlags = NAL_ADAPTATION_FLAG_NONE;
+    minBitrate = (UINT64) pStreamInfo->streamCaps.avgBandwidthBps * 8 * STREAM_LATENCY_MIN_BITRATE_PERCENT / 100;
+
+    EXPECT_EQ(STATUS_SUCCESS, createAbstractDefaultCallbacksProvider(TEST_DEFAULT_CHAIN_COUNT,
+                                                                     API_CALL_CACHE_TYPE_NONE,
+                                                                     TEST_CACHING_ENDPOINT_PERIOD,
+                                                                     mRegion,
+                                                                     TEST_CONTROL_PLANE_URI,
+                                                                     mCaCertPath,
+                                                                     NULL,
+                                                                     NULL,
+                                                                     &pClientCallbacks));
+
+    mApiCallbacks.version = API_CALLBACKS_CURRENT_VERSION;
+    mApiCallbacks.customData = (UINT64) this;
+    mApiCallbacks.freeApiCallbacksFn = testFreeApiCallbackFunc;
+    mApiCallbacks.putStreamFn = testPutStreamFunc;
+    mApiCallbacks.tagResourceFn = testTagResourceFunc;
+    mApiCallbacks.getStreamingEndpointFn = testGetStreamingEndpointFunc;
+    mApiCallbacks.describeStreamFn = testDescribeStreamFunc;
+    mApiCallbacks.createStreamFn = testCreateStreamFunc;
+    mApiCallbacks.createDeviceFn = testCreateDeviceFunc;
+    addApiCallbacks(pClientCallbacks, &mApiCallbacks);
+
+    UINT64 expiration = currentTime + TEST_STREAMING_TOKEN_DURATION;
+    PAuthCallbacks pAuthCallbacks;
+    EXPECT_EQ(STATUS_SUCCESS, createRotatingStaticAuthCallbacks(pClientCallbacks,
+                                                                mAccessKey,
+                                                                mSecretKey,
+                                                                mSessionToken,
+                                                                expiration,
+                                                                TEST_STREAMING_TOKEN_DURATION,
+                                                                &pAuthCallbacks));
+    EXPECT_EQ(STATUS_SUCCESS, createContinuousRetryStreamCallbacks(pClientCallbacks, &pStreamCallbacks));
+    EXPECT_NE(STATUS_SUCCESS, setContinuousRetryStreamBitrateRecommendationCallback(NULL, recordBitrateRecommendationFunc, 0));
+    EXPECT_EQ(STATUS_SUCCESS, setContinuousRetryStreamBitrateRecommendationCallback(pStreamCallbacks, recordBitrateRecommendationFunc,
+                                                                                    (UINT64) &recommendedBitrate));
+
+    EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoClientSync(pDeviceInfo, pClientCallbacks, &clientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, createKinesisVideoStreamSync(clientHandle, pStreamInfo, &streamHandle));
+
+    // Nothing has been uploaded yet so the recommendation is the lowest bitrate
+    EXPECT_NE(STATUS_SUCCESS, streamLatencyStateMachineGetTargetBitrate(streamHandle, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, streamLatencyStateMachineGetTargetBitrate(streamHandle, &targetBitrate));
+    EXPECT_EQ(minBitrate, targetBitrate);
+
+    EXPECT_EQ(STATUS_SUCCESS, getStreamMapping((PContinuousRetryStreamCallbacks) pStreamCallbacks, streamHandle, &pCallbackStateMachine));
+    EXPECT_EQ(STATUS_SUCCESS, streamLatencyStateMachineToThrottlePipelineState(streamHandle, &pCallbackStateMachine->streamLatencyStateMachine));
+    EXPECT_EQ(STREAM_CALLBACK_HANDLING_STATE_THROTTLE_PIPELINE_STATE, pCallbackStateMachine->streamLatencyStateMachine.currentState);
+    EXPECT_EQ(minBitrate, recommendedBitrate);
+
+    EXPECT_EQ(STATUS_SUCCESS, stopKinesisVideoStreamSync(streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoStream(&streamHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeKinesisVideoClient(&clientHandle));
+    EXPECT_EQ(STATUS_SUCCESS, freeDeviceInfo(&pDeviceInfo));
+    EXPECT_EQ(STATUS_SUCCESS, freeStreamInfoProvider(&pStreamInfo));
+    EXPECT_EQ(STATUS_SUCCESS, freeCallbacksProvider(&pClientCallbacks));
+}
+
+}  // namespace video
+}  // namespace kinesis
+}  // namespace amazonaws
+}  // namespace com;
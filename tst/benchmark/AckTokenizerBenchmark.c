@@ -0,0 +1,125 @@
+/**
+ * Micro-benchmark of the putMedia fragment ACK tokenizer. Feeds a synthetic ACK stream through the tokenizer
+ * in fixed size chunks on a single thread and reports the ACKs tokenized per second of CPU time.
+ */
+#define LOG_CLASS "AckTokenizerBenchmark"
+#include <com/amazonaws/kinesis/video/cproducer/Include.h>
+#include <src/source/Include_i.h>
+
+#include <sys/resource.h>
+
+#define BENCHMARK_DEFAULT_FRAGMENT_COUNT            10000
+#define BENCHMARK_DEFAULT_ITERATION_COUNT           100
+#define BENCHMARK_DEFAULT_CHUNK_SIZE                64
+#define BENCHMARK_FRAGMENT_NUMBER                   "91343852333181432392682062607743920146264157939"
+#define BENCHMARK_MAX_ACK_SIZE                      256
+
+STATUS benchmarkAckFunc(UINT64 customData, PFragmentAck pFragmentAck)
+{
+    PUINT64 pAckCount = (PUINT64) customData;
+
+    UNUSED_PARAM(pFragmentAck);
+    (*pAckCount)++;
+
+    return STATUS_SUCCESS;
+}
+
+UINT64 benchmarkGetCpuTime()
+{
+    struct rusage usage;
+
+    if (0 != getrusage(RUSAGE_SELF, &usage)) {
+        return 0;
+    }
+
+    return (UINT64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * HUNDREDS_OF_NANOS_IN_A_SECOND +
+           (UINT64) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * HUNDREDS_OF_NANOS_IN_A_MICROSECOND;
+}
+
+INT32 main(INT32 argc, CHAR *argv[])
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    FragmentAckTokenizer tokenizer;
+    PCHAR pPayload = NULL, pCurPtr;
+    UINT64 value, fragmentCount = BENCHMARK_DEFAULT_FRAGMENT_COUNT, iterationCount = BENCHMARK_DEFAULT_ITERATION_COUNT,
+           chunkSize = BENCHMARK_DEFAULT_CHUNK_SIZE, ackCount = 0, cpuTime, i;
+    UINT32 payloadSize = 0, offset, len;
+    INT32 written;
+    DOUBLE seconds;
+
+    if (argc > 1 && 0 == STRCMP(argv[1], "-h")) {
+        PRINTF("Usage: %s [fragment_count] [iteration_count] [chunk_size]\n", argv[0]);
+        CHK(FALSE, retStatus);
+    }
+
+    if (argc > 1) {
+        CHK_STATUS(STRTOUI64(argv[1], NULL, 10, &value));
+        fragmentCount = value;
+    }
+
+    if (argc > 2) {
+        CHK_STATUS(STRTOUI64(argv[2], NULL, 10, &value));
+        iterationCount = value;
+    }
+
+    if (argc > 3) {
+        CHK_STATUS(STRTOUI64(argv[3], NULL, 10, &value));
+        chunkSize = value;
+    }
+
+    CHK(fragmentCount != 0 && iterationCount != 0 && chunkSize != 0, STATUS_INVALID_ARG);
+
+    // BUFFERING, RECEIVED and PERSISTED ACKs for each fragment as the service sends them
+    pPayload = (PCHAR) MEMALLOC((SIZE_T) (fragmentCount * 3 * BENCHMARK_MAX_ACK_SIZE));
+    CHK(pPayload != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pCurPtr = pPayload;
+    for (i = 0; i < fragmentCount; i++) {
+        written = SNPRINTF(pCurPtr, BENCHMARK_MAX_ACK_SIZE,
+                           "{\"EventType\":\"BUFFERING\",\"FragmentTimecode\":%" PRIu64 ",\"FragmentNumber\":\"" BENCHMARK_FRAGMENT_NUMBER "\"}\n",
+                           i * 2000);
+        pCurPtr += written;
+        written = SNPRINTF(pCurPtr, BENCHMARK_MAX_ACK_SIZE,
+                           "{\"EventType\":\"RECEIVED\",\"FragmentTimecode\":%" PRIu64 ",\"FragmentNumber\":\"" BENCHMARK_FRAGMENT_NUMBER "\"}\n",
+                           i * 2000);
+        pCurPtr += written;
+        written = SNPRINTF(pCurPtr, BENCHMARK_MAX_ACK_SIZE,
+                           "{\"EventType\":\"PERSISTED\",\"FragmentTimecode\":%" PRIu64 ",\"FragmentNumber\":\"" BENCHMARK_FRAGMENT_NUMBER "\"}\n",
+                           i * 2000);
+        pCurPtr += written;
+    }
+
+    payloadSize = (UINT32) (pCurPtr - pPayload);
+
+    PRINTF("Tokenizing %" PRIu64 " ACKs (%u bytes) %" PRIu64 " times in %" PRIu64 " byte chunks\n",
+           fragmentCount * 3, payloadSize, iterationCount, chunkSize);
+
+    cpuTime = benchmarkGetCpuTime();
+
+    for (i = 0; i < iterationCount; i++) {
+        CHK_STATUS(fragmentAckTokenizerInit(&tokenizer, benchmarkAckFunc, (UINT64) &ackCount));
+
+        // Chunks split the ACKs at arbitrary points as the network does
+        for (offset = 0; offset < payloadSize; offset += len) {
+            len = (UINT32) MIN(chunkSize, payloadSize - offset);
+            CHK_STATUS(fragmentAckTokenizerProcess(&tokenizer, pPayload + offset, len));
+        }
+    }
+
+    cpuTime = benchmarkGetCpuTime() - cpuTime;
+
+    CHK(ackCount == fragmentCount * 3 * iterationCount, STATUS_INVALID_OPERATION);
+
+    seconds = (DOUBLE) MAX(cpuTime, 1) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    PRINTF("ACKs/s per core:     %.1f\n", ackCount / seconds);
+    PRINTF("MB/s per core:       %.1f\n", (DOUBLE) payloadSize * iterationCount / seconds / (1024 * 1024));
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        PRINTF("Benchmark failed with 0x%08x\n", retStatus);
+    }
+
+    SAFE_MEMFREE(pPayload);
+
+    return (INT32) retStatus;
+}
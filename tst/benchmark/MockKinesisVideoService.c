@@ -0,0 +1,665 @@
+/**
+ * Local mock Kinesis Video service used for the end-to-end benchmarking
+ */
+#define LOG_CLASS "MockKinesisVideoService"
+#include "MockKinesisVideoService.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// EBML id of the MKV cluster and the cluster timecode elements
+#define MKV_CLUSTER_ELEMENT_ID                  0x1F43B675
+#define MKV_CLUSTER_TIMECODE_ELEMENT_ID         0xE7
+
+#define MOCK_SERVICE_ACK_JSON_TEMPLATE          "{\"EventType\":\"%s\",\"FragmentTimecode\":%" PRIu64 ",\"FragmentNumber\":\"%" PRIu64 "\"}"
+#define MOCK_SERVICE_HTTP_STATUS_OK             200
+#define MOCK_SERVICE_HTTP_STATUS_NOT_FOUND      404
+
+#define MOCK_SERVICE_STREAM_ARN_TEMPLATE        "arn:aws:kinesisvideo:us-west-2:000000000000:stream/%s/0"
+
+STATUS createMockKinesisVideoService(UINT16 port, PMockKinesisVideoService* ppService)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockKinesisVideoService pService = NULL;
+    struct sockaddr_in address;
+    socklen_t addressLen = SIZEOF(address);
+    INT32 option = 1;
+
+    CHK(ppService != NULL, STATUS_NULL_ARG);
+
+    pService = (PMockKinesisVideoService) MEMCALLOC(1, SIZEOF(MockKinesisVideoService));
+    CHK(pService != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    pService->threadId = INVALID_TID_VALUE;
+    pService->listenSocket = -1;
+    ATOMIC_STORE_BOOL(&pService->shutdown, FALSE);
+    pService->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pService->lock), STATUS_INVALID_OPERATION);
+
+    pService->listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    CHK(pService->listenSocket >= 0, STATUS_INVALID_OPERATION);
+    setsockopt(pService->listenSocket, SOL_SOCKET, SO_REUSEADDR, &option, SIZEOF(option));
+
+    MEMSET(&address, 0x00, SIZEOF(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    CHK(0 == bind(pService->listenSocket, (struct sockaddr*) &address, SIZEOF(address)), STATUS_INVALID_OPERATION);
+    CHK(0 == listen(pService->listenSocket, MOCK_SERVICE_LISTEN_BACKLOG), STATUS_INVALID_OPERATION);
+
+    // Get the actual port in case an ephemeral one has been picked
+    CHK(0 == getsockname(pService->listenSocket, (struct sockaddr*) &address, &addressLen), STATUS_INVALID_OPERATION);
+    pService->port = ntohs(address.sin_port);
+    SNPRINTF(pService->url, ARRAY_SIZE(pService->url), "http://127.0.0.1:%u", pService->port);
+
+    CHK_STATUS(THREAD_CREATE(&pService->threadId, mockServiceAcceptRoutine, (PVOID) pService));
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        freeMockKinesisVideoService(&pService);
+    }
+
+    if (ppService != NULL) {
+        *ppService = pService;
+    }
+
+    return retStatus;
+}
+
+STATUS freeMockKinesisVideoService(PMockKinesisVideoService* ppService)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockKinesisVideoService pService;
+
+    CHK(ppService != NULL, STATUS_NULL_ARG);
+
+    pService = *ppService;
+
+    // Call is idempotent
+    CHK(pService != NULL, retStatus);
+
+    ATOMIC_STORE_BOOL(&pService->shutdown, TRUE);
+
+    // Shutting down the listening socket unblocks the accept call
+    if (pService->listenSocket >= 0) {
+        shutdown(pService->listenSocket, SHUT_RDWR);
+    }
+
+    if (IS_VALID_TID_VALUE(pService->threadId)) {
+        THREAD_JOIN(pService->threadId, NULL);
+    }
+
+    if (pService->listenSocket >= 0) {
+        close(pService->listenSocket);
+    }
+
+    if (IS_VALID_MUTEX_VALUE(pService->lock)) {
+        mockServiceReclaimConnections(pService, TRUE);
+        MUTEX_FREE(pService->lock);
+    }
+
+    MEMFREE(pService);
+
+    *ppService = NULL;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockKinesisVideoServiceGetStats(PMockKinesisVideoService pService, PUINT64 pPutMediaBytes, PUINT64 pPersistedFragmentCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pService != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pService->lock);
+
+    if (pPutMediaBytes != NULL) {
+        *pPutMediaBytes = pService->putMediaBytes;
+    }
+
+    if (pPersistedFragmentCount != NULL) {
+        *pPersistedFragmentCount = pService->persistedFragmentCount;
+    }
+
+    MUTEX_UNLOCK(pService->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+PVOID mockServiceAcceptRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockKinesisVideoService pService = (PMockKinesisVideoService) args;
+    PMockServiceConnection pConnection = NULL;
+    INT32 connectionSocket, option = 1;
+    UINT32 i;
+    BOOL added;
+
+    CHK(pService != NULL, STATUS_NULL_ARG);
+
+    while (!ATOMIC_LOAD_BOOL(&pService->shutdown)) {
+        connectionSocket = accept(pService->listenSocket, NULL, NULL);
+        if (connectionSocket < 0) {
+            // Back off on the persistent errors like running out of the descriptors
+            THREAD_SLEEP(MOCK_SERVICE_ACCEPT_RETRY_INTERVAL);
+            continue;
+        }
+
+        setsockopt(connectionSocket, IPPROTO_TCP, TCP_NODELAY, &option, SIZEOF(option));
+
+        // Reclaim the connections which have been closed by the clients
+        mockServiceReclaimConnections(pService, FALSE);
+
+        pConnection = (PMockServiceConnection) MEMCALLOC(1, SIZEOF(MockServiceConnection));
+        if (pConnection == NULL) {
+            close(connectionSocket);
+            continue;
+        }
+
+        pConnection->pService = pService;
+        pConnection->socket = connectionSocket;
+        ATOMIC_STORE_BOOL(&pConnection->completed, FALSE);
+
+        MUTEX_LOCK(pService->lock);
+        for (i = 0; i < MOCK_SERVICE_MAX_CONNECTION_COUNT && pService->connections[i] != NULL; i++);
+
+        added = i < MOCK_SERVICE_MAX_CONNECTION_COUNT &&
+                STATUS_SUCCEEDED(THREAD_CREATE(&pConnection->threadId, mockServiceConnectionRoutine, (PVOID) pConnection));
+        if (added) {
+            pService->connections[i] = pConnection;
+        }
+        MUTEX_UNLOCK(pService->lock);
+
+        if (!added) {
+            DLOGW("Dropping the connection as the max connection count has been reached");
+            close(connectionSocket);
+            MEMFREE(pConnection);
+        }
+
+        pConnection = NULL;
+    }
+
+CleanUp:
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+STATUS mockServiceReclaimConnections(PMockKinesisVideoService pService, BOOL force)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockServiceConnection pConnection;
+    UINT32 i;
+
+    CHK(pService != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < MOCK_SERVICE_MAX_CONNECTION_COUNT; i++) {
+        MUTEX_LOCK(pService->lock);
+        pConnection = pService->connections[i];
+        if (pConnection != NULL && (force || ATOMIC_LOAD_BOOL(&pConnection->completed))) {
+            pService->connections[i] = NULL;
+        } else {
+            pConnection = NULL;
+        }
+        MUTEX_UNLOCK(pService->lock);
+
+        // Join outside of the lock as the connection thread updates the stats under the lock
+        if (pConnection != NULL) {
+            if (force) {
+                shutdown(pConnection->socket, SHUT_RDWR);
+            }
+
+            THREAD_JOIN(pConnection->threadId, NULL);
+            close(pConnection->socket);
+            MEMFREE(pConnection);
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+PVOID mockServiceConnectionRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockServiceConnection pConnection = (PMockServiceConnection) args;
+    CHAR line[MOCK_SERVICE_MAX_HEADER_SIZE];
+    CHAR method[16], path[256];
+    CHAR body[MOCK_SERVICE_MAX_BODY_SIZE + 1];
+    UINT32 contentLength, bodyLen, size;
+    UINT64 value;
+    BOOL expectContinue;
+
+    CHK(pConnection != NULL, STATUS_NULL_ARG);
+
+    // Serve the requests on the connection until the client closes it
+    while (!ATOMIC_LOAD_BOOL(&pConnection->pService->shutdown)) {
+        CHK_STATUS(mockServiceReadLine(pConnection, line, SIZEOF(line)));
+        if (line[0] == '\0') {
+            continue;
+        }
+
+        CHK(2 == sscanf(line, "%15s %255s", method, path), STATUS_INVALID_ARG);
+
+        // Parse the headers we care about
+        contentLength = 0;
+        expectContinue = FALSE;
+        for (;;) {
+            CHK_STATUS(mockServiceReadLine(pConnection, line, SIZEOF(line)));
+            if (line[0] == '\0') {
+                break;
+            }
+
+            if (0 == STRNCMPI(line, "content-length:", STRLEN("content-length:"))) {
+                CHK_STATUS(STRTOUI64(line + STRLEN("content-length:") + 1, NULL, 10, &value));
+                contentLength = (UINT32) value;
+            } else if (0 == STRNCMPI(line, "expect:", STRLEN("expect:"))) {
+                expectContinue = TRUE;
+            }
+        }
+
+        if (expectContinue) {
+            CHK_STATUS(mockServiceSend(pConnection, (PCHAR) "HTTP/1.1 100 Continue\r\n\r\n", 0));
+        }
+
+        if (NULL != STRSTR(path, "/putMedia")) {
+            // putMedia is always chunked
+            CHK_STATUS(mockServiceHandlePutMedia(pConnection));
+        } else if (0 == STRCMP(method, "HEAD")) {
+            // Connection warm up. The response has no body
+            CHK_STATUS(mockServiceSend(pConnection, (PCHAR) "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", 0));
+        } else {
+            CHK(contentLength <= MOCK_SERVICE_MAX_BODY_SIZE, STATUS_INVALID_ARG_LEN);
+            for (bodyLen = 0; bodyLen < contentLength; bodyLen += size) {
+                if (pConnection->dataOffset == pConnection->dataLen) {
+                    CHK_STATUS(mockServiceFill(pConnection));
+                }
+
+                size = MIN(contentLength - bodyLen, pConnection->dataLen - pConnection->dataOffset);
+                MEMCPY(body + bodyLen, pConnection->buffer + pConnection->dataOffset, size);
+                pConnection->dataOffset += size;
+            }
+
+            body[bodyLen] = '\0';
+            CHK_STATUS(mockServiceHandleControlPlane(pConnection, path, body, bodyLen));
+        }
+    }
+
+CleanUp:
+
+    // The socket is closed when the connection is reclaimed
+    if (pConnection != NULL) {
+        ATOMIC_STORE_BOOL(&pConnection->completed, TRUE);
+    }
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+STATUS mockServiceFill(PMockServiceConnection pConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    ssize_t received;
+
+    CHK(pConnection != NULL, STATUS_NULL_ARG);
+
+    // Compact the unprocessed data
+    if (pConnection->dataOffset != 0) {
+        MEMMOVE(pConnection->buffer, pConnection->buffer + pConnection->dataOffset, pConnection->dataLen - pConnection->dataOffset);
+        pConnection->dataLen -= pConnection->dataOffset;
+        pConnection->dataOffset = 0;
+    }
+
+    CHK(pConnection->dataLen < SIZEOF(pConnection->buffer), STATUS_BUFFER_TOO_SMALL);
+
+    received = recv(pConnection->socket, pConnection->buffer + pConnection->dataLen, SIZEOF(pConnection->buffer) - pConnection->dataLen, 0);
+
+    // The connection has been closed or reset
+    CHK(received > 0, STATUS_INVALID_OPERATION);
+
+    pConnection->dataLen += (UINT32) received;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceReadLine(PMockServiceConnection pConnection, PCHAR pLine, UINT32 lineSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pStart, pEnd;
+    UINT32 lineLen;
+
+    CHK(pConnection != NULL && pLine != NULL, STATUS_NULL_ARG);
+
+    for (;;) {
+        pStart = pConnection->buffer + pConnection->dataOffset;
+        pEnd = pConnection->buffer + pConnection->dataLen;
+        for (; pStart + 1 < pEnd && !(pStart[0] == '\r' && pStart[1] == '\n'); pStart++);
+
+        if (pStart + 1 < pEnd) {
+            break;
+        }
+
+        CHK_STATUS(mockServiceFill(pConnection));
+    }
+
+    lineLen = (UINT32) (pStart - (pConnection->buffer + pConnection->dataOffset));
+    CHK(lineLen < lineSize, STATUS_BUFFER_TOO_SMALL);
+
+    MEMCPY(pLine, pConnection->buffer + pConnection->dataOffset, lineLen);
+    pLine[lineLen] = '\0';
+
+    // Skip over the CRLF
+    pConnection->dataOffset += lineLen + 2;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceSend(PMockServiceConnection pConnection, PCHAR pData, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    ssize_t sent;
+
+    CHK(pConnection != NULL && pData != NULL, STATUS_NULL_ARG);
+
+    if (size == 0) {
+        size = (UINT32) STRLEN(pData);
+    }
+
+    while (size != 0) {
+        sent = send(pConnection->socket, pData, size, MSG_NOSIGNAL);
+        CHK(sent > 0, STATUS_INVALID_OPERATION);
+        pData += sent;
+        size -= (UINT32) sent;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceSendChunk(PMockServiceConnection pConnection, PCHAR pData, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CHAR chunk[MOCK_SERVICE_MAX_RESPONSE_SIZE];
+    INT32 headerLen;
+
+    CHK(pConnection != NULL && pData != NULL, STATUS_NULL_ARG);
+    CHK(size + 16 <= SIZEOF(chunk), STATUS_BUFFER_TOO_SMALL);
+
+    headerLen = SNPRINTF(chunk, SIZEOF(chunk), "%x\r\n", size);
+    MEMCPY(chunk + headerLen, pData, size);
+    MEMCPY(chunk + headerLen + size, "\r\n", 2);
+
+    CHK_STATUS(mockServiceSend(pConnection, chunk, headerLen + size + 2));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceHandleControlPlane(PMockServiceConnection pConnection, PCHAR pPath, PCHAR pBody, UINT32 bodyLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMockKinesisVideoService pService;
+    CHAR streamName[MAX_STREAM_NAME_LEN + 1], streamArn[MAX_ARN_LEN + 1];
+    CHAR responseBody[MOCK_SERVICE_MAX_RESPONSE_SIZE], response[MOCK_SERVICE_MAX_RESPONSE_SIZE];
+    UINT32 httpStatus = MOCK_SERVICE_HTTP_STATUS_OK, i;
+    BOOL found = FALSE, locked = FALSE;
+
+    UNUSED_PARAM(bodyLen);
+    CHK(pConnection != NULL && pPath != NULL && pBody != NULL, STATUS_NULL_ARG);
+    pService = pConnection->pService;
+
+    streamName[0] = '\0';
+    mockServiceGetJsonString(pBody, (PCHAR) "StreamName", streamName, ARRAY_SIZE(streamName));
+    SNPRINTF(streamArn, ARRAY_SIZE(streamArn), MOCK_SERVICE_STREAM_ARN_TEMPLATE, streamName);
+
+    MUTEX_LOCK(pService->lock);
+    locked = TRUE;
+
+    for (i = 0; i < pService->streamCount && !found; i++) {
+        found = (0 == STRCMP(pService->streamNames[i], streamName));
+    }
+
+    if (NULL != STRSTR(pPath, "/createStream")) {
+        if (!found && pService->streamCount < MOCK_SERVICE_MAX_STREAM_COUNT) {
+            STRCPY(pService->streamNames[pService->streamCount++], streamName);
+        }
+
+        SNPRINTF(responseBody, ARRAY_SIZE(responseBody), "{\"StreamARN\":\"%s\"}", streamArn);
+    } else if (NULL != STRSTR(pPath, "/describeStream")) {
+        if (found) {
+            SNPRINTF(responseBody, ARRAY_SIZE(responseBody),
+                     "{\"StreamInfo\":{\"DeviceName\":\"mock\",\"StreamName\":\"%s\",\"StreamARN\":\"%s\","
+                     "\"MediaType\":\"video/h264\",\"KmsKeyId\":\"\",\"Version\":\"1\",\"Status\":\"ACTIVE\","
+                     "\"CreationTime\":0,\"DataRetentionInHours\":2}}",
+                     streamName, streamArn);
+        } else {
+            httpStatus = MOCK_SERVICE_HTTP_STATUS_NOT_FOUND;
+            STRCPY(responseBody, "{\"message\":\"The requested stream is not found or not active.\"}");
+        }
+    } else if (NULL != STRSTR(pPath, "/getDataEndpoint")) {
+        SNPRINTF(responseBody, ARRAY_SIZE(responseBody), "{\"DataEndpoint\":\"%s\"}", pService->url);
+    } else if (NULL != STRSTR(pPath, "/tagStream")) {
+        STRCPY(responseBody, "{}");
+    } else {
+        httpStatus = MOCK_SERVICE_HTTP_STATUS_NOT_FOUND;
+        STRCPY(responseBody, "{}");
+    }
+
+    MUTEX_UNLOCK(pService->lock);
+    locked = FALSE;
+
+    SNPRINTF(response, ARRAY_SIZE(response),
+             "HTTP/1.1 %u %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n%s",
+             httpStatus, httpStatus == MOCK_SERVICE_HTTP_STATUS_OK ? "OK" : "Not Found", (UINT32) STRLEN(responseBody), responseBody);
+    CHK_STATUS(mockServiceSend(pConnection, response, 0));
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pService->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS mockServiceHandlePutMedia(PMockServiceConnection pConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CHAR line[MOCK_SERVICE_MAX_HEADER_SIZE];
+    UINT64 chunkSize;
+    UINT32 size;
+
+    CHK(pConnection != NULL, STATUS_NULL_ARG);
+
+    // The acks are streamed back while the upload is in progress
+    CHK_STATUS(mockServiceSend(pConnection,
+                               (PCHAR) "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n",
+                               0));
+
+    pConnection->scanState = MKV_SCAN_STATE_CLUSTER_ID;
+    pConnection->scanWindow = 0;
+    pConnection->fragmentOpen = FALSE;
+
+    for (;;) {
+        CHK_STATUS(mockServiceReadLine(pConnection, line, SIZEOF(line)));
+        CHK_STATUS(STRTOUI64(line, NULL, 16, &chunkSize));
+
+        // Last chunk is followed by the optional trailers and an empty line
+        if (chunkSize == 0) {
+            do {
+                CHK_STATUS(mockServiceReadLine(pConnection, line, SIZEOF(line)));
+            } while (line[0] != '\0');
+
+            break;
+        }
+
+        while (chunkSize != 0) {
+            if (pConnection->dataOffset == pConnection->dataLen) {
+                CHK_STATUS(mockServiceFill(pConnection));
+            }
+
+            size = (UINT32) MIN(chunkSize, pConnection->dataLen - pConnection->dataOffset);
+            CHK_STATUS(mockServiceScanMkv(pConnection, pConnection->buffer + pConnection->dataOffset, size));
+            pConnection->dataOffset += size;
+            chunkSize -= size;
+
+            MUTEX_LOCK(pConnection->pService->lock);
+            pConnection->pService->putMediaBytes += size;
+            MUTEX_UNLOCK(pConnection->pService->lock);
+        }
+
+        // CRLF after the chunk data
+        CHK_STATUS(mockServiceReadLine(pConnection, line, SIZEOF(line)));
+    }
+
+    // Persist the last fragment and terminate the response
+    if (pConnection->fragmentOpen) {
+        CHK_STATUS(mockServiceSendAck(pConnection, (PCHAR) "RECEIVED", pConnection->fragmentTimecode));
+        CHK_STATUS(mockServiceSendAck(pConnection, (PCHAR) "PERSISTED", pConnection->fragmentTimecode));
+        pConnection->fragmentOpen = FALSE;
+    }
+
+    CHK_STATUS(mockServiceSend(pConnection, (PCHAR) "0\r\n\r\n", 0));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceScanMkv(PMockServiceConnection pConnection, PBYTE pData, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, length;
+    BYTE mask;
+
+    CHK(pConnection != NULL && pData != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < size; i++) {
+        switch (pConnection->scanState) {
+            case MKV_SCAN_STATE_CLUSTER_ID:
+                pConnection->scanWindow = (pConnection->scanWindow << 8) | pData[i];
+                if (pConnection->scanWindow == MKV_CLUSTER_ELEMENT_ID) {
+                    pConnection->scanRemaining = 0;
+                    pConnection->scanState = MKV_SCAN_STATE_CLUSTER_SIZE;
+                }
+
+                break;
+
+            case MKV_SCAN_STATE_CLUSTER_SIZE:
+                if (pConnection->scanRemaining == 0) {
+                    // The length of the EBML variable size integer is encoded in the leading zero bits
+                    for (mask = 0x80, length = 1; mask != 0 && (pData[i] & mask) == 0; mask >>= 1, length++);
+                    pConnection->scanRemaining = length;
+                }
+
+                if (--pConnection->scanRemaining == 0) {
+                    pConnection->scanState = MKV_SCAN_STATE_TIMECODE_ID;
+                }
+
+                break;
+
+            case MKV_SCAN_STATE_TIMECODE_ID:
+                pConnection->scanState = pData[i] == MKV_CLUSTER_TIMECODE_ELEMENT_ID ?
+                                         MKV_SCAN_STATE_TIMECODE_SIZE : MKV_SCAN_STATE_CLUSTER_ID;
+                pConnection->scanWindow = 0;
+                break;
+
+            case MKV_SCAN_STATE_TIMECODE_SIZE:
+                // Timecode is at most 8 bytes so the size is a single byte
+                pConnection->scanRemaining = pData[i] & 0x7f;
+                pConnection->scanValue = 0;
+                pConnection->scanState = (pData[i] & 0x80) != 0 && pConnection->scanRemaining != 0 && pConnection->scanRemaining <= 8 ?
+                                         MKV_SCAN_STATE_TIMECODE_VALUE : MKV_SCAN_STATE_CLUSTER_ID;
+                break;
+
+            case MKV_SCAN_STATE_TIMECODE_VALUE:
+                pConnection->scanValue = (pConnection->scanValue << 8) | pData[i];
+                if (--pConnection->scanRemaining == 0) {
+                    // The previous fragment is complete once the next one starts
+                    if (pConnection->fragmentOpen) {
+                        CHK_STATUS(mockServiceSendAck(pConnection, (PCHAR) "RECEIVED", pConnection->fragmentTimecode));
+                        CHK_STATUS(mockServiceSendAck(pConnection, (PCHAR) "PERSISTED", pConnection->fragmentTimecode));
+                    }
+
+                    pConnection->fragmentTimecode = pConnection->scanValue;
+                    pConnection->fragmentOpen = TRUE;
+                    CHK_STATUS(mockServiceSendAck(pConnection, (PCHAR) "BUFFERING", pConnection->fragmentTimecode));
+
+                    pConnection->scanState = MKV_SCAN_STATE_CLUSTER_ID;
+                }
+
+                break;
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS mockServiceSendAck(PMockServiceConnection pConnection, PCHAR pEventType, UINT64 timecode)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    CHAR ack[256];
+    UINT64 fragmentNumber;
+    INT32 ackLen;
+
+    CHK(pConnection != NULL && pEventType != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pConnection->pService->lock);
+    if (0 == STRCMP(pEventType, "PERSISTED")) {
+        pConnection->pService->persistedFragmentCount++;
+    }
+
+    fragmentNumber = pConnection->pService->persistedFragmentCount;
+    MUTEX_UNLOCK(pConnection->pService->lock);
+
+    ackLen = SNPRINTF(ack, SIZEOF(ack), MOCK_SERVICE_ACK_JSON_TEMPLATE, pEventType, timecode, fragmentNumber);
+    CHK_STATUS(mockServiceSendChunk(pConnection, ack, (UINT32) ackLen));
+
+CleanUp:
+
+    return retStatus;
+}
+
+BOOL mockServiceGetJsonString(PCHAR pJson, PCHAR pKey, PCHAR pValue, UINT32 valueSize)
+{
+    PCHAR pStart, pEnd;
+    UINT32 keyLen = (UINT32) STRLEN(pKey);
+
+    for (pStart = STRSTR(pJson, pKey); pStart != NULL; pStart = STRSTR(pStart + keyLen, pKey)) {
+        // Make sure it's the quoted key followed by the colon
+        if (pStart == pJson || pStart[-1] != '"' || pStart[keyLen] != '"') {
+            continue;
+        }
+
+        pStart = STRCHR(pStart + keyLen + 1, '"');
+        if (pStart == NULL) {
+            return FALSE;
+        }
+
+        pEnd = STRCHR(++pStart, '"');
+        if (pEnd == NULL || (UINT32) (pEnd - pStart) >= valueSize) {
+            return FALSE;
+        }
+
+        MEMCPY(pValue, pStart, pEnd - pStart);
+        pValue[pEnd - pStart] = '\0';
+        return TRUE;
+    }
+
+    return FALSE;
+}
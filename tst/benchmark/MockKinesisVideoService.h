@@ -0,0 +1,186 @@
+/*******************************************
+Local mock Kinesis Video service include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_MOCK_SERVICE_INCLUDE__
+#define __KINESIS_VIDEO_MOCK_SERVICE_INCLUDE__
+
+#pragma once
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <com/amazonaws/kinesis/video/cproducer/Include.h>
+
+// Max number of streams the mock service keeps track of
+#define MOCK_SERVICE_MAX_STREAM_COUNT                       256
+
+// Max number of concurrently served connections
+#define MOCK_SERVICE_MAX_CONNECTION_COUNT                   512
+
+// Size of the per connection receive buffer
+#define MOCK_SERVICE_RECEIVE_BUFFER_SIZE                    (64 * 1024)
+
+// Max size of the request line and a header line
+#define MOCK_SERVICE_MAX_HEADER_SIZE                        (4 * 1024)
+
+// Max size of the control plane request body
+#define MOCK_SERVICE_MAX_BODY_SIZE                          (8 * 1024)
+
+// Max size of the response
+#define MOCK_SERVICE_MAX_RESPONSE_SIZE                      (4 * 1024)
+
+// Listen backlog
+#define MOCK_SERVICE_LISTEN_BACKLOG                         128
+
+// Interval to retry accepting after a failure
+#define MOCK_SERVICE_ACCEPT_RETRY_INTERVAL                  (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * MKV cluster parser states used to find the fragment timecodes in the putMedia stream
+ */
+typedef enum {
+    MKV_SCAN_STATE_CLUSTER_ID,
+    MKV_SCAN_STATE_CLUSTER_SIZE,
+    MKV_SCAN_STATE_TIMECODE_ID,
+    MKV_SCAN_STATE_TIMECODE_SIZE,
+    MKV_SCAN_STATE_TIMECODE_VALUE,
+} MKV_SCAN_STATE;
+
+/**
+ * Forward declarations
+ */
+struct __MockKinesisVideoService;
+
+/**
+ * Connection served by the mock service
+ */
+typedef struct __MockServiceConnection MockServiceConnection;
+struct __MockServiceConnection {
+    // Back pointer to the service
+    struct __MockKinesisVideoService* pService;
+
+    // Connection socket
+    INT32 socket;
+
+    // Serving thread
+    TID threadId;
+
+    // Whether the serving thread has exited and the connection can be reclaimed
+    volatile ATOMIC_BOOL completed;
+
+    // Receive buffer with the unprocessed bytes from dataOffset to dataLen
+    BYTE buffer[MOCK_SERVICE_RECEIVE_BUFFER_SIZE];
+    UINT32 dataOffset;
+    UINT32 dataLen;
+
+    // MKV scanner state
+    MKV_SCAN_STATE scanState;
+    UINT32 scanWindow;
+    UINT32 scanRemaining;
+    UINT64 scanValue;
+
+    // Whether a fragment has been started and not yet acked as persisted
+    BOOL fragmentOpen;
+
+    // Timecode of the open fragment
+    UINT64 fragmentTimecode;
+};
+typedef struct __MockServiceConnection* PMockServiceConnection;
+
+/**
+ * Local stand-in for the Kinesis Video control plane and putMedia APIs over plain HTTP.
+ *
+ * The control plane APIs keep track of the created streams. putMedia consumes the chunked MKV upload
+ * and streams back BUFFERING ack as a new cluster begins and RECEIVED and PERSISTED acks when the cluster
+ * is complete.
+ */
+typedef struct __MockKinesisVideoService MockKinesisVideoService;
+struct __MockKinesisVideoService {
+    // Listening socket
+    INT32 listenSocket;
+
+    // Port the service is listening on
+    UINT16 port;
+
+    // Url of the service
+    CHAR url[MAX_URI_CHAR_LEN + 1];
+
+    // Accepting thread
+    TID threadId;
+
+    // Whether the service is shutting down
+    volatile ATOMIC_BOOL shutdown;
+
+    // Lock guarding the streams, connections and the stats
+    MUTEX lock;
+
+    // Created streams
+    CHAR streamNames[MOCK_SERVICE_MAX_STREAM_COUNT][MAX_STREAM_NAME_LEN + 1];
+    UINT32 streamCount;
+
+    // Connections being served
+    PMockServiceConnection connections[MOCK_SERVICE_MAX_CONNECTION_COUNT];
+
+    // Stats
+    UINT64 putMediaBytes;
+    UINT64 persistedFragmentCount;
+};
+typedef struct __MockKinesisVideoService* PMockKinesisVideoService;
+
+////////////////////////////////////////////////////
+// Function definitions
+////////////////////////////////////////////////////
+
+/**
+ * Creates the mock service listening on the loopback interface and starts accepting connections
+ *
+ * @param - UINT16 - IN - Port to listen on. 0 to pick an ephemeral port
+ * @param - PMockKinesisVideoService* - OUT - The newly created object
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS createMockKinesisVideoService(UINT16, PMockKinesisVideoService*);
+
+/**
+ * Stops accepting, closes the connections and frees the mock service.
+ *
+ * NOTE: The call is idempotent
+ *
+ * @param - PMockKinesisVideoService* - IN/OUT - The object to release
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS freeMockKinesisVideoService(PMockKinesisVideoService*);
+
+/**
+ * Returns the number of putMedia bytes received and fragments persisted by the mock service
+ *
+ * @param - PMockKinesisVideoService - IN - Service object
+ * @param - PUINT64 - OUT/OPT - Received putMedia bytes
+ * @param - PUINT64 - OUT/OPT - Persisted fragments
+ *
+ * @return - STATUS code of the execution
+ */
+STATUS mockKinesisVideoServiceGetStats(PMockKinesisVideoService, PUINT64, PUINT64);
+
+////////////////////////////////////////////////////
+// Internal functionality
+////////////////////////////////////////////////////
+PVOID mockServiceAcceptRoutine(PVOID);
+PVOID mockServiceConnectionRoutine(PVOID);
+STATUS mockServiceReclaimConnections(PMockKinesisVideoService, BOOL);
+STATUS mockServiceFill(PMockServiceConnection);
+STATUS mockServiceReadLine(PMockServiceConnection, PCHAR, UINT32);
+STATUS mockServiceSend(PMockServiceConnection, PCHAR, UINT32);
+STATUS mockServiceSendChunk(PMockServiceConnection, PCHAR, UINT32);
+STATUS mockServiceHandleControlPlane(PMockServiceConnection, PCHAR, PCHAR, UINT32);
+STATUS mockServiceHandlePutMedia(PMockServiceConnection);
+STATUS mockServiceScanMkv(PMockServiceConnection, PBYTE, UINT32);
+STATUS mockServiceSendAck(PMockServiceConnection, PCHAR, UINT64);
+BOOL mockServiceGetJsonString(PCHAR, PCHAR, PCHAR, UINT32);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif  /* __KINESIS_VIDEO_MOCK_SERVICE_INCLUDE__ */
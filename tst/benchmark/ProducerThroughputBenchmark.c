@@ -0,0 +1,448 @@
+/**
+ * End-to-end producer throughput benchmark driving N concurrent streams through the curl based API callbacks
+ * against the local mock Kinesis Video service.
+ */
+#define LOG_CLASS "ProducerThroughputBenchmark"
+#include "MockKinesisVideoService.h"
+
+#include <sys/resource.h>
+
+#define BENCHMARK_DEFAULT_STREAM_COUNT              4
+#define BENCHMARK_DEFAULT_DURATION_SECONDS          30
+#define BENCHMARK_DEFAULT_FPS                       25
+#define BENCHMARK_DEFAULT_FRAME_SIZE                (20 * 1024)
+#define BENCHMARK_KEY_FRAME_INTERVAL                25
+#define BENCHMARK_RETENTION_PERIOD                  (2 * HUNDREDS_OF_NANOS_IN_AN_HOUR)
+#define BENCHMARK_BUFFER_DURATION                   (120 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+#define BENCHMARK_STORAGE_SIZE_PER_STREAM           (16 * 1024 * 1024)
+#define BENCHMARK_MAX_PENDING_FRAGMENTS             1024
+#define BENCHMARK_ACCESS_KEY                        "BENCHMARKACCESSKEY"
+#define BENCHMARK_SECRET_KEY                        "BENCHMARKSECRETKEY"
+
+/**
+ * Forward declarations
+ */
+struct __Benchmark;
+
+/**
+ * Per stream benchmark state
+ */
+typedef struct __BenchmarkStream BenchmarkStream;
+struct __BenchmarkStream {
+    // Back pointer to the benchmark
+    struct __Benchmark* pBenchmark;
+
+    CHAR streamName[MAX_STREAM_NAME_LEN + 1];
+    PStreamInfo pStreamInfo;
+    STREAM_HANDLE streamHandle;
+
+    // Frame producing thread
+    TID threadId;
+
+    // Lock guarding the pending fragments and the latencies
+    MUTEX lock;
+
+    // Put times of the fragment starting key frames awaiting the persisted ack
+    UINT64 pendingFragments[BENCHMARK_MAX_PENDING_FRAGMENTS];
+    UINT32 pendingHead;
+    UINT32 pendingTail;
+
+    // Put to persisted ack latencies
+    PUINT64 pLatencies;
+    UINT32 latencyCount;
+    UINT32 maxLatencyCount;
+
+    // Produced frames and bytes
+    UINT64 frameCount;
+    UINT64 byteCount;
+
+    // Result of the frame producing thread
+    STATUS status;
+};
+typedef struct __BenchmarkStream* PBenchmarkStream;
+
+/**
+ * Benchmark parameters and streams
+ */
+typedef struct __Benchmark Benchmark;
+struct __Benchmark {
+    UINT32 streamCount;
+    UINT32 fps;
+    UINT32 frameSize;
+    UINT64 duration;
+    UINT32 networkLoopCount;
+    BOOL http2;
+
+    PBenchmarkStream pStreams;
+};
+typedef struct __Benchmark* PBenchmark;
+
+PVOID benchmarkStreamRoutine(PVOID);
+STATUS benchmarkFragmentAckReceivedFunc(UINT64, STREAM_HANDLE, UPLOAD_HANDLE, PFragmentAck);
+INT32 benchmarkCompareLatencies(const VOID*, const VOID*);
+UINT64 benchmarkGetCpuTime();
+UINT64 benchmarkGetMaxRss();
+
+PVOID benchmarkStreamRoutine(PVOID args)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBenchmarkStream pStream = (PBenchmarkStream) args;
+    PBenchmark pBenchmark;
+    Frame frame;
+    UINT64 startTime, stopTime, nextFrameTime, currentTime;
+    UINT32 frameIndex;
+
+    CHK(pStream != NULL, STATUS_NULL_ARG);
+    pBenchmark = pStream->pBenchmark;
+
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+
+    // Zeroed frame data can't be mistaken for the MKV elements by the mock service
+    frame.frameData = (PBYTE) MEMCALLOC(1, pBenchmark->frameSize);
+    CHK(frame.frameData != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    frame.version = FRAME_CURRENT_VERSION;
+    frame.trackId = DEFAULT_VIDEO_TRACK_ID;
+    frame.duration = HUNDREDS_OF_NANOS_IN_A_SECOND / pBenchmark->fps;
+    frame.size = pBenchmark->frameSize;
+
+    startTime = GETTIME();
+    stopTime = startTime + pBenchmark->duration;
+    frame.decodingTs = startTime;
+    frame.presentationTs = startTime;
+
+    for (frameIndex = 0, currentTime = startTime; currentTime < stopTime; frameIndex++) {
+        frame.index = frameIndex;
+        frame.flags = frameIndex % BENCHMARK_KEY_FRAME_INTERVAL == 0 ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+
+        // Each key frame starts a new fragment
+        if (frame.flags == FRAME_FLAG_KEY_FRAME) {
+            MUTEX_LOCK(pStream->lock);
+            if (pStream->pendingTail - pStream->pendingHead == BENCHMARK_MAX_PENDING_FRAGMENTS) {
+                pStream->pendingHead++;
+            }
+
+            pStream->pendingFragments[pStream->pendingTail++ % BENCHMARK_MAX_PENDING_FRAGMENTS] = GETTIME();
+            MUTEX_UNLOCK(pStream->lock);
+        }
+
+        CHK_STATUS(putKinesisVideoFrame(pStream->streamHandle, &frame));
+        pStream->frameCount++;
+        pStream->byteCount += frame.size;
+
+        frame.decodingTs += frame.duration;
+        frame.presentationTs = frame.decodingTs;
+
+        // Pace the frames in real time
+        nextFrameTime = startTime + (frameIndex + 1) * frame.duration;
+        currentTime = GETTIME();
+        if (currentTime < nextFrameTime) {
+            THREAD_SLEEP(nextFrameTime - currentTime);
+            currentTime = nextFrameTime;
+        }
+    }
+
+CleanUp:
+
+    if (pStream != NULL) {
+        SAFE_MEMFREE(frame.frameData);
+        pStream->status = retStatus;
+    }
+
+    return (PVOID) (ULONG_PTR) retStatus;
+}
+
+STATUS benchmarkFragmentAckReceivedFunc(UINT64 customData, STREAM_HANDLE streamHandle, UPLOAD_HANDLE uploadHandle, PFragmentAck pFragmentAck)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBenchmark pBenchmark = (PBenchmark) customData;
+    PBenchmarkStream pStream = NULL;
+    UINT64 currentTime = GETTIME();
+    UINT32 i;
+
+    UNUSED_PARAM(uploadHandle);
+    CHK(pBenchmark != NULL && pFragmentAck != NULL, STATUS_NULL_ARG);
+    CHK(pFragmentAck->ackType == FRAGMENT_ACK_TYPE_PERSISTED, retStatus);
+
+    for (i = 0; i < pBenchmark->streamCount && pStream == NULL; i++) {
+        if (pBenchmark->pStreams[i].streamHandle == streamHandle) {
+            pStream = &pBenchmark->pStreams[i];
+        }
+    }
+
+    CHK(pStream != NULL, retStatus);
+
+    // The fragments are persisted in order
+    MUTEX_LOCK(pStream->lock);
+    if (pStream->pendingHead != pStream->pendingTail) {
+        if (pStream->latencyCount < pStream->maxLatencyCount) {
+            pStream->pLatencies[pStream->latencyCount++] =
+                currentTime - pStream->pendingFragments[pStream->pendingHead % BENCHMARK_MAX_PENDING_FRAGMENTS];
+        }
+
+        pStream->pendingHead++;
+    }
+    MUTEX_UNLOCK(pStream->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+INT32 benchmarkCompareLatencies(const VOID* pLeft, const VOID* pRight)
+{
+    UINT64 left = *(PUINT64) pLeft, right = *(PUINT64) pRight;
+
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+UINT64 benchmarkGetCpuTime()
+{
+    struct rusage usage;
+
+    if (0 != getrusage(RUSAGE_SELF, &usage)) {
+        return 0;
+    }
+
+    return (UINT64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * HUNDREDS_OF_NANOS_IN_A_SECOND +
+           (UINT64) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * HUNDREDS_OF_NANOS_IN_A_MICROSECOND;
+}
+
+UINT64 benchmarkGetMaxRss()
+{
+    struct rusage usage;
+
+    if (0 != getrusage(RUSAGE_SELF, &usage)) {
+        return 0;
+    }
+
+    // Reported in kilobytes
+    return (UINT64) usage.ru_maxrss * 1024;
+}
+
+INT32 main(INT32 argc, CHAR *argv[])
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    Benchmark benchmark;
+    PBenchmarkStream pStream;
+    PMockKinesisVideoService pService = NULL;
+    PDeviceInfo pDeviceInfo = NULL;
+    PClientCallbacks pClientCallbacks = NULL;
+    PStreamCallbacks pStreamCallbacks = NULL;
+    PAuthCallbacks pAuthCallbacks = NULL;
+    CLIENT_HANDLE clientHandle = INVALID_CLIENT_HANDLE_VALUE;
+    UINT64 value, startTime, elapsed, cpuTime, frameCount = 0, byteCount = 0, serviceBytes = 0, persistedCount = 0;
+    PUINT64 pAllLatencies = NULL;
+    UINT32 i, latencyCount = 0;
+    DOUBLE seconds;
+
+    MEMSET(&benchmark, 0x00, SIZEOF(Benchmark));
+    benchmark.streamCount = BENCHMARK_DEFAULT_STREAM_COUNT;
+    benchmark.duration = BENCHMARK_DEFAULT_DURATION_SECONDS * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    benchmark.fps = BENCHMARK_DEFAULT_FPS;
+    benchmark.frameSize = BENCHMARK_DEFAULT_FRAME_SIZE;
+
+    if (argc > 1 && 0 == STRCMP(argv[1], "-h")) {
+        PRINTF("Usage: %s [stream_count] [duration_in_seconds] [fps] [frame_size] [network_loop_count] [http2]\n", argv[0]);
+        CHK(FALSE, retStatus);
+    }
+
+    if (argc > 1) {
+        CHK_STATUS(STRTOUI64(argv[1], NULL, 10, &value));
+        benchmark.streamCount = (UINT32) value;
+    }
+
+    if (argc > 2) {
+        CHK_STATUS(STRTOUI64(argv[2], NULL, 10, &value));
+        benchmark.duration = value * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    }
+
+    if (argc > 3) {
+        CHK_STATUS(STRTOUI64(argv[3], NULL, 10, &value));
+        benchmark.fps = (UINT32) value;
+    }
+
+    if (argc > 4) {
+        CHK_STATUS(STRTOUI64(argv[4], NULL, 10, &value));
+        benchmark.frameSize = (UINT32) value;
+    }
+
+    if (argc > 5) {
+        CHK_STATUS(STRTOUI64(argv[5], NULL, 10, &value));
+        benchmark.networkLoopCount = (UINT32) value;
+    }
+
+    if (argc > 6) {
+        CHK_STATUS(STRTOUI64(argv[6], NULL, 10, &value));
+        benchmark.http2 = value != 0;
+    }
+
+    CHK(benchmark.streamCount > 0 && benchmark.streamCount <= MOCK_SERVICE_MAX_STREAM_COUNT &&
+        benchmark.fps > 0 && benchmark.frameSize > 0, STATUS_INVALID_ARG);
+
+    benchmark.pStreams = (PBenchmarkStream) MEMCALLOC(benchmark.streamCount, SIZEOF(BenchmarkStream));
+    CHK(benchmark.pStreams != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    for (i = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        pStream->pBenchmark = &benchmark;
+        pStream->streamHandle = INVALID_STREAM_HANDLE_VALUE;
+        pStream->threadId = INVALID_TID_VALUE;
+        pStream->lock = MUTEX_CREATE(FALSE);
+
+        // Enough for a fragment per second with headroom
+        pStream->maxLatencyCount = (UINT32) (benchmark.duration / HUNDREDS_OF_NANOS_IN_A_SECOND) * 2 + 16;
+        pStream->pLatencies = (PUINT64) MEMCALLOC(pStream->maxLatencyCount, SIZEOF(UINT64));
+        CHK(pStream->pLatencies != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        SNPRINTF(pStream->streamName, ARRAY_SIZE(pStream->streamName), "benchmark-stream-%u", i);
+    }
+
+    CHK_STATUS(createMockKinesisVideoService(0, &pService));
+
+    CHK_STATUS(createDefaultDeviceInfo(&pDeviceInfo));
+    pDeviceInfo->clientInfo.loggerLogLevel = LOG_LEVEL_WARN;
+    pDeviceInfo->streamCount = benchmark.streamCount;
+    CHK_STATUS(setDeviceInfoStorageSize(pDeviceInfo, (UINT64) benchmark.streamCount * BENCHMARK_STORAGE_SIZE_PER_STREAM));
+
+    CHK_STATUS(createAbstractDefaultCallbacksProvider(DEFAULT_CALLBACK_CHAIN_COUNT,
+                                                      API_CALL_CACHE_TYPE_NONE,
+                                                      ENDPOINT_UPDATE_PERIOD_SENTINEL_VALUE,
+                                                      (PCHAR) DEFAULT_AWS_REGION,
+                                                      pService->url,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      &pClientCallbacks));
+    CHK_STATUS(createStaticAuthCallbacks(pClientCallbacks, (PCHAR) BENCHMARK_ACCESS_KEY, (PCHAR) BENCHMARK_SECRET_KEY, NULL, MAX_UINT64, &pAuthCallbacks));
+
+    if (benchmark.networkLoopCount != 0) {
+        CHK_STATUS(setCurlApiCallbacksNetworkLoopCount(pClientCallbacks, benchmark.networkLoopCount));
+    }
+
+    // Only takes effect against a TLS endpoint negotiating HTTP/2. The mock service keeps the sessions on HTTP/1.1
+    CHK_STATUS(setCurlApiCallbacksHttp2(pClientCallbacks, benchmark.http2));
+
+    CHK_STATUS(createStreamCallbacks(&pStreamCallbacks));
+    pStreamCallbacks->customData = (UINT64) &benchmark;
+    pStreamCallbacks->fragmentAckReceivedFn = benchmarkFragmentAckReceivedFunc;
+    CHK_STATUS(addStreamCallbacks(pClientCallbacks, pStreamCallbacks));
+
+    CHK_STATUS(createKinesisVideoClientSync(pDeviceInfo, pClientCallbacks, &clientHandle));
+
+    for (i = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        CHK_STATUS(createRealtimeVideoStreamInfoProvider(pStream->streamName, BENCHMARK_RETENTION_PERIOD, BENCHMARK_BUFFER_DURATION, &pStream->pStreamInfo));
+        CHK_STATUS(createKinesisVideoStreamSync(clientHandle, pStream->pStreamInfo, &pStream->streamHandle));
+    }
+
+    PRINTF("Streaming %u streams of %u byte frames at %u fps for %" PRIu64 " seconds against %s\n",
+           benchmark.streamCount, benchmark.frameSize, benchmark.fps, benchmark.duration / HUNDREDS_OF_NANOS_IN_A_SECOND, pService->url);
+
+    startTime = GETTIME();
+    cpuTime = benchmarkGetCpuTime();
+
+    for (i = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        CHK_STATUS(THREAD_CREATE(&pStream->threadId, benchmarkStreamRoutine, (PVOID) pStream));
+    }
+
+    for (i = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        THREAD_JOIN(pStream->threadId, NULL);
+        pStream->threadId = INVALID_TID_VALUE;
+    }
+
+    // Wait for the remaining fragments to be persisted
+    for (i = 0; i < benchmark.streamCount; i++) {
+        CHK_STATUS(stopKinesisVideoStreamSync(benchmark.pStreams[i].streamHandle));
+    }
+
+    elapsed = GETTIME() - startTime;
+    cpuTime = benchmarkGetCpuTime() - cpuTime;
+    seconds = (DOUBLE) elapsed / HUNDREDS_OF_NANOS_IN_A_SECOND;
+
+    for (i = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        if (STATUS_FAILED(pStream->status)) {
+            PRINTF("Stream %s failed with 0x%08x\n", pStream->streamName, pStream->status);
+        }
+
+        frameCount += pStream->frameCount;
+        byteCount += pStream->byteCount;
+        latencyCount += pStream->latencyCount;
+    }
+
+    pAllLatencies = (PUINT64) MEMCALLOC(latencyCount + 1, SIZEOF(UINT64));
+    CHK(pAllLatencies != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    for (i = 0, latencyCount = 0; i < benchmark.streamCount; i++) {
+        pStream = &benchmark.pStreams[i];
+        MEMCPY(pAllLatencies + latencyCount, pStream->pLatencies, pStream->latencyCount * SIZEOF(UINT64));
+        latencyCount += pStream->latencyCount;
+    }
+
+    qsort(pAllLatencies, latencyCount, SIZEOF(UINT64), benchmarkCompareLatencies);
+
+    CHK_STATUS(mockKinesisVideoServiceGetStats(pService, &serviceBytes, &persistedCount));
+
+    PRINTF("Frames/s:            %.1f\n", frameCount / seconds);
+    PRINTF("Bytes/s:             %.1f\n", byteCount / seconds);
+    PRINTF("Service bytes/s:     %.1f\n", serviceBytes / seconds);
+    PRINTF("Persisted fragments: %" PRIu64 "\n", persistedCount);
+    if (latencyCount != 0) {
+        PRINTF("Ack latency ms:      p50 %.1f p90 %.1f p99 %.1f max %.1f\n",
+               (DOUBLE) pAllLatencies[latencyCount * 50 / 100] / HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+               (DOUBLE) pAllLatencies[latencyCount * 90 / 100] / HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+               (DOUBLE) pAllLatencies[latencyCount * 99 / 100] / HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+               (DOUBLE) pAllLatencies[latencyCount - 1] / HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+    PRINTF("CPU per stream:      %.2f%%\n", 100.0 * cpuTime / elapsed / benchmark.streamCount);
+    PRINTF("Max RSS MB:          %.1f (HTTP/2 %s)\n", (DOUBLE) benchmarkGetMaxRss() / (1024 * 1024), benchmark.http2 ? "on" : "off");
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        PRINTF("Benchmark failed with 0x%08x\n", retStatus);
+    }
+
+    if (benchmark.pStreams != NULL) {
+        for (i = 0; i < benchmark.streamCount; i++) {
+            pStream = &benchmark.pStreams[i];
+            if (IS_VALID_TID_VALUE(pStream->threadId)) {
+                THREAD_JOIN(pStream->threadId, NULL);
+            }
+
+            if (IS_VALID_STREAM_HANDLE(pStream->streamHandle)) {
+                freeKinesisVideoStream(&pStream->streamHandle);
+            }
+
+            if (pStream->pStreamInfo != NULL) {
+                freeStreamInfoProvider(&pStream->pStreamInfo);
+            }
+
+            if (IS_VALID_MUTEX_VALUE(pStream->lock)) {
+                MUTEX_FREE(pStream->lock);
+            }
+
+            SAFE_MEMFREE(pStream->pLatencies);
+        }
+
+        MEMFREE(benchmark.pStreams);
+    }
+
+    if (IS_VALID_CLIENT_HANDLE(clientHandle)) {
+        freeKinesisVideoClient(&clientHandle);
+    }
+
+    if (pClientCallbacks != NULL) {
+        freeCallbacksProvider(&pClientCallbacks);
+    }
+
+    if (pDeviceInfo != NULL) {
+        freeDeviceInfo(&pDeviceInfo);
+    }
+
+    freeMockKinesisVideoService(&pService);
+    SAFE_MEMFREE(pAllLatencies);
+
+    return (INT32) retStatus;
+}